@@ -0,0 +1,358 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include <scene_rdl2/common/fb_util/Tiler.h>
+#include <scene_rdl2/common/grid_util/FbStreamClient.h>
+#include <scene_rdl2/common/grid_util/FbStreamServer.h>
+#include <scene_rdl2/render/util/StrUtil.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib> // EXIT_SUCCESS
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using scene_rdl2::grid_util::Fb;
+using scene_rdl2::grid_util::FbStreamClient;
+using scene_rdl2::grid_util::FbStreamServer;
+using scene_rdl2::grid_util::FbStreamSubscribeParam;
+using PrecisionMode = FbStreamSubscribeParam::PrecisionMode;
+
+constexpr const char *benchAovName = "depth";
+
+void
+usage(const char* progName)
+{
+    std::cerr << "Usage : " << progName << " <host> <port> [options]\n"
+              << "        " << progName << " -bench [options]\n"
+              << "Receive live frames from FbStreamServer and show received FRAME info.\n"
+              << "  -noBeauty                 : do not subscribe beauty\n"
+              << "  -aov <name>               : subscribe AOV (can be used multiple times)\n"
+              << "  -precision <F32|H16|UC8>  : pixel precision (default H16)\n"
+              << "  -roi <x0> <y0> <x1> <y1>  : region of interest (inclusive pixel coordinate)\n"
+              << "  -fps <N>                  : max FRAME rate (default 0 : unlimited)\n"
+              << "  -frames <N>               : exit after N FRAMEs\n"
+              << "-bench runs FbStreamServer and clients inside this process over loopback and reports throughput.\n"
+              << "  -reso <w> <h>             : image resolution (default 1920 1080)\n"
+              << "  -clients <N>              : number of clients (default 4)\n"
+              << "  -frames <N>               : number of published frames (default 120)\n"
+              << "  -dirty <ratio>            : updated area ratio of each frame (default 0.25)\n"
+              << "  -precision/-roi/-fps      : same as above, used by all clients\n";
+}
+
+bool
+strToPrecision(const char *str, PrecisionMode &mode)
+{
+    if (std::strcmp(str, "F32") == 0) { mode = PrecisionMode::F32; return true; }
+    if (std::strcmp(str, "H16") == 0) { mode = PrecisionMode::H16; return true; }
+    if (std::strcmp(str, "UC8") == 0) { mode = PrecisionMode::UC8; return true; }
+    return false;
+}
+
+uint64_t
+getNanoSec()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>
+        (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int
+runClient(const std::string &host, const int port, const FbStreamSubscribeParam &param, const int maxFrames)
+{
+    FbStreamClient client;
+    std::string errorMsg;
+    if (!client.connect(host, port, errorMsg) || !client.subscribe(param, errorMsg)) {
+        std::cerr << "ERROR : " << errorMsg << '\n';
+        return EXIT_FAILURE;
+    }
+    std::cerr << param.show() << '\n';
+
+    Fb fb;
+    const uint64_t startTime = getNanoSec();
+    for (int frameCount = 0; maxFrames <= 0 || frameCount < maxFrames; ) {
+        const int flag = client.recvFrame(fb, 1000, errorMsg);
+        if (flag < 0) {
+            std::cerr << "ERROR : " << errorMsg << '\n';
+            return EXIT_FAILURE;
+        }
+        if (flag == 0) continue; // timeout
+
+        ++frameCount;
+        const FbStreamClient::FrameInfo &info = client.getLastFrameInfo();
+        const double sec = static_cast<double>(getNanoSec() - startTime) * 1.0e-9;
+        std::cerr << "frameId:" << info.mFrameId
+                  << ((info.mFullFrame) ? " full " : " delta")
+                  << " reso:" << info.mWidth << 'x' << info.mHeight
+                  << " items:" << info.mItemTotal
+                  << " size:" << scene_rdl2::str_util::byteStr(info.mMessageSize)
+                  << " aveFps:" << std::fixed << std::setprecision(2) << static_cast<double>(frameCount) / sec
+                  << " total:" << scene_rdl2::str_util::byteStr(client.getRecvBytes()) << '\n';
+    }
+    return EXIT_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+
+float
+benchValue(unsigned x, unsigned y, unsigned frame, unsigned chan)
+{
+    return static_cast<float>((x * 7 + y * 13 + frame * 31 + chan * 101) % 256) / 255.0f;
+}
+
+void
+benchUpdateFb(Fb &fb, unsigned y0, unsigned y1, unsigned frame, Fb::ActivePixels &dirty)
+//
+// Updates all the pixels of scanline [y0, y1) of beauty and AOV and sets dirty pixel mask.
+//
+{
+    const unsigned width = fb.getWidth();
+    scene_rdl2::fb_util::Tiler tiler(width, fb.getHeight());
+    float *beauty = reinterpret_cast<float *>(fb.getRenderBufferTiled().getData());
+    float *aov = fb.getAov(benchAovName)->getBufferTiled().getFloatBuffer().getData();
+
+    dirty.reset();
+    for (unsigned y = y0; y < y1; ++y) {
+        for (unsigned x = 0; x < width; ++x) {
+            const unsigned ofs = tiler.linearCoordsToTiledOffset(x, y);
+            for (unsigned c = 0; c < 4; ++c) beauty[ofs * 4 + c] = benchValue(x, y, frame, c);
+            aov[ofs] = benchValue(x, y, frame, 4);
+            dirty.orOp((y >> 3) * dirty.getNumTilesX() + (x >> 3), 0x1ULL << (((y & 0x7) << 3) + (x & 0x7)));
+        }
+    }
+}
+
+bool
+benchVerify(const Fb &src, Fb &dst, const FbStreamSubscribeParam &param, std::string &errorMsg)
+//
+// Compares all the pixels inside ROI. Tolerance depends on the precision mode. (UC8 RGB is sRGB encoded,
+// so the error in linear space is bigger than 1/255)
+//
+{
+    if (dst.getWidth() != src.getWidth() || dst.getHeight() != src.getHeight()) {
+        errorMsg = "resolution mismatch";
+        return false;
+    }
+    const float tolerance = ((param.mPrecision == PrecisionMode::F32) ? 0.0f :
+                             (param.mPrecision == PrecisionMode::H16) ? 1.0e-3f : 2.0e-2f);
+
+    scene_rdl2::fb_util::Tiler tiler(src.getWidth(), src.getHeight());
+    const float *srcBeauty = reinterpret_cast<const float *>(src.getRenderBufferTiled().getData());
+    const float *dstBeauty = reinterpret_cast<const float *>(dst.getRenderBufferTiled().getData());
+    Fb::FbAovShPtr srcAov, dstAov;
+    src.getAov2(benchAovName, srcAov);
+    if (!dst.getAov2(benchAovName, dstAov)) {
+        errorMsg = "AOV was not received";
+        return false;
+    }
+    const float *srcAovData = srcAov->getBufferTiled().getFloatBuffer().getData();
+    const float *dstAovData = dstAov->getBufferTiled().getFloatBuffer().getData();
+
+    for (unsigned y = 0; y < src.getHeight(); ++y) {
+        for (unsigned x = 0; x < src.getWidth(); ++x) {
+            if (param.mRoiActive && !param.mRoi.contains(static_cast<int>(x), static_cast<int>(y))) continue;
+            const unsigned ofs = tiler.linearCoordsToTiledOffset(x, y);
+            bool ok = std::fabs(srcAovData[ofs] - dstAovData[ofs]) <= tolerance;
+            for (unsigned c = 0; c < 4; ++c) {
+                ok &= std::fabs(srcBeauty[ofs * 4 + c] - dstBeauty[ofs * 4 + c]) <= tolerance;
+            }
+            if (!ok) {
+                errorMsg = scene_rdl2::str_util::stringCat("pixel mismatch x:", std::to_string(x),
+                                                           " y:", std::to_string(y));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int
+runBench(const unsigned width, const unsigned height, const unsigned clientTotal, const unsigned frames,
+         const float dirtyRatio, FbStreamSubscribeParam param)
+{
+    param.mBeauty = true;
+    param.mAovNames = {benchAovName};
+
+    Fb src;
+    src.init(scene_rdl2::math::Viewport(0, 0, width - 1, height - 1));
+    src.getAov(benchAovName)->setup(nullptr, scene_rdl2::fb_util::VariablePixelBuffer::FLOAT, width, height, false);
+    Fb::ActivePixels dirty;
+    dirty.init(width, height);
+    benchUpdateFb(src, 0, height, 0, dirty);
+
+    FbStreamServer server;
+    const int port = server.open(0, nullptr, [](const std::string &msg) { std::cerr << msg << '\n'; });
+    if (!port) return EXIT_FAILURE;
+
+    struct ClientResult
+    {
+        Fb mFb;
+        uint64_t mFrames {0};
+        uint64_t mBytes {0};
+        uint64_t mLastRecvTime {0};
+        std::string mError;
+    };
+    std::vector<ClientResult> results(clientTotal);
+    std::atomic<unsigned> readyTotal {0};
+    std::atomic<bool> done {false};
+
+    std::vector<std::thread> threads;
+    for (unsigned clientId = 0; clientId < clientTotal; ++clientId) {
+        threads.emplace_back([&, clientId]() {
+            ClientResult &result = results[clientId];
+            FbStreamClient client;
+            if (!client.connect("localhost", port, result.mError) || !client.subscribe(param, result.mError)) {
+                ++readyTotal;
+                return;
+            }
+            ++readyTotal;
+            while (true) {
+                const int flag = client.recvFrame(result.mFb, 200, result.mError);
+                if (flag < 0) return;
+                if (flag == 0) {
+                    if (done) break;
+                    continue;
+                }
+                result.mLastRecvTime = getNanoSec();
+                ++result.mFrames;
+            }
+            result.mBytes = client.getRecvBytes();
+            client.close();
+        });
+    }
+    while (readyTotal < clientTotal) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // wait until all SUBSCRIBEs are received
+
+    //
+    // producer : every frame updates a band of scanlines which moves down the image
+    //
+    const unsigned bandHeight = std::max(1u, static_cast<unsigned>(static_cast<float>(height) * dirtyRatio));
+    const uint64_t startTime = getNanoSec();
+    uint64_t publishTime = 0;
+    for (unsigned frame = 1; frame <= frames; ++frame) {
+        const unsigned y0 = ((frame - 1) * bandHeight) % height;
+        const unsigned y1 = std::min(height, y0 + bandHeight);
+        benchUpdateFb(src, y0, y1, frame, dirty);
+
+        const uint64_t publishStart = getNanoSec();
+        server.publish(src, &dirty);
+        publishTime += getNanoSec() - publishStart;
+    }
+    const uint64_t producerEndTime = getNanoSec();
+
+    // flush pending pixels of throttled clients
+    dirty.reset();
+    for (int i = 0; i < 100; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        server.publish(src, &dirty);
+    }
+    done = true;
+    for (auto &thread : threads) thread.join();
+
+    std::cerr << server.show() << '\n';
+    server.close();
+
+    //
+    // report
+    //
+    uint64_t totalBytes = 0;
+    uint64_t lastRecvTime = producerEndTime;
+    bool verifyResult = true;
+    for (unsigned clientId = 0; clientId < clientTotal; ++clientId) {
+        ClientResult &result = results[clientId];
+        std::string errorMsg = result.mError;
+        const bool ok = errorMsg.empty() && benchVerify(src, result.mFb, param, errorMsg);
+        verifyResult &= ok;
+        totalBytes += result.mBytes;
+        lastRecvTime = std::max(lastRecvTime, result.mLastRecvTime);
+        std::cerr << "client:" << clientId
+                  << " frames:" << result.mFrames
+                  << " recv:" << scene_rdl2::str_util::byteStr(result.mBytes)
+                  << " verify:" << ((ok) ? "OK" : "NG " + errorMsg) << '\n';
+    }
+
+    const double producerSec = static_cast<double>(producerEndTime - startTime) * 1.0e-9;
+    const double totalSec = static_cast<double>(lastRecvTime - startTime) * 1.0e-9;
+    std::cerr << "reso:" << width << 'x' << height
+              << " clients:" << clientTotal
+              << " frames:" << frames
+              << " dirty:" << dirtyRatio
+              << " precision:" << scene_rdl2::grid_util::PackTiles::showPrecisionMode(param.mPrecision) << '\n'
+              << "  publish fps:" << std::fixed << std::setprecision(2) << static_cast<double>(frames) / producerSec
+              << " (publish ave:" << scene_rdl2::str_util::secStr(static_cast<float>(publishTime * 1.0e-9 / frames))
+              << ")\n"
+              << "  loopback throughput:" << scene_rdl2::str_util::byteStr(static_cast<size_t>(totalBytes / totalSec))
+              << "/sec (all clients, " << scene_rdl2::str_util::byteStr(totalBytes) << " in "
+              << scene_rdl2::str_util::secStr(static_cast<float>(totalSec)) << ")\n"
+              << "  verify:" << ((verifyResult) ? "OK" : "NG") << '\n';
+    return (verifyResult) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace
+
+int
+main(int ac, char** av)
+{
+    if (ac < 2) {
+        usage(av[0]);
+        return EXIT_SUCCESS;
+    }
+
+    const bool bench = (std::strcmp(av[1], "-bench") == 0);
+    if (!bench && ac < 3) {
+        usage(av[0]);
+        return EXIT_FAILURE;
+    }
+
+    FbStreamSubscribeParam param;
+    int frames = (bench) ? 120 : 0;
+    unsigned width = 1920;
+    unsigned height = 1080;
+    unsigned clientTotal = 4;
+    float dirtyRatio = 0.25f;
+    for (int i = (bench) ? 2 : 3; i < ac; ++i) {
+        if (std::strcmp(av[i], "-noBeauty") == 0) {
+            param.mBeauty = false;
+        } else if (std::strcmp(av[i], "-aov") == 0 && i + 1 < ac) {
+            param.mAovNames.push_back(av[++i]);
+        } else if (std::strcmp(av[i], "-precision") == 0 && i + 1 < ac) {
+            if (!strToPrecision(av[++i], param.mPrecision)) {
+                std::cerr << "Unknown precision:" << av[i] << '\n';
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(av[i], "-roi") == 0 && i + 4 < ac) {
+            param.mRoiActive = true;
+            param.mRoi = scene_rdl2::math::Viewport(atoi(av[i + 1]), atoi(av[i + 2]), atoi(av[i + 3]), atoi(av[i + 4]));
+            i += 4;
+        } else if (std::strcmp(av[i], "-fps") == 0 && i + 1 < ac) {
+            param.mMaxFps = static_cast<float>(atof(av[++i]));
+        } else if (std::strcmp(av[i], "-frames") == 0 && i + 1 < ac) {
+            frames = atoi(av[++i]);
+        } else if (bench && std::strcmp(av[i], "-reso") == 0 && i + 2 < ac) {
+            width = static_cast<unsigned>(atoi(av[i + 1]));
+            height = static_cast<unsigned>(atoi(av[i + 2]));
+            i += 2;
+        } else if (bench && std::strcmp(av[i], "-clients") == 0 && i + 1 < ac) {
+            clientTotal = static_cast<unsigned>(atoi(av[++i]));
+        } else if (bench && std::strcmp(av[i], "-dirty") == 0 && i + 1 < ac) {
+            dirtyRatio = static_cast<float>(atof(av[++i]));
+        } else {
+            usage(av[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (bench) {
+        if (!width || !height || !clientTotal || frames <= 0) {
+            usage(av[0]);
+            return EXIT_FAILURE;
+        }
+        return runBench(width, height, clientTotal, static_cast<unsigned>(frames), dirtyRatio, param);
+    }
+    return runClient(av[1], atoi(av[2]), param, frames);
+}
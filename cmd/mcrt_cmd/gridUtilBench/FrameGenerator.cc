@@ -0,0 +1,236 @@
+// Copyright 2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "FrameGenerator.h"
+
+#include <scene_rdl2/common/grid_util/FbAov.h>
+
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+uint64_t
+splitMix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+float
+hashToUnitFloat(uint64_t key)
+{
+    return float(splitMix64(key) >> 40) / float(1 << 24);
+}
+
+constexpr uint64_t FULL_TILE_MASK = ~uint64_t(0);
+constexpr uint64_t COARSE_PASS_MASK = 0x1;                   // 1 pixel per tile
+constexpr uint64_t REFINE_PASS_MASK = 0x0055005500550055ULL; // 16 pixels per tile
+
+} // namespace
+
+namespace bench {
+
+const std::vector<std::string> FrameGenerator::sAovNames = {"float1", "float2", "float3", "float4"};
+
+FrameGenerator::FrameGenerator(unsigned width, unsigned height, Pattern pattern, unsigned totalPasses,
+                               uint64_t seed) :
+    mWidth(width),
+    mHeight(height),
+    mNumTilesX((width + 7) >> 3),
+    mNumTilesY((height + 7) >> 3),
+    mPattern(pattern),
+    mTotalPasses(std::max(totalPasses, 1u)),
+    mSeed(seed)
+{
+    if (mPattern == Pattern::ADAPTIVE) {
+        // Tiles converge by clusters of 8x8 tiles, with some per tile variation.
+        mTileError.resize(mNumTilesX * mNumTilesY);
+        for (unsigned tileY = 0; tileY < mNumTilesY; ++tileY) {
+            for (unsigned tileX = 0; tileX < mNumTilesX; ++tileX) {
+                const uint64_t clusterKey = mSeed ^ ((uint64_t(tileY >> 3) << 32) | (tileX >> 3));
+                const uint64_t tileKey = mSeed ^ ((uint64_t(tileY) << 32) | tileX) ^ 0x5bd1e995ULL;
+                mTileError[tileY * mNumTilesX + tileX] =
+                    0.75f * hashToUnitFloat(clusterKey) + 0.25f * hashToUnitFloat(tileKey);
+            }
+        }
+    }
+}
+
+void
+FrameGenerator::setupFb(Fb& fb, Buffers buffers) const
+{
+    fb.init(scene_rdl2::math::Viewport(0, 0, mWidth - 1, mHeight - 1));
+
+    auto setupAov = [&](const std::string& aovName, int numChan) {
+        static const scene_rdl2::fb_util::VariablePixelBuffer::Format formats[] = {
+            scene_rdl2::fb_util::VariablePixelBuffer::FLOAT,
+            scene_rdl2::fb_util::VariablePixelBuffer::FLOAT2,
+            scene_rdl2::fb_util::VariablePixelBuffer::FLOAT3,
+            scene_rdl2::fb_util::VariablePixelBuffer::FLOAT4
+        };
+        Fb::FbAovShPtr fbAov = fb.getAov(aovName);
+        fbAov->setDefaultValue(0.0f); // need to setup default value before call setup()
+        fbAov->setup(nullptr, formats[numChan - 1], mWidth, mHeight, true);
+    };
+
+    switch (buffers) {
+    case Buffers::BEAUTY :
+        break;
+    case Buffers::BEAUTY_AOV :
+        fb.setupWeightBuffer(nullptr, "weight");
+        setupAov(sAovNames[2], 3);
+        break;
+    case Buffers::ALL :
+        fb.setupPixelInfo(nullptr, "depth");
+        fb.setupHeatMap(nullptr, "heatMap");
+        fb.setupWeightBuffer(nullptr, "weight");
+        fb.setupRenderBufferOdd(nullptr);
+        for (size_t i = 0; i < sAovNames.size(); ++i) {
+            setupAov(sAovNames[i], int(i) + 1);
+        }
+        break;
+    }
+}
+
+size_t
+FrameGenerator::renderPass(Fb& fb, unsigned passId) const
+{
+    std::vector<Fb::FbAovShPtr> fbAovs;
+    for (const std::string& aovName : sAovNames) {
+        Fb::FbAovShPtr fbAov;
+        if (fb.getAov2(aovName, fbAov) && fbAov->getStatus()) {
+            fbAovs.push_back(fbAov);
+        }
+    }
+
+    std::atomic<size_t> sampledTotal(0);
+    tbb::parallel_for(0u, mNumTilesX * mNumTilesY, [&](unsigned tileId) {
+        const unsigned tileX = tileId % mNumTilesX;
+        const unsigned tileY = tileId / mNumTilesX;
+
+        uint64_t rng = mSeed ^ (uint64_t(passId) << 40) ^ tileId;
+        const uint64_t mask = passTileMask(tileId, passId, rng) & validPixelMask(tileX, tileY);
+        if (!mask) return;
+
+        fb.getActivePixels().orOp(tileId, mask);
+        if (fb.getPixelInfoStatus()) fb.getActivePixelsPixelInfo().orOp(tileId, mask);
+        if (fb.getHeatMapStatus()) fb.getActivePixelsHeatMap().orOp(tileId, mask);
+        if (fb.getWeightBufferStatus()) fb.getActivePixelsWeightBuffer().orOp(tileId, mask);
+        if (fb.getRenderBufferOddStatus()) fb.getActivePixelsRenderBufferOdd().orOp(tileId, mask);
+        for (auto& fbAov : fbAovs) {
+            fbAov->getActivePixels().orOp(tileId, mask);
+        }
+
+        const float pass = float(passId + 1);
+        for (unsigned pixOffset = 0; pixOffset < 64; ++pixOffset) {
+            if (!((mask >> pixOffset) & 0x1)) continue;
+
+            const unsigned offset = (tileId << 6) + pixOffset;
+            const float u = float((tileX << 3) + (pixOffset & 0x7)) / float(mWidth);
+            const float v = float((tileY << 3) + (pixOffset >> 3)) / float(mHeight);
+            const float noise = hashToUnitFloat(splitMix64(rng)) * 0.1f / pass;
+
+            fb.getRenderBufferTiled().getData()[offset] =
+                Fb::RenderColor(u + noise, v + noise, 0.5f + noise, 1.0f);
+            ++fb.getNumSampleBufferTiled().getData()[offset];
+
+            if (fb.getPixelInfoStatus()) {
+                fb.getPixelInfoBufferTiled().getData()[offset].depth = 10.0f + u * 100.0f + noise;
+            }
+            if (fb.getHeatMapStatus()) {
+                fb.getHeatMapSecBufferTiled().getData()[offset] += 0.001f + noise * 0.01f;
+                ++fb.getHeatMapNumSampleBufferTiled().getData()[offset];
+            }
+            if (fb.getWeightBufferStatus()) {
+                fb.getWeightBufferTiled().getData()[offset] += 1.0f;
+            }
+            if (fb.getRenderBufferOddStatus()) {
+                fb.getRenderBufferOddTiled().getData()[offset] =
+                    Fb::RenderColor(v + noise, u + noise, 0.25f + noise, 1.0f);
+                ++fb.getRenderBufferOddNumSampleBufferTiled().getData()[offset];
+            }
+            for (auto& fbAov : fbAovs) {
+                const int numChan = fbAov->getNumChan();
+                float* pix = reinterpret_cast<float*>(fbAov->getBufferTiled().getData()) + offset * numChan;
+                for (int c = 0; c < numChan; ++c) {
+                    pix[c] = (c & 1 ? v : u) + noise * float(c + 1);
+                }
+                ++fbAov->getNumSampleBufferTiled().getData()[offset];
+            }
+        }
+        sampledTotal += __builtin_popcountll(mask);
+    });
+
+    return sampledTotal;
+}
+
+// static function
+bool
+FrameGenerator::parsePattern(const std::string& str, Pattern& pattern)
+{
+    if (str == "uniform") pattern = Pattern::UNIFORM;
+    else if (str == "sparse") pattern = Pattern::SPARSE;
+    else if (str == "adaptive") pattern = Pattern::ADAPTIVE;
+    else return false;
+    return true;
+}
+
+// static function
+std::string
+FrameGenerator::showPattern(Pattern pattern)
+{
+    switch (pattern) {
+    case Pattern::UNIFORM : return "uniform";
+    case Pattern::SPARSE : return "sparse";
+    case Pattern::ADAPTIVE : return "adaptive";
+    }
+    return "?";
+}
+
+uint64_t
+FrameGenerator::passTileMask(unsigned tileId, unsigned passId, uint64_t& rng) const
+{
+    switch (mPattern) {
+    case Pattern::UNIFORM :
+        return FULL_TILE_MASK;
+
+    case Pattern::SPARSE :
+        // Each bit is set with 1/32 probability.
+        return (splitMix64(rng) & splitMix64(rng) & splitMix64(rng) &
+                splitMix64(rng) & splitMix64(rng));
+
+    case Pattern::ADAPTIVE : {
+        if (passId == 0) return COARSE_PASS_MASK;
+        if (passId == 1) return REFINE_PASS_MASK;
+        // The convergence threshold goes up over the remaining passes.
+        const float threshold = float(passId - 1) / float(std::max(mTotalPasses - 1, 2u));
+        return (mTileError[tileId] > threshold) ? FULL_TILE_MASK : 0x0;
+    }
+    }
+    return 0x0;
+}
+
+uint64_t
+FrameGenerator::validPixelMask(unsigned tileX, unsigned tileY) const
+//
+// Pixels of the tile inside the original (non tile aligned) resolution.
+//
+{
+    const unsigned validW = std::min(mWidth - (tileX << 3), 8u);
+    const unsigned validH = std::min(mHeight - (tileY << 3), 8u);
+    if (validW == 8 && validH == 8) return FULL_TILE_MASK;
+
+    const uint64_t rowMask = (uint64_t(1) << validW) - 1;
+    uint64_t mask = 0x0;
+    for (unsigned y = 0; y < validH; ++y) {
+        mask |= rowMask << (y << 3);
+    }
+    return mask;
+}
+
+} // namespace bench
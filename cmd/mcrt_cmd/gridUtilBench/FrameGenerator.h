@@ -0,0 +1,70 @@
+// Copyright 2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <scene_rdl2/common/grid_util/Fb.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+//
+// Synthetic render passes for grid_util benchmarks. Each pass marks some pixels as sampled and
+// updates their values, the way a progressive render updates its frame buffers between two
+// snapshots.
+//
+//   UNIFORM  : every pixel is sampled on every pass
+//   SPARSE   : about 1/32 of the pixels, randomly spread, on every pass
+//   ADAPTIVE : a coarse pass (1 pixel per tile), a refinement pass (16 pixels per tile), then
+//              all pixels of the tiles which did not converge yet. The unconverged tiles form
+//              clusters and their number shrinks pass after pass, like adaptive sampling.
+//
+class FrameGenerator
+{
+public:
+    using Fb = scene_rdl2::grid_util::Fb;
+
+    enum class Pattern { UNIFORM, SPARSE, ADAPTIVE };
+
+    enum class Buffers {
+        BEAUTY,     // beauty + numSample only
+        BEAUTY_AOV, // beauty + weight + one float3 AOV
+        ALL         // beauty, pixelInfo, heatMap, weight, beautyOdd and float1..float4 AOVs
+    };
+
+    static const std::vector<std::string> sAovNames; // float1 .. float4
+
+    FrameGenerator(unsigned width, unsigned height, Pattern pattern, unsigned totalPasses,
+                   uint64_t seed = 0);
+
+    unsigned getWidth() const { return mWidth; }
+    unsigned getHeight() const { return mHeight; }
+
+    // Initializes fb at the generator resolution with the requested buffers, all cleared.
+    void setupFb(Fb& fb, Buffers buffers) const;
+
+    // Samples the pixels of the given pass into every active buffer of fb. Returns the number
+    // of pixels sampled by this pass.
+    size_t renderPass(Fb& fb, unsigned passId) const;
+
+    static bool parsePattern(const std::string& str, Pattern& pattern);
+    static std::string showPattern(Pattern pattern);
+
+private:
+    uint64_t passTileMask(unsigned tileId, unsigned passId, uint64_t& rng) const;
+    uint64_t validPixelMask(unsigned tileX, unsigned tileY) const;
+
+    unsigned mWidth;
+    unsigned mHeight;
+    unsigned mNumTilesX;
+    unsigned mNumTilesY;
+    Pattern mPattern;
+    unsigned mTotalPasses;
+    uint64_t mSeed;
+
+    std::vector<float> mTileError; // ADAPTIVE : convergence threshold of each tile, 0 ~ 1
+};
+
+} // namespace bench
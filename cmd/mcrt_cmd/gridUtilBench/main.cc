@@ -0,0 +1,696 @@
+// Copyright 2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "FrameGenerator.h"
+
+#include <scene_rdl2/common/fb_util/ActivePixels.h>
+#include <scene_rdl2/common/grid_util/Fb.h>
+#include <scene_rdl2/common/grid_util/FbActivePixels.h>
+#include <scene_rdl2/common/grid_util/FbAov.h>
+#include <scene_rdl2/common/grid_util/PackTiles.h>
+#include <scene_rdl2/common/rec_time/RecTime.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace scene_rdl2;
+
+namespace {
+
+using bench::FrameGenerator;
+using grid_util::CoarsePassPrecision;
+using grid_util::Fb;
+using grid_util::FbActivePixels;
+using grid_util::FbAov;
+using grid_util::FinePassPrecision;
+using grid_util::PackTiles;
+using DataType = PackTiles::DataType;
+using PrecisionMode = PackTiles::PrecisionMode;
+
+struct BenchOptions
+{
+    std::vector<std::pair<unsigned, unsigned>> mResolutions {{960, 540}, {1920, 1080}};
+    std::vector<FrameGenerator::Pattern> mPatterns {FrameGenerator::Pattern::UNIFORM,
+                                                    FrameGenerator::Pattern::SPARSE,
+                                                    FrameGenerator::Pattern::ADAPTIVE};
+    unsigned mFrames {16};
+    int mMachines {4};
+    int mRuns {3};
+    uint64_t mSeed {1234};
+    std::string mOut; // empty : stdout
+};
+
+//------------------------------------------------------------------------------------------
+
+// Latency of one stage, accumulated over the frames (or the best of the runs).
+struct StageStat
+{
+    std::string mStage;
+    std::string mDataType;  // encode/decode only
+    std::string mPrecision; // encode/decode only
+    int mMachines {0};      // accumulate only
+
+    size_t mCalls {0};
+    double mTotalSec {0.0};
+    double mMaxSec {0.0};
+    double mTotalBytes {0.0};
+    double mTotalPixels {0.0};
+
+    void add(double sec, double pixels, double bytes = 0.0)
+    {
+        ++mCalls;
+        mTotalSec += sec;
+        mMaxSec = std::max(mMaxSec, sec);
+        mTotalPixels += pixels;
+        mTotalBytes += bytes;
+    }
+
+    std::string toJson() const
+    {
+        const double calls = std::max(double(mCalls), 1.0);
+        std::ostringstream ostr;
+        ostr << "{ \"stage\": \"" << mStage << "\"";
+        if (!mDataType.empty()) ostr << ", \"data_type\": \"" << mDataType << "\"";
+        if (!mPrecision.empty()) ostr << ", \"precision\": \"" << mPrecision << "\"";
+        if (mMachines) ostr << ", \"machines\": " << mMachines;
+        ostr << ", \"sec\": " << std::setprecision(6) << mTotalSec / calls
+             << ", \"max_sec\": " << mMaxSec
+             << ", \"pixels\": " << std::setprecision(12) << mTotalPixels / calls
+             << ", \"mpix_per_sec\": " << std::fixed << std::setprecision(2)
+             << ((mTotalSec > 0.0) ? mTotalPixels / mTotalSec * 1.0e-6 : 0.0) << std::defaultfloat;
+        if (mTotalBytes > 0.0) {
+            ostr << ", \"bytes\": " << std::setprecision(12) << mTotalBytes / calls
+                 << ", \"mb_per_sec\": " << std::fixed << std::setprecision(2)
+                 << ((mTotalSec > 0.0) ? mTotalBytes / mTotalSec / (1024.0 * 1024.0) : 0.0)
+                 << std::defaultfloat;
+        }
+        ostr << " }";
+        return ostr.str();
+    }
+};
+
+// Bytes and latency of the whole mcrt frame message (snapshotDelta + all the mcrt side encodes)
+// for one precision mode.
+struct FrameStat
+{
+    std::string mPrecision;
+    size_t mFrames {0};
+    double mTotalSec {0.0};
+    double mTotalBytes {0.0};
+};
+
+struct CaseResult
+{
+    unsigned mWidth {0};
+    unsigned mHeight {0};
+    std::string mPattern;
+    std::vector<StageStat> mStages;
+    std::vector<FrameStat> mFrames;
+};
+
+//------------------------------------------------------------------------------------------
+
+// Decode destination buffers, reused by every decode.
+struct DecodeBuffers
+{
+    fb_util::ActivePixels mActivePixels;
+    Fb::RenderBuffer mRenderBuffer;
+    Fb::NumSampleBuffer mNumSampleBuffer;
+    Fb::PixelInfoBuffer mPixelInfoBuffer;
+    Fb::FloatBuffer mFloatBuffer;
+    Fb::FbAovShPtr mFbAov {std::make_shared<FbAov>("decode")};
+    CoarsePassPrecision mCoarsePassPrecision {CoarsePassPrecision::F32};
+    FinePassPrecision mFinePassPrecision {FinePassPrecision::F32};
+    bool mActiveDecodeAction {false};
+};
+
+// One PackTiles DataType : how to encode it from the snapshot result and decode it back.
+struct Codec
+{
+    DataType mDataType;
+    bool mUsePrecision;  // false : fixed precision (heatMap is always H16, reference has no data)
+    bool mMcrtMessage;   // part of the message sent by mcrt computation
+    std::function<size_t(Fb& fb, FbActivePixels& delta, PrecisionMode precision, std::string& out)> mEncode;
+    std::function<bool(const std::string& data, DecodeBuffers& buffers)> mDecode;
+};
+
+CoarsePassPrecision
+toCoarsePassPrecision(PrecisionMode precision)
+{
+    switch (precision) {
+    case PrecisionMode::F32 : return CoarsePassPrecision::F32;
+    case PrecisionMode::H16 : return CoarsePassPrecision::H16;
+    case PrecisionMode::UC8 : return CoarsePassPrecision::UC8;
+    }
+    return CoarsePassPrecision::F32;
+}
+
+FinePassPrecision
+toFinePassPrecision(PrecisionMode precision)
+{
+    return (precision == PrecisionMode::F32) ? FinePassPrecision::F32 : FinePassPrecision::H16;
+}
+
+Codec
+renderBufferCodec(bool renderBufferOdd, bool withNumSample)
+{
+    const DataType dataType =
+        renderBufferOdd ?
+        (withNumSample ? DataType::BEAUTYODD_WITH_NUMSAMPLE : DataType::BEAUTYODD) :
+        (withNumSample ? DataType::BEAUTY_WITH_NUMSAMPLE : DataType::BEAUTY);
+
+    auto encode = [=](Fb& fb, FbActivePixels& delta, PrecisionMode precision, std::string& out) {
+        const fb_util::ActivePixels& activePixels =
+            renderBufferOdd ? delta.getActivePixelsRenderBufferOdd() : delta.getActivePixels();
+        const Fb::RenderBuffer& renderBuffer =
+            renderBufferOdd ? fb.getRenderBufferOddTiled() : fb.getRenderBufferTiled();
+        if (withNumSample) {
+            // McrtComputation side : non normalized color + weight
+            return PackTiles::encode(renderBufferOdd, activePixels, renderBuffer, fb.getWeightBufferTiled(), out,
+                                     precision, toCoarsePassPrecision(precision), toFinePassPrecision(precision),
+                                     false); // noNumSampleMode
+        }
+        // McrtMergeComputation side : normalized color
+        return PackTiles::encode(renderBufferOdd, activePixels, renderBuffer, out,
+                                 precision, toCoarsePassPrecision(precision), toFinePassPrecision(precision));
+    };
+    auto decode = [=](const std::string& data, DecodeBuffers& b) {
+        if (withNumSample) {
+            return PackTiles::decode(renderBufferOdd, data.data(), data.size(), true, b.mActivePixels,
+                                     b.mRenderBuffer, b.mNumSampleBuffer, b.mCoarsePassPrecision,
+                                     b.mFinePassPrecision, b.mActiveDecodeAction);
+        }
+        return PackTiles::decode(renderBufferOdd, data.data(), data.size(), b.mActivePixels, b.mRenderBuffer,
+                                 b.mCoarsePassPrecision, b.mFinePassPrecision, b.mActiveDecodeAction);
+    };
+    return {dataType, true, withNumSample, encode, decode};
+}
+
+Codec
+renderOutputCodec(int numChan, bool withNumSample)
+{
+    static const DataType withNumSampleTypes[] = {
+        DataType::FLOAT1_WITH_NUMSAMPLE, DataType::FLOAT2_WITH_NUMSAMPLE,
+        DataType::FLOAT3_WITH_NUMSAMPLE, DataType::FLOAT4_WITH_NUMSAMPLE
+    };
+    static const DataType noNumSampleTypes[] = {
+        DataType::FLOAT1, DataType::FLOAT2, DataType::FLOAT3, DataType::FLOAT4
+    };
+    const std::string aovName = FrameGenerator::sAovNames[numChan - 1];
+
+    auto encode = [=](Fb& fb, FbActivePixels& delta, PrecisionMode precision, std::string& out) {
+        Fb::FbAovShPtr fbAov = fb.getAov(aovName);
+        const fb_util::ActivePixels& activePixels = delta.getAov(aovName)->getActivePixels();
+        if (withNumSample) {
+            return PackTiles::encodeRenderOutput(activePixels, fbAov->getBufferTiled(), fbAov->getDefaultValue(),
+                                                 fb.getWeightBufferTiled(), out, precision,
+                                                 false,  // noNumSampleMode
+                                                 true,   // doNormalizeMode
+                                                 false,  // closestFilterStatus
+                                                 0,      // closestFilterAovOriginalNumChan
+                                                 toCoarsePassPrecision(precision),
+                                                 toFinePassPrecision(precision));
+        }
+        return PackTiles::encodeRenderOutputMerge(activePixels, fbAov->getBufferTiled(), fbAov->getDefaultValue(),
+                                                  out, precision,
+                                                  false, // closestFilterStatus
+                                                  toCoarsePassPrecision(precision),
+                                                  toFinePassPrecision(precision));
+    };
+    auto decode = [=](const std::string& data, DecodeBuffers& b) {
+        return PackTiles::decodeRenderOutput(data.data(), data.size(), withNumSample, b.mActivePixels,
+                                             b.mFbAov, b.mActiveDecodeAction);
+    };
+    return {withNumSample ? withNumSampleTypes[numChan - 1] : noNumSampleTypes[numChan - 1],
+            true, withNumSample, encode, decode};
+}
+
+std::vector<Codec>
+makeCodecs()
+{
+    std::vector<Codec> codecs;
+    codecs.push_back(renderBufferCodec(false, true));
+    codecs.push_back(renderBufferCodec(false, false));
+
+    codecs.push_back({DataType::PIXELINFO, true, true,
+            [](Fb& fb, FbActivePixels& delta, PrecisionMode precision, std::string& out) {
+                return PackTiles::encodePixelInfo(delta.getActivePixelsPixelInfo(), fb.getPixelInfoBufferTiled(),
+                                                  out, precision, toCoarsePassPrecision(precision),
+                                                  toFinePassPrecision(precision));
+            },
+            [](const std::string& data, DecodeBuffers& b) {
+                return PackTiles::decodePixelInfo(data.data(), data.size(), b.mActivePixels, b.mPixelInfoBuffer,
+                                                  b.mCoarsePassPrecision, b.mFinePassPrecision,
+                                                  b.mActiveDecodeAction);
+            }});
+
+    codecs.push_back({DataType::HEATMAP_WITH_NUMSAMPLE, false, true,
+            [](Fb& fb, FbActivePixels& delta, PrecisionMode, std::string& out) {
+                return PackTiles::encodeHeatMap(delta.getActivePixelsHeatMap(), fb.getHeatMapSecBufferTiled(),
+                                                fb.getWeightBufferTiled(), out,
+                                                false); // noNumSampleMode
+            },
+            [](const std::string& data, DecodeBuffers& b) {
+                return PackTiles::decodeHeatMap(data.data(), data.size(), true, b.mActivePixels, b.mFloatBuffer,
+                                                b.mNumSampleBuffer, b.mActiveDecodeAction);
+            }});
+    codecs.push_back({DataType::HEATMAP, false, false,
+            [](Fb& fb, FbActivePixels& delta, PrecisionMode, std::string& out) {
+                return PackTiles::encodeHeatMap(delta.getActivePixelsHeatMap(), fb.getHeatMapSecBufferTiled(),
+                                                out);
+            },
+            [](const std::string& data, DecodeBuffers& b) {
+                return PackTiles::decodeHeatMap(data.data(), data.size(), b.mActivePixels, b.mFloatBuffer,
+                                                b.mActiveDecodeAction);
+            }});
+
+    codecs.push_back({DataType::WEIGHT, true, true,
+            [](Fb& fb, FbActivePixels& delta, PrecisionMode precision, std::string& out) {
+                return PackTiles::encodeWeightBuffer(delta.getActivePixelsWeightBuffer(),
+                                                     fb.getWeightBufferTiled(), out, precision,
+                                                     toCoarsePassPrecision(precision),
+                                                     toFinePassPrecision(precision));
+            },
+            [](const std::string& data, DecodeBuffers& b) {
+                return PackTiles::decodeWeightBuffer(data.data(), data.size(), b.mActivePixels, b.mFloatBuffer,
+                                                     b.mCoarsePassPrecision, b.mFinePassPrecision,
+                                                     b.mActiveDecodeAction);
+            }});
+
+    codecs.push_back(renderBufferCodec(true, true));
+    codecs.push_back(renderBufferCodec(true, false));
+
+    for (int numChan = 1; numChan <= 4; ++numChan) {
+        codecs.push_back(renderOutputCodec(numChan, true));
+        codecs.push_back(renderOutputCodec(numChan, false));
+    }
+
+    codecs.push_back({DataType::REFERENCE, false, false,
+            [](Fb&, FbActivePixels&, PrecisionMode, std::string& out) {
+                return PackTiles::encodeRenderOutputReference(grid_util::FbReferenceType::BEAUTY, out);
+            },
+            [](const std::string& data, DecodeBuffers& b) {
+                return PackTiles::decodeRenderOutputReference(data.data(), data.size(), b.mFbAov);
+            }});
+    return codecs;
+}
+
+//------------------------------------------------------------------------------------------
+
+double
+timeIt(const std::function<void()>& func)
+{
+    rec_time::RecTime recTime;
+    recTime.start();
+    func();
+    return recTime.end();
+}
+
+// Best of the runs, in seconds. setup() runs before each measured run and is excluded from
+// the timing.
+double
+timeBestOf(int runs, const std::function<void()>& setup, const std::function<void()>& func)
+{
+    double best = 0.0;
+    for (int i = 0; i < runs; ++i) {
+        setup();
+        const double sec = timeIt(func);
+        if (i == 0 || sec < best) best = sec;
+    }
+    return best;
+}
+
+StageStat
+makeStage(const std::string& stage)
+{
+    StageStat stat;
+    stat.mStage = stage;
+    return stat;
+}
+
+void
+runFrames(const BenchOptions& options, const FrameGenerator& generator, Fb& renderFb, CaseResult& result)
+//
+// Progressive frames : render pass -> snapshotDelta -> encode -> decode of every DataType and
+// precision mode.
+//
+{
+    static const PrecisionMode precisions[] = {PrecisionMode::F32, PrecisionMode::H16, PrecisionMode::UC8};
+
+    const std::vector<Codec> codecs = makeCodecs();
+
+    StageStat snapshotStat = makeStage("snapshot_delta");
+    std::vector<StageStat> encodeStats, decodeStats;
+    for (const Codec& codec : codecs) {
+        for (PrecisionMode precision : precisions) {
+            StageStat stat;
+            stat.mDataType = PackTiles::showDataType(codec.mDataType);
+            stat.mPrecision = codec.mUsePrecision ? PackTiles::showPrecisionMode(precision) : "fixed";
+            stat.mStage = "encode";
+            encodeStats.push_back(stat);
+            stat.mStage = "decode";
+            decodeStats.push_back(stat);
+            if (!codec.mUsePrecision) break;
+        }
+    }
+    for (PrecisionMode precision : precisions) {
+        FrameStat frameStat;
+        frameStat.mPrecision = PackTiles::showPrecisionMode(precision);
+        result.mFrames.push_back(frameStat);
+    }
+
+    Fb snapshotFb;
+    generator.setupFb(snapshotFb, FrameGenerator::Buffers::BEAUTY);
+    FbActivePixels delta;
+    DecodeBuffers decodeBuffers;
+    std::string encoded;
+
+    for (unsigned frame = 0; frame < options.mFrames; ++frame) {
+        generator.renderPass(renderFb, frame);
+
+        const double snapshotSec = timeIt([&]() { renderFb.snapshotDelta(snapshotFb, delta, frame == 0); });
+        const double deltaPixels = delta.getActivePixels().getActivePixelTotal();
+        snapshotStat.add(snapshotSec, deltaPixels);
+
+        std::vector<double> frameBytes(std::size(precisions), 0.0);
+        std::vector<double> frameSec(std::size(precisions), snapshotSec);
+
+        size_t statId = 0;
+        for (const Codec& codec : codecs) {
+            for (size_t precisionId = 0; precisionId < std::size(precisions); ++precisionId) {
+                const PrecisionMode precision = precisions[precisionId];
+
+                encoded.clear();
+                const double encodeSec = timeIt([&]() { codec.mEncode(snapshotFb, delta, precision, encoded); });
+                encodeStats[statId].add(encodeSec, deltaPixels, encoded.size());
+
+                if (PackTiles::decodeDataType(encoded.data(), encoded.size()) != codec.mDataType) {
+                    std::cerr << "WARNING: encoded data type mismatch. expected:"
+                              << PackTiles::showDataType(codec.mDataType) << '\n';
+                }
+
+                bool decodeResult = false;
+                const double decodeSec = timeIt([&]() {
+                    decodeResult = codec.mDecode(encoded, decodeBuffers);
+                });
+                decodeStats[statId].add(decodeSec, deltaPixels, encoded.size());
+                if (!decodeResult) {
+                    std::cerr << "WARNING: decode failed. dataType:" << PackTiles::showDataType(codec.mDataType)
+                              << '\n';
+                }
+                ++statId;
+
+                if (!codec.mUsePrecision) {
+                    // Same data whatever the precision : counts for every precision of the message.
+                    for (size_t i = 0; i < std::size(precisions); ++i) {
+                        if (codec.mMcrtMessage) {
+                            frameBytes[i] += encoded.size();
+                            frameSec[i] += encodeSec;
+                        }
+                    }
+                    break;
+                }
+                if (codec.mMcrtMessage) {
+                    frameBytes[precisionId] += encoded.size();
+                    frameSec[precisionId] += encodeSec;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < std::size(precisions); ++i) {
+            FrameStat& frameStat = result.mFrames[i];
+            ++frameStat.mFrames;
+            frameStat.mTotalBytes += frameBytes[i];
+            frameStat.mTotalSec += frameSec[i];
+        }
+    }
+
+    result.mStages.push_back(snapshotStat);
+    result.mStages.insert(result.mStages.end(), encodeStats.begin(), encodeStats.end());
+    result.mStages.insert(result.mStages.end(), decodeStats.begin(), decodeStats.end());
+}
+
+void
+runAccumulate(const BenchOptions& options, unsigned width, unsigned height,
+              FrameGenerator::Pattern pattern, CaseResult& result)
+//
+// McrtMergeComputation : accumulateAllFbs() of N machines, each one rendered all the passes with
+// its own samples.
+//
+{
+    const int numMachines = options.mMachines;
+    std::vector<Fb> srcFbs(numMachines);
+    for (int machineId = 0; machineId < numMachines; ++machineId) {
+        const FrameGenerator generator(width, height, pattern, options.mFrames, options.mSeed + machineId + 1);
+        generator.setupFb(srcFbs[machineId], FrameGenerator::Buffers::BEAUTY_AOV);
+        for (unsigned frame = 0; frame < options.mFrames; ++frame) {
+            generator.renderPass(srcFbs[machineId], frame);
+        }
+    }
+    const std::vector<char> received(numMachines, 1);
+
+    Fb mergeFb;
+    FrameGenerator(width, height, pattern, options.mFrames).setupFb(mergeFb, FrameGenerator::Buffers::BEAUTY);
+
+    StageStat stat = makeStage("accumulate_all_fbs");
+    stat.mMachines = numMachines;
+    stat.add(timeBestOf(options.mRuns,
+                        [&]() { mergeFb.reset(); },
+                        [&]() { mergeFb.accumulateAllFbs(numMachines, received, srcFbs); }),
+             double(width) * height * numMachines);
+    result.mStages.push_back(stat);
+}
+
+void
+runUntile(const BenchOptions& options, const Fb& renderFb, CaseResult& result)
+//
+// Client side : untile to scanline order and 8bit conversion for display.
+//
+{
+    const double pixels = double(renderFb.getWidth()) * renderFb.getHeight();
+    const int runs = options.mRuns;
+    auto noSetup = []() {};
+
+    Fb::FArray rgba;
+    Fb::UCArray rgb888;
+
+    StageStat untileStat = makeStage("untile_beauty");
+    untileStat.add(timeBestOf(runs, noSetup, [&]() { renderFb.untileBeauty(true, nullptr, rgba); }), pixels);
+    result.mStages.push_back(untileStat);
+
+    StageStat conv888Stat = makeStage("conv888_beauty");
+    conv888Stat.add(timeBestOf(runs, noSetup, [&]() { Fb::conv888Beauty(rgba, true, rgb888); }), pixels);
+    result.mStages.push_back(conv888Stat);
+
+    StageStat untile888Stat = makeStage("untile_beauty_rgb888");
+    untile888Stat.add(timeBestOf(runs, noSetup, [&]() { renderFb.untileBeauty(true, true, nullptr, rgb888); }),
+                      pixels);
+    result.mStages.push_back(untile888Stat);
+
+    StageStat untileAovStat = makeStage("untile_render_output_float3");
+    untileAovStat.add(timeBestOf(runs, noSetup, [&]() {
+                renderFb.untileRenderOutput(FrameGenerator::sAovNames[2], true, nullptr, false, rgba);
+            }), pixels);
+    result.mStages.push_back(untileAovStat);
+}
+
+void
+runExtrapolate(const BenchOptions& options, unsigned width, unsigned height,
+               FrameGenerator::Pattern pattern, CaseResult& result)
+//
+// Client side : extrapolation of the first (partially sampled) frame.
+//
+{
+    const FrameGenerator generator(width, height, pattern, options.mFrames, options.mSeed);
+    Fb fb;
+    generator.setupFb(fb, FrameGenerator::Buffers::BEAUTY_AOV);
+    generator.renderPass(fb, 0);
+
+    const double pixels = double(width) * height;
+    auto noSetup = []() {};
+
+    StageStat beautyStat = makeStage("extrapolate_beauty");
+    beautyStat.add(timeBestOf(options.mRuns, noSetup, [&]() { fb.extrapolateRenderBuffer(); }), pixels);
+    result.mStages.push_back(beautyStat);
+
+    StageStat aovStat = makeStage("extrapolate_render_output_float3");
+    aovStat.add(timeBestOf(options.mRuns, noSetup, [&]() {
+                fb.extrapolateRenderOutput(FrameGenerator::sAovNames[2]);
+            }), pixels);
+    result.mStages.push_back(aovStat);
+}
+
+//------------------------------------------------------------------------------------------
+
+std::vector<std::string>
+splitComma(const std::string& str)
+{
+    std::vector<std::string> items;
+    std::istringstream istr(str);
+    std::string item;
+    while (std::getline(istr, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+void
+usage(const char* progName)
+{
+    std::cerr << "Usage : " << progName << " [options]\n"
+              << "Frame transfer benchmark of grid_util : snapshotDelta, PackTiles encode/decode of every\n"
+              << "DataType and PrecisionMode, accumulateAllFbs, untile/conv888 and extrapolation over\n"
+              << "synthetic sample patterns. Results are reported as JSON.\n"
+              << "  --reso <WxH,...>         resolutions (default 960x540,1920x1080)\n"
+              << "  --pattern <name,...>     uniform, sparse, adaptive (default all)\n"
+              << "  --frames <n>             progressive frames (render passes) per case (default 16)\n"
+              << "  --machines <n>           mcrt machines for accumulateAllFbs (default 4)\n"
+              << "  --runs <n>               runs of the non frame stages, the best one is reported (default 3)\n"
+              << "  --seed <n>               sample pattern seed (default 1234)\n"
+              << "  --out <file>             JSON output file (default stdout)\n";
+}
+
+bool
+parseCommandLine(int argc, char* argv[], BenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) return false;
+        const std::string key = argv[i];
+        const std::string value = argv[++i];
+
+        if (key == "--reso") {
+            options.mResolutions.clear();
+            for (const std::string& reso : splitComma(value)) {
+                unsigned w = 0, h = 0;
+                if (std::sscanf(reso.c_str(), "%ux%u", &w, &h) != 2 || !w || !h) return false;
+                options.mResolutions.emplace_back(w, h);
+            }
+        } else if (key == "--pattern") {
+            options.mPatterns.clear();
+            for (const std::string& name : splitComma(value)) {
+                FrameGenerator::Pattern pattern;
+                if (!FrameGenerator::parsePattern(name, pattern)) return false;
+                options.mPatterns.push_back(pattern);
+            }
+        } else if (key == "--frames") {
+            options.mFrames = std::max(std::atoi(value.c_str()), 1);
+        } else if (key == "--machines") {
+            options.mMachines = std::max(std::atoi(value.c_str()), 1);
+        } else if (key == "--runs") {
+            options.mRuns = std::max(std::atoi(value.c_str()), 1);
+        } else if (key == "--seed") {
+            options.mSeed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--out") {
+            options.mOut = value;
+        } else {
+            return false;
+        }
+    }
+    return !options.mResolutions.empty() && !options.mPatterns.empty();
+}
+
+std::string
+toJson(const BenchOptions& options, const std::vector<CaseResult>& results)
+{
+    std::ostringstream ostr;
+    ostr << "{\n"
+         << "  \"benchmark\": \"grid_util_frame_transfer\",\n"
+         << "  \"params\": { \"frames\": " << options.mFrames
+         << ", \"machines\": " << options.mMachines
+         << ", \"runs\": " << options.mRuns
+         << ", \"seed\": " << options.mSeed << " },\n"
+         << "  \"cases\": [\n";
+    for (size_t caseId = 0; caseId < results.size(); ++caseId) {
+        const CaseResult& result = results[caseId];
+        ostr << "    {\n"
+             << "      \"width\": " << result.mWidth << ", \"height\": " << result.mHeight
+             << ", \"pattern\": \"" << result.mPattern << "\",\n"
+             << "      \"frame\": [\n";
+        for (size_t i = 0; i < result.mFrames.size(); ++i) {
+            const FrameStat& frameStat = result.mFrames[i];
+            const double frames = std::max(double(frameStat.mFrames), 1.0);
+            ostr << "        { \"precision\": \"" << frameStat.mPrecision << "\""
+                 << ", \"bytes_per_frame\": " << std::setprecision(12) << frameStat.mTotalBytes / frames
+                 << ", \"sec_per_frame\": " << std::setprecision(6) << frameStat.mTotalSec / frames << " }"
+                 << ((i + 1 < result.mFrames.size()) ? "," : "") << '\n';
+        }
+        ostr << "      ],\n"
+             << "      \"stages\": [\n";
+        for (size_t i = 0; i < result.mStages.size(); ++i) {
+            ostr << "        " << result.mStages[i].toJson()
+                 << ((i + 1 < result.mStages.size()) ? "," : "") << '\n';
+        }
+        ostr << "      ]\n"
+             << "    }" << ((caseId + 1 < results.size()) ? "," : "") << '\n';
+    }
+    ostr << "  ]\n"
+         << "}\n";
+    return ostr.str();
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+//
+// Frame transfer benchmark for grid_util. Covers the whole path of a progressive frame from
+// mcrt computation (snapshotDelta + PackTiles encode) to the merge computation (decode +
+// accumulateAllFbs) and the client (decode + untile/conv888 + extrapolation).
+// The JSON output is intended to be compared between releases.
+//
+{
+    BenchOptions options;
+    if (!parseCommandLine(argc, argv, options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<CaseResult> results;
+    for (const auto& reso : options.mResolutions) {
+        for (FrameGenerator::Pattern pattern : options.mPatterns) {
+            CaseResult result;
+            result.mWidth = reso.first;
+            result.mHeight = reso.second;
+            result.mPattern = FrameGenerator::showPattern(pattern);
+            std::cerr << "reso:" << result.mWidth << 'x' << result.mHeight
+                      << " pattern:" << result.mPattern << " ..." << std::flush;
+
+            const double sec = timeIt([&]() {
+                const FrameGenerator generator(reso.first, reso.second, pattern, options.mFrames, options.mSeed);
+                Fb renderFb;
+                generator.setupFb(renderFb, FrameGenerator::Buffers::ALL);
+
+                runFrames(options, generator, renderFb, result);
+                runUntile(options, renderFb, result);
+                runExtrapolate(options, reso.first, reso.second, pattern, result);
+                runAccumulate(options, reso.first, reso.second, pattern, result);
+            });
+            std::cerr << " done " << std::fixed << std::setprecision(2) << sec << " sec" << std::defaultfloat
+                      << '\n';
+            results.push_back(std::move(result));
+        }
+    }
+
+    const std::string json = toJson(options, results);
+    if (options.mOut.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream out(options.mOut.c_str());
+        out << json;
+        if (!out) {
+            std::cerr << "ERROR: could not write " << options.mOut << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
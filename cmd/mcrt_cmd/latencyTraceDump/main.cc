@@ -0,0 +1,81 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include <scene_rdl2/common/grid_util/LatencyTrace.h>
+
+#include <cstdlib> // EXIT_SUCCESS
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+void
+usage(const char* progName)
+{
+    std::cerr << "Usage : " << progName << " <traceFile> [-show] [-pair <fromKey> <toKey>]...\n"
+              << "Dump LatencyLog trace file created by LatencyTraceWriter.\n"
+              << "  -show                     : show every LatencyLog\n"
+              << "  -pair <fromKey> <toKey>   : latency histogram between 2 keys (e.g. -pair SEND_MSG RECV_PROGRESSIVEFRAME_END)\n"
+              << "                              default pairs are used when no -pair is given\n";
+}
+
+} // namespace
+
+int
+main(int ac, char** av)
+//
+// Shows latency percentile histograms (p50/p99/p999) of the key pairs across all the frames recorded
+// in the trace file.
+//
+{
+    using scene_rdl2::grid_util::LatencyItem;
+
+    if (ac < 2) {
+        usage(av[0]);
+        return EXIT_SUCCESS;
+    }
+
+    bool show = false;
+    scene_rdl2::grid_util::LatencyHistogramSet histograms;
+    for (int i = 2; i < ac; ++i) {
+        if (std::strcmp(av[i], "-show") == 0) {
+            show = true;
+        } else if (std::strcmp(av[i], "-pair") == 0 && i + 2 < ac) {
+            LatencyItem::Key from, to;
+            if (!LatencyItem::strToKey(av[i + 1], from) || !LatencyItem::strToKey(av[i + 2], to)) {
+                std::cerr << "Unknown LatencyItem key:" << av[i + 1] << " or " << av[i + 2] << '\n';
+                return EXIT_FAILURE;
+            }
+            histograms.addPair(from, to);
+            i += 2;
+        } else {
+            usage(av[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!histograms.getPairTotal()) histograms.addDefaultPairs();
+
+    scene_rdl2::grid_util::LatencyTraceReader reader;
+    std::string errorMsg;
+    if (!reader.open(av[1], errorMsg)) {
+        std::cerr << errorMsg << '\n';
+        return EXIT_FAILURE;
+    }
+
+    size_t total = 0;
+    while (reader.next()) {
+        if (show) {
+            std::cout << reader.getLog().show("") << '\n';
+            if (reader.hasUpstream()) std::cout << reader.getUpstream().show("") << '\n';
+        }
+        if (reader.hasUpstream()) {
+            histograms.add(reader.getUpstream(), reader.getLog());
+        } else {
+            histograms.add(reader.getLog());
+        }
+        ++total;
+    }
+
+    std::cout << "frame total:" << total << '\n' << histograms.show() << '\n';
+    return EXIT_SUCCESS;
+}
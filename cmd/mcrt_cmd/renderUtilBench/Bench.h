@@ -0,0 +1,56 @@
+// Copyright 2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <scene_rdl2/common/rec_time/RecTime.h>
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace bench {
+
+// Runs func once and returns the elapsed time in seconds.
+template <typename F>
+float
+timeIt(F&& func)
+{
+    scene_rdl2::rec_time::RecTime recTime;
+    recTime.start();
+    func();
+    return recTime.end();
+}
+
+// Best of the given number of runs, in seconds. setup() runs before each
+// measured run and is excluded from the timing.
+template <typename S, typename F>
+float
+timeBestOf(int runs, S&& setup, F&& func)
+{
+    float best = 0.0f;
+    for (int i = 0; i < runs; ++i) {
+        setup();
+        const float sec = timeIt(func);
+        if (i == 0 || sec < best) best = sec;
+    }
+    return best;
+}
+
+inline void
+showResult(const std::string& name, size_t count, float sec)
+{
+    std::cout << std::setw(40) << std::left << name
+              << " count:" << std::setw(10) << count << std::right
+              << " " << std::setw(10) << std::fixed << std::setprecision(3) << sec * 1000.0f << " ms"
+              << " " << std::setw(10) << std::setprecision(2)
+              << ((sec > 0.0f) ? (double)count / sec * 1.0e-6 : 0.0) << " M/sec\n";
+}
+
+// Each benchmark parses its own arguments (argv[0] is the benchmark name).
+int benchAtomicAccumulate(int argc, char** argv);
+int benchIndexableArray(int argc, char** argv);
+int benchLuaScriptRunner(int argc, char** argv);
+int benchRadixSort(int argc, char** argv);
+int benchReaderWriterMutex(int argc, char** argv);
+
+} // namespace bench
@@ -0,0 +1,101 @@
+// Copyright 2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "Bench.h"
+
+#include <scene_rdl2/common/math/Vec4.h>
+#include <scene_rdl2/render/util/AtomicAccumulate.h>
+#include <scene_rdl2/render/util/AtomicFloat.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using scene_rdl2::math::Vec4f;
+
+struct alignas(16) AtomicChannels
+{
+    std::atomic<float> mChannel[4];
+};
+
+// Runs threadCount threads which each add opsPerThread samples spread over
+// pixelCount pixels, and returns the elapsed seconds.
+template <typename F>
+float
+runContended(unsigned threadCount, size_t opsPerThread, unsigned pixelCount, F&& addFunc)
+{
+    return bench::timeIt([&]() {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                const Vec4f sample(1.0f, 0.5f, 0.25f, 1.0f);
+                unsigned pixel = t % pixelCount;
+                for (size_t i = 0; i < opsPerThread; ++i) {
+                    addFunc(pixel, sample);
+                    if (++pixel == pixelCount) pixel = 0;
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    });
+}
+
+} // namespace
+
+namespace bench {
+
+int
+benchAtomicAccumulate(int argc, char** argv)
+{
+    namespace util = scene_rdl2::util;
+
+    const unsigned threadCount = (argc > 1) ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+    const unsigned pixelCount = (argc > 2) ? std::atoi(argv[2]) : 4;
+    const size_t opsPerThread = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+    const size_t totalOps = opsPerThread * threadCount;
+
+    std::cout << "Vec4f accumulate benchmark, threads:" << threadCount
+              << " pixels:" << pixelCount << " (lower is more contended)\n";
+
+    {
+        std::vector<AtomicChannels> pixels(pixelCount);
+        for (auto& p : pixels) for (auto& c : p.mChannel) c = 0.0f;
+        showResult("per channel std::atomic<float>", totalOps,
+                   runContended(threadCount, opsPerThread, pixelCount, [&](unsigned i, const Vec4f& v) {
+                       pixels[i].mChannel[0].fetch_add(v.x, std::memory_order_relaxed);
+                       pixels[i].mChannel[1].fetch_add(v.y, std::memory_order_relaxed);
+                       pixels[i].mChannel[2].fetch_add(v.z, std::memory_order_relaxed);
+                       pixels[i].mChannel[3].fetch_add(v.w, std::memory_order_relaxed);
+                   }));
+    }
+    {
+        util::AtomicTileAccumBuffer<Vec4f> buffer(pixelCount, 1);
+        showResult("util::atomicAdd (128-bit CAS)", totalOps,
+                   runContended(threadCount, opsPerThread, pixelCount, [&](unsigned i, const Vec4f& v) {
+                       buffer.add(i, 0, v);
+                   }));
+    }
+    {
+        std::vector<Vec4f, scene_rdl2::alloc::AlignedAllocator<Vec4f, 16>> pixels(pixelCount, Vec4f(0.0f));
+        showResult("util::atomicAddLocked (striped)", totalOps,
+                   runContended(threadCount, opsPerThread, pixelCount, [&](unsigned i, const Vec4f& v) {
+                       util::atomicAddLocked(&pixels[i], v);
+                   }));
+    }
+    {
+        std::vector<Vec4f> pixels(pixelCount, Vec4f(0.0f));
+        std::mutex mutex;
+        showResult("std::mutex", totalOps,
+                   runContended(threadCount, opsPerThread, pixelCount, [&](unsigned i, const Vec4f& v) {
+                       std::lock_guard<std::mutex> lock(mutex);
+                       pixels[i] += v;
+                   }));
+    }
+
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,114 @@
+// Copyright 2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "Bench.h"
+
+#include <scene_rdl2/render/util/IndexableArray.h>
+
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Stand in for SceneObjectIndexable entries: distinct, 64 byte aligned pointers.
+struct alignas(64) FakeObject { char mPad[64]; };
+using Ptr = FakeObject*;
+
+// The previous IndexableArray layout (vector + node based multimap), kept here
+// only as a baseline for comparison.
+class NodeIndexableArray
+{
+public:
+    void reserve(size_t n) { mValues.reserve(n); mIndexMap.reserve(n); }
+    void push_back(Ptr p)
+    {
+        mIndexMap.emplace(std::hash<Ptr>()(p), static_cast<int32_t>(mValues.size()));
+        mValues.push_back(p);
+    }
+    bool contains(Ptr p) const
+    {
+        const auto range = mIndexMap.equal_range(std::hash<Ptr>()(p));
+        for (auto it = range.first; it != range.second; ++it) {
+            if (mValues[it->second] == p) return true;
+        }
+        return false;
+    }
+
+private:
+    std::unordered_multimap<size_t, int32_t> mIndexMap;
+    std::vector<Ptr> mValues;
+};
+
+bool
+contains(const scene_rdl2::IndexableArray<Ptr>& a, Ptr p)
+{
+    const auto range = a.equal_range(p);
+    return range.first != range.second;
+}
+
+} // namespace
+
+namespace bench {
+
+int
+benchIndexableArray(int argc, char** argv)
+{
+    const size_t count = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    constexpr int runs = 3;
+
+    // Only the addresses are used, no need to touch the memory.
+    std::vector<FakeObject> storage(count);
+    std::vector<Ptr> objects(count);
+    for (size_t i = 0; i < count; ++i) objects[i] = &storage[i];
+
+    // Lookups in a random order so that we're not just streaming the table.
+    std::vector<Ptr> queries(objects);
+    srand(1234);
+    for (size_t i = count; i > 1; --i) std::swap(queries[i - 1], queries[rand() % i]);
+
+    std::cout << "IndexableArray<SceneObject*> benchmark, best of " << runs << " runs\n";
+
+    {
+        NodeIndexableArray a;
+        showResult("node   push_back",
+                   count,
+                   timeBestOf(runs, [&]() { a = NodeIndexableArray(); },
+                              [&]() { for (Ptr p : objects) a.push_back(p); }));
+        showResult("node   reserve+push_back",
+                   count,
+                   timeBestOf(runs, [&]() { a = NodeIndexableArray(); },
+                              [&]() { a.reserve(count); for (Ptr p : objects) a.push_back(p); }));
+        size_t found = 0;
+        showResult("node   lookup",
+                   count,
+                   timeBestOf(runs, [&]() { found = 0; },
+                              [&]() { for (Ptr p : queries) found += a.contains(p); }));
+        if (found != count) std::cerr << "node lookup failed\n";
+    }
+
+    {
+        scene_rdl2::IndexableArray<Ptr> a;
+        showResult("flat   push_back",
+                   count,
+                   timeBestOf(runs, [&]() { a = scene_rdl2::IndexableArray<Ptr>(); },
+                              [&]() { for (Ptr p : objects) a.push_back(p); }));
+        showResult("flat   reserve+push_back",
+                   count,
+                   timeBestOf(runs, [&]() { a = scene_rdl2::IndexableArray<Ptr>(); },
+                              [&]() { a.reserve(count); for (Ptr p : objects) a.push_back(p); }));
+        showResult("flat   assign (bulk build)",
+                   count,
+                   timeBestOf(runs, [&]() { a = scene_rdl2::IndexableArray<Ptr>(); },
+                              [&]() { a.assign(objects.begin(), objects.end()); }));
+        size_t found = 0;
+        showResult("flat   lookup",
+                   count,
+                   timeBestOf(runs, [&]() { found = 0; },
+                              [&]() { for (Ptr p : queries) found += contains(a, p); }));
+        if (found != count) std::cerr << "flat lookup failed\n";
+    }
+
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,84 @@
+// Copyright 2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "Bench.h"
+
+#include <scene_rdl2/render/util/LuaScriptRunner.h>
+#include <scene_rdl2/render/util/LuaStatePool.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+// A script of the given number of function definitions, roughly like a small
+// configuration script with helpers.
+std::string
+makeScript(int funcCount)
+{
+    std::string code = "#!/usr/bin/env lua\n";
+    for (int i = 0; i < funcCount; ++i) {
+        const std::string id = std::to_string(i);
+        code += "function func" + id + "(a, b)\n"
+                "    local t = { a, b, " + id + " }\n"
+                "    for k, v in ipairs(t) do t[k] = v * 2 end\n"
+                "    return t[1] + t[2] + t[3]\n"
+                "end\n";
+    }
+    code += "result = func0(1, 2)\n";
+    return code;
+}
+
+} // namespace
+
+namespace bench {
+
+int
+benchLuaScriptRunner(int argc, char** argv)
+{
+    const int runCount = (argc > 1) ? std::atoi(argv[1]) : 1000;
+    const int funcCount = (argc > 2) ? std::atoi(argv[2]) : 100;
+    constexpr int runs = 3;
+
+    const std::string filename = "./benchLuaScriptRunner.lua";
+    {
+        std::ofstream ofs(filename, std::ios::binary);
+        ofs << makeScript(funcCount);
+    }
+
+    using scene_rdl2::util::LuaChunkCache;
+    using scene_rdl2::util::LuaScriptRunner;
+
+    // Per runFile() latency : new lua_State and compile every time (the old runFile()), then with the
+    // pooled lua_State, then also with the compiled chunk cache.
+    auto runFiles = [&]() {
+        for (int i = 0; i < runCount; ++i) {
+            LuaScriptRunner lua;
+            lua.runFile(filename);
+        }
+    };
+    auto show = [&](const std::string& name, float sec) {
+        showResult(name, runCount, sec);
+        std::cout << "    " << std::fixed << std::setprecision(2) << sec / (float)runCount * 1.0e6f
+                  << " us/runFile\n";
+    };
+
+    std::cout << "LuaScriptRunner::runFile() benchmark, " << funcCount << " functions, best of " << runs
+              << " runs\n";
+
+    LuaChunkCache::get().setCapacity(1024 * 1024, 0); // disabled
+    LuaScriptRunner::setStatePoolSize(0);
+    show("new state", timeBestOf(runs, []() {}, runFiles));
+
+    LuaScriptRunner::setStatePoolSize(4);
+    show("pooled state", timeBestOf(runs, []() {}, runFiles));
+
+    LuaChunkCache::get().setCapacity(1024 * 1024, 32 * 1024 * 1024); // default
+    show("pooled state + chunk cache", timeBestOf(runs, []() {}, runFiles));
+    std::cout << LuaChunkCache::get().show() << '\n';
+
+    std::remove(filename.c_str());
+    return 0;
+}
+
+} // namespace bench
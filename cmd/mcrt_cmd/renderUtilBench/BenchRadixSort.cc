@@ -0,0 +1,103 @@
+// Copyright 2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "Bench.h"
+
+#include <scene_rdl2/render/util/SortUtil.h>
+
+#include <tbb/task_arena.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct SortEntry
+{
+    uint32_t mKey;
+    uint32_t mPayload;
+};
+
+size_t
+getBlockSize(size_t count)
+{
+    // The serial inPlaceRadixSort32 needs two scratch copies of the input, the
+    // parallel sorts one copy plus the per chunk histograms.
+    const size_t required = 2 * count * sizeof(SortEntry) + (size_t(1) << 20);
+    size_t blockSize = DEFAULT_ARENA_BLOCK_SIZE;
+    while (blockSize < required) blockSize *= 2;
+    return blockSize;
+}
+
+} // namespace
+
+namespace bench {
+
+int
+benchRadixSort(int argc, char** argv)
+{
+    namespace alloc = scene_rdl2::alloc;
+    namespace util = scene_rdl2::util;
+
+    const size_t maxCount = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+    const int runs = (argc > 2) ? std::atoi(argv[2]) : 3;
+
+    std::cout << "radix sort benchmark, 8 byte entries, "
+              << tbb::this_task_arena::max_concurrency() << " threads, best of " << runs << " runs\n";
+
+    std::mt19937 rng(1234);
+    std::vector<SortEntry> source(maxCount);
+    for (size_t i = 0; i < maxCount; ++i) {
+        source[i].mKey = rng();
+        source[i].mPayload = uint32_t(i);
+    }
+    std::vector<SortEntry> elems(maxCount);
+
+    util::Ref<alloc::ArenaBlockPool> pool =
+        util::alignedMallocCtorArgs<alloc::ArenaBlockPool>(CACHE_LINE_SIZE, getBlockSize(maxCount), true);
+    alloc::Arena arena;
+    arena.init(pool.get());
+
+    for (size_t count = 1000; count <= maxCount; count *= 10) {
+        const unsigned n = unsigned(count);
+        auto reset = [&]() { std::copy(source.begin(), source.begin() + count, elems.begin()); };
+        auto check = [&](const char* name) {
+            if (!util::isSorted32<SortEntry, 0>(n, elems.data())) {
+                std::cerr << name << " failed to sort " << n << " elements\n";
+            }
+        };
+
+        const float stdSec = timeBestOf(runs, reset, [&]() {
+            std::stable_sort(elems.begin(), elems.begin() + count,
+                             [](const SortEntry& a, const SortEntry& b) { return a.mKey < b.mKey; });
+        });
+        check("std::stable_sort");
+        const float serialSec = timeBestOf(runs, reset, [&]() {
+            util::inPlaceRadixSort32<SortEntry>(n, elems.data(), &arena);
+        });
+        check("inPlaceRadixSort32");
+        const float lsdSec = timeBestOf(runs, reset, [&]() {
+            util::parallelInPlaceRadixSort32<SortEntry>(n, elems.data(), &arena);
+        });
+        check("parallelInPlaceRadixSort32");
+        const float msbSec = timeBestOf(runs, reset, [&]() {
+            util::parallelInPlaceRadixSortMSB32<SortEntry>(n, elems.data(), &arena);
+        });
+        check("parallelInPlaceRadixSortMSB32");
+
+        showResult("std::stable_sort", count, stdSec);
+        showResult("inPlaceRadixSort32", count, serialSec);
+        showResult("parallelInPlaceRadixSort32", count, lsdSec);
+        showResult("parallelInPlaceRadixSortMSB32", count, msbSec);
+        std::cout << "  fastest: "
+                  << ((std::min(lsdSec, msbSec) < serialSec) ?
+                      ((lsdSec < msbSec) ? "parallel LSD" : "parallel MSB") : "serial")
+                  << "\n";
+    }
+
+    arena.cleanUp();
+    return 0;
+}
+
+} // namespace bench
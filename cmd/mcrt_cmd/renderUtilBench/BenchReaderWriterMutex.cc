@@ -0,0 +1,80 @@
+// Copyright 2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "Bench.h"
+
+#include <scene_rdl2/render/util/DistributedReaderWriterMutex.h>
+#include <scene_rdl2/render/util/ReaderWriterMutex.h>
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Runs threadCount threads which each take opsPerThread locks on a small
+// shared table, one in every writeInterval of them exclusive (0 for read
+// only), and returns the elapsed seconds.
+template <typename Mutex, typename ReadLockType, typename WriteLockType>
+float
+runLocks(unsigned threadCount, size_t opsPerThread, unsigned writeInterval)
+{
+    Mutex mutex;
+    std::vector<int> table(64, 1);
+
+    return bench::timeIt([&]() {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                volatile int sink = 0;
+                for (size_t i = 0; i < opsPerThread; ++i) {
+                    if (writeInterval && (i % writeInterval) == 0) {
+                        WriteLockType lock(mutex);
+                        ++table[(t + i) & 63];
+                    } else {
+                        ReadLockType lock(mutex);
+                        sink = sink + table[(t + i) & 63];
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    });
+}
+
+} // namespace
+
+namespace bench {
+
+int
+benchReaderWriterMutex(int argc, char** argv)
+{
+    namespace util = scene_rdl2::util;
+
+    const unsigned maxThreads = (argc > 1) ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+    const unsigned writeInterval = (argc > 2) ? std::atoi(argv[2]) : 0;
+    const size_t opsPerThread = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+
+    std::cout << "Reader/writer lock benchmark, one write every " << writeInterval
+              << " locks (0 : read only)\n";
+
+    for (unsigned threadCount = 1; ; threadCount *= 2) {
+        if (threadCount > maxThreads) threadCount = maxThreads;
+        const size_t totalOps = opsPerThread * threadCount;
+        const std::string suffix = " threads:" + std::to_string(threadCount);
+
+        showResult("ReaderWriterMutex" + suffix, totalOps,
+                   runLocks<util::ReaderWriterMutex, util::ReadLock, util::WriteLock>
+                   (threadCount, opsPerThread, writeInterval));
+        showResult("DistributedReaderWriterMutex" + suffix, totalOps,
+                   runLocks<util::DistributedReaderWriterMutex,
+                            util::DistributedReaderWriterMutex::ReadLock,
+                            util::DistributedReaderWriterMutex::WriteLock>
+                   (threadCount, opsPerThread, writeInterval));
+
+        if (threadCount == maxThreads) break;
+    }
+
+    return 0;
+}
+
+} // namespace bench
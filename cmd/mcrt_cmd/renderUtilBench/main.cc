@@ -0,0 +1,57 @@
+// Copyright 2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "Bench.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+struct BenchEntry {
+    const char* mName;
+    int (*mFunc)(int argc, char** argv);
+    const char* mUsage;
+};
+
+const BenchEntry sBenchTable[] = {
+    { "atomicAccumulate", bench::benchAtomicAccumulate, "[threads(default all)] [pixels(default 4)] [opsPerThread(default 1000000)]" },
+    { "indexableArray", bench::benchIndexableArray, "[elemCount(default 10000000)]" },
+    { "luaScript", bench::benchLuaScriptRunner, "[runFileCount(default 1000)] [scriptFunctions(default 100)]" },
+    { "radixSort", bench::benchRadixSort, "[maxElemCount(default 100000000)] [runs(default 3)]" },
+    { "rwMutex", bench::benchReaderWriterMutex, "[maxThreads(default all)] [writeInterval(default 0:read only)] [opsPerThread(default 1000000)]" },
+};
+
+void
+usage(const char* progName)
+{
+    std::cerr << "Usage : " << progName << " <benchName> [options]\n";
+    for (const auto& entry : sBenchTable) {
+        std::cerr << "  " << entry.mName << " " << entry.mUsage << '\n';
+    }
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+//
+// Micro benchmarks for the render_util containers, allocators, sorts and Lua script runner.
+// These are not part of the unit tests; run them by hand before and after
+// changing the corresponding code.
+//
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        return 0;
+    }
+
+    for (const auto& entry : sBenchTable) {
+        if (std::strcmp(argv[1], entry.mName) == 0) {
+            return entry.mFunc(argc - 1, argv + 1);
+        }
+    }
+
+    std::cerr << "Unknown benchmark:" << argv[1] << '\n';
+    usage(argv[0]);
+    return 1;
+}
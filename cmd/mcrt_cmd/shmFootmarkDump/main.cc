@@ -2,21 +2,39 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <scene_rdl2/common/grid_util/ShmFootmark.h>
+#include <scene_rdl2/common/grid_util/ShmFootmarkLanes.h>
 
+#include <cstring>
+#include <exception>
 #include <iostream>
 
 int
 main(int ac, char** av)
 {
     if (ac < 2) {
-        std::cerr << "Usage : " << av[0] << " <shMemId>\n"
-                  << "Dump shared memory information created by ShmFootmark.\n";
+        std::cerr << "Usage : " << av[0] << " <shMemId> [-header]\n"
+                  << "Dump shared memory information created by ShmFootmark or ShmFootmarkLanes.\n"
+                  << "ShmFootmarkLanes records of all the threads are merged into a single timeline.\n"
+                  << "  -header : show ShmFootmarkLanes header and lane info only\n";
         return 0;
     }
 
     int shMemId = atoi(av[1]);
+    bool headerOnly = (ac > 2 && strcmp(av[2], "-header") == 0);
     std::cerr << "shMemId:" << shMemId << '\n';
 
+    try {
+        scene_rdl2::grid_util::ShmFootmarkLanesView lanesView(shMemId);
+        if (lanesView.isValid()) {
+            std::cerr << lanesView.showHeader() << '\n';
+            if (!headerOnly) std::cerr << lanesView.showTimeline() << '\n';
+            return 0;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
     scene_rdl2::grid_util::ShmFootmarkView footmarkView(shMemId);
     std::cerr << "[" << footmarkView.getAll() << "]\n";
 
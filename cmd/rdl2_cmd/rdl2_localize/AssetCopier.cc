@@ -0,0 +1,370 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "AssetCopier.h"
+
+#include <scene_rdl2/common/except/exceptions.h>
+#include <scene_rdl2/common/grid_util/Sha1Util.h>
+#include <scene_rdl2/render/util/Files.h>
+#include <scene_rdl2/render/util/Strings.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace scene_rdl2;
+
+namespace rdl2_localize {
+
+namespace {
+
+// Closes the file descriptor at the end of scope.
+struct FdGuard
+{
+    explicit FdGuard(int fd) : mFd(fd) {}
+    ~FdGuard() { if (mFd != -1) close(mFd); }
+    int mFd;
+};
+
+const size_t READ_CHUNK_SIZE = 1024 * 1024;
+
+bool
+readChunk(int fd, std::vector<char>& buffer, size_t& size)
+{
+    size = 0;
+    while (size < buffer.size()) {
+        ssize_t result = read(fd, buffer.data() + size, buffer.size() - size);
+        if (result == -1) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (result == 0) break;
+        size += result;
+    }
+    return true;
+}
+
+// Returns false if the file can't be read.
+bool
+hashFile(const std::string& path, grid_util::Sha1Util::Hash& hash)
+{
+    FdGuard fd(open(path.c_str(), O_RDONLY));
+    if (fd.mFd == -1) return false;
+
+    grid_util::Sha1Gen sha1;
+    sha1.init();
+    std::vector<char> buffer(READ_CHUNK_SIZE);
+    while (true) {
+        size_t size;
+        if (!readChunk(fd.mFd, buffer, size)) return false;
+        if (size == 0) break;
+        sha1.updateByteData(buffer.data(), size);
+    }
+    hash = sha1.finalize();
+    return true;
+}
+
+// Compares the contents, stops at the first difference.
+bool
+sameContents(const std::string& pathA, const std::string& pathB)
+{
+    FdGuard fdA(open(pathA.c_str(), O_RDONLY));
+    FdGuard fdB(open(pathB.c_str(), O_RDONLY));
+    if (fdA.mFd == -1 || fdB.mFd == -1) return false;
+
+    std::vector<char> bufferA(READ_CHUNK_SIZE);
+    std::vector<char> bufferB(READ_CHUNK_SIZE);
+    while (true) {
+        size_t sizeA, sizeB;
+        if (!readChunk(fdA.mFd, bufferA, sizeA) || !readChunk(fdB.mFd, bufferB, sizeB)) return false;
+        if (sizeA != sizeB || std::memcmp(bufferA.data(), bufferB.data(), sizeA) != 0) return false;
+        if (sizeA == 0) return true;
+    }
+}
+
+double
+secSince(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+AssetCopier::AssetCopier(unsigned maxInFlight, SkipMode skipMode, bool dedupe) :
+    mMaxInFlight(std::max(maxInFlight, 1u)),
+    mSkipMode(skipMode),
+    mDedupe(dedupe),
+    mPool(new ThreadPoolExecutor(mMaxInFlight))
+{
+}
+
+void
+AssetCopier::plan(const std::vector<FileCopy>& fileCopies,
+                  const std::set<std::string>& redirectable)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // Stat all the sources. On network storage this is mostly latency, so it
+    // is done in parallel as well.
+    std::vector<SrcInfo> srcInfos(fileCopies.size());
+    parallelFor(fileCopies.size(), [&](size_t id) {
+        struct stat statBuf;
+        if (stat(fileCopies[id].mSrcPath.c_str(), &statBuf) == 0 && S_ISREG(statBuf.st_mode)) {
+            SrcInfo& info = srcInfos[id];
+            info.mExists = true;
+            info.mDev = statBuf.st_dev;
+            info.mIno = statBuf.st_ino;
+            info.mSize = statBuf.st_size;
+        }
+    });
+
+    // Same file referenced by different paths (symlinks, hard links, "..").
+    std::vector<size_t> primaryIds;
+    std::map<std::pair<uint64_t, uint64_t>, size_t> inodeToId;
+    for (size_t id = 0; id < fileCopies.size(); ++id) {
+        if (!srcInfos[id].mExists) {
+            print(util::buildString("Failed to open '", fileCopies[id].mSrcPath, "': ",
+                                    "No such file"), true);
+            ++mMissingTotal;
+            continue;
+        }
+        const bool canRedirect = mDedupe && redirectable.count(fileCopies[id].mDestPath);
+        auto result = inodeToId.emplace(std::make_pair(srcInfos[id].mDev, srcInfos[id].mIno), id);
+        if (!canRedirect || result.second) {
+            primaryIds.push_back(id);
+        } else if (fileCopies[id].mDestPath != fileCopies[result.first->second].mDestPath) {
+            mRedirects[fileCopies[id].mDestPath] = fileCopies[result.first->second].mDestPath;
+            ++mDedupeInodeTotal;
+        }
+    }
+
+    // Different files with identical contents. Only the files which share
+    // their size with some other file need to be hashed.
+    if (mDedupe) {
+        std::map<uint64_t, std::vector<size_t>> sizeToIds;
+        for (size_t id : primaryIds) {
+            if (srcInfos[id].mSize > 0) sizeToIds[srcInfos[id].mSize].push_back(id);
+        }
+        std::vector<size_t> hashIds;
+        for (const auto& itr : sizeToIds) {
+            if (itr.second.size() > 1) hashIds.insert(hashIds.end(), itr.second.begin(), itr.second.end());
+        }
+
+        std::vector<grid_util::Sha1Util::Hash> hashes(hashIds.size());
+        std::vector<char> hashValid(hashIds.size(), 0);
+        parallelFor(hashIds.size(), [&](size_t i) {
+            hashValid[i] = hashFile(fileCopies[hashIds[i]].mSrcPath, hashes[i]);
+        });
+
+        std::map<std::pair<uint64_t, grid_util::Sha1Util::Hash>, size_t> contentToId;
+        std::vector<char> deduped(fileCopies.size(), 0);
+        for (size_t i = 0; i < hashIds.size(); ++i) {
+            if (!hashValid[i]) continue;
+            const size_t id = hashIds[i];
+            auto result = contentToId.emplace(std::make_pair(srcInfos[id].mSize, hashes[i]), id);
+            if (!result.second && redirectable.count(fileCopies[id].mDestPath)) {
+                mRedirects[fileCopies[id].mDestPath] = fileCopies[result.first->second].mDestPath;
+                deduped[id] = 1;
+                ++mDedupeContentTotal;
+            }
+        }
+        primaryIds.erase(std::remove_if(primaryIds.begin(), primaryIds.end(),
+                                        [&](size_t id) { return deduped[id]; }),
+                         primaryIds.end());
+    }
+
+    // An inode duplicate may point to a file which was then deduplicated by
+    // its contents. Resolve such chains so every redirect points to a copy.
+    for (auto& itr : mRedirects) {
+        auto next = mRedirects.find(itr.second);
+        while (next != mRedirects.end()) {
+            itr.second = next->second;
+            next = mRedirects.find(itr.second);
+        }
+    }
+
+    std::sort(primaryIds.begin(), primaryIds.end()); // keep the original order
+    mPlannedCopies.clear();
+    for (size_t id : primaryIds) {
+        mPlannedCopies.push_back(fileCopies[id]);
+    }
+
+    // Find the destinations which are already up to date. This is done here
+    // instead of copy(), so checkOverwrite() knows which existing files are
+    // expected.
+    mUpToDate.assign(mPlannedCopies.size(), 0);
+    if (mSkipMode != SkipMode::NONE) {
+        parallelFor(mPlannedCopies.size(), [&](size_t id) {
+            mUpToDate[id] = checkUpToDate(mPlannedCopies[id]);
+        });
+    }
+
+    mPlanSec = secSince(start);
+}
+
+void
+AssetCopier::checkOverwrite() const
+{
+    for (size_t id = 0; id < mPlannedCopies.size(); ++id) {
+        const FileCopy& fileCopy = mPlannedCopies[id];
+        if (!mUpToDate[id] && access(fileCopy.mDestPath.c_str(), F_OK) == 0) {
+            throw except::IoError(util::buildString("Destination file '",
+                    fileCopy.mDestPath, "' already exists. (Copying from '",
+                    fileCopy.mSrcPath, "'.) Use --force to overwrite."));
+        }
+    }
+}
+
+void
+AssetCopier::copy()
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // Write test all the files we're going to copy, before copying anything.
+    std::vector<char> writable(mPlannedCopies.size(), 0);
+    parallelFor(mPlannedCopies.size(), [&](size_t id) {
+        writable[id] = util::writeTest(mPlannedCopies[id].mDestPath, true);
+    });
+    for (size_t id = 0; id < mPlannedCopies.size(); ++id) {
+        if (!writable[id]) {
+            throw except::IoError(util::buildString("Can't write file '",
+                    mPlannedCopies[id].mDestPath, "'."));
+        }
+    }
+
+    parallelFor(mPlannedCopies.size(), [&](size_t id) {
+        const FileCopy& fileCopy = mPlannedCopies[id];
+        if (mUpToDate[id]) {
+            ++mSkippedTotal;
+            return;
+        }
+
+        // copyFile will throw if the source file can't be read, in which case
+        // we print out the error and continue.
+        try {
+            print(util::buildString("Copying ", fileCopy.mSrcPath, "\n"
+                                    "     to ", fileCopy.mDestPath));
+            util::copyFile(fileCopy.mSrcPath, fileCopy.mDestPath);
+
+            // Keep the source modification time for the size + mtime check.
+            struct stat statBuf;
+            if (stat(fileCopy.mSrcPath.c_str(), &statBuf) == 0) {
+                struct timespec times[2];
+                times[0].tv_sec = 0;
+                times[0].tv_nsec = UTIME_OMIT; // atime
+                times[1] = statBuf.st_mtim;
+                utimensat(AT_FDCWD, fileCopy.mDestPath.c_str(), times, 0);
+                mCopiedBytes += statBuf.st_size;
+            }
+            ++mCopiedTotal;
+        }
+        catch (const except::IoError& e) {
+            print(e.what(), true);
+            ++mFailedTotal;
+        }
+    });
+
+    mCopySec = secSince(start);
+}
+
+const std::string&
+AssetCopier::getRedirect(const std::string& destPath) const
+{
+    auto itr = mRedirects.find(destPath);
+    return (itr == mRedirects.end()) ? destPath : itr->second;
+}
+
+void
+AssetCopier::redirectAttrValue(const std::string& destPrefix, std::string& value) const
+{
+    const bool relative = (value.empty() || value[0] != '/');
+    const std::string destPath = attrValueToDestPath(destPrefix, value);
+    const std::string& redirect = getRedirect(destPath);
+    if (redirect == destPath) return;
+
+    if (relative && redirect.compare(0, destPrefix.size(), destPrefix) == 0) {
+        value = redirect.substr(destPrefix.size());
+    } else {
+        value = redirect;
+    }
+}
+
+// static function
+std::string
+AssetCopier::attrValueToDestPath(const std::string& destPrefix, const std::string& value)
+{
+    return (value.empty() || value[0] != '/') ? destPrefix + value : value;
+}
+
+std::string
+AssetCopier::showStats() const
+{
+    std::ostringstream ostr;
+    ostr << "Asset copy (in flight:" << mMaxInFlight << ")\n"
+         << "     planned " << mPlannedCopies.size() << " files (" << mPlanSec << " sec)\n"
+         << "      copied " << mCopiedTotal << " files, " << mCopiedBytes << " bytes ("
+         << mCopySec << " sec)\n"
+         << "     skipped " << mSkippedTotal << " unchanged files\n"
+         << "     deduped " << mDedupeInodeTotal << " same files, "
+         << mDedupeContentTotal << " identical contents\n"
+         << "      failed " << mFailedTotal << " copies, " << mMissingTotal << " missing sources";
+    return ostr.str();
+}
+
+// static function
+bool
+AssetCopier::parseSkipMode(const std::string& str, SkipMode& skipMode)
+{
+    if (str == "none") skipMode = SkipMode::NONE;
+    else if (str == "mtime") skipMode = SkipMode::SIZE_MTIME;
+    else if (str == "content") skipMode = SkipMode::CONTENT;
+    else return false;
+    return true;
+}
+
+void
+AssetCopier::parallelFor(size_t total, const std::function<void(size_t)>& func)
+{
+    for (size_t id = 0; id < total; ++id) {
+        mPool->run([&func, id] { func(id); });
+    }
+    mPool->wait();
+}
+
+bool
+AssetCopier::checkUpToDate(const FileCopy& fileCopy) const
+{
+    if (mSkipMode == SkipMode::NONE) return false;
+
+    struct stat srcStat, destStat;
+    if (stat(fileCopy.mSrcPath.c_str(), &srcStat) != 0 ||
+        stat(fileCopy.mDestPath.c_str(), &destStat) != 0) {
+        return false;
+    }
+    if (srcStat.st_size != destStat.st_size) return false;
+
+    if (mSkipMode == SkipMode::SIZE_MTIME) {
+        return (srcStat.st_mtim.tv_sec == destStat.st_mtim.tv_sec &&
+                srcStat.st_mtim.tv_nsec == destStat.st_mtim.tv_nsec);
+    }
+    return sameContents(fileCopy.mSrcPath, fileCopy.mDestPath);
+}
+
+void
+AssetCopier::print(const std::string& msg, bool error) const
+{
+    std::lock_guard<std::mutex> lock(mPrintMutex);
+    (error ? std::cerr : std::cout) << msg << std::endl;
+}
+
+} // namespace rdl2_localize
+
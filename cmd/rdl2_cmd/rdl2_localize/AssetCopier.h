@@ -0,0 +1,128 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include "PathTree.h"
+
+#include <scene_rdl2/render/util/ThreadPoolExecutor.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace rdl2_localize {
+
+/**
+ * Copies the asset files of a localized scene with multiple copies in flight.
+ *
+ * plan() stats all the source files in parallel and detects sources which
+ * are the same file (same device and inode, e.g. symlinks or hard links) or
+ * have identical contents (same size and same SHA1). Each group of identical
+ * sources is copied only once, to the destination of the first FileCopy of
+ * the group, and the other redirectable destinations are redirected to it
+ * (see getRedirect()). Missing source files are reported and dropped.
+ *
+ * plan() also classifies the destinations which are already up to date,
+ * by comparing size and modification time, or size and contents. copy()
+ * skips them. checkOverwrite() rejects any other existing destination, so
+ * the skip mode never silently overwrites a file which differs.
+ *
+ * copy() write tests all the planned destinations, then copies them. Copied
+ * files get the modification time of the source, so the size + mtime check
+ * works for the next run.
+ */
+class AssetCopier
+{
+public:
+    enum class SkipMode
+    {
+        NONE,       // always copy
+        SIZE_MTIME, // skip if the destination has the same size and mtime
+        CONTENT     // skip if the destination has the same size and contents
+    };
+
+    AssetCopier(unsigned maxInFlight, SkipMode skipMode, bool dedupe);
+
+    // Stats the sources and deduplicates them. Only the destinations in
+    // redirectable can be redirected, since the others (e.g. the expanded
+    // motion sample and UDIM files) are not referenced by their own path.
+    void plan(const std::vector<FileCopy>& fileCopies,
+              const std::set<std::string>& redirectable);
+
+    // FileCopies which are actually copied by copy(), unless up to date.
+    const std::vector<FileCopy>& getPlannedCopies() const { return mPlannedCopies; }
+
+    // True if plan() found the destination of getPlannedCopies()[plannedId]
+    // already up to date. Always false if the skip mode is NONE.
+    bool isUpToDate(size_t plannedId) const { return mUpToDate[plannedId]; }
+
+    // Throws except::IoError if the destination of a planned copy already
+    // exists and is not up to date. Used unless overwriting is forced.
+    void checkOverwrite() const;
+
+    // Copies all the planned files which are not up to date. Throws
+    // except::IoError if any destination is not writable, before copying
+    // anything.
+    void copy();
+
+    // Returns the destination path which really has the contents of the given
+    // destination path. (Same path if the destination is not deduplicated.)
+    const std::string& getRedirect(const std::string& destPath) const;
+
+    // Points the attribute value to the copy of a deduplicated destination.
+    // The value is either absolute or relative to destPrefix, and a relative
+    // value stays relative if the redirect is inside destPrefix.
+    void redirectAttrValue(const std::string& destPrefix, std::string& value) const;
+
+    // The destination path of the attribute value.
+    static std::string attrValueToDestPath(const std::string& destPrefix, const std::string& value);
+
+    std::string showStats() const;
+
+    static bool parseSkipMode(const std::string& str, SkipMode& skipMode);
+
+private:
+    struct SrcInfo
+    {
+        bool mExists {false};
+        uint64_t mDev {0};
+        uint64_t mIno {0};
+        uint64_t mSize {0};
+    };
+
+    void parallelFor(size_t total, const std::function<void(size_t)>& func);
+    bool checkUpToDate(const FileCopy& fileCopy) const;
+    void print(const std::string& msg, bool error = false) const; // MTsafe
+
+    unsigned mMaxInFlight;
+    SkipMode mSkipMode;
+    bool mDedupe;
+    std::unique_ptr<scene_rdl2::ThreadPoolExecutor> mPool;
+
+    std::vector<FileCopy> mPlannedCopies;
+    std::vector<char> mUpToDate; // same index as mPlannedCopies
+    std::map<std::string, std::string> mRedirects; // deduplicated destination -> copied destination
+
+    mutable std::mutex mPrintMutex;
+
+    size_t mMissingTotal {0};
+    size_t mDedupeInodeTotal {0};
+    size_t mDedupeContentTotal {0};
+    std::atomic<size_t> mCopiedTotal {0};
+    std::atomic<uint64_t> mCopiedBytes {0};
+    std::atomic<size_t> mSkippedTotal {0};
+    std::atomic<size_t> mFailedTotal {0};
+    double mPlanSec {0.0};
+    double mCopySec {0.0};
+};
+
+} // namespace rdl2_localize
+
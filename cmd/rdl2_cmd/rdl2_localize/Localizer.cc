@@ -18,6 +18,7 @@
 #include <iostream>
 #include <climits>
 #include <map>
+#include <set>
 #include <string>
 #include <stdlib.h>
 #include <unistd.h>
@@ -27,10 +28,14 @@ using namespace scene_rdl2;
 
 namespace rdl2_localize {
 
-Localizer::Localizer(bool forceOverwrite, bool relativePaths, std::string& dsoPath) :
+Localizer::Localizer(bool forceOverwrite, bool relativePaths, std::string& dsoPath,
+                     unsigned copyJobs, AssetCopier::SkipMode skipMode, bool dedupe) :
     mForceOverwrite(forceOverwrite),
     mRelativePaths(relativePaths),
-    mDsoPath(dsoPath)
+    mDsoPath(dsoPath),
+    mCopyJobs(copyJobs),
+    mSkipMode(skipMode),
+    mDedupe(dedupe)
 {
 }
 
@@ -96,6 +101,16 @@ Localizer::localize(const std::string& inFile, const std::string& outFile)
     // Generate the list of attribute updates that need to be done.
     auto attrUpdates = pathTree.getAttrUpdates(destPrefix, mRelativePaths);
 
+    // Stat the sources and find the identical ones, so each of them is only
+    // copied once. Only the files referenced directly by an attribute can be
+    // redirected to the copy of another one.
+    std::set<std::string> redirectable;
+    for (const auto& update : attrUpdates) {
+        redirectable.insert(AssetCopier::attrValueToDestPath(destPrefix, update.mValue));
+    }
+    AssetCopier copier(mCopyJobs, mSkipMode, mDedupe);
+    copier.plan(fileCopies, redirectable);
+
     // Unless we're force overwriting destination files, make sure that none
     // of them exist.
     if (!mForceOverwrite) {
@@ -105,41 +120,20 @@ Localizer::localize(const std::string& inFile, const std::string& outFile)
                     outFile, "' already exists. Use --force to overwrite."));
         }
 
-        // The asset files we're going to copy.
-        for (const auto& fileCopy : fileCopies) {
-            if (access(fileCopy.mDestPath.c_str(), F_OK) == 0) {
-                throw except::IoError(util::buildString("Destination file '",
-                        fileCopy.mDestPath, "' already exists. (Copying from '",
-                        fileCopy.mSrcPath, "'.) Use --force to overwrite."));
-            }
-        }
+        // The asset files we're going to copy. Only the ones which are
+        // already up to date (see AssetCopier::SkipMode) may exist.
+        copier.checkOverwrite();
     }
 
-    // Write test all the files we're going to copy.
-    for (const auto& fileCopy : fileCopies) {
-        if (!util::writeTest(fileCopy.mDestPath, true)) {
-            throw except::IoError(util::buildString("Can't write file '",
-                    fileCopy.mDestPath, "'."));
-        }
-    }
-
-    // Copy the assets. We know the directory exists and is writable because
-    // we did a util::writeTest() at the very beginning of this function.
-    for (const auto& fileCopy : fileCopies) {
-        // copyFile will throw if the source file doesn't exist, in which case
-        // we print out the missing file and continue.
-        try {
-            std::cout << "Copying " << fileCopy.mSrcPath << "\n"
-                         "     to " << fileCopy.mDestPath << std::endl;
-            util::copyFile(fileCopy.mSrcPath, fileCopy.mDestPath);
-        }
-        catch (const except::IoError &e) {
-            std::cerr << e.what() << std::endl;
-        }
-    }
+    // Write test and copy the assets. We know the directory exists and is
+    // writable because we did a util::writeTest() at the very beginning of
+    // this function.
+    copier.copy();
+    std::cout << copier.showStats() << std::endl;
 
     // Update the attribute values.
-    for (const auto& update : attrUpdates) {
+    for (auto& update : attrUpdates) {
+        copier.redirectAttrValue(destPrefix, update.mValue);
         std::cout << "Updating " << update.mSceneObject->getName() << "\n"
                      "    attr " << update.mAttribute->getName() << "\n"
                      "      to " << update.mValue << std::endl;
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "AssetCopier.h"
+
 #include <scene_rdl2/scene/rdl2/rdl2.h>
 
 #include <set>
@@ -26,9 +28,13 @@ class Localizer
 {
 public:
     /**
-     * Create a new localizer.
+     * Create a new localizer. Up to copyJobs asset copies are in flight at
+     * the same time. See AssetCopier for skipMode and dedupe.
      */
-    Localizer(bool forceOverwrite, bool relativePaths, std::string& dsoPath);
+    Localizer(bool forceOverwrite, bool relativePaths, std::string& dsoPath,
+              unsigned copyJobs = 1,
+              AssetCopier::SkipMode skipMode = AssetCopier::SkipMode::NONE,
+              bool dedupe = false);
 
     /**
      * Localize the given RDL2 input file, copying all its dependent assets
@@ -47,6 +53,16 @@ private:
     
     // The dso search path. If set, we passed in -dso_path on the command line.
     std::string& mDsoPath;
+
+    // Number of asset copies in flight at the same time.
+    unsigned mCopyJobs;
+
+    // How to detect destination files which are already up to date. Existing
+    // destination files are not an error if they are up to date.
+    AssetCopier::SkipMode mSkipMode;
+
+    // If true, identical source files are copied only once.
+    bool mDedupe;
 };
 
 } // namespace rdl2_localize
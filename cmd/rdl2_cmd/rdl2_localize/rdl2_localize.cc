@@ -44,6 +44,15 @@ int main(int argc, char* argv[])
             "Output file (.rdla | .rdlb)")
         ("force,f", "Force overwriting of destination files.")
         ("relative,r", "Use relative paths in the output RDL file.")
+        ("jobs,j", po::value<unsigned>()->default_value(8),
+            "Number of asset file copies in flight at the same time.")
+        ("skip-unchanged", po::value<std::string>()->default_value("none"),
+            "Skip destination files which are already up to date: none, "
+            "mtime (same size and modification time) or content (same size "
+            "and contents). Existing destination files which are up to "
+            "date are not an error without --force.")
+        ("no-dedupe", "Copy identical source files to each of their "
+            "destinations instead of copying them once.")
         ("dso_path,d", po::value<std::string>(),
             "The path to the dsos"); // dummy to please boost, will parse below
 
@@ -54,6 +63,7 @@ int main(int argc, char* argv[])
 
     // Parse the command line.
     std::string dsoPath;
+    rdl2_localize::AssetCopier::SkipMode skipMode;
     po::variables_map varsMap;
     try {
         po::store(po::command_line_parser(argc, argv).options(optionsDesc)
@@ -73,6 +83,11 @@ int main(int argc, char* argv[])
         }
         
         po::notify(varsMap);
+
+        if (!rdl2_localize::AssetCopier::parseSkipMode(varsMap["skip-unchanged"].as<std::string>(),
+                                                       skipMode)) {
+            throw po::invalid_option_value(varsMap["skip-unchanged"].as<std::string>());
+        }
     } catch (po::error& e) {
         // Something went wrong while parsing the options. Print the error
         // message and a usage message.
@@ -85,7 +100,10 @@ int main(int argc, char* argv[])
         // Create a localizer and localize the file.
         rdl2_localize::Localizer localizer(varsMap.count("force"),
                                            varsMap.count("relative"),
-                                           dsoPath);
+                                           dsoPath,
+                                           varsMap["jobs"].as<unsigned>(),
+                                           skipMode,
+                                           !varsMap.count("no-dedupe"));
         localizer.localize(varsMap["in"].as<std::string>(),
                            varsMap["out"].as<std::string>());
     } catch (std::exception& e) {
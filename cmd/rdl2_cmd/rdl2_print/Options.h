@@ -1,6 +1,8 @@
 // Copyright 2023-2024 DreamWorks Animation LLC
 // SPDX-License-Identifier: Apache-2.0
 
+#pragma once
+
 #include <scene_rdl2/scene/rdl2/rdl2.h>
 
 #include <functional>
@@ -17,12 +19,20 @@ struct Options
     std::unique_ptr<SceneClassFilter>   sceneClassFilter;
     std::unique_ptr<SceneObjectFilter>  sceneObjectFilter;
 
+    // Names given by --class and --object, to filter .rdlb records by their
+    // header before decoding them in stream mode.
+    std::vector<std::string> sceneClassNames;
+    std::vector<std::string> sceneObjectNames;
+
     std::vector<std::string> dsoPaths;
     std::vector<std::string> rdl2Files;
 
     bool alphabetize{true};
     bool showAttrs{true};
     bool comments{true};
+    bool stream{false};
+    unsigned jobs{0}; // stream mode formatting threads, 0 : hardware concurrency
+    size_t memoryTop{0}; // > 0 : print a memory report of this many entries per table
 };
 
 
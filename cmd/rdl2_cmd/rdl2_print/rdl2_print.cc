@@ -2,7 +2,9 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "printers.h"
+#include "streamPrinter.h"
 
+#include <scene_rdl2/render/util/Files.h>
 #include <scene_rdl2/scene/rdl2/rdl2.h>
 
 #include <algorithm>
@@ -49,6 +51,18 @@ getUsageMessage(const std::string& programName)
     stream << "    " << std::setw(20) << std::left << "--no-sort"       << std::setw(28) << std::left << ""                     << "Do not sort the classes and attributes alphabetically.\n";
     stream << '\n';
 
+    stream << "Streaming options:\n";
+    stream << "    " << std::setw(20) << std::left << "--stream"        << std::setw(28) << std::left << ""                     << "Print .rdlb SceneObjects record by record in file order, without loading the whole scene. "
+                                                                                                                                   "Class and object filters skip records before decoding. Each file is printed on its own, "
+                                                                                                                                   "so an object split over .rdla and .rdlb is printed once per file.\n";
+    stream << "    " << std::setw(20) << std::left << "-j, --jobs"      << std::setw(28) << std::left << "<count>"              << "Number of threads formatting records in stream mode. (default: number of cores)\n";
+    stream << '\n';
+
+    stream << "Memory options:\n";
+    stream << "    " << std::setw(20) << std::left << "--memory"        << std::setw(28) << std::left << "<count>"              << "Print the memory held by the attribute values of the loaded scene instead of its SceneObjects, "
+                                                                                                                                   "with the <count> biggest SceneClasses, SceneObjects and attributes.\n";
+    stream << '\n';
+
     stream << "Examples:\n";
     stream << "    " << "# print all available SceneClasses (found in RDL2_DSO_PATH) with attributes, comments and default values\n";
     stream << "    " << programName << '\n';
@@ -71,6 +85,12 @@ getUsageMessage(const std::string& programName)
     stream << "    " << "# print contents of an existing RDL2 scene, but listing only instances of a particular SceneClass and only certain Attributes\n";
     stream << "    " << programName << " -f scene.rdla -c RenderOutput -a file_name -a checkpoint_file_name -a resume_file_name\n";
     stream << '\n';
+    stream << "    " << "# print the meshes of a huge binary scene without loading all of it into memory\n";
+    stream << "    " << programName << " -f scene.rdlb -c RdlMeshGeometry --stream\n";
+    stream << '\n';
+    stream << "    " << "# find the 20 biggest SceneClasses, SceneObjects and attributes of a scene\n";
+    stream << "    " << programName << " -f scene.rdla -f scene.rdlb --memory 20\n";
+    stream << '\n';
     return stream.str();
 }
 
@@ -122,9 +142,25 @@ parseCommandLine(int argc, char* argv[])
             options.alphabetize = false;
             ++index; continue;
         }
+        if (strcmp(argv[index], "--stream") == 0) {
+            options.stream = true;
+            ++index; continue;
+        }
+        if (strcmp(argv[index], "-j") == 0 ||
+            strcmp(argv[index], "--jobs") == 0) {
+            options.jobs = std::strtoul(argv[index+1], nullptr, 10);
+            ++index; ++index; continue;
+        }
+        if (strcmp(argv[index], "--memory") == 0) {
+            options.memoryTop = std::strtoul(argv[index+1], nullptr, 10);
+            ++index; ++index; continue;
+        }
         ++index;
     }
 
+    options.sceneClassNames = sceneClasses;
+    options.sceneObjectNames = sceneObjects;
+
     // Create filter for Attributes?
     if (!attributes.empty()) {
         auto filter = [=](const rdl2::Attribute& attr) {
@@ -269,20 +305,7 @@ int main(int argc, char* argv[])
     Options options = parseCommandLine(argc, argv);
 
     rdl2::SceneContext context;
-
-    // Use proxy mode. We only need the attribute declarations, and the proxy
-    // DSOs are much, much faster to open.
-    context.setProxyModeEnabled(true);
-
-    // append any additional DSO paths
-    if (!options.dsoPaths.empty()) {
-        std::string newPath = context.getDsoPath();
-        for (const auto &p : options.dsoPaths) {
-            newPath += ":" + p;
-        }
-
-       context.setDsoPath(newPath);
-    }
+    setupContext(context, options);
 
     try {
         if (options.rdl2Files.empty()) {
@@ -290,15 +313,31 @@ int main(int argc, char* argv[])
             context.loadAllSceneClasses();
             printSceneClasses(context,
                               options);
-        } else {
-            // Load the requested RDL2 files
+        } else if (options.stream) {
+            // Stream the binary files, the others are loaded and printed one
+            // at a time.
             for (const auto& f : options.rdl2Files) {
-                rdl2::readSceneFromFile(f, context);
+                if (util::lowerCaseExtension(f) == "rdlb") {
+                    printSceneObjectsStreamed(f, options, std::cout);
+                } else {
+                    rdl2::SceneContext fileContext;
+                    setupContext(fileContext, options);
+                    rdl2::readSceneFromFile(f, fileContext);
+                    printSceneObjects(fileContext,
+                                      options);
+                }
+            }
+        } else {
+            // Load the requested RDL2 files, in order
+            rdl2::readScenesFromFiles(options.rdl2Files, context);
+
+            if (options.memoryTop > 0) {
+                std::cout << context.getMemoryReport().show(options.memoryTop) << '\n';
+            } else {
+                // Print the SceneObjects
+                printSceneObjects(context,
+                                  options);
             }
-
-            // Print the SceneObjects
-            printSceneObjects(context,
-                              options);
         }
     } catch (std::exception& e) {
         std::cerr << "ERROR: " << e.what() << '\n';
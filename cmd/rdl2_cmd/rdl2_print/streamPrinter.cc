@@ -0,0 +1,156 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "streamPrinter.h"
+#include "printers.h"
+
+#include <scene_rdl2/common/except/exceptions.h>
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace scene_rdl2;
+
+void
+setupContext(rdl2::SceneContext& ctx,
+             const Options& options)
+{
+    // Use proxy mode. We only need the attribute declarations, and the proxy
+    // DSOs are much, much faster to open.
+    ctx.setProxyModeEnabled(true);
+
+    // append any additional DSO paths
+    if (!options.dsoPaths.empty()) {
+        std::string newPath = ctx.getDsoPath();
+        for (const auto &p : options.dsoPaths) {
+            newPath += ":" + p;
+        }
+
+       ctx.setDsoPath(newPath);
+    }
+}
+
+namespace {
+
+// Decoding creates SceneClasses, which is not safe to do concurrently, so
+// only the formatting runs in parallel. Constructing and destroying a
+// SceneContext isn't safe either (the SceneVariables declaration writes static
+// AttributeKeys, the destructor closes the DSOs), so they are serialized too.
+std::mutex sDecodeMutex;
+
+// Owns a SceneContext which is constructed and destroyed under sDecodeMutex.
+class LockedSceneContext
+{
+public:
+    explicit LockedSceneContext(const Options& options)
+    {
+        std::lock_guard<std::mutex> lock(sDecodeMutex);
+        mContext.reset(new rdl2::SceneContext);
+        setupContext(*mContext, options);
+    }
+
+    ~LockedSceneContext()
+    {
+        std::lock_guard<std::mutex> lock(sDecodeMutex);
+        mContext.reset();
+    }
+
+    rdl2::SceneContext& get() { return *mContext; }
+
+private:
+    std::unique_ptr<rdl2::SceneContext> mContext;
+};
+
+// Decodes the records into a SceneContext of their own and formats them.
+// Everything decoded is freed on return.
+std::string
+formatRecords(const std::vector<std::string>& records,
+              const Options& options)
+{
+    LockedSceneContext ctx(options);
+
+    std::vector<const rdl2::SceneObject*> array;
+    {
+        std::lock_guard<std::mutex> lock(sDecodeMutex);
+        rdl2::BinaryReader reader(ctx.get());
+        for (const auto& record : records) {
+            const rdl2::SceneObject* obj = reader.fromRecord(record);
+            if (obj) {
+                array.push_back(obj);
+            }
+        }
+    }
+
+    // The records were filtered by name already.
+    std::string str;
+    for (const rdl2::SceneObject* obj : array) {
+        str += getSceneInfoStr(*obj, options);
+    }
+    return str;
+}
+
+} // namespace
+
+void
+printSceneObjectsStreamed(const std::string& filePath,
+                          const Options& options,
+                          std::ostream& out)
+{
+    constexpr size_t BATCH_RECORDS = 256;
+    constexpr size_t BATCH_BYTES = 16 * 1024 * 1024;
+
+    std::ifstream in(filePath.c_str(), std::ios::binary);
+    if (!in) {
+        throw except::IoError("Could not open file '" + filePath + "' for reading.");
+    }
+
+    const unsigned jobs = options.jobs ? options.jobs : std::max(std::thread::hardware_concurrency(), 1u);
+    std::deque<std::future<std::string>> inFlight;
+    std::vector<std::string> batch;
+    size_t batchBytes = 0;
+
+    auto flushBatch = [&]() {
+        if (batch.empty()) {
+            return;
+        }
+        if (inFlight.size() >= jobs) {
+            out << inFlight.front().get();
+            inFlight.pop_front();
+        }
+        inFlight.push_back(std::async(std::launch::async, formatRecords,
+                                      std::move(batch), std::cref(options)));
+        batch.clear();
+        batchBytes = 0;
+    };
+
+    auto filter = [&](const std::string& className, const std::string& objectName) {
+        const auto& classNames = options.sceneClassNames;
+        const auto& objectNames = options.sceneObjectNames;
+        return (classNames.empty() ||
+                std::find(classNames.begin(), classNames.end(), className) != classNames.end()) &&
+               (objectNames.empty() ||
+                std::find(objectNames.begin(), objectNames.end(), objectName) != objectNames.end());
+    };
+
+    rdl2::BinaryReader::streamRecords(in, filter, [&](std::string&& record) {
+        batchBytes += record.size();
+        batch.push_back(std::move(record));
+        if (batch.size() >= BATCH_RECORDS || batchBytes >= BATCH_BYTES) {
+            flushBatch();
+        }
+    });
+    flushBatch();
+
+    while (!inFlight.empty()) {
+        out << inFlight.front().get();
+        inFlight.pop_front();
+    }
+}
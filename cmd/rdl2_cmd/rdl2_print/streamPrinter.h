@@ -0,0 +1,22 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include "Options.h"
+
+#include <scene_rdl2/scene/rdl2/rdl2.h>
+
+#include <ostream>
+#include <string>
+
+// Sets up a SceneContext for printing : proxy mode and the additional DSO paths.
+void setupContext(scene_rdl2::rdl2::SceneContext& ctx, const Options& options);
+
+// Prints the SceneObjects of a .rdlb file as the records are read. Batches of
+// records are decoded into SceneContexts of their own and formatted by up to
+// options.jobs threads, and printed in file order, so memory use is bounded by
+// the batches in flight.
+void printSceneObjectsStreamed(const std::string& filePath, const Options& options,
+                               std::ostream& out);
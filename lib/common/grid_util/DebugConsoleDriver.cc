@@ -4,9 +4,13 @@
 //
 //
 #include "DebugConsoleDriver.h"
+#include "MetricsRegistry.h"
 
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
-#include <unistd.h>
+#include <sstream>
 
 namespace scene_rdl2 {
 namespace grid_util {
@@ -27,6 +31,9 @@ DebugConsoleDriver::initialize(unsigned short port)
     }
 
     parserConfigure(mParser);
+    parserConfigureStream();
+    parserConfigureMetrics();
+    parserConfigureTimeLap();
 
     // open telnet server
     // If you set port as 0, kernel find available port for you.
@@ -52,6 +59,7 @@ DebugConsoleDriver::initialize(unsigned short port)
 DebugConsoleDriver::~DebugConsoleDriver()
 {
     mThreadShutdown = true; // This is the only place mThreadShutdown is set to true
+    mTlSvr.wakeup();
     if (mThread.joinable()) {
         mThread.join();
     }
@@ -60,7 +68,36 @@ DebugConsoleDriver::~DebugConsoleDriver()
 void
 DebugConsoleDriver::showString(const std::string &msg)
 {
-    mTlSvr.send(msg + ((msg.back() == '\n') ? "" : "\n"));
+    if (msg.empty()) return;
+    mTlSvr.broadcast(msg + ((msg.back() == '\n') ? "" : "\n"));
+}
+
+void
+DebugConsoleDriver::addStream(const std::string &name, const std::string &description, const StreamFunc &func)
+{
+    std::lock_guard<std::mutex> lock(mStreamMutex);
+    mStreams[name] = Stream {description, func};
+}
+
+void
+DebugConsoleDriver::removeStream(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mStreamMutex);
+    mStreams.erase(name); // Subscriptions of the removed stream are dropped by processSubscriptions()
+}
+
+void
+DebugConsoleDriver::addTimeLap(const std::string &name, rec_time::RecTimeLap &timeLap)
+{
+    std::lock_guard<std::mutex> lock(mStreamMutex);
+    mTimeLaps[name] = &timeLap;
+}
+
+void
+DebugConsoleDriver::removeTimeLap(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mStreamMutex);
+    mTimeLaps.erase(name);
 }
 
 //------------------------------------------------------------------------------------------
@@ -69,7 +106,8 @@ DebugConsoleDriver::showString(const std::string &msg)
 void
 DebugConsoleDriver::threadMain(DebugConsoleDriver *driver)
 //
-// DebugConsole main thread. This thread receives incoming command lines and executes them.
+// DebugConsole main thread. This thread receives incoming command lines from all the clients,
+// executes them and also sends subscribed streams.
 //
 {
     // First, change driver's threadState condition and do notify_one to caller.
@@ -83,24 +121,21 @@ DebugConsoleDriver::threadMain(DebugConsoleDriver *driver)
             break;
         }
 
-        driver->mThreadState = ThreadState::BUSY;
-        std::string recvBuff;
-        int recvByte = driver->mTlSvr.recv(recvBuff, tlSvrMsgCallBackFunc, tlSvrMsgCallBackFunc);
-        if (recvByte == 0 || recvByte == -1) {
-            // empty or EOF
-            driver->mThreadState = ThreadState::IDLE;
-            usleep(10000); // 10000us = 10ms : wake up every 10ms and check TlSvr
-            
-        } else if (recvByte < -1) { // error
+        driver->mThreadState = ThreadState::IDLE;
+        bool flag =
+            driver->mTlSvr.poll(driver->calcPollTimeoutMs(),
+                                [&](ClientId clientId, const std::string &cmdLine) {
+                                    driver->mThreadState = ThreadState::BUSY;
+                                    driver->evalCommandLine(clientId, cmdLine);
+                                    driver->mThreadState = ThreadState::IDLE;
+                                },
+                                [&](ClientId clientId) { driver->unsubscribe(clientId, "all"); });
+        if (!flag) {
             std::cerr << "telnet server failed\n";
             break;
-        } else {
-            Arg arg(recvBuff, &(driver->mTlSvr)); // construct Arg by received command-line
-            if (!driver->mParser.main(arg)) { // evaluate command-line by predefined command
-                std::cerr << ">> DebugConsoleDriver.cc eval() failed\n";
-            }
-            driver->mThreadState = ThreadState::IDLE;
         }
+
+        driver->processSubscriptions();
     }
     
     driver->mThreadState = ThreadState::DONE;
@@ -109,6 +144,240 @@ DebugConsoleDriver::threadMain(DebugConsoleDriver *driver)
     std::cerr << ">> DebugConsoleDriver.cc threadMain() shutdown\n";
 }
 
+void
+DebugConsoleDriver::parserConfigureStream()
+{
+    mParser.opt("stream", "...command...", "periodic stream output subscription command",
+                [&](Arg &arg) { return mParserStream.main(arg.childArg()); });
+
+    mParserStream.description("periodic stream output subscription command");
+    mParserStream.opt("list", "", "show all available streams",
+                      [&](Arg &arg) { return arg.msg(showStreams() + '\n'); });
+    mParserStream.opt("sub", "<name> <intervalMs>", "subscribe stream. output is sent every intervalMs",
+                      [&](Arg &arg) {
+                          const std::string name = (arg++)();
+                          const unsigned intervalMs = (arg++).as<unsigned>(0);
+                          if (intervalMs == 0) {
+                              return arg.msg("intervalMs has to be 1 or more\n");
+                          }
+                          {
+                              std::lock_guard<std::mutex> lock(mStreamMutex);
+                              if (mStreams.find(name) == mStreams.end()) {
+                                  return arg.msg("unknown stream:" + name + '\n');
+                              }
+                          }
+                          subscribe(mCurrClientId, name, intervalMs);
+                          return arg.msg("subscribed stream:" + name +
+                                         " intervalMs:" + std::to_string(intervalMs) + '\n');
+                      });
+    mParserStream.opt("unsub", "<name|all>", "unsubscribe stream",
+                      [&](Arg &arg) {
+                          const std::string name = (arg++)();
+                          if (!unsubscribe(mCurrClientId, name)) {
+                              return arg.msg("not subscribed stream:" + name + '\n');
+                          }
+                          return arg.msg("unsubscribed stream:" + name + '\n');
+                      });
+    mParserStream.opt("show", "", "show subscriptions of this client",
+                      [&](Arg &arg) { return arg.msg(showSubscriptions(mCurrClientId) + '\n'); });
+    mParserStream.opt("clients", "", "show all connected clients",
+                      [&](Arg &arg) { return arg.msg(mTlSvr.show() + '\n'); });
+}
+
+void
+DebugConsoleDriver::parserConfigureMetrics()
+{
+    mParser.opt("metrics", "...command...", "process-wide metrics registry command",
+                [&](Arg &arg) { return MetricsRegistry::get().getParser().main(arg.childArg()); });
+
+    addStream("metrics", "all the current metric values", [] { return MetricsRegistry::get().show(); });
+}
+
+void
+DebugConsoleDriver::parserConfigureTimeLap()
+{
+    mParser.opt("timeLap", "...command...", "RecTimeLap command",
+                [&](Arg &arg) { return mParserTimeLap.main(arg.childArg()); });
+
+    mParserTimeLap.description("RecTimeLap command");
+    mParserTimeLap.opt("list", "", "show all registered timeLaps",
+                       [&](Arg &arg) { return arg.msg(showTimeLaps() + '\n'); });
+    mParserTimeLap.opt("perfCounter", "<name> <on|off|show>", "hardware perf counter switch of the timeLap",
+                       [&](Arg &arg) {
+                           const std::string name = (arg++)();
+                           const bool show = (arg() == "show");
+                           const bool flag = (arg++).as<bool>(0);
+                           std::lock_guard<std::mutex> lock(mStreamMutex); // keeps timeLap registered
+                           rec_time::RecTimeLap *timeLap = findTimeLap(name);
+                           if (!timeLap) return arg.msg("unknown timeLap:" + name + '\n');
+                           if (!show) timeLap->setPerfCounter(flag);
+                           return arg.msg("timeLap:" + name + " perfCounter:" +
+                                          ((timeLap->getPerfCounter()) ? "on" : "off") + '\n');
+                       });
+    mParserTimeLap.opt("perfInfo", "<name>", "show perf counter info of the timeLap with per-thread breakdown",
+                       [&](Arg &arg) {
+                           const std::string name = (arg++)();
+                           std::lock_guard<std::mutex> lock(mStreamMutex); // keeps timeLap registered
+                           rec_time::RecTimeLap *timeLap = findTimeLap(name);
+                           if (!timeLap) return arg.msg("unknown timeLap:" + name + '\n');
+                           return arg.msg(timeLap->showPerfInfo() + '\n');
+                       });
+}
+
+void
+DebugConsoleDriver::evalCommandLine(ClientId clientId, const std::string &cmdLine)
+{
+    // Output of the command only goes back to the client who sent this command line.
+    Arg arg(cmdLine);
+    arg.setMessageHandler([this, clientId](const std::string &msg) { return mTlSvr.send(clientId, msg); });
+
+    mCurrClientId = clientId;
+    if (!mParser.main(arg)) { // evaluate command-line by predefined command
+        std::cerr << ">> DebugConsoleDriver.cc eval() failed\n";
+    }
+    mCurrClientId = 0;
+}
+
+void
+DebugConsoleDriver::subscribe(ClientId clientId, const std::string &streamName, uint64_t intervalMs)
+{
+    const uint64_t now = getCurrentMilliSec();
+    for (auto &itr : mSubscriptions) {
+        if (itr.mClientId == clientId && itr.mStreamName == streamName) {
+            itr.mIntervalMs = intervalMs; // update interval
+            itr.mNextTimeMs = now;
+            return;
+        }
+    }
+    mSubscriptions.push_back(Subscription {clientId, streamName, intervalMs, now});
+}
+
+bool
+DebugConsoleDriver::unsubscribe(ClientId clientId, const std::string &streamName)
+{
+    const size_t orgSize = mSubscriptions.size();
+    mSubscriptions.erase(std::remove_if(mSubscriptions.begin(), mSubscriptions.end(),
+                                        [&](const Subscription &sub) {
+                                            return (sub.mClientId == clientId &&
+                                                    (streamName == "all" || sub.mStreamName == streamName));
+                                        }),
+                         mSubscriptions.end());
+    return mSubscriptions.size() != orgSize;
+}
+
+void
+DebugConsoleDriver::processSubscriptions()
+{
+    if (mSubscriptions.empty()) return;
+
+    const uint64_t now = getCurrentMilliSec();
+    for (size_t i = 0; i < mSubscriptions.size(); ) {
+        Subscription &sub = mSubscriptions[i];
+        if (now < sub.mNextTimeMs) {
+            ++i;
+            continue;
+        }
+
+        // Copy the function and run it without holding the mutex.
+        StreamFunc func;
+        {
+            std::lock_guard<std::mutex> lock(mStreamMutex);
+            auto itr = mStreams.find(sub.mStreamName);
+            if (itr != mStreams.end()) func = itr->second.mFunc;
+        }
+        if (!func) {
+            mTlSvr.send(sub.mClientId, "stream:" + sub.mStreamName + " was removed\n");
+            mSubscriptions.erase(mSubscriptions.begin() + i);
+            continue;
+        }
+
+        std::string msg = func();
+        if (msg.empty() || msg.back() != '\n') msg += '\n';
+        mTlSvr.send(sub.mClientId, msg);
+
+        // Keep the phase but skip the missed ticks if the stream function was slow.
+        sub.mNextTimeMs += sub.mIntervalMs;
+        if (sub.mNextTimeMs <= now) sub.mNextTimeMs = now + sub.mIntervalMs;
+        ++i;
+    }
+}
+
+int
+DebugConsoleDriver::calcPollTimeoutMs() const
+{
+    // Wake up at least every 100ms in order to check mThreadShutdown even if the wakeup is missed.
+    constexpr uint64_t maxTimeoutMs = 100;
+
+    uint64_t timeoutMs = maxTimeoutMs;
+    if (!mSubscriptions.empty()) {
+        const uint64_t now = getCurrentMilliSec();
+        for (const auto &itr : mSubscriptions) {
+            timeoutMs = std::min(timeoutMs, (itr.mNextTimeMs > now) ? itr.mNextTimeMs - now : 0);
+        }
+    }
+    return static_cast<int>(timeoutMs);
+}
+
+std::string
+DebugConsoleDriver::showStreams() const
+{
+    std::lock_guard<std::mutex> lock(mStreamMutex);
+
+    size_t maxLen = 0;
+    for (const auto &itr : mStreams) maxLen = std::max(maxLen, itr.first.size());
+
+    std::ostringstream ostr;
+    ostr << "streams (size:" << mStreams.size() << ") {\n";
+    for (const auto &itr : mStreams) {
+        ostr << "  " << std::setw(maxLen) << std::left << itr.first << " : " << itr.second.mDescription << '\n';
+    }
+    ostr << "}";
+    return ostr.str();
+}
+
+std::string
+DebugConsoleDriver::showTimeLaps() const
+{
+    std::lock_guard<std::mutex> lock(mStreamMutex);
+
+    std::ostringstream ostr;
+    ostr << "timeLaps (size:" << mTimeLaps.size() << ") {\n";
+    for (const auto &itr : mTimeLaps) {
+        ostr << "  " << itr.first << " perfCounter:" << ((itr.second->getPerfCounter()) ? "on" : "off") << '\n';
+    }
+    ostr << "}";
+    return ostr.str();
+}
+
+rec_time::RecTimeLap *
+DebugConsoleDriver::findTimeLap(const std::string &name) const
+{
+    // caller holds mStreamMutex
+    auto itr = mTimeLaps.find(name);
+    return (itr != mTimeLaps.end()) ? itr->second : nullptr;
+}
+
+std::string
+DebugConsoleDriver::showSubscriptions(ClientId clientId) const
+{
+    std::ostringstream ostr;
+    ostr << "subscriptions clientId:" << clientId << " {\n";
+    for (const auto &itr : mSubscriptions) {
+        if (itr.mClientId != clientId) continue;
+        ostr << "  " << itr.mStreamName << " intervalMs:" << itr.mIntervalMs << '\n';
+    }
+    ostr << "}";
+    return ostr.str();
+}
+
+// static function
+uint64_t
+DebugConsoleDriver::getCurrentMilliSec()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
 } // namespace grid_util
 } // namespace scene_rdl2
 
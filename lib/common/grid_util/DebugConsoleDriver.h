@@ -6,12 +6,16 @@
 #pragma once
 
 #include "Parser.h"
-#include "TlSvr.h"
+#include "TlSvrMulti.h"
+
+#include <scene_rdl2/common/rec_time/RecTimeLap.h>
 
 #include <atomic>
 #include <condition_variable>
+#include <map>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 //
 // --- How to implement your own debug console by using DebugConsoleDriver ---
@@ -34,6 +38,15 @@
 //             moonray::rndr::RenderContextConsoleDriver::init()
 //             mcrt_dataio::ClientReceiverFb::consoleEnable()
 //
+// Step-4) (Optional) Register streams by addStream()
+//         A stream is a named function which returns a string, like RecTimeLap::show() or some allocator
+//         statistics. A client subscribes to it by "stream sub <name> <intervalMs>" and the result is
+//         pushed to the client periodically without any polling command.
+//
+// Step-5) (Optional) Register RecTimeLap objects by addTimeLap()
+//         Their hardware perf counters are then switched on/off by "timeLap perfCounter <name> on|off"
+//         and shown, with a per-thread breakdown, by "timeLap perfInfo <name>".
+//
 
 namespace scene_rdl2 {
 namespace grid_util {
@@ -47,9 +60,21 @@ class DebugConsoleDriver
 // arras multi-machine configurations.)
 //
 // This class boots an independent thread in order to charge a debug console operation inside
-// the initialize(). If we don't have any incoming socket connection, this debug console threads
-// almost always asleep and minimizes the CPU overhead. This debug console thread is automatically
-// shut down inside the destructor.
+// the initialize(). This thread runs an epoll event loop (TlSvrMulti) and is asleep until some
+// socket activity happens or a subscribed stream is due, so the CPU overhead is minimal. This debug
+// console thread is automatically shut down inside the destructor.
+//
+// Multiple telnet clients can connect at the same time. Each command line is evaluated on the console
+// thread and its output only goes back to the client which sent it. showString() has no client to
+// answer, so its message is broadcast to every connected client (with the single client console it
+// went to that one client). Output is queued per client and sent non-blocking, so a slow client never
+// stalls the console thread or the caller of showString().
+//
+// The root parser has a built-in "stream" command for the subscription of the streams which are
+// registered by addStream(), a built-in "metrics" command for the process-wide MetricsRegistry and
+// a built-in "timeLap" command for the RecTimeLap objects which are registered by addTimeLap().
+// Please don't use "stream", "metrics" and "timeLap" as your own command names. The "metrics" stream
+// which pushes all the current metric values is registered by default.
 //
 {
 public:
@@ -71,13 +96,63 @@ public:
 
     Parser & getRootParser() { return mParser; }
 
-    void showString(const std::string &msg); // msg goes to TlSvr if available
+    void showString(const std::string &msg); // msg goes to all the connected clients. MTsafe
+
+    //
+    // Registers a named stream for subscription. func is executed on the console thread, the same as
+    // the command actions, so it has to be safe to call concurrently with the rendering.
+    // Registering the same name again replaces the function. MTsafe.
+    //
+    using StreamFunc = std::function<std::string()>;
+    void addStream(const std::string &name, const std::string &description, const StreamFunc &func);
+    void removeStream(const std::string &name);
+
+    //
+    // Registers a RecTimeLap for the "timeLap" command. timeLap has to stay alive until it is removed
+    // by removeTimeLap() or this driver is destructed. Registering the same name again replaces it. MTsafe.
+    //
+    void addTimeLap(const std::string &name, rec_time::RecTimeLap &timeLap);
+    void removeTimeLap(const std::string &name);
+
+    size_t getClientTotal() const { return mTlSvr.getClientTotal(); }
 
 private:
+    using ClientId = TlSvrMulti::ClientId;
+
+    struct Stream
+    {
+        std::string mDescription;
+        StreamFunc mFunc;
+    };
+
+    struct Subscription
+    {
+        ClientId mClientId;
+        std::string mStreamName;
+        uint64_t mIntervalMs;
+        uint64_t mNextTimeMs;
+    };
+
     static void threadMain(DebugConsoleDriver *driver);
 
     virtual void parserConfigure(Parser &) {} // You should implement this for adding your command to the parser object
 
+    void parserConfigureStream();
+    void parserConfigureMetrics();
+    void parserConfigureTimeLap();
+    void evalCommandLine(ClientId clientId, const std::string &cmdLine);
+
+    void subscribe(ClientId clientId, const std::string &streamName, uint64_t intervalMs);
+    bool unsubscribe(ClientId clientId, const std::string &streamName); // streamName "all" : all streams
+    void processSubscriptions(); // sends all due streams
+    int calcPollTimeoutMs() const; // until the next due stream
+    std::string showStreams() const;
+    std::string showTimeLaps() const;
+    rec_time::RecTimeLap *findTimeLap(const std::string &name) const; // needs mStreamMutex
+    std::string showSubscriptions(ClientId clientId) const;
+
+    static uint64_t getCurrentMilliSec();
+
     //------------------------------
 
     std::thread mThread;
@@ -87,12 +162,22 @@ private:
     mutable std::mutex mMutexBoot;
     std::condition_variable mCvBoot; // using at boot threadMain sequence
 
-    TlSvr mTlSvr; // for telnet server operation
+    TlSvrMulti mTlSvr; // for telnet server operation
     int mTlSvrPortNum; // 0 is error
 
+    mutable std::mutex mStreamMutex;
+    std::map<std::string, Stream> mStreams;
+    std::map<std::string, rec_time::RecTimeLap *> mTimeLaps; // protected by mStreamMutex
+
+    // Only accessed by the console thread
+    ClientId mCurrClientId {0}; // client of the currently evaluated command line
+    std::vector<Subscription> mSubscriptions;
+
     //------------------------------
 
     Parser mParser; // root parser object : all command definitions for the incoming command line.
+    Parser mParserStream;
+    Parser mParserTimeLap;
 };
 
 } // namespace grid_util
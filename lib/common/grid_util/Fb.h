@@ -110,6 +110,8 @@ public:
     const NumSampleBuffer& getNumSampleBufferTiled() const { return mNumSampleBufferTiled; }
     CoarsePassPrecision&   getRenderBufferCoarsePassPrecision() { return mRenderBufferCoarsePassPrecision; }
     FinePassPrecision&     getRenderBufferFinePassPrecision() { return mRenderBufferFinePassPrecision; }
+    CoarsePassPrecision    getRenderBufferCoarsePassPrecision() const { return mRenderBufferCoarsePassPrecision; }
+    FinePassPrecision      getRenderBufferFinePassPrecision() const { return mRenderBufferFinePassPrecision; }
     bool                   isActivePixelRenderBuffer(int sx, int sy) const;
     fb_util::RenderColor   getPixRenderBuffer(int sx, int sy) const;
     unsigned int           getPixRenderBufferNumSample(int sx, int sy) const;
@@ -0,0 +1,91 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "FbStream.h"
+
+#include <scene_rdl2/scene/rdl2/ValueContainerDeq.h>
+#include <scene_rdl2/scene/rdl2/ValueContainerEnq.h>
+
+#include <sstream>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+void
+FbStreamSubscribeParam::encode(std::string &output) const
+{
+    rdl2::ValueContainerEnq vContainerEnq(&output);
+
+    vContainerEnq.enqBool(mBeauty);
+    vContainerEnq.enqStringVector(mAovNames);
+    vContainerEnq.enqChar(static_cast<char>(mPrecision));
+    vContainerEnq.enqBool(mRoiActive);
+    vContainerEnq.enqInt(mRoi.mMinX);
+    vContainerEnq.enqInt(mRoi.mMinY);
+    vContainerEnq.enqInt(mRoi.mMaxX);
+    vContainerEnq.enqInt(mRoi.mMaxY);
+    vContainerEnq.enqFloat(mMaxFps);
+
+    vContainerEnq.finalize();
+}
+
+bool
+FbStreamSubscribeParam::decode(const void *addr, const size_t dataSize)
+{
+    try {
+        rdl2::ValueContainerDeq vContainerDeq(addr, dataSize);
+
+        vContainerDeq.deqBool(mBeauty);
+        vContainerDeq.deqStringVector(mAovNames);
+        char precision;
+        vContainerDeq.deqChar(precision);
+        mPrecision = static_cast<PrecisionMode>(precision);
+        vContainerDeq.deqBool(mRoiActive);
+        int minX, minY, maxX, maxY;
+        vContainerDeq.deqInt(minX);
+        vContainerDeq.deqInt(minY);
+        vContainerDeq.deqInt(maxX);
+        vContainerDeq.deqInt(maxY);
+        mRoi = math::Viewport(minX, minY, maxX, maxY);
+        vContainerDeq.deqFloat(mMaxFps);
+    }
+    catch (...) {
+        return false;
+    }
+
+    return (mPrecision == PrecisionMode::F32 ||
+            mPrecision == PrecisionMode::H16 ||
+            mPrecision == PrecisionMode::UC8);
+}
+
+uint64_t
+FbStreamSubscribeParam::getMinIntervalNanoSec() const
+{
+    if (mMaxFps <= 0.0f) return 0;
+    return static_cast<uint64_t>(1.0e9 / static_cast<double>(mMaxFps));
+}
+
+std::string
+FbStreamSubscribeParam::show() const
+{
+    std::ostringstream ostr;
+    ostr << "FbStreamSubscribeParam {\n"
+         << "  mBeauty:" << ((mBeauty) ? "true" : "false") << '\n'
+         << "  mAovNames (size:" << mAovNames.size() << ") {\n";
+    for (const auto &name : mAovNames) {
+        ostr << "    " << name << '\n';
+    }
+    ostr << "  }\n"
+         << "  mPrecision:" << PackTiles::showPrecisionMode(mPrecision) << '\n'
+         << "  mRoiActive:" << ((mRoiActive) ? "true" : "false");
+    if (mRoiActive) {
+        ostr << " mRoi:(" << mRoi.mMinX << ',' << mRoi.mMinY << ")-(" << mRoi.mMaxX << ',' << mRoi.mMaxY << ')';
+    }
+    ostr << '\n'
+         << "  mMaxFps:" << mMaxFps << ((mMaxFps <= 0.0f) ? " (unlimited)" : "") << '\n'
+         << "}";
+    return ostr.str();
+}
+
+} // namespace grid_util
+} // namespace scene_rdl2
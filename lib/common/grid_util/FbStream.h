@@ -0,0 +1,92 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+
+#include "PackTiles.h"
+
+#include <scene_rdl2/common/math/Viewport.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// -- Binary frame streaming protocol --
+//
+// Shared definitions of FbStreamServer and FbStreamClient. A viewer connects to a running process
+// (typically the merge computation) and pulls live framebuffers as PackTiles encoded deltas.
+//
+// Every message starts with a fixed size FbStreamMsgHeader followed by payloadSize byte payload.
+//
+//   client -> server
+//     SUBSCRIBE   : payload is an encoded FbStreamSubscribeParam. Re-subscribing replaces the param.
+//     UNSUBSCRIBE : empty payload
+//
+//   server -> client
+//     FRAME : payload is
+//               size_t metaSize (ValueContainer header) + meta data (ValueContainerEnq)
+//               encoded PackTiles data of each item (concatenated, sizes are stored in meta data)
+//             meta data : ULong frameId, Bool fullFrame, UInt width, UInt height, UInt itemTotal,
+//                         { Char itemType, String name, ULong dataSize } * itemTotal
+//
+// The very first FRAME after SUBSCRIBE (and after a resolution change) is a full frame which includes
+// all the pixels of the ROI. All following FRAMEs only include pixels which were updated since the
+// previous FRAME to this client. A slow client is not resynced : its updated pixels keep accumulating
+// until it catches up, so it gets fewer but bigger deltas.
+//
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+struct FbStreamMsgHeader
+{
+    static constexpr uint32_t MAGIC = 0x31534246; // "FBS1"
+
+    enum class Type : uint16_t {
+        SUBSCRIBE = 1,
+        UNSUBSCRIBE,
+        FRAME
+    };
+
+    uint32_t mMagic;
+    uint16_t mType;
+    uint16_t mPad;
+    uint64_t mPayloadSize;
+};
+static_assert(sizeof(FbStreamMsgHeader) == 16, "Unexpected FbStreamMsgHeader size");
+
+enum class FbStreamItemType : char {
+    BEAUTY = 0, // RGBA : PackTiles::encode() for merge
+    AOV         // PackTiles::encodeRenderOutputMerge()
+};
+
+class FbStreamSubscribeParam
+//
+// Subscription parameters of a single FbStream client.
+//
+{
+public:
+    using PrecisionMode = PackTiles::PrecisionMode;
+
+    bool mBeauty {true};
+    std::vector<std::string> mAovNames;
+    PrecisionMode mPrecision {PrecisionMode::H16};
+
+    bool mRoiActive {false};
+    math::Viewport mRoi; // pixel coordinate, min/max are inclusive
+
+    float mMaxFps {0.0f}; // rate limit of FRAME messages. 0 is unlimited
+
+    void encode(std::string &output) const;
+    bool decode(const void *addr, const size_t dataSize);
+
+    uint64_t getMinIntervalNanoSec() const;
+
+    std::string show() const;
+};
+
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,281 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "FbStreamClient.h"
+#include "LiteralUtil.h"
+#include "SockUtil.h"
+
+#include <scene_rdl2/render/util/StrUtil.h>
+#include <scene_rdl2/scene/rdl2/ValueContainerDeq.h>
+
+#include <netdb.h>              // getaddrinfo()
+#include <netinet/in.h>
+#include <netinet/tcp.h>        // TCP_NODELAY
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+FbStreamClient::~FbStreamClient()
+{
+    close();
+}
+
+bool
+FbStreamClient::connect(const std::string &hostName, const int port, std::string &errorMsg)
+{
+    close();
+
+    struct addrinfo hints;
+    memset(&hints, 0x0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *result = nullptr;
+    const int status = ::getaddrinfo(hostName.c_str(), std::to_string(port).c_str(), &hints, &result);
+    if (status != 0) {
+        errorMsg = str_util::stringCat("getaddrinfo() failed. host:", hostName, " (", gai_strerror(status), ")");
+        return false;
+    }
+
+    for (struct addrinfo *curr = result; curr; curr = curr->ai_next) {
+        int sock = ::socket(curr->ai_family, curr->ai_socktype | SOCK_CLOEXEC, curr->ai_protocol);
+        if (sock < 0) continue;
+        if (::connect(sock, curr->ai_addr, curr->ai_addrlen) == 0) {
+            mSock = sock;
+            break;
+        }
+        ::close(sock);
+    }
+    ::freeaddrinfo(result);
+
+    if (mSock == -1) {
+        errorMsg = str_util::stringCat("connect() failed. host:", hostName, " port:", std::to_string(port),
+                                       " (", strerror(errno), ")");
+        return false;
+    }
+
+    int optV = 1; // true
+    ::setsockopt(mSock, IPPROTO_TCP, TCP_NODELAY, (char*)&optV, sizeof(optV));
+    setSockBufferSize(mSock, SOL_SOCKET, 4_MiB); // frame data is big
+    return true;
+}
+
+void
+FbStreamClient::close()
+{
+    if (mSock != -1) {
+        ::close(mSock);
+        mSock = -1;
+    }
+    mRecvBuff.clear();
+}
+
+bool
+FbStreamClient::subscribe(const FbStreamSubscribeParam &param, std::string &errorMsg)
+{
+    std::string payload;
+    param.encode(payload);
+    return sendMsg(FbStreamMsgHeader::Type::SUBSCRIBE, payload, errorMsg);
+}
+
+bool
+FbStreamClient::unsubscribe(std::string &errorMsg)
+{
+    return sendMsg(FbStreamMsgHeader::Type::UNSUBSCRIBE, "", errorMsg);
+}
+
+int
+FbStreamClient::recvFrame(Fb &fb, const int timeoutMs, std::string &errorMsg)
+{
+    if (mSock == -1) {
+        errorMsg = "not connected";
+        return -1;
+    }
+
+    while (true) {
+        if (mRecvBuff.size() >= sizeof(FbStreamMsgHeader)) {
+            FbStreamMsgHeader header;
+            memcpy(&header, mRecvBuff.data(), sizeof(header));
+            if (header.mMagic != FbStreamMsgHeader::MAGIC ||
+                header.mType != static_cast<uint16_t>(FbStreamMsgHeader::Type::FRAME)) {
+                errorMsg = "received unknown message";
+                close();
+                return -1;
+            }
+
+            if (header.mPayloadSize > MAX_FRAME_PAYLOAD_SIZE) {
+                errorMsg = str_util::stringCat("received too big FRAME. payloadSize:",
+                                               std::to_string(header.mPayloadSize));
+                close();
+                return -1;
+            }
+
+            const size_t msgSize = sizeof(header) + header.mPayloadSize;
+            if (mRecvBuff.size() >= msgSize) {
+                const bool flag = decodeFrame(fb, mRecvBuff.data() + sizeof(header), header.mPayloadSize, errorMsg);
+                mLastFrameInfo.mMessageSize = msgSize;
+                mRecvBuff.erase(0, msgSize);
+                if (!flag) {
+                    close();
+                    return -1;
+                }
+                ++mRecvFrameTotal;
+                return 1;
+            }
+            if (mRecvBuff.capacity() < msgSize) mRecvBuff.reserve(msgSize);
+        }
+
+        // Only the wait for the very first byte of the message is limited by timeoutMs.
+        struct pollfd pfd;
+        pfd.fd = mSock;
+        pfd.events = POLLIN;
+        const int pollStatus = ::poll(&pfd, 1, (mRecvBuff.empty()) ? timeoutMs : -1);
+        if (pollStatus == 0) return 0; // timeout
+        if (pollStatus < 0) {
+            if (errno == EINTR) continue;
+            errorMsg = str_util::stringCat("poll() failed (", strerror(errno), ")");
+            close();
+            return -1;
+        }
+
+        char buff[256 * 1024];
+        const ssize_t rSize = ::recv(mSock, buff, sizeof(buff), 0);
+        if (rSize <= 0) {
+            if (rSize < 0 && errno == EINTR) continue;
+            errorMsg = (rSize == 0) ? "connection closed by server" :
+                str_util::stringCat("recv() failed (", strerror(errno), ")");
+            close();
+            return -1;
+        }
+        mRecvBuff.append(buff, rSize);
+        mRecvBytes += rSize;
+    }
+}
+
+bool
+FbStreamClient::sendMsg(FbStreamMsgHeader::Type type, const std::string &payload, std::string &errorMsg)
+{
+    if (mSock == -1) {
+        errorMsg = "not connected";
+        return false;
+    }
+
+    FbStreamMsgHeader header;
+    header.mMagic = FbStreamMsgHeader::MAGIC;
+    header.mType = static_cast<uint16_t>(type);
+    header.mPad = 0;
+    header.mPayloadSize = payload.size();
+
+    std::string msg(reinterpret_cast<const char *>(&header), sizeof(header));
+    msg += payload;
+
+    size_t sent = 0;
+    while (sent < msg.size()) {
+        const ssize_t wSize = ::send(mSock, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+        if (wSize < 0) {
+            if (errno == EINTR) continue;
+            errorMsg = str_util::stringCat("send() failed (", strerror(errno), ")");
+            close();
+            return false;
+        }
+        sent += wSize;
+    }
+    return true;
+}
+
+bool
+FbStreamClient::decodeFrame(Fb &fb, const char *payload, const size_t payloadSize, std::string &errorMsg)
+{
+    using ActivePixels = fb_util::ActivePixels;
+    using FbAovShPtr = Fb::FbAovShPtr;
+
+    if (payloadSize < sizeof(size_t)) {
+        errorMsg = "FRAME is too small";
+        return false;
+    }
+    size_t metaSize;
+    memcpy(&metaSize, payload, sizeof(size_t)); // ValueContainerEnq stores own size at the beginning
+    if (metaSize > payloadSize) {
+        errorMsg = "broken FRAME meta data";
+        return false;
+    }
+
+    try {
+        rdl2::ValueContainerDeq vContainerDeq(payload, metaSize);
+        FrameInfo &info = mLastFrameInfo;
+        unsigned long frameId;
+        vContainerDeq.deqULong(frameId);
+        info.mFrameId = frameId;
+        vContainerDeq.deqBool(info.mFullFrame);
+        vContainerDeq.deqUInt(info.mWidth);
+        vContainerDeq.deqUInt(info.mHeight);
+        vContainerDeq.deqUInt(info.mItemTotal);
+
+        if (!info.mWidth || !info.mHeight) {
+            errorMsg = "FRAME has empty resolution";
+            return false;
+        }
+        const ActivePixels &fbActivePixels = fb.getActivePixels(); // 0x0 if fb is not initialized yet
+        if (fbActivePixels.getWidth() != info.mWidth || fbActivePixels.getHeight() != info.mHeight) {
+            fb.init(math::Viewport(0, 0, static_cast<int>(info.mWidth) - 1, static_cast<int>(info.mHeight) - 1));
+        }
+
+        size_t dataOffset = metaSize;
+        for (unsigned itemId = 0; itemId < info.mItemTotal; ++itemId) {
+            char type;
+            std::string name;
+            unsigned long dataSize;
+            vContainerDeq.deqChar(type);
+            vContainerDeq.deqString(name);
+            vContainerDeq.deqULong(dataSize);
+            if (dataOffset + dataSize > payloadSize) {
+                errorMsg = "broken FRAME data size";
+                return false;
+            }
+            const void *addr = payload + dataOffset;
+            dataOffset += dataSize;
+
+            ActivePixels activePixels; // pixels of this FRAME
+            bool activeDecodeAction = false;
+            if (static_cast<FbStreamItemType>(type) == FbStreamItemType::BEAUTY) {
+                if (!PackTiles::decode(false, // renderBufferOdd
+                                       addr,
+                                       dataSize,
+                                       activePixels,
+                                       fb.getRenderBufferTiled(),
+                                       fb.getRenderBufferCoarsePassPrecision(),
+                                       fb.getRenderBufferFinePassPrecision(),
+                                       activeDecodeAction)) {
+                    errorMsg = "decode beauty failed";
+                    return false;
+                }
+                if (activeDecodeAction) fb.getActivePixels().orOp(activePixels);
+            } else {
+                FbAovShPtr fbAov = fb.getAov(name);
+                if (!PackTiles::decodeRenderOutput(addr,
+                                                   dataSize,
+                                                   false, // storeNumSampleData
+                                                   activePixels,
+                                                   fbAov,
+                                                   activeDecodeAction)) {
+                    errorMsg = str_util::stringCat("decode AOV failed. name:", name);
+                    return false;
+                }
+                if (activeDecodeAction && !fbAov->getActivePixels().orOp(activePixels)) {
+                    fbAov->getActivePixels().copy(activePixels);
+                }
+            }
+        }
+    }
+    catch (...) {
+        errorMsg = "broken FRAME meta data";
+        return false;
+    }
+    return true;
+}
+
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,91 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+
+#include "FbStream.h"
+
+#include <cstdint>
+#include <string>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+class FbStreamClient
+//
+// Client side of FbStreamServer. (See FbStream.h about the protocol)
+// Received FRAMEs are decoded and accumulated into the Fb, so after every recvFrame() the Fb holds the
+// latest image of all the subscribed items. Fb is re-initialized when the resolution is changed.
+//
+//    FbStreamClient client;
+//    std::string error;
+//    if (!client.connect("localhost", 20010, error)) return;
+//
+//    FbStreamSubscribeParam param;
+//    param.mAovNames.push_back("depth");
+//    param.mMaxFps = 10.0f;
+//    client.subscribe(param, error);
+//
+//    Fb fb;
+//    while (client.recvFrame(fb, 1000, error) >= 0) {
+//        ... use fb ...
+//    }
+//
+{
+public:
+    // FRAME messages with a bigger payload are treated as broken and close the connection.
+    static constexpr uint64_t MAX_FRAME_PAYLOAD_SIZE = uint64_t(4) << 30; // 4 GiB
+
+    struct FrameInfo
+    {
+        uint64_t mFrameId {0};
+        bool mFullFrame {false};
+        unsigned mWidth {0};
+        unsigned mHeight {0};
+        unsigned mItemTotal {0};
+        size_t mMessageSize {0}; // byte
+    };
+
+    FbStreamClient() = default;
+    ~FbStreamClient();
+
+    // Non-copyable
+    FbStreamClient &operator =(const FbStreamClient &) = delete;
+    FbStreamClient(const FbStreamClient &) = delete;
+
+    bool connect(const std::string &hostName, const int port, std::string &errorMsg);
+    void close();
+    bool isConnected() const { return mSock != -1; }
+
+    bool subscribe(const FbStreamSubscribeParam &param, std::string &errorMsg);
+    bool unsubscribe(std::string &errorMsg);
+
+    //
+    // Waits max timeoutMs millisec (-1 : no timeout) for the next FRAME and decodes it into fb.
+    // Returns 1 : decoded a FRAME, 0 : timeout, -1 : error (connection is closed, also if the message
+    // header is broken or the payload is bigger than MAX_FRAME_PAYLOAD_SIZE)
+    //
+    int recvFrame(Fb &fb, const int timeoutMs, std::string &errorMsg);
+
+    const FrameInfo &getLastFrameInfo() const { return mLastFrameInfo; }
+    uint64_t getRecvFrameTotal() const { return mRecvFrameTotal; }
+    uint64_t getRecvBytes() const { return mRecvBytes; }
+
+private:
+    bool sendMsg(FbStreamMsgHeader::Type type, const std::string &payload, std::string &errorMsg);
+    bool decodeFrame(Fb &fb, const char *payload, const size_t payloadSize, std::string &errorMsg);
+
+    //------------------------------
+
+    int mSock {-1};
+
+    std::string mRecvBuff;
+    FrameInfo mLastFrameInfo;
+    uint64_t mRecvFrameTotal {0};
+    uint64_t mRecvBytes {0};
+};
+
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,874 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "FbStreamServer.h"
+#include "LiteralUtil.h"
+#include "SockUtil.h"
+
+#include <scene_rdl2/render/util/StrUtil.h>
+#include <scene_rdl2/scene/rdl2/ValueContainerEnq.h>
+
+#include <chrono>
+#include <deque>
+#include <sstream>
+#include <vector>
+
+#include <arpa/inet.h>          // inet_ntop()
+#include <netinet/in.h>         // struct sockaddr_in
+#include <netinet/tcp.h>        // TCP_NODELAY
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>            // struct iovec
+#include <unistd.h>
+
+namespace {
+
+constexpr const char *msgHead = ">FbStreamServer<"; // message head strings for *MsgCallBack functions
+
+constexpr size_t maxRecvPayloadSize = 1024 * 1024; // byte : client -> server messages are small
+constexpr int maxIov = 64;
+
+uint64_t
+getNanoSec()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>
+        (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void
+setupRoiMask(const scene_rdl2::math::Viewport *roi, scene_rdl2::fb_util::ActivePixels &mask)
+//
+// Sets all the pixels inside roi (or all the pixels if roi is nullptr) to mask.
+// mask should be already initialized by the image resolution.
+//
+{
+    const int width = static_cast<int>(mask.getWidth());
+    const int height = static_cast<int>(mask.getHeight());
+    const int minX = (roi) ? std::max(roi->mMinX, 0) : 0;
+    const int minY = (roi) ? std::max(roi->mMinY, 0) : 0;
+    const int maxX = (roi) ? std::min(roi->mMaxX, width - 1) : width - 1;
+    const int maxY = (roi) ? std::min(roi->mMaxY, height - 1) : height - 1;
+
+    mask.reset();
+    for (int y = minY; y <= maxY; ++y) {
+        const unsigned tileYOffset = static_cast<unsigned>(y >> 3) * mask.getNumTilesX();
+        const unsigned shift = static_cast<unsigned>(y & 0x7) << 3;
+        for (int x = minX; x <= maxX; ++x) {
+            mask.orOp(tileYOffset + static_cast<unsigned>(x >> 3),
+                      static_cast<uint64_t>(0x1) << (shift + static_cast<unsigned>(x & 0x7)));
+        }
+    }
+}
+
+bool
+andMask(const scene_rdl2::fb_util::ActivePixels &a,
+        const scene_rdl2::fb_util::ActivePixels &b,
+        scene_rdl2::fb_util::ActivePixels &out)
+//
+// out = a & b. Returns false if the result is empty.
+//
+{
+    out.init(a.getWidth(), a.getHeight());
+    uint64_t total = 0x0;
+    for (unsigned tileId = 0; tileId < a.getNumTiles(); ++tileId) {
+        const uint64_t mask = a.getTileMask(tileId) & b.getTileMask(tileId);
+        out.setTileMask(tileId, mask);
+        total |= mask;
+    }
+    return total != 0x0;
+}
+
+bool
+sameMask(const scene_rdl2::fb_util::ActivePixels &a, const scene_rdl2::fb_util::ActivePixels &b)
+{
+    if (!a.isSameSize(b)) return false;
+    for (unsigned tileId = 0; tileId < a.getNumTiles(); ++tileId) {
+        if (a.getTileMask(tileId) != b.getTileMask(tileId)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+struct FbStreamServer::Client
+{
+    struct Item
+    {
+        FbStreamItemType mType {FbStreamItemType::BEAUTY};
+        std::string mName; // empty for beauty
+        ActivePixels mPending; // accumulated dirty pixels since the last FRAME
+    };
+
+    struct OutMsg
+    {
+        std::string mHead; // FbStreamMsgHeader + meta data
+        std::vector<std::shared_ptr<const std::string>> mBlocks; // shared encoded data
+
+        size_t getSegTotal() const { return 1 + mBlocks.size(); }
+        const std::string &getSeg(size_t segId) const { return (segId == 0) ? mHead : *mBlocks[segId - 1]; }
+    };
+
+    ClientId mId {0};
+    int mSock {-1};
+    std::string mAddr;
+
+    std::string mRecvBuff; // only accessed by the server thread
+
+    // Subscription state. Protected by FbStreamServer::mMutex
+    bool mSubscribed {false};
+    uint64_t mGeneration {0}; // incremented by every SUBSCRIBE/UNSUBSCRIBE
+    FbStreamSubscribeParam mParam;
+    std::deque<Item> mItems; // deque : ActivePixels should not be copied by reallocation
+    ActivePixels mRoiMask;
+    unsigned mWidth {0};
+    unsigned mHeight {0};
+    bool mNeedFull {true};
+    uint64_t mNextSendTime {0}; // nanosec
+
+    // Output queue. Protected by FbStreamServer::mMutex
+    std::deque<OutMsg> mQueue;
+    size_t mSegId {0};     // current segment of mQueue.front()
+    size_t mSegOffset {0}; // sent byte of current segment
+    bool mEpollOut {false}; // EPOLLOUT is registered
+    bool mBroken {false};   // will be closed by the server thread
+
+    uint64_t mFrameSent {0};
+};
+
+FbStreamServer::FbStreamServer()
+{
+}
+
+FbStreamServer::~FbStreamServer()
+{
+    close();
+}
+
+int
+FbStreamServer::open(const int serverPortNum,
+                     MsgCallBack infoMsgCallBack,
+                     MsgCallBack errMsgCallBack)
+{
+    if (mEpollFd != -1) {
+        return mPort; // already opened
+    }
+
+    mInfoMsgCallBack = infoMsgCallBack;
+    mErrMsgCallBack = errMsgCallBack;
+    mPort = serverPortNum;
+
+    auto errorExit = [&](const std::string &msg) {
+        errMsg(str_util::stringCat(msg, " errno:", std::to_string(errno), " (", strerror(errno), ")"));
+        close();
+        return 0;
+    };
+
+    if ((mEpollFd = ::epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        mEpollFd = -1;
+        return errorExit("::epoll_create1() failed.");
+    }
+    if ((mWakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        mWakeupFd = -1;
+        return errorExit("::eventfd() failed.");
+    }
+    if (!socketBindAndListen()) {
+        close();
+        return 0;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_ID;
+    if (::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mBaseSock, &ev) < 0) {
+        return errorExit("::epoll_ctl() failed for baseSock.");
+    }
+    ev.data.u64 = WAKEUP_ID;
+    if (::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeupFd, &ev) < 0) {
+        return errorExit("::epoll_ctl() failed for wakeupFd.");
+    }
+
+    mThreadShutdown = false;
+    mThread = std::thread([&]() { threadMain(); });
+
+    infoMsg(str_util::stringCat(" opened server port:", std::to_string(mPort)));
+    return mPort;
+}
+
+void
+FbStreamServer::close()
+{
+    if (mThread.joinable()) {
+        mThreadShutdown = true;
+        wakeup();
+        mThread.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto &itr : mClients) {
+            ::close(itr.second->mSock);
+        }
+        mClients.clear();
+    }
+
+    if (mBaseSock != -1) {
+        ::close(mBaseSock);
+        mBaseSock = -1;
+    }
+    if (mWakeupFd != -1) {
+        ::close(mWakeupFd);
+        mWakeupFd = -1;
+    }
+    if (mEpollFd != -1) {
+        ::close(mEpollFd);
+        mEpollFd = -1;
+    }
+}
+
+void
+FbStreamServer::publish(const Fb &fb, const ActivePixels *dirtyPixels)
+{
+    using PrecisionMode = PackTiles::PrecisionMode;
+
+    struct JobItem
+    {
+        FbStreamItemType mType {FbStreamItemType::BEAUTY};
+        std::string mName;
+        ActivePixels mMask; // sending pixels
+    };
+
+    struct Job
+    {
+        ClientShPtr mClient;
+        uint64_t mGeneration;
+        bool mFull;
+        PrecisionMode mPrecision;
+        std::deque<JobItem> mItems;
+    };
+
+    struct Encoded
+    {
+        FbStreamItemType mType;
+        std::string mName;
+        PrecisionMode mPrecision;
+        const ActivePixels *mMask;
+        std::shared_ptr<const std::string> mData;
+    };
+
+    using FbAovShPtr = Fb::FbAovShPtr;
+
+    ++mPublishTotal;
+    const unsigned width = fb.getWidth();
+    const unsigned height = fb.getHeight();
+    if (!width || !height) return;
+
+    // Returns the dirty pixels of the item. nullptr if the item is not available inside fb
+    std::map<std::string, FbAovShPtr> aovTbl;
+    auto getAov = [&](const std::string &aovName) -> FbAovShPtr {
+        auto itr = aovTbl.find(aovName);
+        if (itr != aovTbl.end()) return itr->second;
+        FbAovShPtr fbAov;
+        if (!fb.getAov2(aovName, fbAov) || !fbAov->getStatus()) fbAov.reset();
+        aovTbl[aovName] = fbAov;
+        return fbAov;
+    };
+    auto getDirtyPixels = [&](const Client::Item &item) -> const ActivePixels * {
+        const ActivePixels *dirty = nullptr;
+        if (item.mType == FbStreamItemType::BEAUTY) {
+            dirty = (dirtyPixels) ? dirtyPixels : &fb.getActivePixels();
+        } else {
+            FbAovShPtr fbAov = getAov(item.mName);
+            if (!fbAov) return nullptr;
+            dirty = (dirtyPixels) ? dirtyPixels : &fbAov->getActivePixels();
+        }
+        return (dirty->getWidth() == width && dirty->getHeight() == height) ? dirty : nullptr;
+    };
+
+    //
+    // phase 1 : update pending pixels of all clients and pick up clients which need FRAME
+    //
+    std::deque<Job> jobs; // deque : jobs include ActivePixels which should not be copied
+    const uint64_t now = getNanoSec();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto &itr : mClients) {
+            Client &client = *(itr.second);
+            if (!client.mSubscribed || client.mBroken) continue;
+
+            if (client.mWidth != width || client.mHeight != height) {
+                // first frame after subscribe or resolution changed
+                client.mWidth = width;
+                client.mHeight = height;
+                client.mRoiMask.init(width, height);
+                setupRoiMask((client.mParam.mRoiActive) ? &client.mParam.mRoi : nullptr, client.mRoiMask);
+                for (auto &item : client.mItems) {
+                    item.mPending.init(width, height);
+                    item.mPending.reset();
+                }
+                client.mNeedFull = true;
+            }
+
+            for (auto &item : client.mItems) {
+                if (const ActivePixels *dirty = getDirtyPixels(item)) {
+                    item.mPending.orOp(*dirty);
+                }
+            }
+
+            if (client.mQueue.size() >= MAX_QUEUED_FRAMES) continue; // client is slow : keep pending
+            if (now < client.mNextSendTime) continue; // rate limit
+
+            Job job;
+            job.mClient = itr.second;
+            job.mGeneration = client.mGeneration;
+            job.mFull = client.mNeedFull;
+            job.mPrecision = client.mParam.mPrecision;
+            for (auto &item : client.mItems) {
+                if (item.mType == FbStreamItemType::AOV && !getAov(item.mName)) continue; // not ready
+                job.mItems.emplace_back();
+                JobItem &jobItem = job.mItems.back();
+                if (job.mFull) {
+                    jobItem.mMask.copy(client.mRoiMask);
+                } else if (!andMask(item.mPending, client.mRoiMask, jobItem.mMask)) {
+                    job.mItems.pop_back();
+                    continue; // nothing updated
+                }
+                jobItem.mType = item.mType;
+                jobItem.mName = item.mName;
+                item.mPending.reset();
+            }
+            if (job.mItems.empty() && !job.mFull) continue;
+
+            client.mNeedFull = false;
+            client.mNextSendTime = now + client.mParam.getMinIntervalNanoSec();
+            jobs.push_back(std::move(job));
+        }
+    }
+    if (jobs.empty()) return;
+
+    //
+    // phase 2 : encode without lock. Encoded data is shared by all the jobs which have the same item,
+    // precision and pixel mask.
+    //
+    const uint64_t frameId = ++mFrameId;
+    std::vector<Encoded> encodedTbl;
+    std::vector<Client::OutMsg> outMsgs(jobs.size());
+    for (size_t jobId = 0; jobId < jobs.size(); ++jobId) {
+        const Job &job = jobs[jobId];
+        Client::OutMsg &outMsg = outMsgs[jobId];
+
+        std::string meta;
+        rdl2::ValueContainerEnq vContainerEnq(&meta);
+        vContainerEnq.enqULong(frameId);
+        vContainerEnq.enqBool(job.mFull);
+        vContainerEnq.enqUInt(width);
+        vContainerEnq.enqUInt(height);
+        vContainerEnq.enqUInt(static_cast<unsigned>(job.mItems.size()));
+
+        uint64_t payloadSize = 0;
+        for (const auto &item : job.mItems) {
+            const ActivePixels &mask = item.mMask;
+
+            std::shared_ptr<const std::string> data;
+            for (const auto &encoded : encodedTbl) {
+                if (encoded.mType == item.mType && encoded.mName == item.mName &&
+                    encoded.mPrecision == job.mPrecision && sameMask(*encoded.mMask, mask)) {
+                    data = encoded.mData;
+                    break;
+                }
+            }
+            if (!data) {
+                const uint64_t start = getNanoSec();
+                auto buff = std::make_shared<std::string>();
+                if (item.mType == FbStreamItemType::BEAUTY) {
+                    PackTiles::encode(false, // renderBufferOdd
+                                      mask,
+                                      fb.getRenderBufferTiled(),
+                                      *buff,
+                                      job.mPrecision,
+                                      fb.getRenderBufferCoarsePassPrecision(),
+                                      fb.getRenderBufferFinePassPrecision());
+                } else {
+                    FbAovShPtr fbAov = getAov(item.mName);
+                    PackTiles::encodeRenderOutputMerge(mask,
+                                                       fbAov->getBufferTiled(),
+                                                       fbAov->getDefaultValue(),
+                                                       *buff,
+                                                       job.mPrecision,
+                                                       fbAov->getClosestFilterStatus(),
+                                                       fbAov->getCoarsePassPrecision(),
+                                                       fbAov->getFinePassPrecision());
+                }
+                mEncodeNanoSec += getNanoSec() - start;
+                mEncodeBytes += buff->size();
+                ++mEncodeTotal;
+
+                data = buff;
+                encodedTbl.push_back(Encoded {item.mType, item.mName, job.mPrecision, &mask, data});
+            }
+
+            vContainerEnq.enqChar(static_cast<char>(item.mType));
+            vContainerEnq.enqString(item.mName);
+            vContainerEnq.enqULong(data->size());
+            payloadSize += data->size();
+            outMsg.mBlocks.push_back(std::move(data));
+        }
+        vContainerEnq.finalize();
+        payloadSize += meta.size();
+
+        FbStreamMsgHeader header;
+        header.mMagic = FbStreamMsgHeader::MAGIC;
+        header.mType = static_cast<uint16_t>(FbStreamMsgHeader::Type::FRAME);
+        header.mPad = 0;
+        header.mPayloadSize = payloadSize;
+        outMsg.mHead.reserve(sizeof(header) + meta.size());
+        outMsg.mHead.append(reinterpret_cast<const char *>(&header), sizeof(header));
+        outMsg.mHead.append(meta);
+    }
+
+    //
+    // phase 3 : enqueue and send as much as possible without blocking. The job is discarded if the client
+    // subscribed again in the meantime (next publish() sends a full frame to it).
+    //
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (size_t jobId = 0; jobId < jobs.size(); ++jobId) {
+            Client &client = *(jobs[jobId].mClient);
+            if (client.mBroken || client.mGeneration != jobs[jobId].mGeneration) continue;
+
+            client.mQueue.push_back(std::move(outMsgs[jobId]));
+            ++client.mFrameSent;
+            ++mFrameTotal;
+            if (!client.mEpollOut) {
+                if (!flushClient(client)) {
+                    client.mBroken = true;
+                } else if (!client.mQueue.empty()) {
+                    updateEpollOut(client, true);
+                }
+            }
+        }
+    }
+}
+
+size_t
+FbStreamServer::getClientTotal() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mClients.size();
+}
+
+size_t
+FbStreamServer::getSubscribedClientTotal() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t total = 0;
+    for (const auto &itr : mClients) {
+        if (itr.second->mSubscribed) ++total;
+    }
+    return total;
+}
+
+std::string
+FbStreamServer::show() const
+{
+    auto perSec = [](uint64_t bytes, uint64_t nanoSec) {
+        return (nanoSec) ? static_cast<double>(bytes) / (static_cast<double>(nanoSec) * 1.0e-9) : 0.0;
+    };
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::ostringstream ostr;
+    ostr << "FbStreamServer {\n"
+         << "  mPort:" << mPort << '\n'
+         << "  mPublishTotal:" << mPublishTotal << '\n'
+         << "  mFrameTotal:" << mFrameTotal << '\n'
+         << "  mEncodeTotal:" << mEncodeTotal
+         << " (" << str_util::byteStr(mEncodeBytes)
+         << ", " << str_util::secStr(static_cast<float>(mEncodeNanoSec * 1.0e-9))
+         << ", " << str_util::byteStr(static_cast<size_t>(perSec(mEncodeBytes, mEncodeNanoSec))) << "/sec)\n"
+         << "  mSentBytes:" << str_util::byteStr(mSentBytes) << '\n'
+         << "  clients (size:" << mClients.size() << ") {\n";
+    for (const auto &itr : mClients) {
+        const Client &client = *(itr.second);
+        ostr << "    clientId:" << client.mId
+             << " addr:" << client.mAddr
+             << ((client.mSubscribed) ? " subscribed" : " idle")
+             << " items:" << client.mItems.size()
+             << " precision:" << PackTiles::showPrecisionMode(client.mParam.mPrecision)
+             << " maxFps:" << client.mParam.mMaxFps
+             << " frameSent:" << client.mFrameSent
+             << " queuedFrames:" << client.mQueue.size()
+             << ((client.mBroken) ? " broken" : "") << '\n';
+    }
+    ostr << "  }\n"
+         << "}";
+    return ostr.str();
+}
+
+//------------------------------------------------------------------------------
+
+void
+FbStreamServer::threadMain()
+{
+    constexpr int maxEvents = 32;
+    struct epoll_event events[maxEvents];
+
+    while (!mThreadShutdown) {
+        int eventTotal = ::epoll_wait(mEpollFd, events, maxEvents, 100); // wait max 100ms
+        if (eventTotal < 0) {
+            if (errno == EINTR) continue;
+            errMsg(str_util::stringCat(" ::epoll_wait() failed. errno:",
+                                       std::to_string(errno), " ", strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < eventTotal; ++i) {
+            const ClientId id = events[i].data.u64;
+            if (id == LISTEN_ID) {
+                acceptClients();
+                continue;
+            }
+            if (id == WAKEUP_ID) {
+                uint64_t count;
+                while (::read(mWakeupFd, &count, sizeof(count)) > 0) {}
+                continue;
+            }
+
+            ClientShPtr client;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                auto itr = mClients.find(id);
+                if (itr == mClients.end()) continue; // already closed
+                client = itr->second;
+            }
+
+            if (events[i].events & EPOLLOUT) {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (!flushClient(*client)) {
+                    client->mBroken = true;
+                } else if (client->mQueue.empty()) {
+                    updateEpollOut(*client, false);
+                }
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                if (!recvClient(*client)) {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    client->mBroken = true;
+                }
+            }
+        }
+
+        // Clients may also be marked broken by publish() on the producer thread.
+        std::vector<ClientId> brokenClients;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (const auto &itr : mClients) {
+                if (itr.second->mBroken) brokenClients.push_back(itr.first);
+            }
+        }
+        for (ClientId id : brokenClients) {
+            closeClient(id);
+        }
+    }
+}
+
+void
+FbStreamServer::wakeup()
+{
+    if (mWakeupFd == -1) return;
+    const uint64_t one = 1;
+    (void)::write(mWakeupFd, &one, sizeof(one));
+}
+
+bool
+FbStreamServer::socketBindAndListen()
+{
+    auto errorMsg = [&](const std::string &msg) {
+        errMsg(str_util::stringCat(msg, " errno:", std::to_string(errno), " (", strerror(errno), ")"));
+        if (mBaseSock != -1) {
+            ::close(mBaseSock);
+            mBaseSock = -1;
+        }
+        return false;
+    };
+
+    if ((mBaseSock = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+        mBaseSock = -1;
+        return errorMsg("::socket() call failed for baseSock.");
+    }
+
+    int status = 1;
+    if (::setsockopt(mBaseSock, SOL_SOCKET, SO_REUSEADDR, (char *)&status, sizeof(status)) < 0) {
+        return errorMsg("set socket option failed. (SO_REUSEADDR)");
+    }
+
+    struct sockaddr_in in;
+    bzero(&in, sizeof(in));
+    in.sin_family = AF_INET;
+    in.sin_addr.s_addr = INADDR_ANY;
+    in.sin_port = htons(static_cast<uint16_t>(mPort)); // put in net order
+    if (::bind(mBaseSock, (struct sockaddr*)&in, sizeof(in)) < 0) {
+        return errorMsg(str_util::stringCat("::bind() socket failed. port:", std::to_string(mPort)));
+    }
+
+    if (mPort == 0) {
+        socklen_t inLen = sizeof(in);
+        if (::getsockname(mBaseSock, (sockaddr*)&in, &inLen) != 0) {
+            return errorMsg("::getsockname() failed.");
+        }
+        mPort = ntohs(in.sin_port);
+    }
+
+    if (::listen(mBaseSock, 16) < 0) {
+        return errorMsg("::listen() failed.");
+    }
+    return true;
+}
+
+void
+FbStreamServer::acceptClients()
+{
+    while (true) {
+        struct sockaddr_in in;
+        socklen_t addrlen = sizeof(in);
+        int sock = ::accept4(mBaseSock, (struct sockaddr *)&in, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (sock < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                errMsg(str_util::stringCat(" ::accept4() returns error. errno:",
+                                           std::to_string(errno), " ", strerror(errno)));
+            }
+            return;
+        }
+
+        int optV = 1; // true
+        ::setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&optV, sizeof(optV));
+        ::setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, (char*)&optV, sizeof(optV));
+        setSockBufferSize(sock, SOL_SOCKET, 4_MiB); // frame data is big
+
+        char addrStr[INET_ADDRSTRLEN] = {0};
+        ::inet_ntop(AF_INET, &in.sin_addr, addrStr, sizeof(addrStr));
+
+        auto client = std::make_shared<Client>();
+        client->mSock = sock;
+        client->mAddr = str_util::stringCat(addrStr, ':', std::to_string(ntohs(in.sin_port)));
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            client->mId = mNextClientId++;
+
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.u64 = client->mId;
+            if (::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, sock, &ev) < 0) {
+                ::close(sock);
+                continue;
+            }
+            mClients[client->mId] = client;
+        }
+
+        infoMsg(str_util::stringCat(" connection established. clientId:", std::to_string(client->mId),
+                                    " addr:", client->mAddr));
+    }
+}
+
+bool
+FbStreamServer::recvClient(Client &client)
+//
+// Returns false if the connection is closed by the other side or broken.
+//
+{
+    char buff[4096];
+    while (true) {
+        const ssize_t rSize = ::read(client.mSock, buff, sizeof(buff));
+        if (rSize == 0) return false; // EOF
+        if (rSize < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break; // empty : try again later
+            return false;
+        }
+        client.mRecvBuff.append(buff, rSize);
+    }
+
+    size_t offset = 0;
+    while (client.mRecvBuff.size() - offset >= sizeof(FbStreamMsgHeader)) {
+        FbStreamMsgHeader header;
+        memcpy(&header, client.mRecvBuff.data() + offset, sizeof(header));
+        if (header.mMagic != FbStreamMsgHeader::MAGIC || header.mPayloadSize > maxRecvPayloadSize) {
+            errMsg(str_util::stringCat(" unknown message from clientId:", std::to_string(client.mId)));
+            return false;
+        }
+        const size_t msgSize = sizeof(header) + header.mPayloadSize;
+        if (client.mRecvBuff.size() - offset < msgSize) break; // wait for the rest of the message
+
+        if (!parseMessage(client, header.mType,
+                          client.mRecvBuff.substr(offset + sizeof(header), header.mPayloadSize))) {
+            return false;
+        }
+        offset += msgSize;
+    }
+    client.mRecvBuff.erase(0, offset);
+    return true;
+}
+
+bool
+FbStreamServer::parseMessage(Client &client, uint16_t type, const std::string &payload)
+{
+    switch (static_cast<FbStreamMsgHeader::Type>(type)) {
+    case FbStreamMsgHeader::Type::SUBSCRIBE : {
+        FbStreamSubscribeParam param;
+        if (!param.decode(payload.data(), payload.size())) {
+            errMsg(str_util::stringCat(" SUBSCRIBE decode failed. clientId:", std::to_string(client.mId)));
+            return false;
+        }
+
+        std::deque<Client::Item> items;
+        if (param.mBeauty) {
+            items.emplace_back();
+            items.back().mType = FbStreamItemType::BEAUTY;
+        }
+        for (const auto &aovName : param.mAovNames) {
+            items.emplace_back();
+            items.back().mType = FbStreamItemType::AOV;
+            items.back().mName = aovName;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            client.mParam = param;
+            client.mItems = std::move(items);
+            client.mSubscribed = true;
+            ++client.mGeneration;
+            client.mWidth = client.mHeight = 0; // re-init pending info by next publish()
+            client.mNeedFull = true;
+            client.mNextSendTime = 0;
+        }
+        infoMsg(str_util::stringCat(" SUBSCRIBE clientId:", std::to_string(client.mId), '\n',
+                                    param.show()));
+    } break;
+
+    case FbStreamMsgHeader::Type::UNSUBSCRIBE : {
+        std::lock_guard<std::mutex> lock(mMutex);
+        client.mSubscribed = false;
+        client.mItems.clear();
+        ++client.mGeneration;
+    } break;
+
+    default :
+        errMsg(str_util::stringCat(" unknown message type:", std::to_string(type),
+                                   " clientId:", std::to_string(client.mId)));
+        return false;
+    }
+    return true;
+}
+
+bool
+FbStreamServer::flushClient(Client &client)
+//
+// Gathers queued data into iovec and sends it by a single sendmsg() without copy.
+// Returns false if the client is broken.
+//
+{
+    while (!client.mQueue.empty()) {
+        struct iovec iov[maxIov];
+        int iovTotal = 0;
+        size_t segId = client.mSegId;
+        size_t segOffset = client.mSegOffset;
+        for (const auto &outMsg : client.mQueue) {
+            for (; segId < outMsg.getSegTotal() && iovTotal < maxIov; ++segId) {
+                const std::string &seg = outMsg.getSeg(segId);
+                if (seg.size() > segOffset) { // empty segments are skipped, the advance below pops them
+                    iov[iovTotal].iov_base = const_cast<char *>(seg.data()) + segOffset;
+                    iov[iovTotal].iov_len = seg.size() - segOffset;
+                    ++iovTotal;
+                }
+                segOffset = 0;
+            }
+            if (iovTotal == maxIov) break;
+            segId = 0;
+        }
+
+        ssize_t sentSize = 0;
+        if (iovTotal > 0) {
+            struct msghdr msg;
+            memset(&msg, 0x0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = iovTotal;
+            sentSize = ::sendmsg(client.mSock, &msg, MSG_NOSIGNAL);
+            if (sentSize < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return true; // socket buffer is full
+                return false;
+            }
+            mSentBytes += sentSize;
+        }
+
+        // Advance the queue. This also pops the empty segments which follow the sent data, so the loop
+        // always makes progress.
+        size_t size = static_cast<size_t>(sentSize);
+        while (!client.mQueue.empty()) {
+            const Client::OutMsg &front = client.mQueue.front();
+            const size_t remain = front.getSeg(client.mSegId).size() - client.mSegOffset;
+            if (size < remain) {
+                client.mSegOffset += size;
+                break;
+            }
+            size -= remain;
+            client.mSegOffset = 0;
+            if (++client.mSegId == front.getSegTotal()) {
+                client.mQueue.pop_front();
+                client.mSegId = 0;
+            }
+        }
+    }
+    return true;
+}
+
+void
+FbStreamServer::updateEpollOut(Client &client, bool wantOut)
+{
+    if (client.mEpollOut == wantOut) return;
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | ((wantOut) ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.u64 = client.mId;
+    if (::epoll_ctl(mEpollFd, EPOLL_CTL_MOD, client.mSock, &ev) == 0) {
+        client.mEpollOut = wantOut;
+    }
+}
+
+void
+FbStreamServer::closeClient(ClientId clientId)
+{
+    ClientShPtr client;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto itr = mClients.find(clientId);
+        if (itr == mClients.end()) return;
+        client = itr->second;
+        mClients.erase(itr);
+        ::epoll_ctl(mEpollFd, EPOLL_CTL_DEL, client->mSock, nullptr);
+        ::close(client->mSock);
+    }
+
+    infoMsg(str_util::stringCat(" connection closed. clientId:", std::to_string(clientId),
+                                " addr:", client->mAddr));
+}
+
+void
+FbStreamServer::errMsg(const std::string &msg) const
+{
+    if (mErrMsgCallBack) mErrMsgCallBack(str_util::stringCat(msgHead, msg));
+}
+
+void
+FbStreamServer::infoMsg(const std::string &msg) const
+{
+    if (mInfoMsgCallBack) mInfoMsgCallBack(str_util::stringCat(msgHead, msg));
+}
+
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,143 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+
+#include "FbStream.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+class FbStreamServer
+//
+// Lightweight TCP server which streams live framebuffer data to subscribed viewers for inspection.
+// (See FbStream.h about the protocol)
+//
+// Each client subscribes to beauty and/or a set of AOVs with its own precision, ROI and max fps. The
+// server keeps the accumulated dirty pixel mask of every subscribed item per client and only sends the
+// pixels updated since the previous FRAME to this client as PackTiles encoded data.
+//
+// The producer calls publish() whenever the Fb is updated. Encoding runs on the producer thread and
+// the same encoded data is shared by all the clients which need exactly the same data (same item,
+// precision and dirty mask), so the cost does not grow with the number of viewers that are in sync.
+// Encoded data is never copied into per-client buffers : every client queue holds references to the
+// shared data and they are directly gathered into the socket by a single sendmsg() (writev style) call.
+//
+// All sockets are non-blocking and handled by an independent epoll thread. A slow client never blocks
+// publish() : if a client still has queued FRAMEs, no new FRAME is made for it and its dirty mask keeps
+// accumulating until the queue drains (i.e. a slow client simply gets lower fps with bigger deltas).
+// Because of this, publish() should be called periodically even if nothing is updated in order to send
+// the pending pixels of throttled clients.
+//
+//    FbStreamServer server;
+//    server.open(20010); // port is 20010
+//    ...
+//    while (rendering) {
+//        ... update fb ...
+//        server.publish(fb); // beauty : fb.getActivePixels(), AOV : fbAov->getActivePixels() are dirty
+//    }
+//    server.close();
+//
+// Please check scene_rdl2/cmd/mcrt_cmd/fbStreamClient/main.cc as an example of the client side.
+//
+{
+public:
+    using ActivePixels = fb_util::ActivePixels;
+    using MsgCallBack = std::function<void(const std::string &)>;
+
+    static constexpr size_t MAX_QUEUED_FRAMES = 2; // per client
+
+    FbStreamServer();
+    ~FbStreamServer();
+
+    // Non-copyable
+    FbStreamServer &operator =(const FbStreamServer &) = delete;
+    FbStreamServer(const FbStreamServer &) = delete;
+
+    //
+    // Opens the listen socket and boots the server thread. You can use serverPortNum = 0 for auto
+    // search of available port by the kernel. Returns opened port number, 0 is error.
+    //
+    int open(const int serverPortNum,
+             MsgCallBack infoMsgCallBack = nullptr,
+             MsgCallBack errMsgCallBack = nullptr);
+    void close();
+
+    int getPort() const { return mPort; }
+
+    //
+    // Sends updated pixels of fb to all the subscribed clients. Should be called by a single producer
+    // thread and fb should not be updated during this call.
+    // dirtyPixels is used as updated pixel mask of all items. If dirtyPixels is nullptr,
+    // fb.getActivePixels() is used for beauty and each FbAov's activePixels is used for AOV.
+    //
+    void publish(const Fb &fb, const ActivePixels *dirtyPixels = nullptr);
+
+    size_t getClientTotal() const;
+    size_t getSubscribedClientTotal() const; // clients whose SUBSCRIBE has been received
+
+    std::string show() const;
+
+private:
+    struct Client;
+    using ClientShPtr = std::shared_ptr<Client>;
+    using ClientId = uint64_t;
+
+    static constexpr ClientId LISTEN_ID = 0;
+    static constexpr ClientId WAKEUP_ID = 1;
+
+    void threadMain();
+    void wakeup();
+
+    bool socketBindAndListen();
+    void acceptClients();
+    bool recvClient(Client &client); // return false if closed
+    bool parseMessage(Client &client, uint16_t type, const std::string &payload);
+    bool flushClient(Client &client); // need mMutex locked. return false if the client is broken
+    void updateEpollOut(Client &client, bool wantOut); // need mMutex locked
+    void closeClient(ClientId clientId);
+
+    void errMsg(const std::string &msg) const;
+    void infoMsg(const std::string &msg) const;
+
+    //------------------------------
+
+    int mPort {0};
+    int mBaseSock {-1};
+    int mEpollFd {-1};
+    int mWakeupFd {-1};
+
+    MsgCallBack mInfoMsgCallBack;
+    MsgCallBack mErrMsgCallBack;
+
+    std::thread mThread;
+    std::atomic<bool> mThreadShutdown {false};
+
+    uint64_t mFrameId {0}; // only accessed by publish()
+
+    mutable std::mutex mMutex; // for mClients and all the client's state
+    ClientId mNextClientId {WAKEUP_ID + 1};
+    std::map<ClientId, ClientShPtr> mClients;
+
+    // statistics
+    std::atomic<uint64_t> mPublishTotal {0};
+    std::atomic<uint64_t> mFrameTotal {0};    // FRAME messages queued for all clients
+    std::atomic<uint64_t> mEncodeTotal {0};   // PackTiles encode calls
+    std::atomic<uint64_t> mEncodeBytes {0};
+    std::atomic<uint64_t> mEncodeNanoSec {0};
+    std::atomic<uint64_t> mSentBytes {0};
+};
+
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -4,6 +4,8 @@
 //
 //
 #include "Fb.h"
+
+#include <scene_rdl2/common/rec_time/RecScopeProfiler.h>
 #include <scene_rdl2/render/logging/logging.h>
 
 namespace scene_rdl2 {
@@ -13,6 +15,7 @@ void
 Fb::accumulateRenderBuffer(const PartialMergeTilesTbl* partialMergeTilesTbl,
                            const Fb& src)
 {
+    REC_SCOPE_PROFILE("Fb::accumulateRenderBuffer");
     operatorOnPartialTiles(partialMergeTilesTbl, [&](int tileId) {
             accumulateRenderBufferOneTile(src, tileId);
 
@@ -35,6 +38,7 @@ void
 Fb::accumulatePixelInfo(const PartialMergeTilesTbl* partialMergeTilesTbl,
                         const Fb& src)
 {
+    REC_SCOPE_PROFILE("Fb::accumulatePixelInfo");
     if (!src.getPixelInfoStatus()) return;
     setupPixelInfo(partialMergeTilesTbl, src.getPixelInfoName());
 
@@ -47,6 +51,7 @@ void
 Fb::accumulateHeatMap(const PartialMergeTilesTbl* partialMergeTilesTbl,
                       const Fb& src)
 {
+    REC_SCOPE_PROFILE("Fb::accumulateHeatMap");
     if (!src.getHeatMapStatus()) return;
     setupHeatMap(partialMergeTilesTbl, src.getHeatMapName());
 
@@ -58,6 +63,7 @@ Fb::accumulateHeatMap(const PartialMergeTilesTbl* partialMergeTilesTbl,
 void
 Fb::accumulateWeightBuffer(const PartialMergeTilesTbl* partialMergeTilesTbl, const Fb& src)
 {
+    REC_SCOPE_PROFILE("Fb::accumulateWeightBuffer");
     if (!src.getWeightBufferStatus()) return;
     setupWeightBuffer(partialMergeTilesTbl, src.getWeightBufferName());
 
@@ -69,6 +75,7 @@ Fb::accumulateWeightBuffer(const PartialMergeTilesTbl* partialMergeTilesTbl, con
 void
 Fb::accumulateRenderBufferOdd(const PartialMergeTilesTbl* partialMergeTilesTbl, const Fb& src)
 {
+    REC_SCOPE_PROFILE("Fb::accumulateRenderBufferOdd");
     if (!src.getRenderBufferOddStatus()) return;
     setupRenderBufferOdd(partialMergeTilesTbl);
 
@@ -82,6 +89,7 @@ Fb::accumulateRenderOutput(const PartialMergeTilesTbl* partialMergeTilesTbl,
                            const Fb& srcFb)
 // This function is used on progmcrt_merge computation
 {
+    REC_SCOPE_PROFILE("Fb::accumulateRenderOutput");
     if (!srcFb.getRenderOutputStatus()) return;
 
     operatorOnAllActiveAov(srcFb, [&](const FbAovShPtr& srcFbAov, FbAovShPtr& dstFbAov) {
@@ -148,6 +156,7 @@ Fb::accumulateAllFbs(const int numMachines,
 // This function is used on progmcrt_merge computation
 //
 {
+    REC_SCOPE_PROFILE("Fb::accumulateAllFbs");
     auto bufferSetupFunc = [&](unsigned bufferId, const Fb& src) {
         switch (bufferId) {
         case 0 : {
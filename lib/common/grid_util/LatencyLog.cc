@@ -24,6 +24,19 @@ LatencyClockOffset::getInstance()
 
 //------------------------------------------------------------------------------
 
+// static
+int64_t
+LatencyClock::calcWallAnchor()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0x0);
+    const int64_t wallMicroSec =
+        static_cast<int64_t>(tv.tv_sec) * 1000 * 1000 + static_cast<int64_t>(tv.tv_usec);
+    return wallMicroSec - static_cast<int64_t>(getMonotonicMicroSec());
+}
+
+//------------------------------------------------------------------------------
+
 std::string
 LatencyItem::show(const std::string &hd, const uint64_t timeBase, const uint32_t prevTime,
                   const int allTimeLen, const int deltaTimeLen) const
@@ -156,6 +169,19 @@ LatencyItem::keyStr(const Key &key)
     return "?";
 }
 
+// static
+bool
+LatencyItem::strToKey(const std::string &str, Key &key)
+{
+    for (uint32_t i = 0; i <= static_cast<uint32_t>(Key::MERGE_SEND_MSG); ++i) {
+        if (keyStr(static_cast<Key>(i)) == str) {
+            key = static_cast<Key>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
 std::string
 LatencyItem::usec2msecStr(const uint64_t uSec, const int len)
 {
@@ -214,6 +240,18 @@ LatencyLog::show(const std::string &hd) const
     return ostr.str();
 }
 
+bool
+LatencyLog::findTime(const LatencyItem::Key key, uint64_t &time, size_t startId) const
+{
+    for (size_t id = startId; id < mLog.size(); ++id) {
+        if (mLog[id].key() == key) {
+            time = mTimeBase + mLog[id].time();
+            return true;
+        }
+    }
+    return false;
+}
+
 std::string
 LatencyLog::idStr(const size_t id, const size_t numDigit) const
 {
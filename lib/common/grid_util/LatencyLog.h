@@ -20,6 +20,7 @@
 #include <vector>
 
 #include <sys/time.h>
+#include <time.h>
 
 //
 // We should always use variable length coding.
@@ -57,6 +58,43 @@ protected:
     float mOffsetMs;            // ms
 }; // LatencyClockOffset
 
+class LatencyClock
+{
+//
+// Monotonic microsecond clock for latency timestamps.
+// Based on CLOCK_MONOTONIC (TSC based and read through the vDSO on linux, so no system call) and anchored
+// once to the wall clock, so values stay comparable with other hosts' timestamps after the
+// LatencyClockOffset correction, but never jump backward when the wall clock is adjusted.
+//
+public:
+    finline static uint64_t getCurrentMicroSec(); // LatencyClockOffset corrected
+
+private:
+    finline static uint64_t getMonotonicMicroSec();
+    static int64_t calcWallAnchor();
+}; // LatencyClock
+
+finline uint64_t
+LatencyClock::getMonotonicMicroSec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 * 1000 + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+finline uint64_t
+LatencyClock::getCurrentMicroSec()
+{
+    static const int64_t wallAnchor = calcWallAnchor(); // wall clock - monotonic clock : usec
+    uint64_t microSec = static_cast<uint64_t>(static_cast<int64_t>(getMonotonicMicroSec()) + wallAnchor);
+    if (LatencyClockOffset::getInstance().isPositive()) {
+        microSec += LatencyClockOffset::getInstance().getAbsOffsetMicroSec();
+    } else {
+        microSec -= LatencyClockOffset::getInstance().getAbsOffsetMicroSec();
+    }
+    return microSec;
+}
+
 class LatencyItem
 {
 public:    
@@ -169,6 +207,8 @@ public:
     }
 
     uint32_t time() const { return mTime; }
+    Key key() const { return mKey; }
+    const std::vector<uint32_t> &data() const { return mData; }
 
     finline static uint64_t getCurrentMicroSec();
     finline static uint64_t getLatencyMicroSec(const uint64_t startTime);
@@ -184,27 +224,20 @@ public:
     // micro-sec to milli-sec conversion and output by string
     static std::string usec2msecStr(const uint64_t uSec, const int len = 6); // %len.2 (default %6.2)
 
+    static std::string keyStr(const Key &key);
+    static bool strToKey(const std::string &str, Key &key); // return false if str is not a key name
+
 protected:
     uint32_t mTime;             // delta time from timeBase (start) by usec (micro-sec)
     Key mKey;
 
     std::vector<uint32_t> mData;
-
-    static std::string keyStr(const Key &key);
 }; // LatencyItem
 
 finline uint64_t
 LatencyItem::getCurrentMicroSec()
 {
-    struct timeval tv;
-    gettimeofday(&tv, 0x0);
-    uint64_t microSec = static_cast<uint64_t>(tv.tv_sec) * 1000 * 1000 + static_cast<uint64_t>(tv.tv_usec);
-    if (LatencyClockOffset::getInstance().isPositive()) {
-        microSec += LatencyClockOffset::getInstance().getAbsOffsetMicroSec();
-    } else {
-        microSec -= LatencyClockOffset::getInstance().getAbsOffsetMicroSec();
-    }
-    return microSec;
+    return LatencyClock::getCurrentMicroSec();
 }
 
 finline uint64_t
@@ -302,7 +335,15 @@ public:
     finline void decode(VContainerDeq &vContainerDeq);
     finline void decode(const void *data, const size_t dataSize);
 
+    const std::string &getName() const { return mName; }
+    uint32_t getSnapshotId() const { return mSnapshotId; }
+    size_t getDataSize() const { return mDataSize; }
     uint64_t getTimeBase() const { return mTimeBase; }
+    const std::vector<LatencyItem> &getItems() const { return mLog; }
+
+    // Absolute time (LatencyClock usec) of the first item with the given key after item startId.
+    // Returns false if there is no such item.
+    bool findTime(const LatencyItem::Key key, uint64_t &time, size_t startId = 0) const;
 
     std::string show(const std::string &hd) const;
 
@@ -446,6 +487,8 @@ public:
 
     std::string show(const std::string &hd) const;
 
+    const std::vector<std::vector<LatencyLog>> &getMachines() const { return mMachine; }
+
 protected:
 
     std::vector<std::vector<LatencyLog>> mMachine;
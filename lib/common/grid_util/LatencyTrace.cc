@@ -0,0 +1,300 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "LatencyTrace.h"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+const char sMagic[4] = {'L', 'T', 'R', 'C'};
+const uint32_t sVersion = 1;
+
+} // namespace
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+bool
+LatencyTraceWriter::open(const std::string &filename)
+{
+    close();
+    mFp = fopen(filename.c_str(), "wb");
+    if (!mFp) return false;
+    mRecordTotal = 0;
+    return (fwrite(sMagic, sizeof(sMagic), 1, mFp) == 1 &&
+            fwrite(&sVersion, sizeof(sVersion), 1, mFp) == 1);
+}
+
+void
+LatencyTraceWriter::close()
+{
+    if (mFp) {
+        fclose(mFp);
+        mFp = nullptr;
+    }
+}
+
+bool
+LatencyTraceWriter::write(const LatencyLog &log, const void *upstreamData, const size_t upstreamDataSize)
+{
+    if (!mFp) return false;
+
+    mWork.clear();
+    rdl2::ValueContainerEnq vContainerEnq(&mWork);
+    log.encode(vContainerEnq);
+    const uint32_t logSize = static_cast<uint32_t>(vContainerEnq.finalize());
+    const uint32_t upstreamSize = (upstreamData) ? static_cast<uint32_t>(upstreamDataSize) : 0;
+
+    if (fwrite(&logSize, sizeof(logSize), 1, mFp) != 1 ||
+        fwrite(mWork.data(), 1, logSize, mFp) != logSize ||
+        fwrite(&upstreamSize, sizeof(upstreamSize), 1, mFp) != 1 ||
+        (upstreamSize && fwrite(upstreamData, 1, upstreamSize, mFp) != upstreamSize)) {
+        return false;
+    }
+    ++mRecordTotal;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool
+LatencyTraceReader::open(const std::string &filename, std::string &errorMsg)
+{
+    close();
+    mFp = fopen(filename.c_str(), "rb");
+    if (!mFp) {
+        errorMsg = "could not open file:" + filename;
+        return false;
+    }
+
+    char magic[sizeof(sMagic)];
+    uint32_t version = 0;
+    if (fread(magic, sizeof(magic), 1, mFp) != 1 || std::memcmp(magic, sMagic, sizeof(sMagic)) != 0 ||
+        fread(&version, sizeof(version), 1, mFp) != 1) {
+        errorMsg = "not a LatencyLog trace file:" + filename;
+        close();
+        return false;
+    }
+    if (version != sVersion) {
+        std::ostringstream ostr;
+        ostr << "unsupported LatencyLog trace version:" << version << " file:" << filename;
+        errorMsg = ostr.str();
+        close();
+        return false;
+    }
+    return true;
+}
+
+void
+LatencyTraceReader::close()
+{
+    if (mFp) {
+        fclose(mFp);
+        mFp = nullptr;
+    }
+}
+
+bool
+LatencyTraceReader::next()
+{
+    if (!mFp) return false;
+
+    if (!readBlock(mWork) || mWork.empty()) return false;
+    mLog.decode(mWork.data(), mWork.size());
+
+    if (!readBlock(mWork)) return false;
+    mHasUpstream = !mWork.empty();
+    if (mHasUpstream) {
+        mUpstream.decode(mWork.data(), mWork.size());
+    } else {
+        mUpstream.reset();
+    }
+    return true;
+}
+
+bool
+LatencyTraceReader::readBlock(std::string &out)
+{
+    uint32_t size = 0;
+    if (fread(&size, sizeof(size), 1, mFp) != 1) return false;
+    out.resize(size);
+    return (size == 0 || fread(&out[0], 1, size, mFp) == size);
+}
+
+//------------------------------------------------------------------------------
+
+LatencyHistogram::LatencyHistogram() :
+    mBuckets(calcBucketId(~uint64_t(0)) + 1, 0)
+{
+    reset();
+}
+
+void
+LatencyHistogram::reset()
+{
+    std::fill(mBuckets.begin(), mBuckets.end(), 0);
+    mCount = 0;
+    mSum = 0;
+    mMin = ~uint64_t(0);
+    mMax = 0;
+}
+
+void
+LatencyHistogram::record(const uint64_t uSec)
+{
+    ++mBuckets[calcBucketId(uSec)];
+    ++mCount;
+    mSum += uSec;
+    if (uSec < mMin) mMin = uSec;
+    if (uSec > mMax) mMax = uSec;
+}
+
+void
+LatencyHistogram::merge(const LatencyHistogram &src)
+{
+    for (size_t i = 0; i < mBuckets.size(); ++i) mBuckets[i] += src.mBuckets[i];
+    mCount += src.mCount;
+    mSum += src.mSum;
+    if (src.mCount && src.mMin < mMin) mMin = src.mMin;
+    if (src.mMax > mMax) mMax = src.mMax;
+}
+
+uint64_t
+LatencyHistogram::getPercentile(const double percent) const
+{
+    if (!mCount) return 0;
+
+    // Rank of the requested sample (1 base), then walk buckets up to it.
+    uint64_t rank = (uint64_t)(percent / 100.0 * (double)mCount + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > mCount) rank = mCount;
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < mBuckets.size(); ++i) {
+        total += mBuckets[i];
+        if (total >= rank) {
+            const uint64_t v = calcBucketMax(i);
+            return (v < mMax) ? v : mMax;
+        }
+    }
+    return mMax;
+}
+
+std::string
+LatencyHistogram::show() const
+{
+    std::ostringstream ostr;
+    ostr << "count:" << std::setw(7) << mCount
+         << " min:" << LatencyItem::usec2msecStr(getMin(), 7)
+         << " p50:" << LatencyItem::usec2msecStr(getPercentile(50.0), 7)
+         << " p90:" << LatencyItem::usec2msecStr(getPercentile(90.0), 7)
+         << " p99:" << LatencyItem::usec2msecStr(getPercentile(99.0), 7)
+         << " p999:" << LatencyItem::usec2msecStr(getPercentile(99.9), 7)
+         << " max:" << LatencyItem::usec2msecStr(getMax(), 7)
+         << " mean:" << LatencyItem::usec2msecStr((uint64_t)getMean(), 7) << " (ms)";
+    return ostr.str();
+}
+
+// static function
+size_t
+LatencyHistogram::calcBucketId(const uint64_t v)
+{
+    if (v < 2 * sSubBucketTotal) return static_cast<size_t>(v); // exact for small values
+    const unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(v));
+    const unsigned shift = msb - sSubBucketBits;
+    return (shift + 1) * sSubBucketTotal + static_cast<size_t>((v >> shift) - sSubBucketTotal);
+}
+
+// static function
+uint64_t
+LatencyHistogram::calcBucketMax(const size_t bucketId)
+{
+    if (bucketId < 2 * sSubBucketTotal) return bucketId;
+    const unsigned shift = static_cast<unsigned>(bucketId / sSubBucketTotal) - 1;
+    const uint64_t sub = bucketId % sSubBucketTotal + sSubBucketTotal;
+    return ((sub + 1) << shift) - 1;
+}
+
+//------------------------------------------------------------------------------
+
+void
+LatencyHistogramSet::addPair(const Key from, const Key to)
+{
+    mPairs.push_back(Pair {from, to, LatencyHistogram()});
+}
+
+void
+LatencyHistogramSet::addDefaultPairs()
+{
+    // mcrt computation
+    addPair(Key::START, Key::SEND_MSG);
+    addPair(Key::ENCODE_START_BEAUTY, Key::ENCODE_END_BEAUTY);
+    // mcrt -> mcrt_merge transfer
+    addPair(Key::SEND_MSG, Key::RECV_PROGRESSIVEFRAME_END);
+    // mcrt_merge computation
+    addPair(Key::RECV_PROGRESSIVEFRAME_START, Key::RECV_PROGRESSIVEFRAME_END);
+    addPair(Key::MERGE_PROGRESSIVEFRAME_DEQ_START, Key::MERGE_PROGRESSIVEFRAME_DEQ_END);
+    addPair(Key::START, Key::MERGE_SEND_MSG);
+}
+
+void
+LatencyHistogramSet::add(const LatencyLog &log)
+{
+    for (Pair &pair : mPairs) {
+        uint64_t fromTime, toTime;
+        if (log.findTime(pair.mFrom, fromTime) && log.findTime(pair.mTo, toTime) && fromTime <= toTime) {
+            pair.mHistogram.record(toTime - fromTime);
+        }
+    }
+}
+
+void
+LatencyHistogramSet::add(const LatencyLog &fromLog, const LatencyLog &toLog)
+{
+    for (Pair &pair : mPairs) {
+        uint64_t fromTime, toTime;
+        if (fromLog.findTime(pair.mTo, toTime)) continue; // already handled by add(fromLog)
+        if (fromLog.findTime(pair.mFrom, fromTime) && toLog.findTime(pair.mTo, toTime) && fromTime <= toTime) {
+            pair.mHistogram.record(toTime - fromTime);
+        }
+    }
+}
+
+void
+LatencyHistogramSet::add(const LatencyLogUpstream &upstream, const LatencyLog &log)
+{
+    add(log);
+    for (const auto &machineLogs : upstream.getMachines()) {
+        for (const LatencyLog &upstreamLog : machineLogs) {
+            add(upstreamLog);
+            add(upstreamLog, log);
+        }
+    }
+}
+
+std::string
+LatencyHistogramSet::show() const
+{
+    size_t nameLen = 0;
+    std::vector<std::string> names;
+    for (const Pair &pair : mPairs) {
+        names.push_back(LatencyItem::keyStr(pair.mFrom) + " -> " + LatencyItem::keyStr(pair.mTo));
+        nameLen = std::max(nameLen, names.back().size());
+    }
+
+    std::ostringstream ostr;
+    ostr << "LatencyHistogramSet (total:" << mPairs.size() << ") {\n";
+    for (size_t i = 0; i < mPairs.size(); ++i) {
+        ostr << "  " << std::setw(nameLen) << std::left << names[i] << std::right << " "
+             << mPairs[i].mHistogram.show() << '\n';
+    }
+    ostr << "}";
+    return ostr.str();
+}
+
+} // namespace grid_util
+} // namespace scene_rdl2
+
@@ -0,0 +1,160 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+//
+// -- Binary trace files and latency histograms for LatencyLog --
+//
+// LatencyLog::show() is fine for looking at a single frame, but tail latency only shows up across
+// thousands of frames. LatencyTraceWriter appends LatencyLogs (optionally with the LatencyLogUpstream
+// received for the same frame) to a compact binary file, LatencyTraceReader reads them back and
+// LatencyHistogramSet builds per key pair (e.g. SEND_MSG -> RECV_PROGRESSIVEFRAME_END) histograms
+// reporting p50/p99/p999. See cmd/mcrt_cmd/latencyTraceDump.
+//
+// File layout (native byte order) :
+//   header : "LTRC" uint32:version
+//   record : uint32:logSize byte[logSize]:LatencyLog::encode() result
+//            uint32:upstreamSize byte[upstreamSize]:LatencyLogUpstream data (upstreamSize may be 0)
+//
+
+#include "LatencyLog.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+class LatencyTraceWriter
+{
+public:
+    LatencyTraceWriter() : mFp(nullptr), mRecordTotal(0) {}
+    ~LatencyTraceWriter() { close(); }
+
+    // Non-copyable
+    LatencyTraceWriter &operator =(const LatencyTraceWriter &) = delete;
+    LatencyTraceWriter(const LatencyTraceWriter &) = delete;
+
+    bool open(const std::string &filename); // creates or truncates the file
+    void close();
+    bool isOpen() const { return mFp != nullptr; }
+
+    // upstreamData is the LatencyLogUpstream data which arrived together with this frame (if any).
+    bool write(const LatencyLog &log, const void *upstreamData = nullptr, const size_t upstreamDataSize = 0);
+
+    size_t getRecordTotal() const { return mRecordTotal; }
+
+protected:
+    FILE *mFp;
+    size_t mRecordTotal;
+    std::string mWork;          // encode buffer, reused
+};
+
+class LatencyTraceReader
+{
+public:
+    LatencyTraceReader() : mFp(nullptr) {}
+    ~LatencyTraceReader() { close(); }
+
+    // Non-copyable
+    LatencyTraceReader &operator =(const LatencyTraceReader &) = delete;
+    LatencyTraceReader(const LatencyTraceReader &) = delete;
+
+    bool open(const std::string &filename, std::string &errorMsg);
+    void close();
+
+    // Reads the next record. Returns false at the end of the file or on a broken record.
+    bool next();
+
+    const LatencyLog &getLog() const { return mLog; }
+    bool hasUpstream() const { return mHasUpstream; }
+    const LatencyLogUpstream &getUpstream() const { return mUpstream; }
+
+protected:
+    FILE *mFp;
+    std::string mWork;
+
+    LatencyLog mLog;
+    bool mHasUpstream {false};
+    LatencyLogUpstream mUpstream;
+
+    bool readBlock(std::string &out);
+};
+
+//------------------------------------------------------------------------------
+
+class LatencyHistogram
+{
+//
+// HDR style log-linear histogram of usec values. Every power of 2 range is split into 32 buckets,
+// so recorded values are kept with a relative error of ~3% (values below 64 usec exactly) in a
+// fixed size table, whatever the number of samples.
+//
+public:
+    LatencyHistogram();
+
+    void reset();
+    void record(const uint64_t uSec);
+    void merge(const LatencyHistogram &src);
+
+    uint64_t getCount() const { return mCount; }
+    uint64_t getMin() const { return (mCount) ? mMin : 0; }
+    uint64_t getMax() const { return mMax; }
+    double getMean() const { return (mCount) ? (double)mSum / (double)mCount : 0.0; }
+    uint64_t getPercentile(const double percent) const; // percent : 0.0 ~ 100.0
+
+    std::string show() const; // single line : count/min/p50/p90/p99/p999/max/mean by ms
+
+protected:
+    static constexpr unsigned sSubBucketBits = 5;
+    static constexpr unsigned sSubBucketTotal = 1 << sSubBucketBits;
+
+    static size_t calcBucketId(const uint64_t v);
+    static uint64_t calcBucketMax(const size_t bucketId); // largest value which goes into the bucket
+
+    std::vector<uint64_t> mBuckets;
+    uint64_t mCount;
+    uint64_t mSum;
+    uint64_t mMin;
+    uint64_t mMax;
+};
+
+class LatencyHistogramSet
+{
+//
+// Latency histograms for the time between pairs of LatencyItem keys.
+//
+public:
+    using Key = LatencyItem::Key;
+
+    void addPair(const Key from, const Key to);
+    void addDefaultPairs(); // typical mcrt / mcrt_merge pairs
+    size_t getPairTotal() const { return mPairs.size(); }
+
+    // Pairs where both keys are found in the log.
+    void add(const LatencyLog &log);
+    // Pairs where "from" is in fromLog and "to" is only found in toLog. LatencyLog time bases are
+    // LatencyClockOffset corrected, so this works across hosts.
+    void add(const LatencyLog &fromLog, const LatencyLog &toLog);
+    // Both of above for the log itself and every upstream log of the same frame.
+    void add(const LatencyLogUpstream &upstream, const LatencyLog &log);
+
+    const LatencyHistogram &getHistogram(const size_t pairId) const { return mPairs[pairId].mHistogram; }
+
+    std::string show() const;
+
+protected:
+    struct Pair {
+        Key mFrom;
+        Key mTo;
+        LatencyHistogram mHistogram;
+    };
+
+    std::vector<Pair> mPairs;
+};
+
+} // namespace grid_util
+} // namespace scene_rdl2
+
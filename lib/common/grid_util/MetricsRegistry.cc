@@ -0,0 +1,590 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "MetricsRegistry.h"
+
+#include <scene_rdl2/render/util/StrUtil.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include <string.h>
+
+namespace {
+
+std::string
+valStr(const double v)
+//
+// Prometheus style number string. Also used for JSON (non finite value is replaced by null).
+//
+{
+    if (std::isnan(v)) return "NaN";
+    if (std::isinf(v)) return (v > 0.0) ? "+Inf" : "-Inf";
+    char buff[64];
+    snprintf(buff, sizeof(buff), "%.15g", v);
+    return buff;
+}
+
+std::string
+jsonValStr(const double v)
+{
+    return (std::isfinite(v)) ? valStr(v) : "null";
+}
+
+std::string
+jsonStr(const std::string &str)
+{
+    std::ostringstream ostr;
+    ostr << '"';
+    for (const char c : str) {
+        switch (c) {
+        case '"': ostr << "\\\""; break;
+        case '\\': ostr << "\\\\"; break;
+        case '\n': ostr << "\\n"; break;
+        case '\t': ostr << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                ostr << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+            } else {
+                ostr << c;
+            }
+        }
+    }
+    ostr << '"';
+    return ostr.str();
+}
+
+std::string
+promHelpStr(const std::string &str)
+{
+    std::string out;
+    for (const char c : str) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+uint64_t
+MetricsCounter::get() const
+{
+    uint64_t total = 0;
+    for (const auto &shard : mShards) total += shard.mValue.load(std::memory_order_relaxed);
+    return total;
+}
+
+void
+MetricsCounter::reset()
+{
+    for (auto &shard : mShards) shard.mValue.store(0, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------------------
+
+void
+MetricsGauge::add(const double delta)
+{
+    double curr = mValue.load(std::memory_order_relaxed);
+    while (!mValue.compare_exchange_weak(curr, curr + delta, std::memory_order_relaxed)) {}
+}
+
+//------------------------------------------------------------------------------------------
+
+double
+MetricsHistogram::Snapshot::getPercentile(const float fraction) const
+{
+    if (!mTotal) return 0.0;
+    const uint64_t target = std::max(static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(mTotal))),
+                                     static_cast<uint64_t>(1));
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < mCounts.size(); ++i) {
+        cumulative += mCounts[i];
+        if (cumulative >= target) {
+            return (i < mBounds.size()) ? mBounds[i] : std::numeric_limits<double>::infinity();
+        }
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+MetricsHistogram::MetricsHistogram(const std::vector<double> &bounds)
+    : mBounds(bounds)
+{
+    std::sort(mBounds.begin(), mBounds.end());
+    mBounds.erase(std::unique(mBounds.begin(), mBounds.end()), mBounds.end());
+    mBounds.erase(std::remove_if(mBounds.begin(), mBounds.end(),
+                                 [](const double v) { return !std::isfinite(v); }), mBounds.end());
+
+    for (auto &shard : mShards) {
+        shard.mCounts.reset(new std::atomic<uint64_t>[mBounds.size() + 1]);
+        for (size_t i = 0; i <= mBounds.size(); ++i) shard.mCounts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void
+MetricsHistogram::observe(const double v)
+{
+    const size_t bucketId = std::lower_bound(mBounds.begin(), mBounds.end(), v) - mBounds.begin();
+    Shard &shard = mShards[MetricsShard::getId()];
+    shard.mCounts[bucketId].fetch_add(1, std::memory_order_relaxed);
+
+    // Only the threads which share the same shard compete, so the CAS loop almost always succeeds at once.
+    double curr = shard.mSum.load(std::memory_order_relaxed);
+    while (!shard.mSum.compare_exchange_weak(curr, curr + v, std::memory_order_relaxed)) {}
+}
+
+MetricsHistogram::Snapshot
+MetricsHistogram::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.mBounds = mBounds;
+    snapshot.mCounts.resize(mBounds.size() + 1, 0);
+    for (const auto &shard : mShards) {
+        for (size_t i = 0; i <= mBounds.size(); ++i) {
+            const uint64_t count = shard.mCounts[i].load(std::memory_order_relaxed);
+            snapshot.mCounts[i] += count;
+            snapshot.mTotal += count;
+        }
+        snapshot.mSum += shard.mSum.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+void
+MetricsHistogram::reset()
+{
+    for (auto &shard : mShards) {
+        for (size_t i = 0; i <= mBounds.size(); ++i) shard.mCounts[i].store(0, std::memory_order_relaxed);
+        shard.mSum.store(0.0, std::memory_order_relaxed);
+    }
+}
+
+// static function
+std::vector<double>
+MetricsHistogram::exponentialBounds(const double start, const double factor, const unsigned total)
+{
+    std::vector<double> bounds;
+    double v = start;
+    for (unsigned i = 0; i < total; ++i) {
+        bounds.push_back(v);
+        v *= factor;
+    }
+    return bounds;
+}
+
+// static function
+std::vector<double>
+MetricsHistogram::linearBounds(const double start, const double width, const unsigned total)
+{
+    std::vector<double> bounds;
+    for (unsigned i = 0; i < total; ++i) {
+        bounds.push_back(start + width * static_cast<double>(i));
+    }
+    return bounds;
+}
+
+//------------------------------------------------------------------------------------------
+
+// static function
+MetricsRegistry &
+MetricsRegistry::get()
+//
+// Singleton definition about MetricsRegistry
+//
+{
+    static MetricsRegistry instance;
+    return instance;
+}
+
+MetricsCounter &
+MetricsRegistry::counter(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Entry &entry = findOrAdd(name, Type::COUNTER, help);
+    if (!entry.mCounter) entry.mCounter.reset(new MetricsCounter);
+    return *entry.mCounter;
+}
+
+MetricsGauge &
+MetricsRegistry::gauge(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Entry &entry = findOrAdd(name, Type::GAUGE, help);
+    if (!entry.mGauge) entry.mGauge.reset(new MetricsGauge);
+    return *entry.mGauge;
+}
+
+MetricsHistogram &
+MetricsRegistry::histogram(const std::string &name,
+                           const std::string &help,
+                           const std::vector<double> &bounds)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Entry &entry = findOrAdd(name, Type::HISTOGRAM, help);
+    if (!entry.mHistogram) entry.mHistogram.reset(new MetricsHistogram(bounds));
+    return *entry.mHistogram; // bounds of the already registered histogram are kept as is
+}
+
+void
+MetricsRegistry::gaugeFunc(const std::string &name, const std::string &help, const GaugeFunc &func)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Entry &entry = findOrAdd(name, Type::GAUGE_FUNC, help);
+    entry.mGaugeFunc = func; // replace
+}
+
+void
+MetricsRegistry::removeGaugeFunc(const std::string &name)
+//
+// Only the gaugeFunc is removable. Other metrics are referenced by the caller without any lookup.
+//
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto itr = mEntries.find(name);
+    if (itr != mEntries.end() && itr->second.mType == Type::GAUGE_FUNC) {
+        mEntries.erase(itr);
+    }
+}
+
+std::vector<std::string>
+MetricsRegistry::getNames() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<std::string> names;
+    for (const auto &itr : mEntries) names.push_back(itr.first);
+    return names;
+}
+
+void
+MetricsRegistry::resetAll()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto &itr : mEntries) {
+        Entry &entry = itr.second;
+        if (entry.mCounter) entry.mCounter->reset();
+        if (entry.mHistogram) entry.mHistogram->reset();
+    }
+}
+
+std::string
+MetricsRegistry::showList() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t nameW = 0;
+    for (const auto &itr : mEntries) nameW = std::max(nameW, itr.first.size());
+
+    std::ostringstream ostr;
+    ostr << "metrics (total:" << mEntries.size() << ") {\n";
+    for (const auto &itr : mEntries) {
+        ostr << "  " << std::setw(nameW) << std::left << itr.first << ' '
+             << std::setw(9) << std::left << typeStr(itr.second.mType) << ' ' << itr.second.mHelp << '\n';
+    }
+    ostr << "}";
+    return ostr.str();
+}
+
+std::string
+MetricsRegistry::show(const std::string &name) const
+{
+    const GaugeValues gaugeValues = evalGaugeFuncs(name);
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto showEntry = [&](const std::string &name, const Entry &entry) {
+        std::ostringstream ostr;
+        ostr << name << " (" << typeStr(entry.mType) << ") ";
+        if (entry.mType == Type::HISTOGRAM) {
+            const MetricsHistogram::Snapshot snapshot = entry.mHistogram->snapshot();
+            const double avg = (snapshot.mTotal) ? snapshot.mSum / static_cast<double>(snapshot.mTotal) : 0.0;
+            ostr << "count:" << snapshot.mTotal
+                 << " sum:" << valStr(snapshot.mSum)
+                 << " avg:" << valStr(avg)
+                 << " p50<=" << valStr(snapshot.getPercentile(0.50f))
+                 << " p90<=" << valStr(snapshot.getPercentile(0.90f))
+                 << " p99<=" << valStr(snapshot.getPercentile(0.99f));
+        } else {
+            ostr << valStr(entryValue(name, entry, gaugeValues));
+        }
+        return ostr.str();
+    };
+
+    if (!name.empty()) {
+        auto itr = mEntries.find(name);
+        if (itr == mEntries.end()) return "unknown metric:" + name;
+        return showEntry(itr->first, itr->second);
+    }
+
+    std::ostringstream ostr;
+    ostr << "metrics (total:" << mEntries.size() << ") {\n";
+    for (const auto &itr : mEntries) {
+        ostr << "  " << showEntry(itr.first, itr.second) << '\n';
+    }
+    ostr << "}";
+    return ostr.str();
+}
+
+std::string
+MetricsRegistry::exportPrometheus() const
+//
+// Prometheus text exposition format (version 0.0.4)
+//
+{
+    const GaugeValues gaugeValues = evalGaugeFuncs();
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::ostringstream ostr;
+    for (const auto &itr : mEntries) {
+        const std::string &name = itr.first;
+        const Entry &entry = itr.second;
+        if (!entry.mHelp.empty()) {
+            ostr << "# HELP " << name << ' ' << promHelpStr(entry.mHelp) << '\n';
+        }
+        ostr << "# TYPE " << name << ' ' << ((entry.mType == Type::GAUGE_FUNC) ? "gauge" : typeStr(entry.mType)) << '\n';
+        if (entry.mType == Type::HISTOGRAM) {
+            const MetricsHistogram::Snapshot snapshot = entry.mHistogram->snapshot();
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < snapshot.mCounts.size(); ++i) {
+                cumulative += snapshot.mCounts[i];
+                const double le = (i < snapshot.mBounds.size()) ? snapshot.mBounds[i] : std::numeric_limits<double>::infinity();
+                ostr << name << "_bucket{le=\"" << valStr(le) << "\"} " << cumulative << '\n';
+            }
+            ostr << name << "_sum " << valStr(snapshot.mSum) << '\n'
+                 << name << "_count " << snapshot.mTotal << '\n';
+        } else if (entry.mType == Type::COUNTER) {
+            ostr << name << ' ' << entry.mCounter->get() << '\n';
+        } else {
+            ostr << name << ' ' << valStr(entryValue(name, entry, gaugeValues)) << '\n';
+        }
+    }
+    return ostr.str();
+}
+
+std::string
+MetricsRegistry::exportJson() const
+{
+    const GaugeValues gaugeValues = evalGaugeFuncs();
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::ostringstream ostr;
+    ostr << "{\n";
+    bool first = true;
+    for (const auto &itr : mEntries) {
+        const Entry &entry = itr.second;
+        if (!first) ostr << ",\n";
+        first = false;
+        ostr << "  " << jsonStr(itr.first) << ": {\"type\": " << jsonStr(typeStr(entry.mType))
+             << ", \"help\": " << jsonStr(entry.mHelp);
+        if (entry.mType == Type::HISTOGRAM) {
+            const MetricsHistogram::Snapshot snapshot = entry.mHistogram->snapshot();
+            ostr << ", \"bounds\": [";
+            for (size_t i = 0; i < snapshot.mBounds.size(); ++i) {
+                ostr << ((i) ? ", " : "") << jsonValStr(snapshot.mBounds[i]);
+            }
+            ostr << "], \"counts\": [";
+            for (size_t i = 0; i < snapshot.mCounts.size(); ++i) {
+                ostr << ((i) ? ", " : "") << snapshot.mCounts[i];
+            }
+            ostr << "], \"count\": " << snapshot.mTotal << ", \"sum\": " << jsonValStr(snapshot.mSum) << '}';
+        } else if (entry.mType == Type::COUNTER) {
+            ostr << ", \"value\": " << entry.mCounter->get() << '}';
+        } else {
+            ostr << ", \"value\": " << jsonValStr(entryValue(itr.first, entry, gaugeValues)) << '}';
+        }
+    }
+    ostr << ((first) ? "}\n" : "\n}\n");
+    return ostr.str();
+}
+
+std::string
+MetricsRegistry::exportString(const Format format) const
+{
+    switch (format) {
+    case Format::PROMETHEUS : return exportPrometheus();
+    case Format::JSON : return exportJson();
+    default : return show() + '\n';
+    }
+}
+
+bool
+MetricsRegistry::saveFile(const std::string &filename, const Format format, std::string &errorMsg) const
+//
+// Writes to the temporary file first and renames it, so a reader which periodically scrapes
+// the file (like the node_exporter textfile collector) never sees a partially written file.
+//
+{
+    const std::string data = exportString(format);
+    const std::string tmpFilename = filename + ".tmp";
+    {
+        std::ofstream ofs(tmpFilename, std::ios::trunc);
+        if (!ofs) {
+            errorMsg = str_util::stringCat("could not open file. filename:", tmpFilename);
+            return false;
+        }
+        ofs << data;
+        if (!ofs.flush()) {
+            errorMsg = str_util::stringCat("write failed. filename:", tmpFilename);
+            return false;
+        }
+    }
+    if (std::rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+        errorMsg = str_util::stringCat("rename failed. filename:", filename, " (", strerror(errno), ")");
+        std::remove(tmpFilename.c_str());
+        return false;
+    }
+    return true;
+}
+
+// static function
+bool
+MetricsRegistry::isValidName(const std::string &name)
+{
+    if (name.empty()) return false;
+    for (size_t i = 0; i < name.size(); ++i) {
+        const char c = name[i];
+        const bool alpha = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':');
+        if (!alpha && (i == 0 || !(c >= '0' && c <= '9'))) return false;
+    }
+    return true;
+}
+
+// static function
+bool
+MetricsRegistry::strToFormat(const std::string &str, Format &format)
+{
+    if (str == "text") format = Format::TEXT;
+    else if (str == "prom" || str == "prometheus") format = Format::PROMETHEUS;
+    else if (str == "json") format = Format::JSON;
+    else return false;
+    return true;
+}
+
+// static function
+std::string
+MetricsRegistry::formatStr(const Format format)
+{
+    switch (format) {
+    case Format::TEXT : return "text";
+    case Format::PROMETHEUS : return "prometheus";
+    case Format::JSON : return "json";
+    default : return "?";
+    }
+}
+
+MetricsRegistry::Entry &
+MetricsRegistry::findOrAdd(const std::string &name, const Type type, const std::string &help)
+{
+    auto itr = mEntries.find(name);
+    if (itr != mEntries.end()) {
+        if (itr->second.mType != type) {
+            throw str_util::stringCat("MetricsRegistry metric type mismatch. name:", name,
+                                      " registered:", typeStr(itr->second.mType), " requested:", typeStr(type));
+        }
+        return itr->second;
+    }
+    if (!isValidName(name)) {
+        throw str_util::stringCat("MetricsRegistry invalid metric name:", name);
+    }
+
+    Entry &entry = mEntries[name];
+    entry.mType = type;
+    entry.mHelp = help;
+    return entry;
+}
+
+// static function
+std::string
+MetricsRegistry::typeStr(const Type type)
+{
+    switch (type) {
+    case Type::COUNTER : return "counter";
+    case Type::GAUGE : return "gauge";
+    case Type::GAUGE_FUNC : return "gaugeFunc";
+    case Type::HISTOGRAM : return "histogram";
+    default : return "?";
+    }
+}
+
+MetricsRegistry::GaugeValues
+MetricsRegistry::evalGaugeFuncs(const std::string &name) const
+//
+// Calls the gaugeFunc callbacks (all of them if name is empty). The callbacks are copied out under
+// mMutex and called after releasing it, because a callback is user code which may use the registry
+// (or take a lock which is held by another thread waiting for the registry).
+//
+{
+    std::vector<std::pair<std::string, GaugeFunc>> funcs;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto &itr : mEntries) {
+            if (itr.second.mType != Type::GAUGE_FUNC || !itr.second.mGaugeFunc) continue;
+            if (!name.empty() && itr.first != name) continue;
+            funcs.emplace_back(itr.first, itr.second.mGaugeFunc);
+        }
+    }
+
+    GaugeValues gaugeValues;
+    for (const auto &itr : funcs) gaugeValues[itr.first] = itr.second();
+    return gaugeValues;
+}
+
+// static function
+double
+MetricsRegistry::entryValue(const std::string &name, const Entry &entry, const GaugeValues &gaugeValues)
+//
+// The gaugeFunc value comes from evalGaugeFuncs(). A gaugeFunc which has been registered after
+// evalGaugeFuncs() shows 0 this time.
+//
+{
+    switch (entry.mType) {
+    case Type::COUNTER : return static_cast<double>(entry.mCounter->get());
+    case Type::GAUGE : return entry.mGauge->get();
+    case Type::GAUGE_FUNC : {
+        auto itr = gaugeValues.find(name);
+        return (itr != gaugeValues.end()) ? itr->second : 0.0;
+    }
+    default : return 0.0;
+    }
+}
+
+void
+MetricsRegistry::parserConfigure()
+{
+    mParser.description("process-wide metrics registry command");
+    mParser.opt("list", "", "show all registered metrics",
+                [&](Arg &arg) { return arg.msg(showList() + '\n'); });
+    mParser.opt("show", "<name|all>", "show current value of the metric",
+                [&](Arg &arg) {
+                    const std::string name = (arg++)();
+                    return arg.msg(show((name == "all") ? "" : name) + '\n');
+                });
+    mParser.opt("prometheus", "", "dump all metrics by Prometheus text format",
+                [&](Arg &arg) { return arg.msg(exportPrometheus()); });
+    mParser.opt("json", "", "dump all metrics by JSON",
+                [&](Arg &arg) { return arg.msg(exportJson()); });
+    mParser.opt("save", "<text|prom|json> <filename>", "save all metrics to the file",
+                [&](Arg &arg) {
+                    Format format;
+                    if (!strToFormat((arg++)(), format)) return arg.msg("unknown format\n");
+                    const std::string filename = (arg++)();
+                    std::string errorMsg;
+                    if (!saveFile(filename, format, errorMsg)) return arg.msg(errorMsg + '\n');
+                    return arg.msg("saved " + formatStr(format) + " filename:" + filename + '\n');
+                });
+    mParser.opt("reset", "", "reset all counters and histograms",
+                [&](Arg &arg) {
+                    resetAll();
+                    return arg.msg("reset all\n");
+                });
+}
+
+} // namespace grid_util
+} // namespace scene_rdl2
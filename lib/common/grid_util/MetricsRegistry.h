@@ -0,0 +1,209 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+// -- Process-wide metrics registry --
+//
+// Counters, gauges and histograms which are registered by name into the single MetricsRegistry
+// and exported as human readable text, Prometheus text exposition format or JSON.
+// Every DebugConsoleDriver has the built-in "metrics" command which is MetricsRegistry's parser.
+//
+#pragma once
+
+#include "Parser.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+class MetricsShard
+//
+// Shard index of the current thread. Hot metrics keep one cache line per shard and every thread
+// only touches the shard of its own, so concurrent increments don't fight for the same cache line.
+//
+{
+public:
+    static constexpr unsigned TOTAL = 32;
+
+    static unsigned getId()
+    {
+        static std::atomic<unsigned> sNextId {0};
+        thread_local unsigned tShardId = (sNextId.fetch_add(1, std::memory_order_relaxed) % TOTAL);
+        return tShardId;
+    }
+};
+
+class MetricsCounter
+//
+// Monotonically increasing counter. inc() is a single relaxed atomic add to the shard of the
+// current thread. get() sums all the shards.
+//
+{
+public:
+    void inc(const uint64_t delta = 1)
+    {
+        mShards[MetricsShard::getId()].mValue.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    uint64_t get() const;
+    void reset();
+
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> mValue {0};
+    };
+
+    Shard mShards[MetricsShard::TOTAL];
+};
+
+class MetricsGauge
+//
+// Current value which goes up and down. A gauge is not a hot path metric, so it is not sharded.
+//
+{
+public:
+    void set(const double v) { mValue.store(v, std::memory_order_relaxed); }
+    void add(const double delta);
+    double get() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> mValue {0.0};
+};
+
+class MetricsHistogram
+//
+// Distribution of the observed values. Buckets are defined by the sorted upper bounds and
+// the value v goes to the first bucket which satisfies v <= bound (same as Prometheus "le").
+// The last bucket is +Inf. Bucket counts and sum are sharded the same as MetricsCounter.
+//
+{
+public:
+    struct Snapshot
+    {
+        std::vector<double> mBounds;
+        std::vector<uint64_t> mCounts; // non-cumulative, mBounds.size() + 1 (last one is +Inf)
+        uint64_t mTotal {0};
+        double mSum {0.0};
+
+        double getPercentile(const float fraction) const; // upper bound of the bucket
+    };
+
+    explicit MetricsHistogram(const std::vector<double> &bounds);
+
+    void observe(const double v);
+
+    Snapshot snapshot() const;
+    void reset();
+
+    const std::vector<double> &getBounds() const { return mBounds; }
+
+    // bounds : start, start*factor, start*factor^2 ...
+    static std::vector<double> exponentialBounds(const double start, const double factor, const unsigned total);
+    static std::vector<double> linearBounds(const double start, const double width, const unsigned total);
+
+private:
+    struct alignas(64) Shard
+    {
+        std::unique_ptr<std::atomic<uint64_t>[]> mCounts;
+        std::atomic<double> mSum {0.0};
+    };
+
+    std::vector<double> mBounds;
+    Shard mShards[MetricsShard::TOTAL];
+};
+
+class MetricsRegistry
+//
+// This is singleton.
+// Registration APIs return a reference which stays valid until the end of the process,
+// so the caller should keep it and update the metric without any lookup.
+//
+//    static MetricsCounter &sCounter =
+//        MetricsRegistry::get().counter("mcrt_send_frame_total", "total sent frames");
+//    sCounter.inc();
+//
+// Calling the registration API again with the same name returns the same metric. Name should
+// follow the Prometheus metric name rule ([a-zA-Z_:][a-zA-Z0-9_:]*) and re-registration of
+// the same name by the different type throws std::string.
+// Existing statistics of some component can be exposed without any change to it by gaugeFunc().
+// The function is executed at export time under the registry lock.
+//
+{
+public:
+    enum class Format : int { TEXT, PROMETHEUS, JSON };
+
+    static MetricsRegistry &get();
+
+    MetricsRegistry() { parserConfigure(); }
+
+    // Non-copyable
+    MetricsRegistry &operator =(const MetricsRegistry &) = delete;
+    MetricsRegistry(const MetricsRegistry &) = delete;
+
+    MetricsCounter &counter(const std::string &name, const std::string &help);
+    MetricsGauge &gauge(const std::string &name, const std::string &help);
+    MetricsHistogram &histogram(const std::string &name,
+                                const std::string &help,
+                                const std::vector<double> &bounds);
+    // func is called without the registry lock held, so it may use the registry itself.
+    using GaugeFunc = std::function<double()>;
+    void gaugeFunc(const std::string &name, const std::string &help, const GaugeFunc &func);
+    void removeGaugeFunc(const std::string &name);
+
+    std::vector<std::string> getNames() const;
+    void resetAll(); // counters and histograms
+
+    std::string showList() const;
+    std::string show(const std::string &name = "") const; // all metrics if name is empty
+    std::string exportPrometheus() const;
+    std::string exportJson() const;
+    std::string exportString(const Format format) const;
+    bool saveFile(const std::string &filename, const Format format, std::string &errorMsg) const;
+
+    static bool isValidName(const std::string &name);
+    static bool strToFormat(const std::string &str, Format &format);
+    static std::string formatStr(const Format format);
+
+    Parser &getParser() { return mParser; }
+
+private:
+    enum class Type : int { COUNTER, GAUGE, GAUGE_FUNC, HISTOGRAM };
+
+    struct Entry
+    {
+        Type mType;
+        std::string mHelp;
+        std::unique_ptr<MetricsCounter> mCounter;
+        std::unique_ptr<MetricsGauge> mGauge;
+        GaugeFunc mGaugeFunc;
+        std::unique_ptr<MetricsHistogram> mHistogram;
+    };
+
+    using GaugeValues = std::map<std::string, double>;
+
+    Entry &findOrAdd(const std::string &name, const Type type, const std::string &help); // under mMutex
+    static std::string typeStr(const Type type);
+    GaugeValues evalGaugeFuncs(const std::string &name = "") const; // without mMutex
+    static double entryValue(const std::string &name, const Entry &entry, const GaugeValues &gaugeValues);
+
+    void parserConfigure();
+
+    //------------------------------
+
+    mutable std::mutex mMutex;
+    std::map<std::string, Entry> mEntries; // sorted by name
+
+    Parser mParser;
+};
+
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -13,6 +13,7 @@
 #include <scene_rdl2/common/math/Vec3.h>
 #include <scene_rdl2/common/math/Vec4.h>
 #include <scene_rdl2/common/platform/Platform.h> // for definition of finline
+#include <scene_rdl2/common/rec_time/RecScopeProfiler.h>
 #include <scene_rdl2/common/rec_time/RecTime.h>
 #include <scene_rdl2/scene/rdl2/ValueContainerDeq.h>
 #include <scene_rdl2/scene/rdl2/ValueContainerEnq.h>
@@ -5039,6 +5040,7 @@ PackTiles::encode(const bool renderBufferOdd,
                   const bool withSha1Hash,
                   const EnqFormatVer enqFormatVer)
 {
+    REC_SCOPE_PROFILE("PackTiles::encode");
     if (renderBufferOdd) {
         return PackTilesImpl::encode<true>(activePixels, renderBufferTiled, weightBufferTiled,
                                            output,
@@ -5068,6 +5070,7 @@ PackTiles::encode(const bool renderBufferOdd,
                   const bool withSha1Hash,
                   const EnqFormatVer enqFormatVer)
 {
+    REC_SCOPE_PROFILE("PackTiles::encode");
     if (renderBufferOdd) {
         return PackTilesImpl::encode<true>(activePixels, renderBufferTiled, output,
                                            precisionMode, coarsePassPrecision, finePassPrecision,
@@ -5094,6 +5097,7 @@ PackTiles::encode(const bool renderBufferOdd,
                   const bool withSha1Hash,
                   const EnqFormatVer enqFormatVer)
 {
+    REC_SCOPE_PROFILE("PackTiles::encode");
     if (renderBufferOdd) {
         return PackTilesImpl::encode<true>(activePixels, renderBufferTiled, numSampleBufferTiled,
                                            output,
@@ -5123,6 +5127,7 @@ PackTiles::decode(const bool renderBufferOdd,                // in
                                                              //                       empty data (=false)
                   unsigned char* sha1HashDigest)
 {
+    REC_SCOPE_PROFILE("PackTiles::decode");
     if (renderBufferOdd) {
         return PackTilesImpl::decode<true>(addr,
                                            dataSize,
@@ -5162,6 +5167,7 @@ PackTiles::decode(const bool renderBufferOdd,                // in
                                                              //                       empty data (=false)
                   unsigned char* sha1HashDigest)
 {
+    REC_SCOPE_PROFILE("PackTiles::decode");
     if (renderBufferOdd) {
         return PackTilesImpl::decode<true>(addr, dataSize, activePixels,
                                            normalizedRenderBufferTiled,
@@ -5193,6 +5199,7 @@ PackTiles::encodePixelInfo(const ActivePixels &activePixels,
                            const bool withSha1Hash,
                            const EnqFormatVer enqFormatVer)
 {
+    REC_SCOPE_PROFILE("PackTiles::encodePixelInfo");
     return PackTilesImpl::encodePixelInfo(activePixels, pixelInfoBufferTiled,
                                           output,
                                           precisionMode,
@@ -5213,6 +5220,7 @@ PackTiles::decodePixelInfo(const void* addr,                   // in
                                                                //                       empty data (=false)
                            unsigned char* sha1HashDigest)
 {
+    REC_SCOPE_PROFILE("PackTiles::decodePixelInfo");
     return PackTilesImpl::decodePixelInfo(addr, dataSize,
                                           activePixels, pixelInfoBufTiled,
                                           coarsePassPrecision,
@@ -5237,6 +5245,7 @@ PackTiles::encodeHeatMap(const ActivePixels &activePixels,
                          const bool withSha1Hash,
                          const EnqFormatVer enqFormatVer)
 {
+    REC_SCOPE_PROFILE("PackTiles::encodeHeatMap");
     return PackTilesImpl::encodeHeatMap(activePixels, heatMapSecBufferTiled, heatMapWeightBufferTiled,
                                         output,
                                         noNumSampleMode, withSha1Hash, enqFormatVer);
@@ -5251,6 +5260,7 @@ PackTiles::encodeHeatMap(const ActivePixels &activePixels,
                          const bool withSha1Hash,
                          const EnqFormatVer enqFormatVer)
 {
+    REC_SCOPE_PROFILE("PackTiles::encodeHeatMap");
     return PackTilesImpl::encodeHeatMap(activePixels, heatMapSecBufferTiled,
                                         output,
                                         withSha1Hash, enqFormatVer);
@@ -5269,6 +5279,7 @@ PackTiles::decodeHeatMap(const void* addr,                      // in
                                                                 //                     empty data (=false)
                          unsigned char* sha1HashDigest)
 {
+    REC_SCOPE_PROFILE("PackTiles::decodeHeatMap");
     return PackTilesImpl::decodeHeatMap(addr, dataSize,
                                         storeNumSampleData,
                                         activePixels, heatMapSecBufferTiled, heatMapNumSampleBufTiled,
@@ -5287,6 +5298,7 @@ PackTiles::decodeHeatMap(const void* addr,                      // in
                                                                 //                     empty data (=false)
                          unsigned char* sha1HashDigest)
 {
+    REC_SCOPE_PROFILE("PackTiles::decodeHeatMap");
     return PackTilesImpl::decodeHeatMap(addr, dataSize,
                                         activePixels, normalizedHeatMapSecBufTiled,
                                         activeDecodeAction,
@@ -5309,6 +5321,7 @@ PackTiles::encodeWeightBuffer(const ActivePixels &activePixels,
                               const bool withSha1Hash,
                               const EnqFormatVer enqFormatVer)
 {
+    REC_SCOPE_PROFILE("PackTiles::encodeWeightBuffer");
     return PackTilesImpl::encodeWeightBuffer(activePixels,
                                              weightBufferTiled,
                                              output,
@@ -5331,6 +5344,7 @@ PackTiles::decodeWeightBuffer(const void* addr,               // in
                                                               //                       empty data (=false)
                               unsigned char* sha1HashDigest)
 {
+    REC_SCOPE_PROFILE("PackTiles::decodeWeightBuffer");
     return PackTilesImpl::decodeWeightBuffer(addr, dataSize, activePixels, weightBufferTiled,
                                              coarsePassPrecision, finePassPrecision,
                                              activeDecodeAction,
@@ -5365,6 +5379,7 @@ PackTiles::encodeRenderOutput(const ActivePixels &activePixels,
                               const EnqFormatVer enqFormatVer)
 // closestFilterAovOriginalNumChan is only used when closestFilterStatus is true
 {
+    REC_SCOPE_PROFILE("PackTiles::encodeRenderOutput");
     return PackTilesImpl::encodeRenderOutput(activePixels,
                                              renderOutputBufferTiled,
                                              renderOutputBufferDefaultValue,
@@ -5396,6 +5411,7 @@ PackTiles::encodeRenderOutputMerge(const ActivePixels &activePixels,
                                    const bool withSha1Hash,
                                    const EnqFormatVer enqFormatVer)
 {
+    REC_SCOPE_PROFILE("PackTiles::encodeRenderOutputMerge");
     return PackTilesImpl::encodeRenderOutputMerge(activePixels,
                                                   renderOutputBufferTiled,
                                                   renderOutputBufferDefaultValue,
@@ -5422,6 +5438,7 @@ PackTiles::decodeRenderOutput(const void* addr,           // in
                                                           //                       empty data (=false)
                               unsigned char* sha1HashDigest)
 {
+    REC_SCOPE_PROFILE("PackTiles::decodeRenderOutput");
     return PackTilesImpl::decodeRenderOutput(addr,
                                              dataSize,
                                              storeNumSampleData,
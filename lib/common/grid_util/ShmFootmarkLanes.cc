@@ -0,0 +1,459 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ShmFootmarkLanes.h"
+
+#include <scene_rdl2/common/except/exceptions.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+#include <pthread.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/syscall.h>
+#include <sys/time.h> // gettimeofday()
+#include <time.h>
+#include <unistd.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+namespace {
+
+size_t
+calcLaneStride(unsigned laneCapacity)
+{
+    return sizeof(ShmFootmarkLaneHeader) + sizeof(ShmFootmarkRecord) * laneCapacity;
+}
+
+unsigned
+roundUpPow2(unsigned v)
+{
+    unsigned p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+ShmFootmarkRecord*
+getLaneRecords(ShmFootmarkLaneHeader* lane)
+{
+    return reinterpret_cast<ShmFootmarkRecord*>(lane + 1);
+}
+
+const ShmFootmarkRecord*
+getLaneRecords(const ShmFootmarkLaneHeader* lane)
+{
+    return reinterpret_cast<const ShmFootmarkRecord*>(lane + 1);
+}
+
+void
+copyName(char* dst, size_t dstSize, const std::string& src)
+{
+    const size_t size = std::min(src.size(), dstSize - 1);
+    memcpy(dst, src.data(), size);
+    dst[size] = 0x0;
+}
+
+std::atomic<uint64_t> gInstanceIdCounter {0};
+
+std::string
+errnoMessage(const std::string& msg)
+{
+    return msg + " failed. errno:" + std::to_string(errno) + " (" + strerror(errno) + ")";
+}
+
+} // namespace
+
+ShmFootmarkLanes::LanePool::LanePool(unsigned numLanes)
+    : mNumLanes(numLanes)
+    , mInUse(new std::atomic<uint64_t>[(numLanes + 63) / 64])
+{
+    for (unsigned i = 0; i < (numLanes + 63) / 64; ++i) {
+        mInUse[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+int
+ShmFootmarkLanes::LanePool::acquire()
+{
+    for (unsigned word = 0; word < (mNumLanes + 63) / 64; ++word) {
+        const unsigned bitTotal = std::min(mNumLanes - word * 64, 64u);
+        const uint64_t validMask = (bitTotal == 64) ? ~uint64_t(0) : ((uint64_t(1) << bitTotal) - 1);
+        uint64_t inUse = mInUse[word].load(std::memory_order_relaxed);
+        while (uint64_t free = ~inUse & validMask) {
+            const uint64_t bit = free & (~free + 1); // lowest free lane
+            if (mInUse[word].compare_exchange_weak(inUse, inUse | bit, std::memory_order_acquire)) {
+                return static_cast<int>(word * 64 + __builtin_ctzll(bit));
+            }
+        }
+    }
+    return -1;
+}
+
+void
+ShmFootmarkLanes::LanePool::release(unsigned laneId)
+{
+    // release : the lane's last records are written before the next owner can take it.
+    mInUse[laneId / 64].fetch_and(~(uint64_t(1) << (laneId % 64)), std::memory_order_release);
+}
+
+ShmFootmarkLanes::ShmFootmarkLanes(const std::string& title, unsigned numLanes, unsigned laneCapacity)
+{
+    numLanes = std::max(numLanes, 1u);
+    laneCapacity = roundUpPow2(std::max(laneCapacity, 2u));
+
+    mLaneStride = calcLaneStride(laneCapacity);
+    mMemSize = sizeof(ShmFootmarkLanesHeader) + mLaneStride * numLanes;
+    mInstanceId = ++gInstanceIdCounter;
+    mLanePool = std::make_shared<LanePool>(numLanes);
+
+    mShmId = shmget(IPC_PRIVATE, mMemSize, SHM_R | SHM_W);
+    if (mShmId < 0) {
+        throw except::RuntimeError(errnoMessage("ShmFootmarkLanes shmget()"));
+    }
+    std::cerr << "=====>>ShmFootmarkLanes:" << title << " shmId:" << mShmId << "<<=====\n";
+
+    void* ptr = shmat(mShmId, NULL, 0);
+    if (ptr == (void *)-1) {
+        throw except::RuntimeError(errnoMessage("ShmFootmarkLanes shmat()"));
+    }
+    memset(ptr, 0x0, mMemSize);
+
+    struct timeval tv;
+    gettimeofday(&tv, 0x0);
+
+    mHeader = static_cast<ShmFootmarkLanesHeader*>(ptr);
+    mHeader->mVersion = ShmFootmarkLanesHeader::VERSION;
+    mHeader->mNumLanes = numLanes;
+    mHeader->mLaneCapacity = laneCapacity;
+    mHeader->mPid = static_cast<uint32_t>(getpid());
+    mHeader->mBaseMonoNs = getMonotonicNanoSec();
+    mHeader->mBaseWallUs = static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+    copyName(mHeader->mTitle, sizeof(mHeader->mTitle), title);
+
+    // The magic number is stored last, the view ignores half initialized segments.
+    __atomic_store_n(&mHeader->mMagic, ShmFootmarkLanesHeader::MAGIC, __ATOMIC_RELEASE);
+}
+
+ShmFootmarkLanes::~ShmFootmarkLanes()
+{
+    // Only detach. The segment itself is kept for the post-mortem dump.
+    if (mHeader) shmdt(mHeader);
+}
+
+void
+ShmFootmarkLanes::setEventName(uint16_t eventId, const std::string& name)
+{
+    if (eventId >= ShmFootmarkLanesHeader::MAX_EVENT_NAMES) return;
+    copyName(mHeader->mEventName[eventId], ShmFootmarkLanesHeader::EVENT_NAME_SIZE, name);
+}
+
+void
+ShmFootmarkLanes::setThreadName(const std::string& name)
+{
+    ShmFootmarkLaneHeader* lane = getThreadLane();
+    if (!lane) return;
+    copyName(lane->mThreadName, sizeof(lane->mThreadName), name);
+}
+
+bool
+ShmFootmarkLanes::record(uint16_t eventId, uint32_t arg, uint64_t payload0, uint64_t payload1)
+{
+    ShmFootmarkRecord rec;
+    rec.mTimeNs = getMonotonicNanoSec();
+    rec.mEventId = eventId;
+    rec.mFlags = 0;
+    rec.mArg = arg;
+    rec.mPayload[0] = payload0;
+    rec.mPayload[1] = payload1;
+    return append(getThreadLane(), rec);
+}
+
+bool
+ShmFootmarkLanes::recordText(uint16_t eventId, const char* text, uint32_t arg)
+{
+    ShmFootmarkRecord rec;
+    rec.mTimeNs = getMonotonicNanoSec();
+    rec.mEventId = eventId;
+    rec.mFlags = ShmFootmarkRecord::FLAG_TEXT;
+    rec.mArg = arg;
+    rec.mPayload[0] = 0;
+    rec.mPayload[1] = 0;
+    if (text) strncpy(reinterpret_cast<char*>(rec.mPayload), text, sizeof(rec.mPayload));
+    return append(getThreadLane(), rec);
+}
+
+// static function
+uint64_t
+ShmFootmarkLanes::getMonotonicNanoSec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+ShmFootmarkLaneHeader*
+ShmFootmarkLanes::getThreadLane()
+{
+    // Each thread caches its lane per ShmFootmarkLanes instance. The instance id is used as the key
+    // instead of the address so that a new instance at the same address never picks up a stale lane.
+    // The cache hands the lanes back to their pools when the thread exits. A pool which is already
+    // gone belonged to a destroyed instance and is skipped.
+    struct ThreadLane
+    {
+        uint64_t mInstanceId;
+        unsigned mLaneId;
+        ShmFootmarkLaneHeader* mLane;
+        std::weak_ptr<LanePool> mLanePool;
+    };
+    struct ThreadLanes
+    {
+        ~ThreadLanes()
+        {
+            for (const ThreadLane& itr : mLanes) {
+                if (std::shared_ptr<LanePool> lanePool = itr.mLanePool.lock()) lanePool->release(itr.mLaneId);
+            }
+        }
+        std::vector<ThreadLane> mLanes;
+    };
+    thread_local ThreadLanes tLanes;
+
+    for (const ThreadLane& itr : tLanes.mLanes) {
+        if (itr.mInstanceId == mInstanceId) return itr.mLane;
+    }
+    // Not cached if there is no free lane, so that the next record() tries again.
+    const int laneId = acquireLane();
+    if (laneId < 0) return nullptr;
+    ShmFootmarkLaneHeader* lane = getLaneAddr(laneId);
+    tLanes.mLanes.push_back(ThreadLane {mInstanceId, static_cast<unsigned>(laneId), lane, mLanePool});
+    return lane;
+}
+
+int
+ShmFootmarkLanes::acquireLane()
+{
+    const int laneId = mLanePool->acquire();
+    if (laneId < 0) return -1;
+
+    uint32_t numUsed = __atomic_load_n(&mHeader->mNextLane, __ATOMIC_RELAXED);
+    while (numUsed < static_cast<uint32_t>(laneId) + 1 &&
+           !__atomic_compare_exchange_n(&mHeader->mNextLane, &numUsed, laneId + 1, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+
+    // Records before mOwnerStart are the previous owner's. Only owners write mWriteCount, and the
+    // previous one has handed the lane back (see LanePool::release()), so a plain read is enough.
+    ShmFootmarkLaneHeader* lane = getLaneAddr(laneId);
+    __atomic_store_n(&lane->mTid, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&lane->mOwnerStart, lane->mWriteCount, __ATOMIC_RELAXED);
+    char name[sizeof(lane->mThreadName)] = {0};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    copyName(lane->mThreadName, sizeof(lane->mThreadName), name);
+    __atomic_store_n(&lane->mTid, static_cast<uint32_t>(syscall(SYS_gettid)), __ATOMIC_RELEASE);
+    return laneId;
+}
+
+ShmFootmarkLaneHeader*
+ShmFootmarkLanes::getLaneAddr(unsigned laneId) const
+{
+    char* addr = reinterpret_cast<char*>(mHeader + 1) + mLaneStride * laneId;
+    return reinterpret_cast<ShmFootmarkLaneHeader*>(addr);
+}
+
+bool
+ShmFootmarkLanes::append(ShmFootmarkLaneHeader* lane, const ShmFootmarkRecord& rec)
+{
+    if (!lane) {
+        __atomic_fetch_add(&mHeader->mDroppedRecords, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    // Only the owner thread writes this lane, so a plain load of the count is enough. The fence keeps
+    // the previous count update ordered before we start overwriting the next slot, the reader relies
+    // on this to detect records which were overwritten while it was copying them.
+    const uint64_t count = lane->mWriteCount;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&getLaneRecords(lane)[count & (mHeader->mLaneCapacity - 1)], &rec, sizeof(rec));
+    __atomic_store_n(&lane->mWriteCount, count + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+
+ShmFootmarkLanesView::ShmFootmarkLanesView(int shmId)
+    : mShmId(shmId)
+{
+    if ((mMemPtr = shmat(mShmId, NULL, SHM_RDONLY)) == (void *)-1) {
+        mMemPtr = nullptr;
+        throw except::RuntimeError(errnoMessage("ShmFootmarkLanesView shmat()"));
+    }
+
+    struct shmid_ds ds;
+    if (shmctl(mShmId, IPC_STAT, &ds) == -1) return;
+    if (ds.shm_segsz < sizeof(ShmFootmarkLanesHeader)) return; // ShmFootmark segment
+
+    const ShmFootmarkLanesHeader* header = static_cast<const ShmFootmarkLanesHeader*>(mMemPtr);
+    if (__atomic_load_n(&header->mMagic, __ATOMIC_ACQUIRE) != ShmFootmarkLanesHeader::MAGIC ||
+        header->mVersion != ShmFootmarkLanesHeader::VERSION) {
+        return;
+    }
+    const unsigned capacity = header->mLaneCapacity;
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        ds.shm_segsz < sizeof(ShmFootmarkLanesHeader) + calcLaneStride(capacity) * header->mNumLanes) {
+        return; // broken header
+    }
+    mHeader = header;
+}
+
+ShmFootmarkLanesView::~ShmFootmarkLanesView()
+{
+    if (mMemPtr) shmdt(mMemPtr);
+}
+
+std::vector<ShmFootmarkLanesView::Item>
+ShmFootmarkLanesView::getTimeline() const
+{
+    std::vector<Item> items;
+    if (!mHeader) return items;
+
+    const uint64_t capacity = mHeader->mLaneCapacity;
+    std::vector<ShmFootmarkRecord> work(capacity);
+    for (unsigned laneId = 0; laneId < mHeader->mNumLanes; ++laneId) {
+        const ShmFootmarkLaneHeader* lane = getLane(laneId);
+        if (__atomic_load_n(&lane->mTid, __ATOMIC_ACQUIRE) == 0) continue;
+
+        // Seqlock style read : copy everything, then discard the slots which the writer might have
+        // touched in the meantime. The writer may be in the middle of writing record #count2, which
+        // lives in the slot of record #(count2 - capacity).
+        const uint64_t count1 = __atomic_load_n(&lane->mWriteCount, __ATOMIC_ACQUIRE);
+        memcpy(work.data(), getLaneRecords(lane), sizeof(ShmFootmarkRecord) * capacity);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        const uint64_t count2 = __atomic_load_n(&lane->mWriteCount, __ATOMIC_RELAXED);
+
+        const uint64_t start = (count2 >= capacity) ? count2 - capacity + 1 : 0;
+        const uint64_t ownerStart = __atomic_load_n(&lane->mOwnerStart, __ATOMIC_RELAXED);
+        for (uint64_t i = start; i < count1; ++i) {
+            items.push_back(Item {laneId, i < ownerStart, work[i & (capacity - 1)]});
+        }
+    }
+
+    std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return a.mRecord.mTimeNs < b.mRecord.mTimeNs;
+    });
+    return items;
+}
+
+std::string
+ShmFootmarkLanesView::showHeader() const
+{
+    if (!mHeader) return "ShmFootmarkLanes is not valid";
+
+    const unsigned numUsed = std::min(mHeader->mNextLane, mHeader->mNumLanes);
+
+    std::ostringstream ostr;
+    ostr << "ShmFootmarkLanes {\n"
+         << "  mShmId:" << mShmId << '\n'
+         << "  title:" << std::string(mHeader->mTitle, strnlen(mHeader->mTitle, sizeof(mHeader->mTitle))) << '\n'
+         << "  pid:" << mHeader->mPid << '\n'
+         << "  numLanes:" << mHeader->mNumLanes << " (used:" << numUsed << ")\n"
+         << "  laneCapacity:" << mHeader->mLaneCapacity << '\n'
+         << "  droppedRecords:" << mHeader->mDroppedRecords << '\n';
+    for (unsigned laneId = 0; laneId < numUsed; ++laneId) {
+        const ShmFootmarkLaneHeader* lane = getLane(laneId);
+        ostr << "  lane:" << laneId
+             << " tid:" << lane->mTid
+             << " name:" << std::string(lane->mThreadName, strnlen(lane->mThreadName, sizeof(lane->mThreadName)))
+             << " writeCount:" << lane->mWriteCount
+             << " ownerStart:" << lane->mOwnerStart << '\n';
+    }
+    ostr << "}";
+    return ostr.str();
+}
+
+std::string
+ShmFootmarkLanesView::showTimeline() const
+{
+    const std::vector<Item> items = getTimeline();
+
+    std::ostringstream ostr;
+    ostr << "timeline (size:" << items.size() << ") {\n";
+    for (const Item& item : items) {
+        ostr << "  " << showItem(item) << '\n';
+    }
+    ostr << "}";
+    return ostr.str();
+}
+
+std::string
+ShmFootmarkLanesView::showItem(const Item& item) const
+{
+    if (!mHeader) return "";
+
+    const ShmFootmarkRecord& rec = item.mRecord;
+
+    // Convert to the wall clock by the base time pair which was recorded at construction.
+    const int64_t deltaNs = static_cast<int64_t>(rec.mTimeNs - mHeader->mBaseMonoNs);
+    const int64_t wallUs = static_cast<int64_t>(mHeader->mBaseWallUs) + deltaNs / 1000;
+    const time_t sec = static_cast<time_t>(wallUs / 1000000);
+    struct tm tmBuf;
+    localtime_r(&sec, &tmBuf);
+
+    std::ostringstream ostr;
+    ostr << std::setfill('0')
+         << std::setw(2) << tmBuf.tm_hour << ':'
+         << std::setw(2) << tmBuf.tm_min << ':'
+         << std::setw(2) << tmBuf.tm_sec << '.'
+         << std::setw(6) << wallUs % 1000000 << std::setfill(' ')
+         << " lane:" << std::setw(2) << item.mLaneId;
+    if (item.mPrevOwner) {
+        ostr << " tid:prev"; // the thread which used the lane before has finished, its tid is gone
+    } else {
+        ostr << " tid:" << getLane(item.mLaneId)->mTid;
+    }
+    ostr << ' ' << getEventName(rec.mEventId)
+         << " arg:" << rec.mArg;
+    if (rec.mFlags & ShmFootmarkRecord::FLAG_TEXT) {
+        const char* text = reinterpret_cast<const char*>(rec.mPayload);
+        ostr << " text:\"" << std::string(text, strnlen(text, sizeof(rec.mPayload))) << '"';
+    } else if (rec.mPayload[0] || rec.mPayload[1]) {
+        ostr << " payload:0x" << std::hex << rec.mPayload[0] << ",0x" << rec.mPayload[1] << std::dec;
+    }
+    return ostr.str();
+}
+
+void
+ShmFootmarkLanesView::freeShMem()
+{
+    if (shmctl(mShmId, IPC_RMID, 0) == -1) {
+        std::cerr << ">> ShmFootmarkLanes.cc freeShMem() failed\n";
+    }
+}
+
+const ShmFootmarkLaneHeader*
+ShmFootmarkLanesView::getLane(unsigned laneId) const
+{
+    const char* addr = reinterpret_cast<const char*>(mHeader + 1) + calcLaneStride(mHeader->mLaneCapacity) * laneId;
+    return reinterpret_cast<const ShmFootmarkLaneHeader*>(addr);
+}
+
+std::string
+ShmFootmarkLanesView::getEventName(uint16_t eventId) const
+{
+    std::ostringstream ostr;
+    if (eventId < ShmFootmarkLanesHeader::MAX_EVENT_NAMES && mHeader->mEventName[eventId][0]) {
+        const char* name = mHeader->mEventName[eventId];
+        ostr << std::string(name, strnlen(name, ShmFootmarkLanesHeader::EVENT_NAME_SIZE)) << '(' << eventId << ')';
+    } else {
+        ostr << "event(" << eventId << ')';
+    }
+    return ostr.str();
+}
+
+} // namespace grid_util
+} // namespace scene_rdl2
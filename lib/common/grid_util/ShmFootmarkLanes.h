@@ -0,0 +1,199 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+//
+// Shared memory layout of ShmFootmarkLanes. Everything is plain old data so that the segment can be
+// decoded by another process (shmFootmarkDump) after the owner process has crashed.
+//
+//   ShmFootmarkLanesHeader
+//   ShmFootmarkLaneHeader + ShmFootmarkRecord[laneCapacity]   x numLanes
+//
+struct ShmFootmarkRecord
+{
+    static constexpr uint16_t FLAG_TEXT = 0x1; // payload holds a (not null terminated) text
+
+    uint64_t mTimeNs;     // CLOCK_MONOTONIC nanosec
+    uint16_t mEventId;
+    uint16_t mFlags;
+    uint32_t mArg;
+    uint64_t mPayload[2];
+};
+static_assert(sizeof(ShmFootmarkRecord) == 32, "Unexpected ShmFootmarkRecord size");
+
+struct alignas(64) ShmFootmarkLaneHeader
+{
+    uint64_t mWriteCount; // total records ever appended to this lane. Updated by release store
+    uint64_t mOwnerStart; // mWriteCount when the current owner took the lane. Earlier records are from
+                          // threads which used the lane before and have finished
+    uint32_t mTid;        // 0 : lane is not used yet
+    uint32_t mPad;
+    char mThreadName[40];
+};
+static_assert(sizeof(ShmFootmarkLaneHeader) == 64, "Unexpected ShmFootmarkLaneHeader size");
+
+struct alignas(64) ShmFootmarkLanesHeader
+{
+    static constexpr uint32_t MAGIC = 0x4c4d4653; // "SFML"
+    static constexpr uint32_t VERSION = 2;
+    static constexpr unsigned MAX_EVENT_NAMES = 256;
+    static constexpr unsigned EVENT_NAME_SIZE = 24;
+
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint32_t mNumLanes;
+    uint32_t mLaneCapacity;   // records per lane, power of 2
+    uint32_t mNextLane;       // number of lanes ever used (lanes are handed out lowest free first)
+    uint32_t mPid;
+    uint64_t mDroppedRecords; // records dropped because all lanes were in use by live threads
+    uint64_t mBaseMonoNs;     // CLOCK_MONOTONIC nanosec at construction
+    uint64_t mBaseWallUs;     // gettimeofday microsec at construction
+    char mTitle[80];
+    char mEventName[MAX_EVENT_NAMES][EVENT_NAME_SIZE];
+};
+
+class ShmFootmarkLanes
+//
+// Multi-thread version of ShmFootmark for crash forensics.
+// ShmFootmark keeps a single stack of strings and is not MTsafe. This class instead gives every thread
+// its own lane inside a single shared memory segment. Each lane is a circular buffer of small fixed size
+// binary records (timestamp, event id, 32bit arg and 16 bytes payload) and only its owner thread writes
+// to it, so append is lock-free and costs a clock read plus a few stores. This is cheap enough to be
+// left on in production.
+//
+// After the process exits or crashes, the shared memory remains and shmFootmarkDump decodes it and
+// merges all lanes into a single timeline. Like ShmFootmark, the shared memory is never cleaned up
+// automatically (see ipcs -m / ipcrm -m <shmId>).
+//
+// How to use ShmFootmarkLanes
+//
+//   static ShmFootmarkLanes sFootmark("myProcess");  // shmId is shown on cerr
+//   sFootmark.setEventName(1, "tileStart");         // optional, used by the dump
+//   sFootmark.setEventName(2, "tileEnd");
+//   ...
+//   sFootmark.record(1, tileId);                    // from any thread
+//   sFootmark.recordText(3, "snapshot");            // keeps first 16 chars
+//
+// A thread gets its lane on the first record() call and hands it back when it exits. A returned lane
+// keeps the last records of its finished thread until the lane is taken by another thread, whose
+// records then gradually overwrite them. If more than numLanes live threads record, the extra records
+// are dropped and counted in the header. A thread which found no free lane tries again on its next
+// record(), so short lived threads (e.g. TBB arena churn) do not use up the lanes.
+//
+{
+public:
+    static constexpr unsigned DEFAULT_NUM_LANES = 64;
+    static constexpr unsigned DEFAULT_LANE_CAPACITY = 1024; // records
+
+    // laneCapacity is rounded up to a power of 2. Throws except::RuntimeError on shared memory failure.
+    ShmFootmarkLanes(const std::string& title,
+                     unsigned numLanes = DEFAULT_NUM_LANES,
+                     unsigned laneCapacity = DEFAULT_LANE_CAPACITY);
+    ~ShmFootmarkLanes();
+
+    ShmFootmarkLanes(const ShmFootmarkLanes&) = delete;
+    ShmFootmarkLanes& operator=(const ShmFootmarkLanes&) = delete;
+
+    int getShmId() const { return mShmId; }
+    size_t getMemSize() const { return mMemSize; }
+
+    // Not MTsafe. Intended to be called at setup time, before recording starts.
+    void setEventName(uint16_t eventId, const std::string& name);
+
+    // Names the current thread's lane. The pthread name is used by default.
+    void setThreadName(const std::string& name);
+
+    // MTsafe and lock-free. Returns false if the record was dropped (no lane left).
+    bool record(uint16_t eventId, uint32_t arg = 0, uint64_t payload0 = 0, uint64_t payload1 = 0);
+    bool recordText(uint16_t eventId, const char* text, uint32_t arg = 0);
+
+    static uint64_t getMonotonicNanoSec();
+
+private:
+    // Which lanes are owned by a live thread. Shared with the threads' lane caches, so that a thread
+    // which exits after this ShmFootmarkLanes was destroyed does not touch freed memory.
+    struct LanePool
+    {
+        explicit LanePool(unsigned numLanes);
+        int acquire(); // returns the lowest free lane id or -1
+        void release(unsigned laneId);
+
+        const unsigned mNumLanes;
+        std::unique_ptr<std::atomic<uint64_t>[]> mInUse; // 1 bit per lane
+    };
+
+    ShmFootmarkLaneHeader* getThreadLane();
+    int acquireLane(); // returns the lane id or -1
+    ShmFootmarkLaneHeader* getLaneAddr(unsigned laneId) const;
+    bool append(ShmFootmarkLaneHeader* lane, const ShmFootmarkRecord& rec);
+
+    //------------------------------
+
+    int mShmId {0};
+    size_t mMemSize {0};
+    size_t mLaneStride {0};
+    uint64_t mInstanceId {0};
+    ShmFootmarkLanesHeader* mHeader {nullptr};
+    std::shared_ptr<LanePool> mLanePool;
+};
+
+class ShmFootmarkLanesView
+//
+// Read-only decoder of the shared memory made by ShmFootmarkLanes. Records are read by the seqlock
+// style, so it is also safe to run against a live process : records which might have been overwritten
+// while copying are discarded.
+//
+// Please check scene_rdl2/cmd/mcrt_cmd/shmFootmarkDump/main.cc as an example of use.
+//
+{
+public:
+    struct Item
+    {
+        unsigned mLaneId;
+        bool mPrevOwner; // recorded by a finished thread which used the lane before its current owner
+        ShmFootmarkRecord mRecord;
+    };
+
+    // Throws except::RuntimeError if the shared memory can not be attached.
+    explicit ShmFootmarkLanesView(int shmId);
+    ~ShmFootmarkLanesView();
+
+    ShmFootmarkLanesView(const ShmFootmarkLanesView&) = delete;
+    ShmFootmarkLanesView& operator=(const ShmFootmarkLanesView&) = delete;
+
+    // false if the segment was not made by ShmFootmarkLanes (i.e. it is a ShmFootmark segment).
+    bool isValid() const { return mHeader != nullptr; }
+
+    // All valid records of all lanes sorted by time.
+    std::vector<Item> getTimeline() const;
+
+    std::string showHeader() const;
+    std::string showTimeline() const;
+    std::string showItem(const Item& item) const;
+
+    void freeShMem();
+
+private:
+    const ShmFootmarkLaneHeader* getLane(unsigned laneId) const;
+    std::string getEventName(uint16_t eventId) const;
+
+    //------------------------------
+
+    int mShmId {0};
+    void* mMemPtr {nullptr};
+    const ShmFootmarkLanesHeader* mHeader {nullptr}; // nullptr if not a ShmFootmarkLanes segment
+};
+
+} // namespace grid_util
+} // namespace scene_rdl2
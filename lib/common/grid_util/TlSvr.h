@@ -18,6 +18,7 @@ class TlSvr
 // This class provides the functionality of server side telnet connection. 
 // Only support p2p (point to point) connection so far and not support multiple
 // incoming input from multiple clients. Only support IPv4 so far.
+// (See TlSvrMulti for the multi-client version with non-blocking output.)
 // Using this class, it is very easy to implement interactive command line console
 // functionality to the non interactive application.
 //
@@ -0,0 +1,525 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "TlSvrMulti.h"
+#include "LiteralUtil.h"
+#include "SockUtil.h"
+
+#include <scene_rdl2/render/util/StrUtil.h>
+
+#include <sstream>
+#include <vector>
+
+#include <arpa/inet.h>          // inet_ntop()
+#include <netinet/in.h>         // struct sockaddr_in
+#include <netinet/tcp.h>        // TCP_NODELAY
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+static constexpr const char *msgHead = ">TLSvrMulti<"; // message head strings for *MSG_CALLBACK functions
+
+struct TlSvrMulti::Client
+{
+    ClientId mId {0};
+    int mSock {-1};
+    std::string mAddr;
+
+    std::string mRecvBuff; // only accessed by poll() thread
+
+    // Output queue. Protected by TlSvrMulti::mMutex
+    std::string mSendBuff;
+    size_t mSendOffset {0};
+    bool mEpollOut {false}; // EPOLLOUT is registered
+    bool mReadClosed {false}; // EOF received : closed by poll() once the output queue is empty
+    bool mBroken {false};   // will be closed by next poll()
+
+    size_t getQueuedSize() const { return mSendBuff.size() - mSendOffset; }
+};
+
+TlSvrMulti::TlSvrMulti()
+{
+}
+
+TlSvrMulti::~TlSvrMulti()
+{
+    close();
+}
+
+int
+TlSvrMulti::open(const int serverPortNum,
+                 INFOMSG_CALLBACK infoMsgCallBack,
+                 ERRMSG_CALLBACK errMsgCallBack)
+{
+    if (mEpollFd != -1) {
+        return mPort; // already opened
+    }
+
+    mInfoMsgCallBack = infoMsgCallBack;
+    mErrMsgCallBack = errMsgCallBack;
+    mPort = serverPortNum;
+
+    auto errorExit = [&](const std::string &msg) {
+        if (errMsgCallBack) {
+            errMsgCallBack(str_util::stringCat(msgHead, ' ', msg, " errno:", std::to_string(errno),
+                                               " (", strerror(errno), ")"));
+        }
+        close();
+        return 0;
+    };
+
+    if ((mEpollFd = ::epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        mEpollFd = -1;
+        return errorExit("::epoll_create1() failed.");
+    }
+    if ((mWakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        mWakeupFd = -1;
+        return errorExit("::eventfd() failed.");
+    }
+    if (!socketBindAndListen(errMsgCallBack)) {
+        close();
+        return 0;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_ID;
+    if (::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mBaseSock, &ev) < 0) {
+        return errorExit("::epoll_ctl() failed for baseSock.");
+    }
+    ev.data.u64 = WAKEUP_ID;
+    if (::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeupFd, &ev) < 0) {
+        return errorExit("::epoll_ctl() failed for wakeupFd.");
+    }
+
+    if (infoMsgCallBack) {
+        infoMsgCallBack(str_util::stringCat(msgHead, " opened server port:", std::to_string(mPort)));
+    }
+    return mPort;
+}
+
+void
+TlSvrMulti::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto &itr : mClients) {
+            ::close(itr.second->mSock);
+        }
+        mClients.clear();
+    }
+
+    if (mBaseSock != -1) {
+        ::close(mBaseSock);
+        mBaseSock = -1;
+    }
+    if (mWakeupFd != -1) {
+        ::close(mWakeupFd);
+        mWakeupFd = -1;
+    }
+    if (mEpollFd != -1) {
+        ::close(mEpollFd);
+        mEpollFd = -1;
+    }
+}
+
+bool
+TlSvrMulti::poll(int timeoutMs,
+                 const LINE_CALLBACK &lineCallBack,
+                 const CLOSE_CALLBACK &closeCallBack)
+{
+    if (mEpollFd == -1) {
+        return false;
+    }
+
+    constexpr int maxEvents = 32;
+    struct epoll_event events[maxEvents];
+    int eventTotal = ::epoll_wait(mEpollFd, events, maxEvents, timeoutMs);
+    if (eventTotal < 0) {
+        if (errno == EINTR) return true;
+        if (mErrMsgCallBack) {
+            mErrMsgCallBack(str_util::stringCat(msgHead, " ::epoll_wait() failed. errno:",
+                                                std::to_string(errno), " ", strerror(errno)));
+        }
+        return false;
+    }
+
+    for (int i = 0; i < eventTotal; ++i) {
+        const ClientId id = events[i].data.u64;
+        if (id == LISTEN_ID) {
+            acceptClients();
+            continue;
+        }
+        if (id == WAKEUP_ID) {
+            uint64_t count;
+            while (::read(mWakeupFd, &count, sizeof(count)) > 0) {}
+            continue;
+        }
+
+        ClientShPtr client = findClient(id);
+        if (!client) continue; // already closed
+
+        if (events[i].events & EPOLLOUT) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (!flushClient(*client)) {
+                client->mBroken = true;
+            } else if (client->getQueuedSize() == 0) {
+                updateEpollOut(*client, false);
+            }
+        }
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            bool eof = false;
+            const bool alive = recvClient(*client, lineCallBack, eof);
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (!alive) {
+                client->mBroken = true;
+            } else if (eof && !client->mReadClosed) {
+                // Half-closed by the other side. Stop reading but keep the connection until the
+                // output for its last lines is sent.
+                client->mReadClosed = true;
+                modEpoll(*client, client->mEpollOut);
+            }
+        }
+    }
+
+    // Clients may also be marked broken by send() from other threads.
+    std::vector<ClientId> brokenClients;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto &itr : mClients) {
+            const Client &client = *(itr.second);
+            if (client.mBroken || (client.mReadClosed && client.getQueuedSize() == 0)) {
+                brokenClients.push_back(itr.first);
+            }
+        }
+    }
+    for (ClientId id : brokenClients) {
+        closeClient(id, closeCallBack);
+    }
+
+    return true;
+}
+
+void
+TlSvrMulti::wakeup()
+{
+    if (mWakeupFd == -1) return;
+    const uint64_t one = 1;
+    (void)::write(mWakeupFd, &one, sizeof(one));
+}
+
+bool
+TlSvrMulti::send(ClientId clientId, const std::string &sendStr)
+{
+    if (sendStr.empty()) return true;
+
+    bool needWakeup = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto itr = mClients.find(clientId);
+        if (itr == mClients.end() || itr->second->mBroken) {
+            return false;
+        }
+
+        Client &client = *(itr->second);
+        if (client.getQueuedSize() + sendStr.size() > mMaxQueueSize) {
+            // The client does not read its output anymore. Disconnect rather than growing forever.
+            client.mBroken = true;
+            needWakeup = true;
+        } else {
+            client.mSendBuff += sendStr;
+            if (!client.mEpollOut) {
+                // Nothing is pending, so try to send right away and only fall back to the queue
+                // (flushed by poll()) when the socket buffer is full.
+                if (!flushClient(client)) {
+                    client.mBroken = true;
+                    needWakeup = true;
+                } else if (client.getQueuedSize() > 0) {
+                    updateEpollOut(client, true);
+                }
+            }
+        }
+    }
+    if (needWakeup) {
+        wakeup();
+        return false;
+    }
+    return true;
+}
+
+void
+TlSvrMulti::broadcast(const std::string &sendStr)
+{
+    std::vector<ClientId> ids;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto &itr : mClients) ids.push_back(itr.first);
+    }
+    for (ClientId id : ids) {
+        send(id, sendStr);
+    }
+}
+
+size_t
+TlSvrMulti::getClientTotal() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mClients.size();
+}
+
+std::string
+TlSvrMulti::getClientAddr(ClientId clientId) const
+{
+    ClientShPtr client = findClient(clientId);
+    return (client) ? client->mAddr : "";
+}
+
+std::string
+TlSvrMulti::show() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::ostringstream ostr;
+    ostr << "TlSvrMulti {\n"
+         << "  mPort:" << mPort << '\n'
+         << "  mMaxQueueSize:" << str_util::byteStr(mMaxQueueSize) << '\n'
+         << "  clients (size:" << mClients.size() << ") {\n";
+    for (const auto &itr : mClients) {
+        const Client &client = *(itr.second);
+        ostr << "    clientId:" << client.mId
+             << " addr:" << client.mAddr
+             << " queued:" << str_util::byteStr(client.getQueuedSize())
+             << ((client.mReadClosed) ? " readClosed" : "")
+             << ((client.mBroken) ? " broken" : "") << '\n';
+    }
+    ostr << "  }\n"
+         << "}";
+    return ostr.str();
+}
+
+//------------------------------------------------------------------------------
+
+bool
+TlSvrMulti::socketBindAndListen(ERRMSG_CALLBACK errMsgCallBack)
+{
+    auto errorMsg = [&](const std::string &msg) {
+        if (errMsgCallBack) {
+            errMsgCallBack(str_util::stringCat(msgHead, ' ', msg, " errno:", std::to_string(errno),
+                                               " (", strerror(errno), ")"));
+        }
+        if (mBaseSock != -1) {
+            ::close(mBaseSock);
+            mBaseSock = -1;
+        }
+        return false;
+    };
+
+    if ((mBaseSock = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+        mBaseSock = -1;
+        return errorMsg("::socket() call failed for baseSock.");
+    }
+
+    int status = 1;
+    if (::setsockopt(mBaseSock, SOL_SOCKET, SO_REUSEADDR, (char *)&status, sizeof(status)) < 0) {
+        return errorMsg("set socket option failed. (SO_REUSEADDR)");
+    }
+
+    struct sockaddr_in in;
+    bzero(&in, sizeof(in));
+    in.sin_family = AF_INET;
+    in.sin_addr.s_addr = INADDR_ANY;
+    in.sin_port = htons(static_cast<uint16_t>(mPort)); // put in net order
+    if (::bind(mBaseSock, (struct sockaddr*)&in, sizeof(in)) < 0) {
+        return errorMsg(str_util::stringCat("::bind() socket failed. port:", std::to_string(mPort)));
+    }
+
+    if (mPort == 0) {
+        socklen_t inLen = sizeof(in);
+        if (::getsockname(mBaseSock, (sockaddr*)&in, &inLen) != 0) {
+            return errorMsg("::getsockname() failed.");
+        }
+        mPort = ntohs(in.sin_port);
+    }
+
+    if (::listen(mBaseSock, 16) < 0) {
+        return errorMsg("::listen() failed.");
+    }
+    return true;
+}
+
+void
+TlSvrMulti::acceptClients()
+{
+    while (true) {
+        struct sockaddr_in in;
+        socklen_t addrlen = sizeof(in);
+        int sock = ::accept4(mBaseSock, (struct sockaddr *)&in, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (sock < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK && mErrMsgCallBack) {
+                mErrMsgCallBack(str_util::stringCat(msgHead, " ::accept4() returns error. errno:",
+                                                    std::to_string(errno), " ", strerror(errno)));
+            }
+            return;
+        }
+
+        int optV = 1; // true
+        ::setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&optV, sizeof(optV));
+        ::setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, (char*)&optV, sizeof(optV));
+        setSockBufferSize(sock, SOL_SOCKET, 64_KiB);
+
+        char addrStr[INET_ADDRSTRLEN] = {0};
+        ::inet_ntop(AF_INET, &in.sin_addr, addrStr, sizeof(addrStr));
+
+        auto client = std::make_shared<Client>();
+        client->mSock = sock;
+        client->mAddr = str_util::stringCat(addrStr, ':', std::to_string(ntohs(in.sin_port)));
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            client->mId = mNextClientId++;
+
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.u64 = client->mId;
+            if (::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, sock, &ev) < 0) {
+                ::close(sock);
+                continue;
+            }
+            mClients[client->mId] = client;
+        }
+
+        if (mInfoMsgCallBack) {
+            mInfoMsgCallBack(str_util::stringCat(msgHead, " connection established. port:",
+                                                 std::to_string(mPort), " clientId:",
+                                                 std::to_string(client->mId), " addr:", client->mAddr));
+        }
+    }
+}
+
+bool
+TlSvrMulti::recvClient(Client &client, const LINE_CALLBACK &lineCallBack, bool &eof)
+//
+// Returns false if the connection is broken. eof is set if the other side closed its sending side,
+// which may be a half-close only, so the output for the received lines still has to be flushed.
+//
+{
+    auto deliverLine = [&]() {
+        if (lineCallBack) lineCallBack(client.mId, client.mRecvBuff);
+        client.mRecvBuff.clear();
+    };
+
+    char buff[4096];
+    while (true) {
+        const ssize_t rSize = ::read(client.mSock, buff, sizeof(buff));
+        if (rSize == 0) {
+            if (!client.mRecvBuff.empty()) deliverLine(); // last line without '\n'
+            eof = true;
+            return true;
+        }
+        if (rSize < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true; // empty : try again later
+            return false;
+        }
+
+        for (ssize_t i = 0; i < rSize; ++i) {
+            const char c = buff[i];
+            if (c == '\r') continue; // skip \r
+            if (c == '\n' || c == 0x0) {
+                deliverLine();
+            } else {
+                client.mRecvBuff += c;
+            }
+        }
+        if (client.mRecvBuff.size() > MAX_LINE_SIZE) {
+            if (mErrMsgCallBack) {
+                mErrMsgCallBack(str_util::stringCat(msgHead, " too long line. clientId:",
+                                                    std::to_string(client.mId)));
+            }
+            return false;
+        }
+    }
+}
+
+bool
+TlSvrMulti::flushClient(Client &client)
+{
+    while (client.mSendOffset < client.mSendBuff.size()) {
+        const ssize_t wSize = ::send(client.mSock,
+                                     client.mSendBuff.data() + client.mSendOffset,
+                                     client.mSendBuff.size() - client.mSendOffset,
+                                     MSG_NOSIGNAL);
+        if (wSize < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break; // socket buffer is full
+            return false; // EPIPE or other error
+        }
+        client.mSendOffset += static_cast<size_t>(wSize);
+    }
+
+    if (client.mSendOffset == client.mSendBuff.size()) {
+        client.mSendBuff.clear();
+        client.mSendOffset = 0;
+    } else if (client.mSendOffset > client.mSendBuff.size() / 2) {
+        client.mSendBuff.erase(0, client.mSendOffset);
+        client.mSendOffset = 0;
+    }
+    return true;
+}
+
+void
+TlSvrMulti::updateEpollOut(Client &client, bool wantOut)
+{
+    if (client.mEpollOut == wantOut) return;
+
+    if (modEpoll(client, wantOut)) {
+        client.mEpollOut = wantOut;
+    }
+}
+
+bool
+TlSvrMulti::modEpoll(Client &client, bool wantOut)
+{
+    // No EPOLLIN after EOF, otherwise epoll keeps reporting the EOF until the client is closed.
+    struct epoll_event ev;
+    ev.events = ((client.mReadClosed) ? 0u : static_cast<uint32_t>(EPOLLIN)) |
+                ((wantOut) ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.u64 = client.mId;
+    return ::epoll_ctl(mEpollFd, EPOLL_CTL_MOD, client.mSock, &ev) == 0;
+}
+
+void
+TlSvrMulti::closeClient(ClientId clientId, const CLOSE_CALLBACK &closeCallBack)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto itr = mClients.find(clientId);
+        if (itr == mClients.end()) return;
+
+        ::epoll_ctl(mEpollFd, EPOLL_CTL_DEL, itr->second->mSock, nullptr);
+        ::close(itr->second->mSock);
+        mClients.erase(itr);
+    }
+
+    if (mInfoMsgCallBack) {
+        mInfoMsgCallBack(str_util::stringCat(msgHead, " connection closed. port:", std::to_string(mPort),
+                                             " clientId:", std::to_string(clientId)));
+    }
+    if (closeCallBack) closeCallBack(clientId);
+}
+
+TlSvrMulti::ClientShPtr
+TlSvrMulti::findClient(ClientId clientId) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto itr = mClients.find(clientId);
+    return (itr == mClients.end()) ? nullptr : itr->second;
+}
+
+} // namespace grid_util
+} // namespace scene_rdl2
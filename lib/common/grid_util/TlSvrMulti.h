@@ -0,0 +1,134 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+class TlSvrMulti
+//
+// Multi-client version of TlSvr based on epoll.
+// TlSvr only accepts a single telnet connection and its send() blocks until all data is written.
+// TlSvrMulti keeps listening after a connection is established, so any number of clients can attach
+// at the same time. All sockets are non-blocking and every client has its own output queue, so a slow
+// or stalled client never blocks the sender. A client whose output queue exceeds the max queue size is
+// disconnected. A client which only closes its sending side (e.g. "echo cmd | nc host port") stays
+// connected until the output which is queued for it is sent.
+//
+// Typical usage is a single event loop thread which calls poll() repeatedly. Received command lines
+// are delivered to the line callback on the poll() thread. send() and broadcast() can be called from
+// any thread.
+//
+//    TlSvrMulti svr;
+//    if (!svr.open(20000)) return; // port is 20000
+//
+//    while (!shutdown) {
+//        svr.poll(100, // wait max 100ms
+//                 [&](ClientId clientId, const std::string &cmdLine) {
+//                     // parse cmdLine here and do something ...
+//                     svr.send(clientId, "..test..test..test\n");
+//                 });
+//    }
+//    svr.close();
+//
+{
+public:
+    using ClientId = uint64_t;
+    using INFOMSG_CALLBACK = std::function<void(const std::string &)>;
+    using ERRMSG_CALLBACK = std::function<void(const std::string &)>;
+    using LINE_CALLBACK = std::function<void(ClientId clientId, const std::string &line)>;
+    using CLOSE_CALLBACK = std::function<void(ClientId clientId)>;
+
+    static constexpr size_t DEFAULT_MAX_QUEUE_SIZE = 64 * 1024 * 1024; // byte
+    static constexpr size_t MAX_LINE_SIZE = 64 * 1024; // byte
+
+    TlSvrMulti();
+    ~TlSvrMulti();
+
+    // Non-copyable
+    TlSvrMulti &operator =(const TlSvrMulti &) = delete;
+    TlSvrMulti(const TlSvrMulti &) = delete;
+
+    //
+    // Opens the listen socket immediately. You can use serverPortNum = 0 for auto search of available
+    // port by the kernel. Returns opened port number, 0 is error.
+    //
+    int open(const int serverPortNum,
+             INFOMSG_CALLBACK infoMsgCallBack = nullptr,
+             ERRMSG_CALLBACK errMsgCallBack = nullptr);
+    void close();
+
+    //
+    // Waits max timeoutMs millisec for socket activity (-1 : no timeout), then accepts new clients,
+    // receives data and flushes pending output. lineCallBack is called for each received line (terminated
+    // by '\n' or 0x0, '\r' is removed) and closeCallBack is called when a client is disconnected. Both are
+    // called on the caller's thread. Output sent by lineCallBack to a client which has closed its sending
+    // side is still flushed before the client is disconnected.
+    // Returns false if the server is not opened or epoll failed.
+    //
+    bool poll(int timeoutMs,
+              const LINE_CALLBACK &lineCallBack,
+              const CLOSE_CALLBACK &closeCallBack = nullptr);
+
+    // Wakes up poll() from another thread.
+    void wakeup();
+
+    // Non-blocking send. MTsafe. Data which can not be written immediately is queued and sent by poll().
+    // Returns false if the client does not exist (anymore).
+    bool send(ClientId clientId, const std::string &sendStr);
+    void broadcast(const std::string &sendStr); // send to all clients
+
+    int getPort() const { return mPort; }
+    size_t getClientTotal() const;
+    std::string getClientAddr(ClientId clientId) const;
+
+    void setMaxQueueSize(size_t size) { mMaxQueueSize = size; }
+
+    std::string show() const;
+
+private:
+    struct Client;
+    using ClientShPtr = std::shared_ptr<Client>;
+
+    static constexpr ClientId LISTEN_ID = 0;
+    static constexpr ClientId WAKEUP_ID = 1;
+
+    bool socketBindAndListen(ERRMSG_CALLBACK errMsgCallBack);
+    void acceptClients();
+    // return false if broken. eof is set if the other side closed its sending side
+    bool recvClient(Client &client, const LINE_CALLBACK &lineCallBack, bool &eof);
+    bool flushClient(Client &client); // need mMutex locked. return false if the client is broken
+    void updateEpollOut(Client &client, bool wantOut); // need mMutex locked
+    bool modEpoll(Client &client, bool wantOut); // need mMutex locked
+    void closeClient(ClientId clientId, const CLOSE_CALLBACK &closeCallBack);
+
+    ClientShPtr findClient(ClientId clientId) const;
+
+    //------------------------------
+
+    int mPort {0};
+    int mBaseSock {-1};
+    int mEpollFd {-1};
+    int mWakeupFd {-1};
+    size_t mMaxQueueSize {DEFAULT_MAX_QUEUE_SIZE};
+
+    INFOMSG_CALLBACK mInfoMsgCallBack;
+    ERRMSG_CALLBACK mErrMsgCallBack;
+
+    mutable std::mutex mMutex; // for mClients and all the client's output queue
+    ClientId mNextClientId {WAKEUP_ID + 1};
+    std::map<ClientId, ClientShPtr> mClients;
+};
+
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,142 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "RecPerfCounter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace scene_rdl2 {
+namespace rec_time {
+
+#ifdef __linux__
+namespace {
+
+int
+openEvent(uint64_t config, int groupFd)
+{
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (groupFd < 0) ? 1 : 0; // the whole group starts with its leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0 /* this thread */, -1 /* any cpu */,
+                                      groupFd, 0));
+}
+
+} // namespace
+#endif
+
+RecPerfCounter::RecPerfCounter() :
+    mGroupFd(-1)
+{
+    for (int i = 0; i < sEventTotal; ++i) mFd[i] = -1;
+
+#ifdef __linux__
+    static const uint64_t configs[sEventTotal] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    mFd[0] = openEvent(configs[0], -1);
+    if (mFd[0] < 0) {
+        std::ostringstream ostr;
+        ostr << "perf_event_open failed : " << std::strerror(errno);
+        if (errno == EACCES || errno == EPERM) ostr << " (check /proc/sys/kernel/perf_event_paranoid)";
+        else if (errno == ENOENT || errno == EOPNOTSUPP) ostr << " (no hardware PMU, e.g. virtual machine)";
+        mError = ostr.str();
+        return;
+    }
+    for (int i = 1; i < sEventTotal; ++i) {
+        mFd[i] = openEvent(configs[i], mFd[0]); // unsupported events simply stay at -1
+    }
+    mGroupFd = mFd[0];
+
+    ::ioctl(mGroupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl(mGroupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+    mError = "perf events are only supported on linux";
+#endif
+}
+
+RecPerfCounter::~RecPerfCounter()
+{
+#ifdef __linux__
+    for (int i = sEventTotal - 1; i >= 0; --i) {
+        if (mFd[i] >= 0) ::close(mFd[i]);
+    }
+#endif
+}
+
+// static function
+RecPerfCounter &
+RecPerfCounter::getThreadInstance()
+{
+    thread_local RecPerfCounter counter;
+    return counter;
+}
+
+RecPerfValues
+RecPerfCounter::read() const
+{
+    RecPerfValues values;
+#ifdef __linux__
+    if (!isAvailable()) return values;
+
+    // PERF_FORMAT_GROUP layout : nr, time_enabled, time_running, value[nr]
+    // values are in the order the events were added to the group.
+    uint64_t buff[3 + sEventTotal];
+    if (::read(mGroupFd, buff, sizeof(buff)) < (ssize_t)(sizeof(uint64_t) * 3)) return values;
+
+    const uint64_t nr = buff[0];
+    const double scale = (buff[2] > 0 && buff[2] < buff[1]) ? (double)buff[1] / (double)buff[2] : 1.0;
+    uint64_t *const dst[sEventTotal] = {
+        &values.mCycles, &values.mInstructions, &values.mLlcMisses, &values.mBranchMisses
+    };
+    uint64_t id = 0;
+    for (int i = 0; i < sEventTotal; ++i) {
+        if (mFd[i] < 0) continue;
+        if (id >= nr) break;
+        *dst[i] = (uint64_t)((double)buff[3 + id] * scale);
+        ++id;
+    }
+#endif
+    return values;
+}
+
+std::string
+RecPerfCounter::show() const
+{
+    std::ostringstream ostr;
+    ostr << "RecPerfCounter {\n";
+    if (!isAvailable()) {
+        ostr << "  not available : " << mError << '\n';
+    } else {
+        static const char *names[sEventTotal] = { "cycles", "instructions", "LLC misses", "branch misses" };
+        for (int i = 0; i < sEventTotal; ++i) {
+            ostr << "  " << names[i] << " : " << ((mFd[i] >= 0) ? "active" : "not supported") << '\n';
+        }
+    }
+    ostr << "}";
+    return ostr.str();
+}
+
+} // namespace rec_time
+} // namespace scene_rdl2
+
@@ -0,0 +1,163 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+
+namespace scene_rdl2 {
+namespace rec_time {
+
+class RecPerfValues
+//
+// One sample (or a difference of two samples) of the hardware counters
+//
+{
+public:
+    RecPerfValues() { reset(); }
+
+    void reset() { mCycles = 0; mInstructions = 0; mLlcMisses = 0; mBranchMisses = 0; }
+
+    RecPerfValues &operator += (const RecPerfValues &v) {
+        mCycles += v.mCycles;
+        mInstructions += v.mInstructions;
+        mLlcMisses += v.mLlcMisses;
+        mBranchMisses += v.mBranchMisses;
+        return *this;
+    }
+    RecPerfValues operator - (const RecPerfValues &v) const {
+        RecPerfValues r;
+        r.mCycles = mCycles - v.mCycles;
+        r.mInstructions = mInstructions - v.mInstructions;
+        r.mLlcMisses = mLlcMisses - v.mLlcMisses;
+        r.mBranchMisses = mBranchMisses - v.mBranchMisses;
+        return r;
+    }
+
+    RecPerfValues operator / (const uint64_t n) const {
+        RecPerfValues r;
+        if (n) {
+            r.mCycles = mCycles / n;
+            r.mInstructions = mInstructions / n;
+            r.mLlcMisses = mLlcMisses / n;
+            r.mBranchMisses = mBranchMisses / n;
+        }
+        return r;
+    }
+
+    float getIpc() const { return (mCycles)? (float)mInstructions / (float)mCycles: 0.0f; }
+
+    uint64_t mCycles;
+    uint64_t mInstructions;
+    uint64_t mLlcMisses;     // last level cache misses
+    uint64_t mBranchMisses;
+};
+
+class RecPerfCounter
+//
+// Hardware performance counters (cycles, instructions, LLC misses and branch
+// misses) of the calling thread, based on perf_event_open(2).
+//
+// perf events opened this way only count the thread which opened them, so use
+// RecPerfCounter::getThreadInstance() and always read a counter from its own
+// thread. When perf events are not available (not linux, a container without
+// the syscall, perf_event_paranoid too strict, no PMU in a VM, ...) the
+// counter stays unavailable, read() returns all zeros and getError() tells why.
+// Individual events the PMU doesn't support read as zero.
+//
+{
+public:
+    RecPerfCounter();
+    ~RecPerfCounter();
+
+    RecPerfCounter(const RecPerfCounter &) = delete;
+    RecPerfCounter &operator = (const RecPerfCounter &) = delete;
+
+    static RecPerfCounter &getThreadInstance(); // counter for the calling thread
+
+    bool isAvailable() const { return mGroupFd >= 0; }
+    const std::string &getError() const { return mError; }
+
+    // Current counter values since the counter was opened. Scaled up when the
+    // kernel had to multiplex the events.
+    RecPerfValues read() const;
+
+    std::string show() const;
+
+private:
+    static constexpr int sEventTotal = 4;
+
+    int mGroupFd;
+    int mFd[sEventTotal];
+    std::string mError;
+};
+
+class RecPerfManualInterval
+//
+// get interval by hardware counters of the calling thread and logging.
+// start() and end() must be called from the same thread. The intervals are
+// also kept per thread, for sections which run on different threads over time.
+//
+{
+public:
+    struct ThreadValues
+    {
+        std::thread::id mThreadId;
+        RecPerfValues mAll;
+        uint64_t mTotal;
+
+        RecPerfValues getAverage() const { return mAll / mTotal; }
+    };
+
+    RecPerfManualInterval() : mStarted(false), mTotal(0) {}
+
+    void start() { mStart = RecPerfCounter::getThreadInstance().read(); mStarted = true; }
+    bool isStarted() const { return mStarted; }
+    RecPerfValues end() { // end interval and return interval values
+        mStarted = false;
+        return RecPerfCounter::getThreadInstance().read() - mStart;
+    }
+    void add(const RecPerfValues &v, const std::thread::id threadId) { // add interval values to log
+        mLast = v;
+        mAll += v;
+        ++mTotal;
+
+        for (ThreadValues &cThread : mThreads) {
+            if (cThread.mThreadId == threadId) {
+                cThread.mAll += v;
+                ++cThread.mTotal;
+                return;
+            }
+        }
+        mThreads.push_back(ThreadValues {threadId, v, 1});
+    }
+    void endAdd() { add(end(), std::this_thread::get_id()); }
+
+    void reset() { mAll.reset(); mLast.reset(); mTotal = 0; mThreads.clear(); }
+    bool isReset() const { return (mTotal == 0)? true: false; }
+
+    const RecPerfValues &getLast() const { return mLast; }
+    RecPerfValues getAverage() const { return mAll / mTotal; }
+    uint64_t getTotal() const { return mTotal; }
+
+    // per thread breakdown, in the order the threads first ran the interval
+    const std::vector<ThreadValues> &getThreads() const { return mThreads; }
+
+protected:
+    RecPerfValues mStart;
+    bool mStarted;
+    RecPerfValues mLast;
+    RecPerfValues mAll;
+    uint64_t mTotal;
+    std::vector<ThreadValues> mThreads;
+};
+
+} // namespace rec_time
+} // namespace scene_rdl2
+
@@ -0,0 +1,374 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "RecScopeProfiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>             // getpid
+
+namespace scene_rdl2 {
+namespace rec_time {
+
+namespace {
+
+enum class EventType : uint32_t { SCOPE, COUNTER };
+
+struct Event
+{
+    const char *mName;
+    uint64_t mTick;
+    uint64_t mEndTick;  // SCOPE only
+    int64_t mValue;     // COUNTER only
+    EventType mType;
+};
+
+// Events are stored in fixed size chunks which are never moved, so export can
+// read a buffer while its thread keeps appending.
+constexpr size_t sChunkEvents = 8192;
+constexpr size_t sMaxChunks = 4096;   // per thread, 32M events
+
+struct ThreadBuffer
+{
+    ThreadBuffer() : mTid(0), mCount(0), mInUse(false) {}
+
+    Event *append()
+    {
+        const size_t count = mCount.load(std::memory_order_relaxed);
+        const size_t chunkId = count / sChunkEvents;
+        if (chunkId >= sMaxChunks) return nullptr;
+        if (!mChunks[chunkId]) mChunks[chunkId].reset(new Event[sChunkEvents]);
+        return &mChunks[chunkId][count % sChunkEvents];
+    }
+    void publish() { mCount.store(mCount.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    unsigned mTid;
+    std::string mThreadName;
+    std::atomic<size_t> mCount;
+    std::unique_ptr<Event[]> mChunks[sMaxChunks];
+    bool mInUse;
+};
+
+// The events of a thread which has exited, compacted.
+struct RetiredEvents
+{
+    unsigned mTid;
+    std::string mThreadName;
+    std::vector<Event> mEvents;
+};
+
+struct Registry
+{
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> mBuffers; // reused once their thread exits
+    std::vector<RetiredEvents> mRetired;
+    unsigned mNextTid {0};
+    std::atomic<uint64_t> mDropped {0};
+
+    // Ticks are converted to time against the steady clock over the whole
+    // interval since profiling was first enabled.
+    bool mCalibrated {false};
+    uint64_t mBaseTick {0};
+    std::chrono::steady_clock::time_point mBaseTime;
+};
+
+Registry &
+getRegistry()
+{
+    // Never destroyed, threads may still record during process exit.
+    static Registry *registry = new Registry;
+    return *registry;
+}
+
+// Hands the thread's buffer back when the thread exits: its events are
+// moved to the (compact) retired list and the buffer, with its first chunk,
+// is reused by the next new thread. Thread pool churn then costs memory for
+// the recorded events only, not a buffer per thread ever started.
+struct ThreadBufferHolder
+{
+    ~ThreadBufferHolder()
+    {
+        if (!mBuffer) return;
+
+        Registry &registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mMutex);
+        const size_t count = mBuffer->mCount.load(std::memory_order_relaxed);
+        if (count) {
+            registry.mRetired.push_back(RetiredEvents {mBuffer->mTid, mBuffer->mThreadName, {}});
+            std::vector<Event> &events = registry.mRetired.back().mEvents;
+            events.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                events.push_back(mBuffer->mChunks[i / sChunkEvents][i % sChunkEvents]);
+            }
+        }
+        mBuffer->mCount.store(0, std::memory_order_relaxed);
+        mBuffer->mThreadName.clear();
+        for (size_t i = 1; i < sMaxChunks && mBuffer->mChunks[i]; ++i) {
+            mBuffer->mChunks[i].reset();
+        }
+        mBuffer->mInUse = false;
+    }
+
+    ThreadBuffer *mBuffer {nullptr};
+};
+
+ThreadBuffer &
+getThreadBuffer()
+{
+    thread_local ThreadBufferHolder tHolder;
+    if (!tHolder.mBuffer) {
+        Registry &registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mMutex);
+        for (const auto &buffer : registry.mBuffers) {
+            if (!buffer->mInUse) {
+                tHolder.mBuffer = buffer.get();
+                break;
+            }
+        }
+        if (!tHolder.mBuffer) {
+            registry.mBuffers.emplace_back(new ThreadBuffer);
+            tHolder.mBuffer = registry.mBuffers.back().get();
+        }
+        tHolder.mBuffer->mTid = registry.mNextTid++;
+        tHolder.mBuffer->mInUse = true;
+    }
+    return *tHolder.mBuffer;
+}
+
+double
+computeTicksPerMicroSec(const Registry &registry)
+{
+    if (!registry.mCalibrated) return 0.0;
+    const uint64_t tick = RecScopeProfiler::getTick();
+    const double usec =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - registry.mBaseTime).count();
+    return (usec > 0.0 && tick > registry.mBaseTick) ? (double)(tick - registry.mBaseTick) / usec : 1.0;
+}
+
+void
+writeJsonString(std::ostream &out, const char *str)
+{
+    out << '"';
+    for (const char *c = str; *c; ++c) {
+        switch (*c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        default:
+            if (static_cast<unsigned char>(*c) < 0x20) {
+                char buff[8];
+                std::snprintf(buff, sizeof(buff), "\\u%04x", *c);
+                out << buff;
+            } else {
+                out << *c;
+            }
+        }
+    }
+    out << '"';
+}
+
+void
+saveAtExit()
+{
+    if (const char *filename = std::getenv("SCENE_RDL2_SCOPE_PROFILE")) {
+        RecScopeProfiler::saveChromeTrace(filename);
+    }
+}
+
+// Runtime switch for whole-process profiling, see RecScopeProfiler.h
+struct EnvSwitch
+{
+    EnvSwitch()
+    {
+        const char *filename = std::getenv("SCENE_RDL2_SCOPE_PROFILE");
+        if (filename && *filename) {
+            RecScopeProfiler::setEnabled(true);
+            std::atexit(saveAtExit);
+        }
+    }
+} sEnvSwitch;
+
+} // namespace
+
+std::atomic<bool> RecScopeProfiler::sEnabled(false);
+
+void
+RecScopeProfiler::setEnabled(bool flag)
+{
+    if (flag) {
+        Registry &registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mMutex);
+        if (!registry.mCalibrated) {
+            registry.mBaseTick = getTick();
+            registry.mBaseTime = std::chrono::steady_clock::now();
+            registry.mCalibrated = true;
+        }
+    }
+    sEnabled.store(flag, std::memory_order_relaxed);
+}
+
+double
+RecScopeProfiler::getTicksPerMicroSec()
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    return computeTicksPerMicroSec(registry);
+}
+
+size_t
+RecScopeProfiler::getThreadBufferCount()
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    return registry.mBuffers.size();
+}
+
+void
+RecScopeProfiler::setThreadName(const std::string &name)
+{
+    ThreadBuffer &buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(getRegistry().mMutex);
+    buffer.mThreadName = name;
+}
+
+void
+RecScopeProfiler::recordScope(const char *name, uint64_t startTick, uint64_t endTick)
+{
+    ThreadBuffer &buffer = getThreadBuffer();
+    Event *event = buffer.append();
+    if (!event) {
+        getRegistry().mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    event->mName = name;
+    event->mTick = startTick;
+    event->mEndTick = endTick;
+    event->mValue = 0;
+    event->mType = EventType::SCOPE;
+    buffer.publish();
+}
+
+void
+RecScopeProfiler::recordCounter(const char *name, int64_t value, uint64_t tick)
+{
+    ThreadBuffer &buffer = getThreadBuffer();
+    Event *event = buffer.append();
+    if (!event) {
+        getRegistry().mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    event->mName = name;
+    event->mTick = tick;
+    event->mEndTick = tick;
+    event->mValue = value;
+    event->mType = EventType::COUNTER;
+    buffer.publish();
+}
+
+uint64_t
+RecScopeProfiler::getFallbackTick()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                 (std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void
+RecScopeProfiler::exportChromeTrace(std::ostream &out)
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+
+    const double ticksPerMicroSec = computeTicksPerMicroSec(registry);
+    const double ticksPerUs = (ticksPerMicroSec > 0.0) ? ticksPerMicroSec : 1.0;
+    const uint64_t baseTick = registry.mBaseTick;
+    const int pid = static_cast<int>(getpid());
+    auto toUs = [&](uint64_t tick) {
+        return (tick > baseTick) ? (double)(tick - baseTick) / ticksPerUs : 0.0;
+    };
+
+    const std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&]() { out << (first ? "\n" : ",\n"); first = false; };
+
+    auto writeThread = [&](unsigned tid, const std::string &threadName, size_t count,
+                           const std::function<const Event &(size_t)> &getEvent) {
+        if (!threadName.empty()) {
+            separator();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+                << ",\"args\":{\"name\":";
+            writeJsonString(out, threadName.c_str());
+            out << "}}";
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const Event &event = getEvent(i);
+            separator();
+            out << "{\"name\":";
+            writeJsonString(out, event.mName);
+            if (event.mType == EventType::SCOPE) {
+                out << ",\"cat\":\"scene_rdl2\",\"ph\":\"X\",\"ts\":" << toUs(event.mTick)
+                    << ",\"dur\":" << (double)(event.mEndTick - event.mTick) / ticksPerUs;
+            } else {
+                out << ",\"ph\":\"C\",\"ts\":" << toUs(event.mTick)
+                    << ",\"args\":{\"value\":" << event.mValue << "}";
+            }
+            out << ",\"pid\":" << pid << ",\"tid\":" << tid << "}";
+        }
+    };
+
+    for (const RetiredEvents &retired : registry.mRetired) {
+        writeThread(retired.mTid, retired.mThreadName, retired.mEvents.size(),
+                    [&](size_t i) -> const Event & { return retired.mEvents[i]; });
+    }
+    for (const auto &buffer : registry.mBuffers) {
+        if (!buffer->mInUse) continue;
+        const ThreadBuffer &b = *buffer;
+        writeThread(b.mTid, b.mThreadName, b.mCount.load(std::memory_order_acquire),
+                    [&](size_t i) -> const Event & { return b.mChunks[i / sChunkEvents][i % sChunkEvents]; });
+    }
+    out << "\n]}\n";
+    out.flags(flags);
+}
+
+bool
+RecScopeProfiler::saveChromeTrace(const std::string &filename)
+{
+    std::ofstream out(filename);
+    if (!out) return false;
+    exportChromeTrace(out);
+    return static_cast<bool>(out);
+}
+
+void
+RecScopeProfiler::reset()
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    for (auto &buffer : registry.mBuffers) {
+        buffer->mCount.store(0, std::memory_order_release);
+    }
+    registry.mRetired.clear();
+    registry.mDropped = 0;
+}
+
+uint64_t
+RecScopeProfiler::getDroppedEventCount()
+{
+    return getRegistry().mDropped.load(std::memory_order_relaxed);
+}
+
+} // namespace rec_time
+} // namespace scene_rdl2
+
@@ -0,0 +1,131 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+#include <stdint.h>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+//
+// Scoped timeline profiling. Usage:
+//
+//   void SceneContext::applyUpdates(Layer* layer)
+//   {
+//       REC_SCOPE_PROFILE("SceneContext::applyUpdates");
+//       ...
+//       REC_SCOPE_COUNTER("dirtyObjects", dirtyCount);
+//   }
+//
+// Names must be string literals (or otherwise outlive the profiler), only the
+// pointer is recorded. Profiling is off by default, in which case a scope costs
+// a single relaxed load. Turn it on with RecScopeProfiler::setEnabled(true), or
+// for a whole process by setting SCENE_RDL2_SCOPE_PROFILE=<file.json> in the
+// environment, which also saves the trace to that file at exit. Traces load
+// in chrome://tracing and https://ui.perfetto.dev.
+//
+#define REC_SCOPE_PROFILE_CONCAT_INNER(a, b) a##b
+#define REC_SCOPE_PROFILE_CONCAT(a, b) REC_SCOPE_PROFILE_CONCAT_INNER(a, b)
+#define REC_SCOPE_PROFILE(name) \
+    ::scene_rdl2::rec_time::RecScopeProfiler::Scope REC_SCOPE_PROFILE_CONCAT(recScopeProfile_, __LINE__)(name)
+#define REC_SCOPE_COUNTER(name, value) \
+    ::scene_rdl2::rec_time::RecScopeProfiler::counter(name, static_cast<int64_t>(value))
+
+namespace scene_rdl2 {
+namespace rec_time {
+
+class RecScopeProfiler
+//
+// Low overhead recorder of nested, multi-threaded scopes and counters on a
+// common timeline, exported as Chrome trace event JSON.
+//
+// Timestamps are raw CPU ticks (TSC on x86-64, the virtual counter on aarch64)
+// which are converted to time once, at export, using the tick rate measured
+// against the steady clock since profiling was first enabled. Each thread
+// appends to its own event buffer, so recording never takes a lock after the
+// first event of a thread. When a thread exits its events are compacted and
+// its buffer is reused by the next new thread.
+//
+{
+public:
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name) :
+            mName(isEnabled() ? name : nullptr),
+            mStartTick(mName ? getTick() : 0)
+        {
+        }
+        ~Scope() { if (mName) recordScope(mName, mStartTick, getTick()); }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        const char *mName;
+        uint64_t mStartTick;
+    };
+
+    static void setEnabled(bool flag);
+    static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+    static void counter(const char *name, int64_t value)
+    {
+        if (isEnabled()) recordCounter(name, value, getTick());
+    }
+
+    // Name shown for the calling thread's track in the trace viewer.
+    static void setThreadName(const std::string &name);
+
+    // Writes every event recorded so far as Chrome trace JSON. Safe to call
+    // while other threads are recording, their newest events may be missed.
+    static void exportChromeTrace(std::ostream &out);
+    static bool saveChromeTrace(const std::string &filename);
+
+    // Drops all recorded events. Must not be called while threads are
+    // recording.
+    static void reset();
+
+    // Number of events dropped because a thread's buffer was full.
+    static uint64_t getDroppedEventCount();
+
+    static uint64_t getTick()
+    {
+#if defined(__x86_64__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t tick;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(tick));
+        return tick;
+#else
+        return getFallbackTick();
+#endif
+    }
+
+    // Tick rate measured since profiling was first enabled, 0 before that.
+    static double getTicksPerMicroSec();
+
+    // Number of per-thread event buffers allocated so far. Only grows with the
+    // number of threads recording at the same time.
+    static size_t getThreadBufferCount();
+
+private:
+    static void recordScope(const char *name, uint64_t startTick, uint64_t endTick);
+    static void recordCounter(const char *name, int64_t value, uint64_t tick);
+    static uint64_t getFallbackTick();
+
+    static std::atomic<bool> sEnabled;
+};
+
+} // namespace rec_time
+} // namespace scene_rdl2
+
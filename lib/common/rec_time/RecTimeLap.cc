@@ -100,6 +100,7 @@ RecTimeLap::showLastInfo(const float referenceFps, void (*msgOutFunc)(const std:
             }
         }
     }
+    if (getPerfCounter()) showPerfSections(true, false, ostr);
     ostr << "}\n";
     
     (*msgOutFunc)(ostr.str());    
@@ -159,6 +160,7 @@ RecTimeLap::show(const float referenceFps, void (*msgOutFunc)(const std::string
             }
         }
     }
+    if (getPerfCounter()) showPerfSections(false, false, ostr);
     ostr << "}";
     
     (void)saveFile(ostr.str());
@@ -190,6 +192,65 @@ RecTimeLap::calcNextShowIntervalSec()
     return true;
 }
 
+std::string
+RecTimeLap::showPerfInfo() const
+{
+    std::ostringstream ostr;
+    ostr << "perfInfo " << mName << " (perfCounter:" << ((getPerfCounter()) ? "on" : "off") << ") {\n";
+    showPerfSections(false, true, ostr);
+    ostr << "}";
+    return ostr.str();
+}
+
+void
+RecTimeLap::showPerfSections(const bool last, const bool perThread, std::ostringstream &ostr) const
+{
+    auto showValues = [&](const RecPerfValues &v) {
+        ostr << " cyc:" << _D11 << v.mCycles
+             << " inst:" << _D11 << v.mInstructions
+             << " ipc:" << _F6_2 << v.getIpc()
+             << " llcMiss:" << _D11 << v.mLlcMisses
+             << " brMiss:" << _D11 << v.mBranchMisses << '\n';
+    };
+
+    std::lock_guard<std::mutex> lock(mPerf->mMutex);
+    if (!mPerf->mError.empty()) {
+        ostr << " <perf> not available : " << mPerf->mError << '\n';
+        if (!perThread) return; // still show which threads ran the sections
+    }
+
+    ostr << " <perf> " << ((last) ? "last" : "average")
+         << " (cycles / instructions / IPC / LLC misses / branch misses)\n";
+    for (size_t i = 0; i < mPerf->mSections.size(); ++i) {
+        const rec_time::RecPerfManualInterval &cSection = mPerf->mSections[i];
+        if (cSection.isReset()) {
+            ostr << mSections[i].getName() << '\n';
+        } else {
+            ostr << mSections[i].getName() << ":";
+            showValues((last) ? cSection.getLast() : cSection.getAverage());
+            if (!perThread) continue;
+            for (const RecPerfManualInterval::ThreadValues &cThread : cSection.getThreads()) {
+                ostr << "  thread:" << cThread.mThreadId << " n:" << cThread.mTotal << ":";
+                showValues(cThread.getAverage());
+            }
+        }
+    }
+}
+
+void
+RecTimeLap::perfSectionEnd(const size_t sectionId)
+{
+    RecPerfManualInterval &cSection = mPerf->mSections[sectionId];
+    const RecPerfValues v = cSection.end();
+    const RecPerfCounter &counter = RecPerfCounter::getThreadInstance(); // this section's thread
+
+    std::lock_guard<std::mutex> lock(mPerf->mMutex);
+    if (!counter.isAvailable() && mPerf->mError.empty()) {
+        mPerf->mError = counter.getError();
+    }
+    cSection.add(v, std::this_thread::get_id());
+}
+
 bool
 RecTimeLap::saveFile(const std::string &str) const
 {
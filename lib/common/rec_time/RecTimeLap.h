@@ -7,8 +7,12 @@
 
 #include "RecTick.h"
 #include "RecDouble.h"
+#include "RecPerfCounter.h"
 #include "RecUInt64.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace scene_rdl2 {
@@ -21,7 +25,10 @@ public:
         mFileDumpId(0xffff),
         mMessageIntervalSec(1.0f),
         mNextShowIntervalSec(0.05f),
-        mLastInterval(false) {}
+        mLastInterval(false),
+        mPerf(std::make_unique<PerfState>()) {}
+    RecTimeLap(RecTimeLap &&) = default;
+    RecTimeLap &operator = (RecTimeLap &&) = default;
 
     void setFileDumpId(const int id) { mFileDumpId = id; }
 
@@ -30,6 +37,7 @@ public:
 
     size_t sectionRegistration(std::string &&sectionName) {
         mSections.push_back(rec_time::RecTickManualInterval(std::move(sectionName)));
+        mPerf->mSections.emplace_back();
         return mSections.size() - 1;
     }
     size_t auxSectionRegistration(std::string &&sectionName) {
@@ -43,8 +51,26 @@ public:
 
     void passStartingLine() { mWhole.endAddStart(); }
 
-    void sectionStart(const size_t sectionId) { mSections[sectionId].start(); }
-    void sectionEnd(const size_t sectionId) { mSections[sectionId].endAdd(); }
+    void sectionStart(const size_t sectionId) {
+        if (mPerf->mEnabled.load(std::memory_order_relaxed)) mPerf->mSections[sectionId].start();
+        mSections[sectionId].start();
+    }
+    void sectionEnd(const size_t sectionId) {
+        mSections[sectionId].endAdd();
+        if (mPerf->mSections[sectionId].isStarted()) perfSectionEnd(sectionId);
+    }
+
+    // Optionally also measure hardware counters (cycles, instructions, LLC misses, branch misses) for every
+    // section, reported by the lap info messages and by showPerfInfo(). The counters are those of the thread
+    // which runs the section, so sectionStart() and sectionEnd() have to be called from the same thread.
+    // showPerfInfo() also breaks every section down by the threads which ran it.
+    // If perf events are unavailable this only adds a note to the messages.
+    // setPerfCounter() and showPerfInfo() are MTsafe, so they can be used from a debug console thread
+    // (see grid_util::DebugConsoleDriver::addTimeLap()). The switch takes effect at the next sectionStart().
+    // showPerfInfo() only reads what the sections recorded and never opens counters on the calling thread.
+    void setPerfCounter(const bool flag) { mPerf->mEnabled.store(flag, std::memory_order_relaxed); }
+    bool getPerfCounter() const { return mPerf->mEnabled.load(std::memory_order_relaxed); }
+    std::string showPerfInfo() const; // for debug console
 
     float getLastMsec(const size_t sectionId) { return tick2msec(getLast(sectionId)); }
     bool minBoundCheckMsec(const size_t sectionId, const float minMsec, void (*msgOutFunc)(const std::string &msg)) {
@@ -86,8 +112,10 @@ public:
         intervalReset();
         setInitialNextShowIntervalSec();
         mLastInterval = false;
+        std::lock_guard<std::mutex> lock(mPerf->mMutex);
         for (size_t i = 0; i < mSections.size(); ++i) {
             mSections[i].reset();
+            mPerf->mSections[i].reset();
         }
         for (size_t i = 0; i < mAuxSections.size(); ++i) {
             mAuxSections[i].reset();
@@ -112,6 +140,16 @@ protected:
     std::vector<rec_time::RecDoubleManualInterval> mAuxSections;
     std::vector<rec_time::RecUInt64ManualInterval> mAuxUInt64Sections;
 
+    // Hardware counter state. Held by pointer because the switch and the lock can not be moved, and so that
+    // RecTimeLap stays movable.
+    struct PerfState {
+        std::atomic<bool> mEnabled {false};
+        std::mutex mMutex; // for mSections values and mError, which showPerfInfo() reads from other threads
+        std::vector<rec_time::RecPerfManualInterval> mSections; // same index as RecTimeLap::mSections
+        std::string mError; // why perf events were unavailable on a thread which ran a section
+    };
+    std::unique_ptr<PerfState> mPerf;
+
     //------------------------------
 
     void setInitialNextShowIntervalSec() { mNextShowIntervalSec = mMessageIntervalSec * 0.05f; }
@@ -128,7 +166,10 @@ protected:
         return (float)tick * tickMiSec; // return milli sec
     }
 
+    void perfSectionEnd(const size_t sectionId);
+
     bool saveFile(const std::string &str) const;
+    void showPerfSections(const bool last, const bool perThread, std::ostringstream &ostr) const;
 };
 
 } // namespace rec_time
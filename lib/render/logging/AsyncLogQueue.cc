@@ -0,0 +1,457 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+
+#include "AsyncLogQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+
+#include <unistd.h>
+
+namespace {
+
+// How often the background thread drains the queues when nobody asks it to.
+constexpr auto sDrainInterval = std::chrono::milliseconds(2);
+
+// A streambuf writing into a fixed inline buffer, spilling into a string only
+// once the inline buffer is full. Reused for every message a thread logs.
+class FixedStreamBuf : public std::streambuf
+{
+public:
+    FixedStreamBuf() { reset(); }
+
+    void reset()
+    {
+        setp(mInline, mInline + sizeof(mInline));
+        mSpill.clear();
+        mSpilled = false;
+    }
+
+    bool isSpilled() const { return mSpilled; }
+    const char* data() const { return mInline; }
+    size_t size() const { return static_cast<size_t>(pptr() - pbase()); }
+    std::string& spill() { return mSpill; }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        startSpill();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            mSpill.push_back(traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+        if (!mSpilled && n <= epptr() - pptr()) {
+            std::memcpy(pptr(), s, static_cast<size_t>(n));
+            pbump(static_cast<int>(n));
+        } else {
+            startSpill();
+            mSpill.append(s, static_cast<size_t>(n));
+        }
+        return n;
+    }
+
+private:
+    void startSpill()
+    {
+        if (!mSpilled) {
+            mSpill.assign(pbase(), size());
+            mSpilled = true;
+            // Route everything through overflow()/xsputn() from now on.
+            setp(nullptr, nullptr);
+        }
+    }
+
+    char        mInline[scene_rdl2::logging::AsyncLogQueue::kSlotTextSize];
+    std::string mSpill;
+    bool        mSpilled;
+};
+
+// Set while this thread drains the queue, so that anything logged from within
+// the synchronous Logger functions is output directly.
+thread_local bool tDraining = false;
+
+struct sigaction sPreviousActions[32];
+const int sCrashSignals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+
+void
+crashHandler(int sig)
+{
+    scene_rdl2::logging::AsyncLogQueue::getInstance().dumpPending();
+
+    // Hand over to whoever was there before us (usually the default action).
+    sigaction(sig, &sPreviousActions[sig], nullptr);
+    raise(sig);
+}
+
+void
+stopAtExit()
+{
+    scene_rdl2::logging::Logger::setAsync(false);
+}
+
+} // end anonymous namespace
+
+namespace scene_rdl2 {
+namespace logging {
+
+struct AsyncLogQueue::ThreadState
+{
+    explicit ThreadState(Ring* ring) :
+        mStream(&mBuf),
+        mRing(ring)
+    {
+    }
+
+    ~ThreadState()
+    {
+        mRing->mThreadExited.store(true, std::memory_order_release);
+    }
+
+    FixedStreamBuf mBuf;
+    std::ostream   mStream;
+    Ring*          mRing;
+};
+
+AsyncLogQueue&
+AsyncLogQueue::getInstance()
+{
+    static AsyncLogQueue* sInstance = new AsyncLogQueue;
+    return *sInstance;
+}
+
+AsyncLogQueue::AsyncLogQueue() :
+    mNextSeq(0),
+    mNextOutputSeq(0),
+    mActiveWriters(0),
+    mRunning(false)
+{
+}
+
+// static function
+void
+AsyncLogQueue::installCrashHandlers()
+{
+    static std::once_flag sOnce;
+    std::call_once(sOnce, []() {
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = crashHandler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESETHAND;
+        for (int sig : sCrashSignals) {
+            sigaction(sig, &action, &sPreviousActions[sig]);
+        }
+    });
+}
+
+void
+AsyncLogQueue::setOutput(OutputFunc output)
+{
+    std::lock_guard<std::mutex> drainLock(mDrainMutex);
+    mOutput = std::move(output);
+}
+
+void
+AsyncLogQueue::start()
+{
+    std::lock_guard<std::mutex> lock(mThreadMutex);
+    if (mRunning) {
+        return;
+    }
+
+    static bool sRegistered = false;
+    if (!sRegistered) {
+        std::atexit(stopAtExit);
+        sRegistered = true;
+    }
+
+    mRunning.store(true, std::memory_order_seq_cst);
+    mDrainThread = std::thread(&AsyncLogQueue::drainThreadMain, this);
+}
+
+void
+AsyncLogQueue::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mThreadMutex);
+        if (!mRunning) {
+            return;
+        }
+        mRunning.store(false, std::memory_order_seq_cst);
+    }
+    mWakeUp.notify_one();
+    mDrainThread.join();
+
+    // From now on beginMessage() turns everybody away, but threads which got
+    // in before may still be queueing. Pairs with beginMessage(): either they
+    // see mRunning cleared, or we see them here.
+    while (mActiveWriters.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+
+    // Messages may have been queued after the last drain.
+    flush();
+}
+
+AsyncLogQueue::ThreadState&
+AsyncLogQueue::getThreadState()
+{
+    thread_local std::unique_ptr<ThreadState> tState;
+    if (!tState) {
+        Ring* ring = new Ring;
+        {
+            std::lock_guard<std::mutex> lock(mRingsMutex);
+            mRings.emplace_back(ring);
+        }
+        tState.reset(new ThreadState(ring));
+    }
+    return *tState;
+}
+
+std::ostream*
+AsyncLogQueue::beginMessage()
+{
+    mActiveWriters.fetch_add(1, std::memory_order_seq_cst);
+    if (!mRunning.load(std::memory_order_seq_cst)) {
+        mActiveWriters.fetch_sub(1, std::memory_order_release);
+        return nullptr;
+    }
+
+    ThreadState& state = getThreadState();
+    state.mBuf.reset();
+    state.mStream.clear();
+    return &state.mStream;
+}
+
+void
+AsyncLogQueue::commitMessage(LogLevel level)
+{
+    ThreadState& state = getThreadState();
+    FixedStreamBuf& buf = state.mBuf;
+
+    if (tDraining) {
+        // Logged from inside the drain, don't queue behind ourselves.
+        output(level, buf.isSpilled() ? buf.spill() : std::string(buf.data(), buf.size()));
+        mActiveWriters.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    Ring& ring = *state.mRing;
+    const uint64_t tail = ring.mTail.load(std::memory_order_relaxed);
+    while (tail - ring.mHead.load(std::memory_order_acquire) >= kRingSize) {
+        // Our ring is full, drain it ourselves rather than wait.
+        flush();
+    }
+
+    Slot& slot = ring.mSlots[tail & (kRingSize - 1)];
+    slot.mSeq = mNextSeq.fetch_add(1, std::memory_order_relaxed);
+    slot.mLevel = level;
+    slot.mIsLong = buf.isSpilled();
+    if (slot.mIsLong) {
+        slot.mLongText.swap(buf.spill());
+    } else {
+        slot.mLength = static_cast<uint32_t>(buf.size());
+        std::memcpy(slot.mText, buf.data(), buf.size());
+    }
+    ring.mTail.store(tail + 1, std::memory_order_release);
+    mActiveWriters.fetch_sub(1, std::memory_order_release);
+
+    if (level >= FATAL_LEVEL) {
+        flush();
+    } else if (tail - ring.mHead.load(std::memory_order_relaxed) >= kRingSize / 2) {
+        mWakeUp.notify_one();
+    }
+}
+
+void
+AsyncLogQueue::flush()
+{
+    // Every message numbered below target has been or is about to be
+    // committed. Wait for the ones still in flight on other threads.
+    const uint64_t target = mNextSeq.load(std::memory_order_acquire);
+    while (drain() < target) {
+        std::this_thread::yield();
+    }
+}
+
+uint64_t
+AsyncLogQueue::drain()
+{
+    std::lock_guard<std::mutex> drainLock(mDrainMutex);
+
+    std::vector<Ring*> rings;
+    {
+        std::lock_guard<std::mutex> lock(mRingsMutex);
+        rings.reserve(mRings.size());
+        for (const auto& ring : mRings) {
+            rings.push_back(ring.get());
+        }
+    }
+
+    for (Ring* ring : rings) {
+        const uint64_t head = ring->mHead.load(std::memory_order_relaxed);
+        const uint64_t tail = ring->mTail.load(std::memory_order_acquire);
+        for (uint64_t i = head; i < tail; ++i) {
+            Slot& slot = ring->mSlots[i & (kRingSize - 1)];
+            PendingMessage msg { slot.mSeq, slot.mLevel, std::string() };
+            if (slot.mIsLong) {
+                msg.mText = slot.mLongText;
+            } else {
+                msg.mText.assign(slot.mText, slot.mLength);
+            }
+            mPending.push_back(std::move(msg));
+        }
+        ring->mHead.store(tail, std::memory_order_release);
+    }
+
+    std::sort(mPending.begin(), mPending.end(),
+              [](const PendingMessage& a, const PendingMessage& b) { return a.mSeq < b.mSeq; });
+
+    // Stop at the first gap: the missing message is still being queued and
+    // will be output by a later drain, before everything after it.
+    size_t ready = 0;
+    while (ready < mPending.size() && mPending[ready].mSeq == mNextOutputSeq) {
+        ++ready;
+        ++mNextOutputSeq;
+    }
+
+    tDraining = true;
+    for (size_t i = 0; i < ready; ++i) {
+        output(mPending[i].mLevel, mPending[i].mText);
+    }
+    tDraining = false;
+    mPending.erase(mPending.begin(), mPending.begin() + ready);
+
+    // Release the rings of exited threads. Their last messages have been
+    // drained above, and nobody can add new ones.
+    std::lock_guard<std::mutex> lock(mRingsMutex);
+    mRings.erase(std::remove_if(mRings.begin(), mRings.end(),
+                                [](const std::unique_ptr<Ring>& ring) {
+                                    return ring->mThreadExited.load(std::memory_order_acquire) &&
+                                           ring->mHead.load(std::memory_order_relaxed) ==
+                                           ring->mTail.load(std::memory_order_relaxed);
+                                }),
+                 mRings.end());
+
+    return mNextOutputSeq;
+}
+
+void
+AsyncLogQueue::drainThreadMain()
+{
+    std::unique_lock<std::mutex> lock(mThreadMutex);
+    while (mRunning) {
+        mWakeUp.wait_for(lock, sDrainInterval);
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+void
+AsyncLogQueue::dumpPending() const
+{
+    // No locks here: we may have crashed while holding one. This is best
+    // effort, a ring being drained right now may print some messages twice.
+    for (const PendingMessage& msg : mPending) {
+        ssize_t unused = ::write(STDERR_FILENO, msg.mText.data(), msg.mText.size());
+        unused = ::write(STDERR_FILENO, "\n", 1);
+        (void)unused;
+    }
+    for (const auto& ring : mRings) {
+        const uint64_t head = ring->mHead.load(std::memory_order_relaxed);
+        const uint64_t tail = ring->mTail.load(std::memory_order_acquire);
+        for (uint64_t i = head; i < tail && i < head + kRingSize; ++i) {
+            const Slot& slot = ring->mSlots[i & (kRingSize - 1)];
+            const char* text = slot.mIsLong ? slot.mLongText.data() : slot.mText;
+            const size_t length = slot.mIsLong ? slot.mLongText.size() : slot.mLength;
+            ssize_t unused = ::write(STDERR_FILENO, text, length);
+            unused = ::write(STDERR_FILENO, "\n", 1);
+            (void)unused;
+        }
+    }
+}
+
+void
+AsyncLogQueue::output(LogLevel level, const std::string& text) const
+{
+    if (mOutput) {
+        mOutput(level, text);
+        return;
+    }
+
+    switch (level) {
+    case DEBUG_LEVEL:
+        Logger::logDebug(text);
+        break;
+    case INFO_LEVEL:
+        Logger::logInfo(text);
+        break;
+    case WARN_LEVEL:
+        Logger::logWarn(text);
+        break;
+    case ERROR_LEVEL:
+        Logger::logError(text);
+        break;
+    default:
+        Logger::logFatal(text);
+        break;
+    }
+}
+
+//----------------------------------------------------------------------------
+
+std::atomic<bool> Logger::sAsync(false);
+
+void
+Logger::setAsync(bool async)
+{
+    // One switch at a time. Switching off only returns once everything that
+    // was queued has been output.
+    static std::mutex sSwitchMutex;
+    std::lock_guard<std::mutex> lock(sSwitchMutex);
+
+    AsyncLogQueue& queue = AsyncLogQueue::getInstance();
+    if (async) {
+        init();
+        queue.start();
+        sAsync = true;
+    } else {
+        sAsync = false;
+        queue.stop();
+    }
+}
+
+void
+Logger::flush()
+{
+    AsyncLogQueue::getInstance().flush();
+}
+
+std::ostream*
+Logger::beginAsyncMessage()
+{
+    return AsyncLogQueue::getInstance().beginMessage();
+}
+
+void
+Logger::commitAsyncMessage(LogLevel level)
+{
+    AsyncLogQueue::getInstance().commitMessage(level);
+}
+
+} // end namespace logging
+} // end namespace scene_rdl2
+
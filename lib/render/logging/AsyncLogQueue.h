@@ -0,0 +1,151 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+
+#pragma once
+
+#include "logging.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace logging {
+
+// The backend for Logger's asynchronous mode (see Logger::setAsync()).
+//
+// Every logging thread owns a fixed size ring of message slots which only it
+// writes to, so queueing a message takes no locks. A single background thread
+// periodically drains all of the rings, puts the messages back into the order
+// they were logged in, and passes them to the normal synchronous Logger
+// functions (i.e. to log4cplus). Every message gets a global sequence number
+// when it is queued, and a message is only output once all the messages
+// before it have been, so the order holds across drains too.
+//
+// Messages up to kSlotTextSize bytes are copied into the slot itself. Longer
+// ones are kept in a string owned by the slot, which only allocates the first
+// time a message that long goes through that slot.
+class AsyncLogQueue
+{
+public:
+    static constexpr size_t kRingSize     = 128; // Must be a power of two
+    static constexpr size_t kSlotTextSize = 232;
+
+    // Returns the singleton queue.
+    static AsyncLogQueue& getInstance();
+
+    AsyncLogQueue(const AsyncLogQueue&) = delete;
+    AsyncLogQueue& operator=(const AsyncLogQueue&) = delete;
+
+    // stop() waits for the threads which are queueing a message, then
+    // outputs everything queued.
+    void start();
+    void stop();
+    bool isRunning() const { return mRunning.load(std::memory_order_relaxed); }
+
+    // Returns the calling thread's (reused) formatting stream, or nullptr if
+    // the queue isn't running, in which case the message should be logged
+    // synchronously. Every non null beginMessage() must be followed by a
+    // commitMessage(), which queues whatever was written to the stream.
+    std::ostream* beginMessage();
+    void commitMessage(LogLevel level);
+
+    // Outputs every message queued so far, on the calling thread. Safe to call
+    // from any thread at any time.
+    void flush();
+
+    // Writes whatever is still queued straight to stderr. Only uses async
+    // signal safe calls, for use from a crash handler.
+    void dumpPending() const;
+
+    // Installs SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT handlers which call
+    // dumpPending() and then hand the signal over to the handlers that were
+    // installed before. This is never done implicitly, since the host
+    // application may have crash handlers of its own: call it once after
+    // those are in place.
+    static void installCrashHandlers();
+
+    // Replaces the synchronous Logger functions as the destination of the
+    // queued messages, or restores them when given an empty function. Meant
+    // for tests. Must not be called while the queue is running.
+    using OutputFunc = std::function<void(LogLevel, const std::string&)>;
+    void setOutput(OutputFunc output);
+
+private:
+    struct Slot
+    {
+        uint64_t    mSeq;
+        LogLevel    mLevel;
+        uint32_t    mLength;   // Length of an inline message, unused when mIsLong
+        bool        mIsLong;
+        char        mText[kSlotTextSize];
+        std::string mLongText;
+    };
+
+    struct alignas(64) Ring
+    {
+        Ring() : mHead(0), mTail(0), mThreadExited(false) {}
+
+        std::atomic<uint64_t> mHead;   // Next slot to drain, written by the drainer
+        alignas(64) std::atomic<uint64_t> mTail;   // Next slot to fill, written by the owning thread
+        std::atomic<bool>     mThreadExited;
+        Slot                  mSlots[kRingSize];
+    };
+
+    struct ThreadState;
+
+    struct PendingMessage
+    {
+        uint64_t    mSeq;
+        LogLevel    mLevel;
+        std::string mText;
+    };
+
+    // The singleton is never destroyed, so that threads which log during
+    // process exit never find it gone.
+    AsyncLogQueue();
+
+    ThreadState& getThreadState();
+
+    // Outputs every message which has no gap left before it and returns the
+    // sequence number of the next message to output.
+    uint64_t drain();
+    void drainThreadMain();
+    void output(LogLevel level, const std::string& text) const;
+
+    std::atomic<uint64_t> mNextSeq;
+
+    // All rings ever handed out. Rings of threads which have exited are
+    // released once they have been drained.
+    std::mutex                         mRingsMutex;
+    std::vector<std::unique_ptr<Ring>> mRings;
+
+    // Only one thread drains at a time. Messages which were drained but have
+    // a gap before them (a message still being queued by another thread) are
+    // kept in mPending until the gap is filled.
+    std::mutex                  mDrainMutex;
+    std::vector<PendingMessage> mPending;
+    uint64_t                    mNextOutputSeq;
+    OutputFunc                  mOutput;
+
+    // Threads between a successful beginMessage() and its commitMessage().
+    std::atomic<int>        mActiveWriters;
+
+    std::mutex              mThreadMutex;
+    std::condition_variable mWakeUp;
+    std::thread             mDrainThread;
+    std::atomic<bool>       mRunning;
+};
+
+} // end namespace logging
+} // end namespace scene_rdl2
+
@@ -282,6 +282,15 @@ Logger::logInfo(const std::string& s) {
     }
 }
 
+bool
+Logger::isEnabled(LogLevel level)
+{
+    // Same logger as outputLog(). Its level is looked up on every call, so
+    // level changes are picked up.
+    static const log4cplus::Logger sLogger = getDefaultLogger(__FILE__);
+    return sLogger.isEnabledFor(level);
+}
+
 bool
 Logger::isDebugEnabled(const std::string& s)
 {
@@ -12,12 +12,15 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <log4cplus/loglevel.h>
 
@@ -66,11 +69,29 @@ const LogLevel OUTPUT_LEVEL  = (WARN_LEVEL + ERROR_LEVEL) / 2;
 const LogLevel NORMAL_LEVEL  = OUTPUT_LEVEL;
 const LogLevel VERBOSE_LEVEL = INFO_LEVEL;
 
+// Logging below this level is compiled out entirely, e.g. building with
+// -DSCENE_RDL2_LOG_MIN_LEVEL=20000 (log4cplus' INFO level) removes every
+// Logger::debug() call, including the formatting of its arguments.
+#ifndef SCENE_RDL2_LOG_MIN_LEVEL
+#define SCENE_RDL2_LOG_MIN_LEVEL 0
+#endif
+
 // Central place for logging support.
 //
 // Sample usage:
 //
 // Logger::error("File could not be found", filename);
+//
+// By default messages are formatted and written out on the calling thread.
+// Calling Logger::setAsync(true) switches to asynchronous logging: messages
+// are formatted into preallocated per-thread buffers, without touching the
+// heap unless they are very long, and a background thread hands them to
+// log4cplus. Fatal messages are always flushed before the call returns.
+// AsyncLogQueue::installCrashHandlers() makes a crash write the pending
+// messages to stderr.
+//
+// In both modes a message below the logger's level is dropped before its
+// arguments are formatted.
 class Logger
 {
 public:
@@ -85,31 +106,31 @@ public:
     template <typename... T>
     static void debug(const T&... value)
     {
-        logDebug(logging_util::buildString(value...));
+        output<DEBUG_LEVEL>(logDebug, value...);
     }
 
     template <typename... T>
     static void info(const T&... value)
     {
-        logInfo(logging_util::buildString(value...));
+        output<INFO_LEVEL>(logInfo, value...);
     }
 
     template <typename... T>
     static void warn(const T&... value)
     {
-        logWarn(logging_util::buildString(value...));
+        output<WARN_LEVEL>(logWarn, value...);
     }
 
     template <typename... T>
     static void error(const T&... value)
     {
-        logError(logging_util::buildString(value...));
+        output<ERROR_LEVEL>(logError, value...);
     }
 
     template <typename... T>
     static void fatal(const T&... value)
     {
-        logFatal(logging_util::buildString(value...));
+        output<FATAL_LEVEL>(logFatal, value...);
     }
 
     // Calls one of the other log functions, depending on the level.
@@ -143,12 +164,63 @@ public:
     static void setDebugLevel();
     static void setInfoLevel();
 
+    // Switches asynchronous logging on or off. Switching it off waits for the
+    // threads which are queueing a message, flushes all pending messages and
+    // stops the background thread.
+    static void setAsync(bool async);
+    static bool getAsync() { return sAsync.load(std::memory_order_relaxed); }
+
+    // Blocks until every message logged so far has been output. Does nothing
+    // in synchronous mode.
+    static void flush();
+
+    static constexpr bool isCompiledIn(LogLevel level)
+    {
+        return level >= SCENE_RDL2_LOG_MIN_LEVEL;
+    }
+
 private:
+    friend class AsyncLogQueue;
+
+    template <LogLevel level, typename... T>
+    static void output(void (*logSync)(const std::string&), const T&... value)
+    {
+        if constexpr (isCompiledIn(level)) {
+            if (!isEnabled(level)) {
+                return;
+            }
+            if (getAsync()) {
+                if (std::ostream* o = beginAsyncMessage()) {
+                    try {
+                        logging_util::combineString(*o, value...);
+                    } catch (...) {
+                        commitAsyncMessage(level);
+                        throw;
+                    }
+                    commitAsyncMessage(level);
+                    return;
+                }
+                // Switched back to synchronous logging meanwhile.
+            }
+            logSync(logging_util::buildString(value...));
+        }
+    }
+
+    // Whether the default logger outputs messages of this level.
+    static bool isEnabled(LogLevel level);
+
+    // Returns the calling thread's (reused) formatting stream, or nullptr if
+    // the queue has stopped, and queues whatever was written to it.
+    static std::ostream* beginAsyncMessage();
+    static void commitAsyncMessage(LogLevel level);
+
     static void logDebug(const std::string& s);
     static void logInfo(const std::string& s);
     static void logWarn(const std::string& s);
     static void logError(const std::string& s);
     static void logFatal(const std::string& s);
+
+    static std::atomic<bool> sAsync;
 };
 
 // Describes a single logging "event" to be saved in the ObjectLogs class.
@@ -178,66 +250,148 @@ using LogEvent = int;
 
 #define DEBUG_LOG_EVENT_REGISTRY 0
 
-// I apologize for the complexity of this class. If I knew how to simplify it, I would.
-// We share the EventCounters across threads, but we want to know the origin of the events. So, we have a map from a
-// pointer address (an object of type T: e.g., a Shader) that maps to another map of LogEvent to count.
+// We share the EventCounters across threads, but we want to know the origin of the events, so counts are kept per
+// (object pointer, LogEvent) pair, where the object is of type T: e.g., a Shader.
+//
+// record() is on the shading hot path: a shader which warns once per sample calls it from every render thread at
+// once. So instead of a mutex around nested maps, the counts live in a concurrent open addressing hash table whose
+// slots are claimed with a single compare-and-swap of a packed 64-bit key and incremented with a relaxed atomic add.
+// Neither step ever waits on another thread. Slots are never removed (other than by clear()), so once a key has been
+// placed it stays in the same slot, which is what makes the lock free lookup safe.
+//
+// When a key's probe sequence is full the table overflows into a second, twice as large table, and so on. Tables are
+// only ever appended, never freed or moved, until clear() or the EventCounters is destroyed. A given key can only ever live in
+// one table: everyone who gets to look for it finds the same earlier probe sequences full.
 //
-// mMap: Object pointer to EventCountMap
-// EventCountMap: LogEvent to count
+// Keys which can't be packed (pointers above 48 bits or very large LogEvent values, neither of which happen on the
+// platforms we build for) fall back to a mutex protected map.
 template <typename T>
 class EventCounters
 {
     using MutexType = std::mutex;
 
-    using EventCountMap = std::unordered_map<LogEvent, unsigned>;
-
     using KeyType = const T*;
-    using MapType = std::unordered_map<KeyType, EventCountMap>;
+    using PackedKey = uint64_t;
+
+    static constexpr PackedKey kEmptyKey    = ~PackedKey(0);
+    static constexpr unsigned  kPointerBits = 48;
+    static constexpr unsigned  kEventBits   = 64 - kPointerBits;
+    static constexpr unsigned  kMaxProbes   = 16;
+    static constexpr size_t    kInitialSize = 256; // Must be a power of two
+
+    struct Slot
+    {
+        std::atomic<PackedKey> mKey;
+        std::atomic<unsigned>  mCount;
+    };
+
+    struct Table
+    {
+        explicit Table(size_t size) :
+            mSlots(new Slot[size]),
+            mMask(size - 1),
+            mNext(nullptr)
+        {
+            for (size_t i = 0; i < size; ++i) {
+                mSlots[i].mKey.store(kEmptyKey, std::memory_order_relaxed);
+                mSlots[i].mCount.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        std::unique_ptr<Slot[]> mSlots;
+        const size_t            mMask;
+        std::atomic<Table*>     mNext;
+    };
+
+    using OverflowMap = std::map<std::pair<KeyType, LogEvent>, unsigned>;
 
 public:
+    EventCounters() :
+        mTable(kInitialSize)
+    {
+    }
+
+    ~EventCounters()
+    {
+        freeOverflowTables();
+    }
+
+    EventCounters(const EventCounters&) = delete;
+    EventCounters& operator=(const EventCounters&) = delete;
+
+    // Forgets every recorded key: the initial table is emptied and the overflow tables and map are freed, so objects
+    // which are gone (e.g. after a scene reload) no longer take up slots. Must not be called concurrently with any
+    // other member function, like at a frame or scene boundary.
     void clear()
     {
-        std::lock_guard<MutexType> lock(mMutex);
-        mMap.clear();
+        freeOverflowTables();
+        for (size_t i = 0; i <= mTable.mMask; ++i) {
+            mTable.mSlots[i].mKey.store(kEmptyKey, std::memory_order_relaxed);
+            mTable.mSlots[i].mCount.store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<MutexType> lock(mOverflowMutex);
+        mOverflow.clear();
     }
 
-    void record(const T* const p, LogEvent event)
+    // Resets every count to zero but keeps the keys and tables, since the same events tend to be logged again on the
+    // next frame. Safe to call concurrently with record(), but events recorded during the reset may or may not be
+    // counted.
+    void resetCounts()
     {
-        std::lock_guard<MutexType> lock(mMutex);
+        for (Table* t = &mTable; t; t = t->mNext.load(std::memory_order_acquire)) {
+            for (size_t i = 0; i <= t->mMask; ++i) {
+                t->mSlots[i].mCount.store(0, std::memory_order_relaxed);
+            }
+        }
+        std::lock_guard<MutexType> lock(mOverflowMutex);
+        for (auto& entry : mOverflow) {
+            entry.second = 0;
+        }
+    }
 
-        // Constant time (O(1)) lookup in unordered_map
-        auto baseIt = mMap.find(p);
+    // Number of slots over all tables, for diagnostics.
+    size_t getCapacity() const
+    {
+        size_t capacity = 0;
+        for (const Table* t = &mTable; t; t = t->mNext.load(std::memory_order_acquire)) {
+            capacity += t->mMask + 1;
+        }
+        return capacity;
+    }
 
-        if (baseIt == mMap.cend()) {
-            // Pointer not found: insert it
-            const auto insertionResult = mMap.emplace(p, EventCountMap{});
-            MNRY_LOGGING_LIBRARY_ASSERT(insertionResult.second);
-            baseIt = insertionResult.first;
+    void record(const T* const p, LogEvent event)
+    {
+        PackedKey key;
+        if (!packKey(p, event, key)) {
+            std::lock_guard<MutexType> lock(mOverflowMutex);
+            ++mOverflow[std::make_pair(p, event)];
+            return;
         }
 
-        EventCountMap& eventMap = baseIt->second;
-        ++eventMap[event];
+        for (Table* t = &mTable; ; t = getOrAddNextTable(t)) {
+            if (Slot* slot = findSlot(*t, key, true)) {
+                slot->mCount.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
     }
 
     unsigned getCount(const T* const p, LogEvent event) const
     {
-        std::lock_guard<MutexType> lock(mMutex);
-
-        // Constant time (O(1)) lookup in unordered_map
-        const auto baseIt = mMap.find(p);
+        PackedKey key;
+        if (!packKey(p, event, key)) {
+            std::lock_guard<MutexType> lock(mOverflowMutex);
+            const auto it = mOverflow.find(std::make_pair(p, event));
+            return (it == mOverflow.cend()) ? 0 : it->second;
+        }
 
-        if (baseIt == mMap.cend()) {
-            // We didn't find any records for this pointer, so the count is zero.
-            return 0;
-        } else {
-            const EventCountMap& eventMap = baseIt->second;
-            const auto           it       = eventMap.find(event);
-            if (it == eventMap.cend()) {
-                return 0;
-            } else {
-                return it->second;
+        for (const Table* t = &mTable; t; t = t->mNext.load(std::memory_order_acquire)) {
+            if (const Slot* slot = findSlot(*t, key, false)) {
+                return slot->mCount.load(std::memory_order_relaxed);
             }
         }
+        // We didn't find any records for this pointer and event, so the count is zero.
+        return 0;
     }
 
     // Skips zero-records
@@ -245,19 +399,111 @@ public:
     template <typename F>
     void forEachRecord(F&& f) const
     {
-        std::lock_guard<MutexType> lock(mMutex);
+        for (const Table* t = &mTable; t; t = t->mNext.load(std::memory_order_acquire)) {
+            for (size_t i = 0; i <= t->mMask; ++i) {
+                const Slot&     slot  = t->mSlots[i];
+                const PackedKey key   = slot.mKey.load(std::memory_order_acquire);
+                const unsigned  count = slot.mCount.load(std::memory_order_relaxed);
+                if (key != kEmptyKey && count > 0) {
+                    f(unpackPointer(key), unpackEvent(key), count);
+                }
+            }
+        }
 
-        for (const auto& key : mMap) {
-            const EventCountMap& eventMap = key.second;
-            for (const auto& eventCount : eventMap) {
-                f(key.first, eventCount.first, eventCount.second);
+        std::lock_guard<MutexType> lock(mOverflowMutex);
+        for (const auto& entry : mOverflow) {
+            if (entry.second > 0) {
+                f(entry.first.first, entry.first.second, entry.second);
             }
         }
     }
 
 private:
-    mutable MutexType mMutex;
-    MapType           mMap;
+    static bool packKey(const T* const p, LogEvent event, PackedKey& key)
+    {
+        const auto bits = reinterpret_cast<uintptr_t>(p);
+        if ((bits >> kPointerBits) != 0 || event < 0 || (static_cast<uint64_t>(event) >> kEventBits) != 0) {
+            return false;
+        }
+        key = (static_cast<PackedKey>(event) << kPointerBits) | bits;
+        // An all ones key would need an all ones pointer.
+        return key != kEmptyKey;
+    }
+
+    static const T* unpackPointer(PackedKey key)
+    {
+        return reinterpret_cast<const T*>(static_cast<uintptr_t>(key & ((PackedKey(1) << kPointerBits) - 1)));
+    }
+
+    static LogEvent unpackEvent(PackedKey key)
+    {
+        return static_cast<LogEvent>(key >> kPointerBits);
+    }
+
+    static size_t hashKey(PackedKey key)
+    {
+        // Pointers have their low bits in common, so mix before masking.
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+
+    // Returns the slot holding key, claiming an empty one for it if insert is set, or nullptr if the key isn't in
+    // this table (and, when inserting, there was no room left in its probe sequence).
+    static Slot* findSlot(const Table& t, PackedKey key, bool insert)
+    {
+        size_t pos = hashKey(key);
+        for (unsigned probe = 0; probe < kMaxProbes; ++probe, ++pos) {
+            Slot&     slot    = t.mSlots[pos & t.mMask];
+            PackedKey current = slot.mKey.load(std::memory_order_acquire);
+            if (current == key) {
+                return &slot;
+            }
+            if (current == kEmptyKey) {
+                if (!insert) {
+                    return nullptr;
+                }
+                if (slot.mKey.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                    return &slot;
+                }
+                // Somebody else claimed it first, possibly for the same key.
+                if (current == key) {
+                    return &slot;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    void freeOverflowTables()
+    {
+        Table* t = mTable.mNext.exchange(nullptr, std::memory_order_relaxed);
+        while (t) {
+            Table* const next = t->mNext.load(std::memory_order_relaxed);
+            delete t;
+            t = next;
+        }
+    }
+
+    Table* getOrAddNextTable(Table* t)
+    {
+        Table* next = t->mNext.load(std::memory_order_acquire);
+        if (next) {
+            return next;
+        }
+        Table* const newTable = new Table((t->mMask + 1) * 2);
+        if (t->mNext.compare_exchange_strong(next, newTable, std::memory_order_acq_rel)) {
+            return newTable;
+        }
+        // Lost the race, use the winner's table.
+        delete newTable;
+        return next;
+    }
+
+    Table             mTable;
+    mutable MutexType mOverflowMutex;
+    OverflowMap       mOverflow;
 };
 
 // Maintains a registry of the types of events that could be logged by an object.
@@ -348,12 +594,19 @@ public:
         mEventCounters.clear();
     }
 
+    // Forgets all recorded events. Must not be called while other threads log.
     void clearCounters()
     {
-        // EventCounters is already thread-safe.
         mEventCounters.clear();
     }
 
+    // Zeroes the counts but keeps the recorded keys. Safe to call while other threads log.
+    void resetCounters()
+    {
+        // EventCounters is already thread-safe.
+        mEventCounters.resetCounts();
+    }
+
     // Records an event.
     void log(const T* p, LogEvent event)
     {
@@ -424,8 +677,9 @@ private:
     StringToEventContainer mStringToEvent;
     EventToNodeContainer   mEventToNode;
 
-    // The event counter has its own mutex and locks, which may lead to concern about deadlocks if the locks are not
-    // taken in a consistent order. This is not a problem, because the locks within EventCounters are self-contained.
+    // The event counter is lock free, apart from the mutex around its (normally unused) overflow map, which may lead to
+    // concern about deadlocks if the locks are not taken in a consistent order. This is not a problem, because the
+    // locks within EventCounters are self-contained.
     // There are only two possible scenarios:
     // 1. LogEventRegistry does not take its lock and calls into the EventCounters, which is not an issue because we
     //    assume EventCounters is doing the proper work.
@@ -7,6 +7,10 @@
 //
 #include "Arena.h"
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 // Functions exposed to ISPC:
 extern "C"
 {
@@ -31,6 +35,63 @@ bool CPP_Arena_isValidPtr(const scene_rdl2::alloc::Arena *arena, const void *ptr
 namespace scene_rdl2 {
 namespace alloc {
 
+uint8_t *
+allocHugePageMemory(size_t size)
+{
+#ifdef __linux__
+    if (size < ARENA_HUGE_PAGE_SIZE || (size % ARENA_HUGE_PAGE_SIZE) != 0) {
+        return nullptr;
+    }
+
+    // Explicit huge pages first. These only succeed if the admin has reserved
+    // pages via /proc/sys/vm/nr_hugepages.
+    void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mem != MAP_FAILED) {
+        return static_cast<uint8_t *>(mem);
+    }
+
+    // Fall back to transparent huge pages. The kernel will only back a range
+    // with huge pages if it is 2MB aligned, so over-allocate and trim.
+    const size_t mapSize = size + ARENA_HUGE_PAGE_SIZE;
+    mem = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        return nullptr;
+    }
+
+    uint8_t *start = static_cast<uint8_t *>(mem);
+    uint8_t *aligned = reinterpret_cast<uint8_t *>(util::alignUp(reinterpret_cast<size_t>(start),
+                                                                 size_t(ARENA_HUGE_PAGE_SIZE)));
+    const size_t head = aligned - start;
+    const size_t tail = mapSize - head - size;
+    if (head) {
+        munmap(start, head);
+    }
+    if (tail) {
+        munmap(aligned + size, tail);
+    }
+
+#ifdef MADV_HUGEPAGE
+    // Advisory only; if THP is disabled we still have a valid aligned block.
+    madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+
+    return aligned;
+#else
+    return nullptr;
+#endif
+}
+
+void
+freeHugePageMemory(uint8_t *memory, size_t size)
+{
+#ifdef __linux__
+    if (memory) {
+        munmap(memory, size);
+    }
+#endif
+}
+
 } // namespace alloc
 } // namespace scene_rdl2
 
@@ -0,0 +1,376 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// Include this before any other includes!
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include "AlignedAllocator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+//
+// Atomic accumulation of small float vectors (RenderColor, Vec2f, Vec3f, ...)
+// into shared memory.
+//
+// std::atomic<float> (see AtomicFloat.h) needs one compare-and-swap per
+// channel, and a reader may observe a half updated color. Here the whole
+// value is updated with a single CAS instead:
+//
+//   2 floats (8 bytes, 8 byte aligned)   : 64-bit CAS
+//   4 floats (16 bytes, 16 byte aligned) : 128-bit CAS (cmpxchg16b) on x86-64
+//   anything else, or no 128-bit CAS     : striped spin lock keyed by address
+//
+// Usage:
+//
+//     util::atomicAdd(&mColors[index], sampleColor);
+//
+// The value type must be trivially copyable, hold only floats and provide
+// operator+. Note that math::Vec4f is only 4 byte aligned, so a misaligned
+// address silently takes the locked path; AtomicTileAccumBuffer guarantees
+// the alignment for its pixels.
+//
+
+namespace scene_rdl2 {
+namespace util {
+
+namespace atomic_accumulate_detail {
+
+// Spin locks used by the fallback path. Addresses hash onto a fixed set of
+// cache line sized locks so that unrelated pixels rarely contend.
+constexpr unsigned kNumLockStripes = 1024;
+
+struct CACHE_ALIGN LockStripe
+{
+    std::atomic<bool> mLocked { false };
+    char mPad[CACHE_LINE_SIZE - sizeof(std::atomic<bool>)];
+};
+
+inline LockStripe *
+getLockStripes()
+{
+    static LockStripe sStripes[kNumLockStripes];
+    return sStripes;
+}
+
+inline LockStripe &
+getLockStripe(const void *addr)
+{
+    // Drop the low bits which are the same for every element of an array.
+    const uintptr_t a = reinterpret_cast<uintptr_t>(addr) >> 4;
+    return getLockStripes()[(a ^ (a >> 10)) & (kNumLockStripes - 1)];
+}
+
+finline void
+cpuRelax()
+{
+#if defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+class StripeLockGuard
+{
+public:
+    explicit StripeLockGuard(const void *addr) :
+        mStripe(getLockStripe(addr))
+    {
+        while (mStripe.mLocked.exchange(true, std::memory_order_acquire)) {
+            while (mStripe.mLocked.load(std::memory_order_relaxed)) {
+                cpuRelax();
+            }
+        }
+    }
+
+    ~StripeLockGuard()
+    {
+        mStripe.mLocked.store(false, std::memory_order_release);
+    }
+
+private:
+    LockStripe &mStripe;
+
+    DISALLOW_COPY_OR_ASSIGNMENT(StripeLockGuard);
+};
+
+#if defined(__x86_64__)
+#define SCENE_RDL2_HAS_CAS128 1
+
+// Returns true if *ptr matched expected and was replaced with desired.
+// Otherwise expected is updated with the current contents of *ptr.
+finline bool
+cas128(void *ptr, uint64_t expected[2], const uint64_t desired[2])
+{
+    bool ok;
+    __asm__ __volatile__("lock cmpxchg16b %1\n\t"
+                         "setz %0"
+                         : "=q"(ok), "+m"(*static_cast<volatile unsigned __int128 *>(ptr)),
+                           "+a"(expected[0]), "+d"(expected[1])
+                         : "b"(desired[0]), "c"(desired[1])
+                         : "cc", "memory");
+    return ok;
+}
+
+// Reads 16 bytes at a 16 byte aligned address without tearing.
+finline void
+load128(const void *ptr, uint64_t bits[2])
+{
+#if defined(__AVX__)
+    // Processors which support AVX guarantee that 16 byte aligned vector loads
+    // are atomic (Intel SDM "Guaranteed Atomic Operations", AMD APM vol 2).
+    __m128i v;
+    __asm__ __volatile__("vmovdqa %1, %0"
+                         : "=x"(v)
+                         : "m"(*static_cast<const volatile __m128i *>(ptr))
+                         : "memory");
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(bits), v);
+#else
+    // Without AVX there is no architecturally atomic 16 byte load, so compare
+    // and swap the value with itself: the CAS either writes zero back over
+    // zero or fails, and in both cases hands back the current contents. This
+    // needs the memory to be writable even though it is logically only read.
+    bits[0] = bits[1] = 0;
+    const uint64_t desired[2] = { 0, 0 };
+    cas128(const_cast<void *>(ptr), bits, desired);
+#endif
+}
+#else
+#define SCENE_RDL2_HAS_CAS128 0
+#endif
+
+template <typename T>
+finline T
+fromBits(const void *bits)
+{
+    T t;
+    std::memcpy(&t, bits, sizeof(T));
+    return t;
+}
+
+template <typename T>
+finline void
+atomicAdd64(T *dst, const T &v)
+{
+    static_assert(sizeof(T) == sizeof(uint64_t), "Expected an 8 byte value");
+
+    uint64_t *bits = reinterpret_cast<uint64_t *>(dst);
+    uint64_t expected = __atomic_load_n(bits, __ATOMIC_RELAXED);
+    uint64_t desired;
+    do {
+        const T sum = fromBits<T>(&expected) + v;
+        std::memcpy(&desired, &sum, sizeof(T));
+    } while (!__atomic_compare_exchange_n(bits, &expected, desired, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+#if SCENE_RDL2_HAS_CAS128
+template <typename T>
+finline void
+atomicAdd128(T *dst, const T &v)
+{
+    static_assert(sizeof(T) == 2 * sizeof(uint64_t), "Expected a 16 byte value");
+
+    // A torn initial read is fine, the CAS simply fails and hands us back the
+    // real current value.
+    uint64_t expected[2];
+    std::memcpy(expected, dst, sizeof(expected));
+    uint64_t desired[2];
+    do {
+        const T sum = fromBits<T>(expected) + v;
+        std::memcpy(desired, &sum, sizeof(T));
+    } while (!cas128(dst, expected, desired));
+}
+#endif
+
+template <typename T>
+finline void
+lockedAdd(T *dst, const T &v)
+{
+    StripeLockGuard guard(dst);
+    *dst = *dst + v;
+}
+
+template <typename T>
+finline bool
+isAligned(const T *p)
+{
+    return (reinterpret_cast<uintptr_t>(p) & (sizeof(T) - 1)) == 0;
+}
+
+} // namespace atomic_accumulate_detail
+
+// True if atomicAdd on (naturally aligned) values of type T will use a single
+// CAS rather than the striped lock fallback.
+template <typename T>
+constexpr bool
+isAtomicAddLockFree()
+{
+    return sizeof(T) == 8 || (sizeof(T) == 16 && SCENE_RDL2_HAS_CAS128);
+}
+
+// Atomically performs *dst = *dst + v for a small vector of floats.
+template <typename T>
+finline void
+atomicAdd(T *dst, const T &v)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "atomicAdd requires a trivially copyable type");
+    namespace detail = atomic_accumulate_detail;
+
+    if constexpr (sizeof(T) == 8) {
+        if (detail::isAligned(dst)) {
+            detail::atomicAdd64(dst, v);
+            return;
+        }
+#if SCENE_RDL2_HAS_CAS128
+    } else if constexpr (sizeof(T) == 16) {
+        if (detail::isAligned(dst)) {
+            detail::atomicAdd128(dst, v);
+            return;
+        }
+#endif
+    }
+    detail::lockedAdd(dst, v);
+}
+
+// Same as atomicAdd, but always uses the striped lock. Exposed mainly for
+// benchmarking against the lock free paths.
+template <typename T>
+finline void
+atomicAddLocked(T *dst, const T &v)
+{
+    atomic_accumulate_detail::lockedAdd(dst, v);
+}
+
+// Reads a value which may be concurrently updated by atomicAdd, without
+// tearing. For the lock free sizes this is a single atomic load, see load128().
+template <typename T>
+finline T
+atomicLoad(const T *src)
+{
+    namespace detail = atomic_accumulate_detail;
+
+    if constexpr (sizeof(T) == 8) {
+        if (detail::isAligned(src)) {
+            const uint64_t bits = __atomic_load_n(reinterpret_cast<const uint64_t *>(src), __ATOMIC_RELAXED);
+            return detail::fromBits<T>(&bits);
+        }
+#if SCENE_RDL2_HAS_CAS128
+    } else if constexpr (sizeof(T) == 16) {
+        if (detail::isAligned(src)) {
+            uint64_t bits[2];
+            detail::load128(src, bits);
+            return detail::fromBits<T>(bits);
+        }
+#endif
+    }
+    detail::StripeLockGuard guard(src);
+    return *src;
+}
+
+///
+/// @class AtomicTileAccumBuffer AtomicAccumulate.h <scene_rdl2/render/util/AtomicAccumulate.h>
+/// @brief A width x height buffer of T which many threads can accumulate into
+/// concurrently with atomicAdd.
+///
+/// Pixels are stored tile by tile (8x8 tiles) rather than in scanlines, so
+/// threads working on different tiles never share a cache line, and threads
+/// splatting into the same tile touch a compact block of memory. The buffer is
+/// cache line aligned and a tile is 64 values, so every tile starts on its own
+/// cache line whatever the size of T.
+///
+template <typename T>
+class AtomicTileAccumBuffer
+{
+public:
+    static constexpr unsigned kTileSize = 8;
+    static constexpr unsigned kTilePixels = kTileSize * kTileSize;
+    static constexpr std::size_t kAlignment = CACHE_LINE_SIZE;
+    static_assert((kTilePixels * sizeof(T)) % CACHE_LINE_SIZE == 0,
+                  "Tiles must not share cache lines");
+
+    AtomicTileAccumBuffer() :
+        mWidth(0),
+        mHeight(0),
+        mNumTilesX(0)
+    {
+    }
+
+    AtomicTileAccumBuffer(unsigned width, unsigned height)
+    {
+        init(width, height);
+    }
+
+    void init(unsigned width, unsigned height)
+    {
+        mWidth = width;
+        mHeight = height;
+        mNumTilesX = (width + kTileSize - 1) / kTileSize;
+        const unsigned numTilesY = (height + kTileSize - 1) / kTileSize;
+        mPixels.assign(std::size_t(mNumTilesX) * numTilesY * kTilePixels, T());
+        clear();
+    }
+
+    unsigned getWidth() const { return mWidth; }
+    unsigned getHeight() const { return mHeight; }
+    unsigned getNumTiles() const { return unsigned(mPixels.size() / kTilePixels); }
+
+    // Not thread safe with respect to concurrent adds.
+    void clear()
+    {
+        std::memset(static_cast<void *>(mPixels.data()), 0, mPixels.size() * sizeof(T));
+    }
+
+    // Thread safe.
+    finline void add(unsigned x, unsigned y, const T &v)
+    {
+        atomicAdd(&mPixels[getPixelOffset(x, y)], v);
+    }
+
+    // Thread safe, never returns a partially updated value.
+    finline T get(unsigned x, unsigned y) const
+    {
+        return atomicLoad(&mPixels[getPixelOffset(x, y)]);
+    }
+
+    // Direct access to the kTilePixels pixels of a tile, row major within the
+    // tile. Only valid once all adds into the tile have completed.
+    const T *getTile(unsigned tileId) const { return &mPixels[std::size_t(tileId) * kTilePixels]; }
+
+    // Copies the buffer out in scanline order (width * height entries).
+    void untile(T *dst) const
+    {
+        for (unsigned y = 0; y < mHeight; ++y) {
+            for (unsigned x = 0; x < mWidth; ++x) {
+                dst[std::size_t(y) * mWidth + x] = mPixels[getPixelOffset(x, y)];
+            }
+        }
+    }
+
+private:
+    finline std::size_t getPixelOffset(unsigned x, unsigned y) const
+    {
+        MNRY_ASSERT(x < mWidth && y < mHeight);
+        const std::size_t tileId = std::size_t(y / kTileSize) * mNumTilesX + x / kTileSize;
+        return tileId * kTilePixels + (y % kTileSize) * kTileSize + (x % kTileSize);
+    }
+
+    unsigned mWidth;
+    unsigned mHeight;
+    unsigned mNumTilesX;
+    std::vector<T, alloc::AlignedAllocator<T, kAlignment>> mPixels;
+};
+
+} // namespace util
+} // namespace scene_rdl2
+
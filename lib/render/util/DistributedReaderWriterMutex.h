@@ -0,0 +1,179 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace scene_rdl2 {
+namespace util {
+
+///
+/// @class DistributedReaderWriterMutex DistributedReaderWriterMutex.h <scene_rdl2/render/util/DistributedReaderWriterMutex.h>
+/// @brief A reader-biased reader/writer lock for read-mostly data shared by
+/// all render threads.
+///
+/// std::shared_mutex keeps a single reader count, so every lock_shared() from
+/// every thread bounces the same cache line and stops scaling somewhere past
+/// 32 threads. Here each thread is assigned one of kNumSlots cache line sized
+/// reader counters (based on the CPU it first ran on), so readers only ever
+/// write their own line. The price is paid by writers, which have to scan all
+/// of the slots, and by memory: each mutex is kNumSlots cache lines.
+///
+/// Writers take priority: once a writer is waiting new readers back off, so
+/// writers can't be starved by a continuous stream of readers.
+///
+/// Meets the standard SharedMutex requirements, so it works with the usual
+/// std::shared_lock / std::unique_lock wrappers. The ReadLock and WriteLock
+/// aliases of ReaderWriterMutex.h are provided as members, so switching a
+/// structure over is DistributedReaderWriterMutex::ReadLock instead of
+/// ReadLock.
+///
+/// Read locks may be taken recursively by the same thread, provided no writer
+/// can arrive in between. Write locks are not recursive.
+///
+class DistributedReaderWriterMutex
+{
+public:
+    static constexpr unsigned kNumSlots = 64;
+
+    using ReadLock  = std::shared_lock<DistributedReaderWriterMutex>;
+    using WriteLock = std::unique_lock<DistributedReaderWriterMutex>;
+
+    DistributedReaderWriterMutex() :
+        mWriter(false)
+    {
+        for (auto &slot : mSlots) {
+            slot.mReaders.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    DistributedReaderWriterMutex(const DistributedReaderWriterMutex&) = delete;
+    DistributedReaderWriterMutex& operator=(const DistributedReaderWriterMutex&) = delete;
+
+    void lock_shared()
+    {
+        std::atomic<int32_t> &readers = mSlots[getThreadSlot()].mReaders;
+        while (true) {
+            // Publish ourselves first, then check for a writer. The writer does
+            // the opposite, so at least one of us sees the other. This is the
+            // store-buffer pattern: both the stores and the loads on either side
+            // have to be seq_cst, acquire loads are not enough on ARM.
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if (!mWriter.load(std::memory_order_seq_cst)) {
+                return;
+            }
+            readers.fetch_sub(1, std::memory_order_release);
+            waitWhile([this]() { return mWriter.load(std::memory_order_relaxed); });
+        }
+    }
+
+    bool try_lock_shared()
+    {
+        std::atomic<int32_t> &readers = mSlots[getThreadSlot()].mReaders;
+        readers.fetch_add(1, std::memory_order_seq_cst);
+        if (!mWriter.load(std::memory_order_seq_cst)) {
+            return true;
+        }
+        readers.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    void unlock_shared()
+    {
+        mSlots[getThreadSlot()].mReaders.fetch_sub(1, std::memory_order_release);
+    }
+
+    void lock()
+    {
+        // One writer at a time.
+        while (mWriter.exchange(true, std::memory_order_seq_cst)) {
+            waitWhile([this]() { return mWriter.load(std::memory_order_relaxed); });
+        }
+
+        // Wait for readers which got in before us to drain. seq_cst to pair
+        // with the readers' publish-then-check, see lock_shared().
+        for (auto &slot : mSlots) {
+            waitWhile([&slot]() { return slot.mReaders.load(std::memory_order_seq_cst) != 0; });
+        }
+    }
+
+    bool try_lock()
+    {
+        if (mWriter.exchange(true, std::memory_order_seq_cst)) {
+            return false;
+        }
+        for (const auto &slot : mSlots) {
+            if (slot.mReaders.load(std::memory_order_seq_cst) != 0) {
+                mWriter.store(false, std::memory_order_release);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void unlock()
+    {
+        mWriter.store(false, std::memory_order_release);
+    }
+
+private:
+    struct CACHE_ALIGN Slot
+    {
+        std::atomic<int32_t> mReaders;
+    };
+
+    static unsigned getThreadSlot()
+    {
+        // Threads are normally pinned, so the CPU a thread first locks from
+        // makes a good, stable slot. It has to be stable: unlock_shared() must
+        // find the same slot lock_shared() used.
+        static thread_local const unsigned sSlot = assignThreadSlot();
+        return sSlot;
+    }
+
+    static unsigned assignThreadSlot()
+    {
+#ifdef __linux__
+        const int cpu = sched_getcpu();
+        if (cpu >= 0) {
+            return unsigned(cpu) % kNumSlots;
+        }
+#endif
+        static std::atomic<unsigned> sNextSlot(0);
+        return sNextSlot.fetch_add(1, std::memory_order_relaxed) % kNumSlots;
+    }
+
+    template <typename Predicate>
+    static void waitWhile(Predicate pred)
+    {
+        // Spin briefly, then start yielding so long writes don't burn a core
+        // per blocked reader.
+        for (unsigned spin = 0; pred(); ++spin) {
+            if (spin < 64) {
+#if defined(__x86_64__)
+                __builtin_ia32_pause();
+#endif
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    CACHE_ALIGN std::atomic<bool> mWriter;
+    Slot mSlots[kNumSlots];
+};
+
+} // namespace util
+} // namespace scene_rdl2
+
@@ -117,8 +117,9 @@ writeTest(const std::string& filePath, bool createDirectories)
                 return false;
             }
 
-            // Does not exist, try to create directory.
-            if (mkdir(leadingPath.c_str(), 0777) != 0) {
+            // Does not exist, try to create directory. Another thread may
+            // have created it meanwhile.
+            if (mkdir(leadingPath.c_str(), 0777) != 0 && errno != EEXIST) {
                 return false;
             }
         }
@@ -184,13 +185,38 @@ copyFile(const std::string& src, const std::string& dst)
     }
     size_t numBytes = statBuf.st_size;
 
+    size_t bytesCopied = 0;
+
+#if !defined(__APPLE__)
+    // Try copy_file_range() first. The filesystem can do the copy by itself
+    // (reflink on btrfs/XFS, server side copy on NFS 4.2) without moving the
+    // data through the page cache. Not supported across filesystems on older
+    // kernels, in which case we fall back to sendfile() below.
+    while (bytesCopied < numBytes) {
+        ssize_t result = copy_file_range(in.fd, nullptr, out.fd, nullptr,
+                                         numBytes - bytesCopied, 0);
+        if (result == -1) {
+            if (bytesCopied == 0 && (errno == EXDEV || errno == ENOSYS ||
+                                     errno == EINVAL || errno == EOPNOTSUPP)) {
+                break;
+            }
+            throw except::IoError(util::buildString("copy_file_range() failed: ",
+                    std::strerror(errno)));
+        }
+        if (result == 0) {
+            throw except::IoError(util::buildString("Failed to copy '", src,
+                    "': file size changed during copy"));
+        }
+        bytesCopied += result;
+    }
+#endif
+
     // Copy the file in kernel space (zero-copy, woo!).
     // Note: A single call to sendfile will copy at most 2,147,479,552 bytes,
     //       so files larger than this require multiple calls.
 
-    size_t bytesToCopy = numBytes;
-    size_t bytesCopied = 0;
-    off_t offset = 0;
+    size_t bytesToCopy = numBytes - bytesCopied;
+    off_t offset = bytesCopied;
 
     while (bytesCopied < numBytes) {
         #if defined(__APPLE__)
@@ -203,6 +229,10 @@ copyFile(const std::string& src, const std::string& dst)
             throw except::IoError(util::buildString("sendfile() failed: ",
                     std::strerror(errno)));
         }
+        if (result == 0) {
+            throw except::IoError(util::buildString("Failed to copy '", src,
+                    "': file size changed during copy"));
+        }
         bytesToCopy -= result;
         bytesCopied += result;
     }
@@ -103,7 +103,9 @@ std::string findFile(const std::string& name, const std::string& searchPath);
 /**
  * Copies the file with the given source path to the given destination path.
  * The file copy is done entirely within the kernel, so it's more efficient
- * than copying the file through userspace buffers.
+ * than copying the file through userspace buffers. On Linux copy_file_range()
+ * is used first, which lets the filesystem clone or server side copy the data,
+ * and sendfile() is the fallback.
  *
  * Throws an except::IoError if any of the following occur:
  *  1) The source file cannot be opened for reading.
@@ -0,0 +1,289 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace scene_rdl2 {
+
+///
+/// @class FlatIndexMap
+/// @brief Open addressing (Robin Hood) multimap from a hash value to an
+/// int32_t array index. This is the lookup structure behind IndexableArray.
+///
+/// Entries are stored inline in a single power-of-two sized slot array, so
+/// building and probing the map never allocates per element and never chases
+/// pointers. Only a 32-bit fingerprint of the (remixed) hash is kept, which
+/// means two different hashes may compare equal here: callers must always
+/// confirm a match against the real value, exactly as they already have to
+/// with hash collisions.
+///
+/// Deletion uses backward shifting, so there are no tombstones, but any
+/// insert or erase invalidates all outstanding HashIterators.
+///
+class FlatIndexMap
+{
+    struct Slot
+    {
+        uint32_t mHash;
+        int32_t  mIndex;    // < 0 when the slot is empty
+    };
+
+    // The maximum load factor is kMaxLoadNum / kMaxLoadDen.
+    static constexpr std::size_t kMaxLoadNum = 7;
+    static constexpr std::size_t kMaxLoadDen = 8;
+    static constexpr std::size_t kMinCapacity = 16;
+
+public:
+    typedef std::size_t size_type;
+
+    ///
+    /// Forward iterator over all indices stored with a given hash value.
+    /// Dereferencing gives back the array index.
+    ///
+    class HashIterator
+    {
+    public:
+        HashIterator() :
+            mMap(nullptr),
+            mPos(0),
+            mDist(0),
+            mHash(0)
+        {
+        }
+
+        HashIterator(const FlatIndexMap* map, uint32_t hash) :
+            mMap(map),
+            mPos(map->homeSlot(hash)),
+            mDist(0),
+            mHash(hash)
+        {
+            find_next_valid_slot();
+        }
+
+        friend bool operator==(const HashIterator& a, const HashIterator& b)
+        {
+            // All end iterators compare equal.
+            return a.mMap == b.mMap && a.mPos == b.mPos;
+        }
+
+        friend bool operator!=(const HashIterator& a, const HashIterator& b)
+        {
+            return !(a == b);
+        }
+
+        int32_t operator*() const
+        {
+            return mMap->mSlots[mPos].mIndex;
+        }
+
+        HashIterator& operator++()
+        {
+            advance();
+            find_next_valid_slot();
+            return *this;
+        }
+
+    private:
+        void advance()
+        {
+            mPos = (mPos + 1) & mMap->mMask;
+            ++mDist;
+        }
+
+        void find_next_valid_slot()
+        {
+            // Robin Hood ordering lets us stop as soon as we reach a slot whose
+            // occupant is closer to its home than we are to ours.
+            while (true) {
+                const Slot& s = mMap->mSlots[mPos];
+                if (s.mIndex < 0 || mMap->probeDistance(s.mHash, mPos) < mDist) {
+                    *this = HashIterator();
+                    return;
+                }
+                if (s.mHash == mHash) {
+                    return;
+                }
+                advance();
+            }
+        }
+
+        const FlatIndexMap* mMap;
+        size_type mPos;
+        size_type mDist;
+        uint32_t mHash;
+    };
+
+    FlatIndexMap() :
+        mSize(0),
+        mMask(0)
+    {
+    }
+
+    size_type size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    size_type capacity() const { return mSlots.size(); }
+    size_type heap_bytes() const { return mSlots.capacity() * sizeof(Slot); }
+
+    void clear()
+    {
+        std::fill(mSlots.begin(), mSlots.end(), Slot { 0, -1 });
+        mSize = 0;
+    }
+
+    // Make room for at least n entries without rehashing.
+    void reserve(size_type n)
+    {
+        size_type cap = std::max(kMinCapacity, mSlots.size());
+        while (n * kMaxLoadDen > cap * kMaxLoadNum) {
+            cap *= 2;
+        }
+        if (cap != mSlots.size()) {
+            rehash(cap);
+        }
+    }
+
+    // Reduce a full std::hash value to the fingerprint stored in the map.
+    // std::hash is the identity for integers and pointers on our platform, so
+    // we remix the bits before truncating.
+    static uint32_t fingerprint(std::size_t hash)
+    {
+        uint64_t h = hash;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<uint32_t>(h);
+    }
+
+    void insert(uint32_t hash, int32_t index)
+    {
+        MNRY_ASSERT(index >= 0);
+        if ((mSize + 1) * kMaxLoadDen > mSlots.size() * kMaxLoadNum) {
+            rehash(std::max(kMinCapacity, mSlots.size() * 2));
+        }
+        insertNoGrow(Slot { hash, index });
+        ++mSize;
+    }
+
+    // Removes the entry (hash, index). Returns false if it wasn't present.
+    bool erase(uint32_t hash, int32_t index)
+    {
+        if (mSize == 0) {
+            return false;
+        }
+
+        size_type pos = homeSlot(hash);
+        for (size_type dist = 0; ; ++dist, pos = (pos + 1) & mMask) {
+            const Slot& s = mSlots[pos];
+            if (s.mIndex < 0 || probeDistance(s.mHash, pos) < dist) {
+                return false;
+            }
+            if (s.mHash == hash && s.mIndex == index) {
+                break;
+            }
+        }
+
+        // Backward shift the following cluster into the hole.
+        size_type next = (pos + 1) & mMask;
+        while (mSlots[next].mIndex >= 0 && probeDistance(mSlots[next].mHash, next) > 0) {
+            mSlots[pos] = mSlots[next];
+            pos = next;
+            next = (next + 1) & mMask;
+        }
+        mSlots[pos] = Slot { 0, -1 };
+        --mSize;
+        return true;
+    }
+
+    // Decrement every stored index greater than the given one, used when an
+    // element is removed from the middle of the array.
+    void shiftIndicesDown(int32_t index)
+    {
+        for (Slot& s : mSlots) {
+            if (s.mIndex > index) {
+                --s.mIndex;
+            }
+        }
+    }
+
+    HashIterator find(uint32_t hash) const
+    {
+        return (mSize == 0) ? HashIterator() : HashIterator(this, hash);
+    }
+
+    HashIterator end() const
+    {
+        return HashIterator();
+    }
+
+    // Calls f(hash, index) for every entry, in no particular order.
+    template <typename F>
+    void for_each(F&& f) const
+    {
+        for (const Slot& s : mSlots) {
+            if (s.mIndex >= 0) {
+                f(s.mHash, s.mIndex);
+            }
+        }
+    }
+
+private:
+    size_type homeSlot(uint32_t hash) const
+    {
+        return hash & mMask;
+    }
+
+    size_type probeDistance(uint32_t hash, size_type pos) const
+    {
+        return (pos - homeSlot(hash)) & mMask;
+    }
+
+    void insertNoGrow(Slot entry)
+    {
+        size_type pos = homeSlot(entry.mHash);
+        size_type dist = 0;
+        while (true) {
+            Slot& s = mSlots[pos];
+            if (s.mIndex < 0) {
+                s = entry;
+                return;
+            }
+            // Steal from the rich: displace entries closer to their home.
+            const size_type existingDist = probeDistance(s.mHash, pos);
+            if (existingDist < dist) {
+                std::swap(s, entry);
+                dist = existingDist;
+            }
+            pos = (pos + 1) & mMask;
+            ++dist;
+        }
+    }
+
+    void rehash(size_type capacity)
+    {
+        MNRY_ASSERT(capacity >= mSize && (capacity & (capacity - 1)) == 0);
+        std::vector<Slot> old(capacity, Slot { 0, -1 });
+        old.swap(mSlots);
+        mMask = capacity - 1;
+        for (const Slot& s : old) {
+            if (s.mIndex >= 0) {
+                insertNoGrow(s);
+            }
+        }
+    }
+
+    std::vector<Slot> mSlots;
+    size_type mSize;
+    size_type mMask;
+};
+
+} // namespace scene_rdl2
+
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "FlatIndexMap.h"
+
 #include <scene_rdl2/common/platform/Platform.h>
 
 #include <algorithm>
@@ -14,7 +16,6 @@
 #include <memory>
 #include <mutex>
 #include <type_traits>
-#include <unordered_map>
 #include <vector>
 
 // Uncomment DO_INDEXABLE_ARRAY_INVARIANT_CHECKING to test invariants for all
@@ -54,8 +55,11 @@ public:
     // that we don't have to store the object twice (we already have it in a
     // vector), but we can still look the index up in constant time.
     //
-    // We use two containers for bidirectional lookup.
-    typedef std::unordered_multimap<typename hasher::result_type, int32_t>  map_type;
+    // We use two containers for bidirectional lookup. The map is a flat open
+    // addressing table, so large arrays (e.g. the SceneObjectIndexable
+    // geometry lists of TraceSets and Layers) don't pay for a heap node per
+    // element.
+    typedef FlatIndexMap                                                    map_type;
     typedef T                                                               value_type;
     typedef typename container_type::allocator_type                         allocator_type;
     typedef typename container_type::size_type                              size_type;
@@ -66,7 +70,7 @@ public:
     typedef typename container_type::const_pointer                          const_pointer;
     typedef typename container_type::const_iterator                         const_iterator;
     typedef typename container_type::const_reverse_iterator                 const_reverse_iterator;
-    typedef typename map_type::const_iterator                               const_map_iterator;
+    typedef typename map_type::HashIterator                                 const_map_iterator;
 
     // An iterator over the indices that match the passed in type. It's always
     // const, since it makes no sense to change the indices. The value_type of
@@ -109,7 +113,7 @@ public:
 
         value_type operator*() const
         {
-            return mCurrent->second;
+            return *mCurrent;
         }
 
         MapIndexIterator &operator++()
@@ -135,7 +139,7 @@ public:
 
             // Increment if not last and it's not equal
             while (mCurrent != mLast &&
-                   !key_equal()((*mContainer)[mCurrent->second], mValue)) {
+                   !key_equal()((*mContainer)[*mCurrent], mValue)) {
                 ++mCurrent;
             }
         }
@@ -161,12 +165,7 @@ public:
         mIndexMap(),
         mValues(first, last)
     {
-        typedef typename map_type::value_type value_type;
-        mIndexMap.reserve(mValues.size());
-        int32_t size = static_cast<int32_t>(mValues.size());
-        for (int32_t i = 0; i < size; ++i) {
-            mIndexMap.insert(value_type(hasher()(mValues[i]), i));
-        }
+        build_index();
         invariant_check();
     }
 
@@ -181,6 +180,42 @@ public:
     IndexableArray& operator=(const IndexableArray&) = default;
     IndexableArray& operator=(IndexableArray&&) = default;
 
+    // O(n)
+    // Replaces the contents with [first, last), building the index in one pass.
+    template <typename Iter>
+    void assign(Iter first, Iter last)
+    {
+        invariant_check();
+        mValues.assign(first, last);
+        mIndexMap.clear();
+        build_index();
+        invariant_check();
+    }
+
+    // O(n)
+    // Reserves space in both the array and the index so that the next n - size()
+    // insertions don't reallocate or rehash.
+    void reserve(size_type n)
+    {
+        invariant_check();
+        mValues.reserve(n);
+        mIndexMap.reserve(n);
+        invariant_check();
+    }
+
+    // O(1)
+    size_type capacity() const
+    {
+        invariant_check();
+        return mValues.capacity();
+    }
+
+    // Bytes allocated by the array and its index, for memory accounting.
+    size_type heap_bytes() const
+    {
+        return mValues.capacity() * sizeof(T) + mIndexMap.heap_bytes();
+    }
+
     // Amortized O(1)
     void push_back(const T& t)
     {
@@ -202,14 +237,14 @@ public:
     void emplace_back(Args&&... args)
     {
         invariant_check();
-        typedef typename map_type::value_type value_type;
         const auto s = mValues.size();
         mValues.emplace_back(std::forward<Args>(args)...);
-        mIndexMap.insert(value_type(hasher()(mValues.back()), s));
+        mIndexMap.insert(hash_of(mValues.back()), static_cast<int32_t>(s));
         invariant_check();
     }
 
-    // O(1)
+    // O(n + capacity): destroys the values and resets every index slot.
+    // The index keeps its capacity.
     void clear()
     {
         invariant_check();
@@ -265,23 +300,13 @@ public:
     const_iterator erase(const_iterator pos)
     {
         invariant_check();
-        const auto idx = pos - mValues.cbegin();
+        const auto idx = static_cast<int32_t>(pos - mValues.cbegin());
 
-        auto pair = mIndexMap.equal_range(hasher()(*pos));
-        for (auto it = pair.first; it != pair.second; ++it) {
-            if (it->second == idx) { // If this is the index...
-                mIndexMap.erase(it);
-                break;
-            }
-        }
+        mIndexMap.erase(hash_of(*pos), idx);
 
         // Everything beyond index is going to be shifted down one. We have to
         // adjust our stored indices.
-        for (auto& v : mIndexMap) {
-            if (v.second >= idx) {
-                --v.second;
-            }
-        }
+        mIndexMap.shiftIndicesDown(idx);
 
         //const_iterator ret = mValues.erase(pos);
         // TODO: A hack, since our version of the standard library doesn't
@@ -296,9 +321,10 @@ public:
     std::pair<index_iterator, index_iterator> equal_range(const T& val) const
     {
         invariant_check();
-        const auto itpair = mIndexMap.equal_range(hasher()(val));
-        return std::make_pair(index_iterator(this, val, itpair.first, itpair.second),
-                              index_iterator(this, val, itpair.second, itpair.second));
+        const auto first = mIndexMap.find(hash_of(val));
+        const auto last = mIndexMap.end();
+        return std::make_pair(index_iterator(this, val, first, last),
+                              index_iterator(this, val, last, last));
     }
 
     // O(1)
@@ -372,42 +398,40 @@ public:
     }
 
 private:
+    static uint32_t hash_of(const T& value)
+    {
+        return map_type::fingerprint(hasher()(value));
+    }
+
+    void build_index()
+    {
+        const int32_t size = static_cast<int32_t>(mValues.size());
+        mIndexMap.reserve(mValues.size());
+        for (int32_t i = 0; i < size; ++i) {
+            mIndexMap.insert(hash_of(mValues[i]), i);
+        }
+    }
+
     template <typename U>
     void update_value_impl(size_type i, U&& value)
     {
         MNRY_ASSERT(i < mValues.size());
-        typedef typename map_type::value_type value_type;
 
         // We have to remove the old value from the hash.
-        const auto oldhash = hasher()(mValues[i]);
-        auto pair = mIndexMap.equal_range(oldhash);
-        for (auto it = pair.first; it != pair.second; ++it) {
-            if (it->second == i) { // If this is the index...
-                mIndexMap.erase(it);
-                break;
-            }
-        }
+        mIndexMap.erase(hash_of(mValues[i]), static_cast<int32_t>(i));
 
         mValues[i] = std::forward<U>(value);
-        mIndexMap.insert(value_type(hasher()(mValues[i]), i));
+        mIndexMap.insert(hash_of(mValues[i]), static_cast<int32_t>(i));
     }
 
-    typename map_type::const_iterator get_key(const T& val) const
+    int32_t get_index(const T& val) const
     {
-        const auto itpair = mIndexMap.equal_range(hasher()(val));
-        for (auto it = itpair.first; it != itpair.second; ++it) {
-            const T& lookup = (*this)[it->second];
-            if (key_equal()(lookup, val)) {
-                return it;
+        for (auto it = mIndexMap.find(hash_of(val)); it != mIndexMap.end(); ++it) {
+            if (key_equal()(mValues[*it], val)) {
+                return *it;
             }
         }
-        return mIndexMap.end();
-    }
-
-    int32_t get_index(const T& val) const
-    {
-        auto it = get_key(val);
-        return (it == mIndexMap.end()) ? -1 : it->second;
+        return -1;
     }
 
     map_type       mIndexMap;
@@ -421,15 +445,15 @@ void IndexableArray<T, Hash, KeyEqual>::invariant_check() const
     MNRY_ASSERT(mValues.size() == mIndexMap.size());
 
     std::deque<bool> indexList(mValues.size(), false);
-    for (const auto p : mIndexMap) {
-        const std::size_t idx = p.second;
+    mIndexMap.for_each([&](uint32_t hash, int32_t index) {
+        const std::size_t idx = index;
 
         MNRY_ASSERT(idx < mValues.size());
         // We haven't already seen this index.
         MNRY_ASSERT(indexList[idx] != true);
-        MNRY_ASSERT(hasher()(mValues[idx]) == p.first);
+        MNRY_ASSERT(hash_of(mValues[idx]) == hash);
         indexList[idx] = true;
-    }
+    });
 
     // We have a map to all items in the list.
     MNRY_ASSERT(std::all_of(indexList.cbegin(), indexList.cend(),
@@ -441,8 +465,7 @@ template <typename T, typename Hash, typename KeyEqual>
 template <typename U>
 void IndexableArray<T, Hash, KeyEqual>::push_back_impl(U&& value)
 {
-    typedef typename map_type::value_type value_type;
-    mIndexMap.insert(value_type(hasher()(value), mValues.size()));
+    mIndexMap.insert(hash_of(value), static_cast<int32_t>(mValues.size()));
     mValues.push_back(std::forward<U>(value));
 }
 
@@ -462,21 +485,18 @@ bool operator!=(const IndexableArray<T, Hash, KeyEqual>& lhs,
 };
 
 // Average case: O(n), where n is the number of elements in the container.
-// Worst case: O(n^3), when every element matches the value, and you have very
-// bad luck. Don't be that guy.
+// Worst case: O(n^2), when every element matches the value.
 template <typename T, typename Hash, typename KeyEqual, typename U>
 void erase_all(IndexableArray<T, Hash, KeyEqual>& a, const U& value)
 {
-    auto p = a.equal_range(value);
-    auto first = p.first;
-    auto last  = p.second;
-    while (first != last) {
-        // Tricky business. The iterator returned by equal_range will be
-        // invalided when we call erase on that element, but the other iterators
-        // aren't. Move to the next iterator before we call erase.
-        auto idx = *first;
-        ++first;
-        a.erase(a.begin() + idx);
+    // Erasing from the index invalidates all index iterators, so gather the
+    // matches first and remove them back to front so the remaining indices
+    // stay valid.
+    const auto p = a.equal_range(value);
+    std::vector<uint32_t> indices(p.first, p.second);
+    std::sort(indices.begin(), indices.end());
+    for (auto it = indices.rbegin(); it != indices.rend(); ++it) {
+        a.erase(a.begin() + *it);
     }
 };
 
@@ -4,8 +4,10 @@
 //
 //
 #include "LuaScriptRunner.h"
+#include "LuaStatePool.h"
 #include "StrUtil.h"
 
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <list>
@@ -52,6 +54,13 @@ errorHandler(lua_State *state)
 namespace scene_rdl2 {
 namespace util {
 
+static LuaStatePool &
+getLuaStatePool()
+{
+    static LuaStatePool pool(4); // max idle states
+    return pool;
+}
+
 //------------------------------------------------------------------------------------------
 
 class LuaGlobalVarBase
@@ -310,6 +319,7 @@ public:
 
 private:
     void loadScript(lua_State *state, const std::string &filename) const;
+    static void skipFirstLineComment(std::string &code);
     static std::string showLuaStack(lua_State *state); // for debug
 
     void convertJsonVal(const std::string &name, const Json::Value &jv);
@@ -338,10 +348,21 @@ LuaScriptRunner::Impl::setDictionaryByJson(const std::string &name, const std::s
 void
 LuaScriptRunner::Impl::runFile(const std::string &filename) const
 {
-    lua_State *state = luaL_newstate(); // create new state
-    luaL_openlibs(state);
-    lua_atpanic(state, panicHandler); // set panic handler
-    loadScript(state, filename);
+    // Reuse pooled state if possible. Pooled state is already reset to just after luaL_openlibs().
+    lua_State *state = getLuaStatePool().acquire();
+    if (!state) {
+        state = luaL_newstate(); // create new state
+        luaL_openlibs(state);
+        lua_atpanic(state, panicHandler); // set panic handler
+        LuaStatePool::snapshotGlobals(state);
+    }
+    try {
+        loadScript(state, filename);
+    }
+    catch (...) {
+        getLuaStatePool().release(state);
+        throw;
+    }
 
     // set global variables
     if (mGlobalVarDictionaryRoot) {
@@ -356,11 +377,11 @@ LuaScriptRunner::Impl::runFile(const std::string &filename) const
     // execute lua script
     if (lua_pcall(state, 0, 0, hpos) != 0) {
         std::string error = lua_tostring(state, -1);
-        lua_close(state); // This is not a panic situation, we should do clean up.
+        getLuaStatePool().release(state); // This is not a panic situation, state is still reusable.
         throw std::runtime_error(error);
     }
 
-    lua_close(state);           // clean up
+    getLuaStatePool().release(state); // reset and back to the pool
 }
 
 void
@@ -373,7 +394,31 @@ LuaScriptRunner::Impl::loadScript(lua_State *state, const std::string &filename)
         throw std::runtime_error(ostr.str().c_str());
     }
 
-    luaL_loadfile(state, filename.c_str()); // load lua script file
+    // Script is compiled once and the bytecode is reused by the following runFile() of the same script.
+    std::ifstream ifs(filename, std::ios::binary);
+    std::string code((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    skipFirstLineComment(code);
+    if (LuaChunkCache::get().load(state, code, '@' + filename) != LUA_OK) { // load lua script file
+        std::string error = lua_tostring(state, -1);
+        throw std::runtime_error(error);
+    }
+}
+
+// static function
+void
+LuaScriptRunner::Impl::skipFirstLineComment(std::string &code)
+//
+// Same as luaL_loadfile() does : skips an UTF-8 BOM and a first line which starts with '#'
+// (e.g. "#!/usr/bin/env lua"). The comment is replaced by an empty line, so the line numbers of
+// the error messages don't change, except in front of a precompiled chunk.
+//
+{
+    if (code.compare(0, 3, "\xEF\xBB\xBF") == 0) code.erase(0, 3);
+    if (code.empty() || code[0] != '#') return;
+
+    const size_t eol = code.find('\n');
+    code.erase(0, eol);
+    if (code.size() > 1 && code[1] == LUA_SIGNATURE[0]) code.erase(0, 1);
 }
 
 // static function
@@ -593,6 +638,13 @@ LuaScriptRunner::showGlobalVarRoot() const
     return mImpl->showGlobalVarRoot();
 }
 
+// static function
+void
+LuaScriptRunner::setStatePoolSize(size_t maxIdle)
+{
+    getLuaStatePool().setMaxIdle(maxIdle);
+}
+
 } // namespace util
 } // namespace scene_rdl2
 
@@ -25,8 +25,10 @@ namespace util {
 //
 // Lua script is executed as single thread task. If you create 2 LuaScriptRunner object and
 // call each runFile() by different threads, each LuaScriptRunner::runFile() is executed
-// independently by 2 different threads in parallel. Also each LuaScriptRunner creates independent
+// independently by 2 different threads in parallel. Also each runFile() uses independent
 // lua_State internally and they are isolated each other.
+// lua_States are reused through LuaStatePool and reset to just after luaL_openlibs() between
+// runFile() calls, and compiled scripts are cached by LuaChunkCache. (See LuaStatePool.h)
 //
 
 // >>>>> How to setup Lua global variables? <<<<<
@@ -373,6 +375,8 @@ public:
 
     std::string showGlobalVarRoot() const;
 
+    static void setStatePoolSize(size_t maxIdle); // 0 : always create new lua_State
+
 private:
     class Impl;
     std::unique_ptr<Impl> mImpl;
@@ -0,0 +1,339 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "LuaStatePool.h"
+
+#include <sstream>
+
+#include <lua.hpp>
+
+namespace {
+
+// The addresses of these are unique through the whole program and used as keys of the Lua registry.
+const char sSnapshotKey = 's';
+const char sGlobalsMetatableKey = 'm';
+
+void
+pushShallowCopy(lua_State *state, int srcIdx)
+{
+    srcIdx = lua_absindex(state, srcIdx);
+    lua_newtable(state);
+    lua_pushnil(state);
+    while (lua_next(state, srcIdx)) {
+        lua_pushvalue(state, -2);
+        lua_insert(state, -2);
+        lua_rawset(state, -4);
+    }
+}
+
+void
+addSnapshot(lua_State *state, const int snapshotIdx, int tblIdx)
+//
+// snapshot[tbl] = shallow copy of tbl, and the same for every table reachable from tbl through its
+// values. Every table is copied once even if it is referenced by multiple names or by a cycle.
+//
+{
+    tblIdx = lua_absindex(state, tblIdx);
+    lua_pushvalue(state, tblIdx);
+    lua_rawget(state, snapshotIdx);
+    const bool done = !lua_isnil(state, -1);
+    lua_pop(state, 1);
+    if (done) return;
+
+    lua_pushvalue(state, tblIdx);
+    pushShallowCopy(state, tblIdx);
+    lua_rawset(state, snapshotIdx);
+
+    luaL_checkstack(state, 3, "LuaStatePool snapshot is too deep");
+    lua_pushnil(state);
+    while (lua_next(state, tblIdx)) {
+        if (lua_type(state, -1) == LUA_TTABLE) {
+            addSnapshot(state, snapshotIdx, -1);
+        }
+        lua_pop(state, 1);
+    }
+}
+
+int
+writer(lua_State *, const void *p, size_t size, void *ud)
+{
+    static_cast<std::string *>(ud)->append(static_cast<const char *>(p), size);
+    return 0;
+}
+
+} // namespace
+
+namespace scene_rdl2 {
+namespace util {
+
+LuaStatePool::~LuaStatePool()
+{
+    for (lua_State *state : mIdle) {
+        lua_close(state);
+    }
+}
+
+lua_State *
+LuaStatePool::acquire()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mIdle.empty()) return nullptr;
+    lua_State *state = mIdle.back();
+    mIdle.pop_back();
+    return state;
+}
+
+void
+LuaStatePool::release(lua_State *state)
+{
+    if (!state) return;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mIdle.size() >= mMaxIdle) {
+            lua_close(state);
+            return;
+        }
+    }
+
+    // Reset is done outside of the lock. This is the main cost of the release.
+    if (!restoreGlobals(state)) {
+        lua_close(state);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mIdle.size() >= mMaxIdle) {
+        lua_close(state);
+        return;
+    }
+    mIdle.push_back(state);
+}
+
+void
+LuaStatePool::setMaxIdle(size_t maxIdle)
+{
+    std::vector<lua_State *> closeStates;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mMaxIdle = maxIdle;
+        while (mIdle.size() > mMaxIdle) {
+            closeStates.push_back(mIdle.back());
+            mIdle.pop_back();
+        }
+    }
+    for (lua_State *state : closeStates) {
+        lua_close(state);
+    }
+}
+
+size_t
+LuaStatePool::getIdleTotal() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mIdle.size();
+}
+
+// static function
+void
+LuaStatePool::snapshotGlobals(lua_State *state)
+{
+    const int top = lua_gettop(state);
+
+    lua_newtable(state); // snapshot : key = original table, value = shallow copy
+    const int snapshotIdx = lua_gettop(state);
+
+    lua_pushglobaltable(state);
+    const int globalsIdx = lua_gettop(state);
+    addSnapshot(state, snapshotIdx, globalsIdx);
+
+    // Modules loaded by require() are kept in the registry's _LOADED table (package.loaded). It is
+    // also reachable by the global table through the package library, but not necessarily (e.g. the
+    // package global has been removed by the setup), so snapshot it explicitly. Then the next use
+    // loads its modules again instead of seeing the ones of the previous use.
+    lua_pushstring(state, "_LOADED");
+    lua_rawget(state, LUA_REGISTRYINDEX);
+    if (lua_istable(state, -1)) addSnapshot(state, snapshotIdx, -1);
+    lua_pop(state, 1);
+
+    if (lua_getmetatable(state, globalsIdx)) { // like strict.lua, which keeps declared names inside
+        addSnapshot(state, snapshotIdx, -1);
+    } else {
+        lua_pushnil(state);
+    }
+    lua_rawsetp(state, LUA_REGISTRYINDEX, &sGlobalsMetatableKey);
+
+    lua_pushvalue(state, snapshotIdx);
+    lua_rawsetp(state, LUA_REGISTRYINDEX, &sSnapshotKey);
+
+    lua_settop(state, top);
+}
+
+// static function
+bool
+LuaStatePool::restoreGlobals(lua_State *state)
+{
+    lua_settop(state, 0); // drop leftovers of the last use (e.g. error message)
+
+    lua_rawgetp(state, LUA_REGISTRYINDEX, &sSnapshotKey);
+    if (!lua_istable(state, 1)) {
+        lua_settop(state, 0);
+        return false;
+    }
+    const int snapshotIdx = 1;
+
+    lua_pushglobaltable(state);
+    lua_rawgetp(state, LUA_REGISTRYINDEX, &sGlobalsMetatableKey);
+    lua_setmetatable(state, -2);
+    lua_pop(state, 1);
+
+    lua_pushnil(state);
+    while (lua_next(state, snapshotIdx)) { // stack : key = original table, value = copy
+        const int origIdx = lua_gettop(state) - 1;
+        const int copyIdx = lua_gettop(state);
+
+        // Clearing existing fields is allowed during the traversal.
+        lua_pushnil(state);
+        while (lua_next(state, origIdx)) {
+            lua_pop(state, 1);
+            lua_pushvalue(state, -1);
+            lua_pushnil(state);
+            lua_rawset(state, origIdx);
+        }
+
+        lua_pushnil(state);
+        while (lua_next(state, copyIdx)) {
+            lua_pushvalue(state, -2);
+            lua_insert(state, -2);
+            lua_rawset(state, origIdx);
+        }
+
+        lua_pop(state, 1); // keep original table as the key of the next iteration
+    }
+    lua_settop(state, 0);
+
+    lua_gc(state, LUA_GCCOLLECT, 0); // releases everything which was only referenced from the last use
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+
+// static function
+LuaChunkCache &
+LuaChunkCache::get()
+{
+    static LuaChunkCache instance;
+    return instance;
+}
+
+int
+LuaChunkCache::load(lua_State *state, const std::string &code, const std::string &chunkName)
+{
+    const bool binary = (!code.empty() && code[0] == LUA_SIGNATURE[0]); // precompiled already
+    if (binary || code.size() > mMaxEntryByte || !mMaxTotalByte) {
+        return luaL_loadbuffer(state, code.c_str(), code.size(), chunkName.c_str());
+    }
+
+    std::string key;
+    key.reserve(chunkName.size() + 1 + code.size());
+    key.append(chunkName).append(1, '\0').append(code);
+
+    BytecodeShPtr bytecode;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto itr = mTable.find(key);
+        if (itr != mTable.end()) {
+            mLru.splice(mLru.begin(), mLru, itr->second.mLruItr);
+            bytecode = itr->second.mBytecode;
+            ++mHitTotal;
+        } else {
+            ++mMissTotal;
+        }
+    }
+    if (bytecode) {
+        // Bytecode is shared by shared_ptr and loaded outside of the lock.
+        return luaL_loadbufferx(state, bytecode->data(), bytecode->size(), chunkName.c_str(), "b");
+    }
+
+    const int status = luaL_loadbuffer(state, code.c_str(), code.size(), chunkName.c_str());
+    if (status != LUA_OK) return status;
+
+    std::shared_ptr<std::string> dump = std::make_shared<std::string>();
+#if LUA_VERSION_NUM >= 503
+    const int dumpStatus = lua_dump(state, writer, dump.get(), 0); // keep debug info
+#else
+    const int dumpStatus = lua_dump(state, writer, dump.get());
+#endif
+    if (dumpStatus == 0) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        insert(std::move(key), std::move(dump));
+    }
+    return status;
+}
+
+void
+LuaChunkCache::setCapacity(size_t maxEntryByte, size_t maxTotalByte)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMaxEntryByte = maxEntryByte;
+    mMaxTotalByte = maxTotalByte;
+    while (mTotalByte > mMaxTotalByte && !mLru.empty()) {
+        auto itr = mTable.find(*mLru.back());
+        mTotalByte -= itr->second.mByte;
+        mLru.pop_back();
+        mTable.erase(itr);
+    }
+}
+
+void
+LuaChunkCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mLru.clear();
+    mTable.clear();
+    mTotalByte = 0;
+}
+
+std::string
+LuaChunkCache::show() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::ostringstream ostr;
+    ostr << "LuaChunkCache {\n"
+         << "  mMaxEntryByte:" << mMaxEntryByte << '\n'
+         << "  mMaxTotalByte:" << mMaxTotalByte << '\n'
+         << "  mTotalByte:" << mTotalByte << '\n'
+         << "  entry total:" << mTable.size() << '\n'
+         << "  mHitTotal:" << mHitTotal << '\n'
+         << "  mMissTotal:" << mMissTotal << '\n'
+         << "}";
+    return ostr.str();
+}
+
+void
+LuaChunkCache::insert(std::string &&key, BytecodeShPtr bytecode)
+{
+    const size_t byte = key.size() + bytecode->size();
+    if (byte > mMaxTotalByte) return;
+
+    auto result = mTable.emplace(std::move(key), Entry());
+    if (!result.second) return; // inserted by other thread meanwhile
+
+    Entry &entry = result.first->second;
+    entry.mBytecode = std::move(bytecode);
+    entry.mByte = byte;
+    mLru.push_front(&result.first->first);
+    entry.mLruItr = mLru.begin();
+    mTotalByte += byte;
+
+    while (mTotalByte > mMaxTotalByte) {
+        auto itr = mTable.find(*mLru.back());
+        mTotalByte -= itr->second.mByte;
+        mLru.pop_back();
+        mTable.erase(itr);
+    }
+}
+
+} // namespace util
+} // namespace scene_rdl2
@@ -0,0 +1,124 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+
+namespace scene_rdl2 {
+namespace util {
+
+//
+// LuaStatePool keeps initialized lua_States for reuse, so the user of the Lua interpreter only pays
+// luaL_newstate(), luaL_openlibs() and its own library setup once per pooled state instead of
+// once per use.
+//
+//   lua_State *state = pool.acquire();
+//   if (!state) {
+//       state = luaL_newstate();
+//       ... open libraries, register functions, load support library ...
+//       LuaStatePool::snapshotGlobals(state); // this is the state which release() goes back to
+//   }
+//   ... per use setup and run scripts ...
+//   pool.release(state);
+//
+// release() restores the global table, the tables of the package library (package.loaded, ...),
+// the metatable of the global table and every table reachable from them through table values (so
+// also the nested tables of the support library) to the snapshot, then runs a full garbage
+// collection. So a module loaded by require() is loaded again by the next use of the state and
+// tables created by the previous use are unreachable. Values which are not tables are restored by
+// reference : the state inside a userdata or the upvalues of a function are kept as is, and so are
+// the metatables of the tables other than the global table.
+// A state without the snapshot is closed by release() instead of pooled.
+// All APIs are MTsafe. A pooled state is only used by one thread at a time.
+//
+class LuaStatePool
+{
+public:
+    explicit LuaStatePool(size_t maxIdle) : mMaxIdle(maxIdle) {}
+    ~LuaStatePool();
+
+    // Non-copyable
+    LuaStatePool &operator =(const LuaStatePool &) = delete;
+    LuaStatePool(const LuaStatePool &) = delete;
+
+    lua_State *acquire(); // returns nullptr if no pooled state
+    void release(lua_State *state); // resets and pools state, closed if the pool is full
+
+    void setMaxIdle(size_t maxIdle); // 0 disables pooling
+    size_t getIdleTotal() const;
+
+    static void snapshotGlobals(lua_State *state);
+    static bool restoreGlobals(lua_State *state); // returns false if there is no snapshot
+
+private:
+    mutable std::mutex mMutex;
+    size_t mMaxIdle;
+    std::vector<lua_State *> mIdle;
+};
+
+//
+// Process-wide cache of the compiled Lua chunks. load() is a replacement of luaL_loadbuffer() and
+// loads the bytecode (lua_dump() result) instead of compiling the source again when the same chunk
+// (same chunkName and same source code) was loaded before. Bytecode keeps the debug information,
+// so error messages are the same as the source code. Only chunks up to maxEntryByte of source are
+// cached and least recently used chunks are dropped when total exceeds maxTotalByte.
+//
+class LuaChunkCache
+{
+public:
+    static LuaChunkCache &get();
+
+    LuaChunkCache() = default;
+
+    // Non-copyable
+    LuaChunkCache &operator =(const LuaChunkCache &) = delete;
+    LuaChunkCache(const LuaChunkCache &) = delete;
+
+    // Same return value as luaL_loadbuffer(). Compiled chunk is pushed on the stack.
+    int load(lua_State *state, const std::string &code, const std::string &chunkName);
+
+    void setCapacity(size_t maxEntryByte, size_t maxTotalByte); // maxTotalByte = 0 disables cache
+    size_t getMaxEntryByte() const { return mMaxEntryByte; } // larger chunks are not cached
+    void clear();
+
+    uint64_t getHitTotal() const { return mHitTotal; }
+    uint64_t getMissTotal() const { return mMissTotal; }
+    std::string show() const;
+
+private:
+    using BytecodeShPtr = std::shared_ptr<const std::string>;
+
+    struct Entry
+    {
+        BytecodeShPtr mBytecode;
+        size_t mByte {0}; // source + bytecode
+        std::list<const std::string *>::iterator mLruItr;
+    };
+
+    void insert(std::string &&key, BytecodeShPtr bytecode); // under mMutex
+
+    mutable std::mutex mMutex;
+    std::atomic<size_t> mMaxEntryByte {1024 * 1024};
+    std::atomic<size_t> mMaxTotalByte {32 * 1024 * 1024};
+    size_t mTotalByte {0};
+    std::unordered_map<std::string, Entry> mTable; // key : chunkName + '\0' + code
+    std::list<const std::string *> mLru; // front is most recently used. points key of mTable
+
+    std::atomic<uint64_t> mHitTotal {0};
+    std::atomic<uint64_t> mMissTotal {0};
+};
+
+} // namespace util
+} // namespace scene_rdl2
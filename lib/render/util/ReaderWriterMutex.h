@@ -25,6 +25,8 @@
 namespace scene_rdl2 {
 namespace util {
 
+// For read-mostly data locked from many threads at once, see also
+// DistributedReaderWriterMutex.h, which avoids the shared reader cache line.
 #if defined(USE_SHARED_MUTEX)
     using ReaderWriterMutex    = std::shared_mutex;
     using ReadLock             = std::shared_lock<ReaderWriterMutex>;
@@ -8,6 +8,10 @@
 #include "BitUtils.h"
 #include <algorithm>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
 #define EXTRACT_KEY32(x, offset)    (((const uint32_t *)(&(x)))[offset >> 2])
 #define EXTRACT_KEY22(x, offset)    ((((const uint32_t *)(&(x)))[offset >> 2]) & 0x3fffff)
 #define EXTRACT_KEY11(x, offset)    ((((const uint32_t *)(&(x)))[offset >> 2]) & 0x7ff)
@@ -110,7 +114,7 @@ inPlaceRadixSort32(unsigned numElems, T *elems, alloc::Arena *arena)
     const uint32_t scratchBufSize = alignUp<uint32_t>(sizeof(T) * numElems, CACHE_LINE_SIZE);
     MNRY_ASSERT((histogramBufSize % CACHE_LINE_SIZE) == 0);
 
-    SCOPED_MEM(arena);
+    SCOPED_ARENA_MARKER(arena);
     unsigned bufSize = histogramBufSize + scratchBufSize * 2;
     uint8_t *buf = arena->alloc(bufSize, CACHE_LINE_SIZE);
 
@@ -185,7 +189,7 @@ inPlaceRadixSort22(unsigned numElems, T *elems, alloc::Arena *arena)
     const uint32_t scratchBufSize = alignUp<uint32_t>(sizeof(T) * numElems, CACHE_LINE_SIZE);
     MNRY_ASSERT((histogramBufSize % CACHE_LINE_SIZE) == 0);
 
-    SCOPED_MEM(arena);
+    SCOPED_ARENA_MARKER(arena);
     unsigned bufSize = histogramBufSize + scratchBufSize;
     uint8_t *buf = arena->alloc(bufSize, CACHE_LINE_SIZE);
 
@@ -248,7 +252,7 @@ outOfPlaceRadixSort11(unsigned numElems, T *elems, T *dst, alloc::Arena *arena)
     const uint32_t histogramBufSize = numBuckets * sizeof(uint32_t);
     MNRY_ASSERT((histogramBufSize % CACHE_LINE_SIZE) == 0);
 
-    SCOPED_MEM(arena);
+    SCOPED_ARENA_MARKER(arena);
     uint32_t *histogram = (uint32_t *)arena->alloc(histogramBufSize, CACHE_LINE_SIZE);
     memset(histogram, 0, histogramBufSize);
 
@@ -286,7 +290,7 @@ outOfPlaceRadixSortMSB8(unsigned numElems, T *elems, T *dst, alloc::Arena *arena
     const uint32_t histogramBufSize = numBuckets * sizeof(uint32_t);
     MNRY_ASSERT((histogramBufSize % CACHE_LINE_SIZE) == 0);
 
-    SCOPED_MEM(arena);
+    SCOPED_ARENA_MARKER(arena);
     uint32_t *histogram = (uint32_t *)arena->alloc(histogramBufSize, CACHE_LINE_SIZE);
     memset(histogram, 0, histogramBufSize);
 
@@ -471,6 +475,213 @@ smartSort32(unsigned numElems, T *elems, uint32_t maxSortKey, alloc::Arena *aren
 
 //-----------------------------------------------------------------------------
 
+//
+// Parallel radix sort functions.
+//
+// These split the input into contiguous chunks, one histogram per chunk, and
+// run each pass as a parallel count followed by a parallel stable scatter.
+// The results are identical to the serial versions above (i.e. stable), and
+// like them all scratch memory comes from the supplied arena, which is only
+// touched by the calling thread. Note that the arena block size must be large
+// enough to hold a full copy of the input.
+//
+// They only pay off for large inputs, see inPlaceParallelSort32 for a version
+// which picks between serial and parallel based on the element count.
+//
+
+namespace detail {
+
+// Smallest chunk we'll hand to a single task. Below this the per chunk
+// histogram clearing and prefix sums start to dominate.
+const unsigned PARALLEL_RADIX_MIN_CHUNK_SIZE = 32 * 1024;
+
+inline unsigned
+getParallelRadixChunkCount(unsigned numElems)
+{
+    // A couple of chunks per thread helps smooth out uneven scheduling.
+    const unsigned maxChunks = unsigned(std::max(1, tbb::this_task_arena::max_concurrency())) * 2;
+    return std::max(1u, std::min(maxChunks, numElems / PARALLEL_RADIX_MIN_CHUNK_SIZE));
+}
+
+// A single stable counting sort pass on the digit (key >> SHIFT) & (2^BITS - 1)
+// of every element, from src to dst. histograms must have room for
+// numChunks * 2^BITS counters.
+template<typename T, unsigned SORT_KEY_OFFSET, unsigned SHIFT, unsigned BITS>
+inline void
+parallelRadixPass(unsigned numElems, const T *src, T *dst, unsigned numChunks, uint32_t *histograms)
+{
+    const uint32_t numBuckets = 1 << BITS;
+    const uint32_t mask = numBuckets - 1;
+    const unsigned chunkSize = (numElems + numChunks - 1) / numChunks;
+
+    tbb::parallel_for(tbb::blocked_range<unsigned>(0, numChunks, 1),
+                      [&](const tbb::blocked_range<unsigned> &range) {
+        for (unsigned chunk = range.begin(); chunk != range.end(); ++chunk) {
+            uint32_t *histogram = histograms + chunk * numBuckets;
+            memset(histogram, 0, numBuckets * sizeof(uint32_t));
+            const unsigned end = std::min(numElems, (chunk + 1) * chunkSize);
+            for (unsigned i = chunk * chunkSize; i < end; ++i) {
+                ++histogram[(EXTRACT_KEY32(src[i], SORT_KEY_OFFSET) >> SHIFT) & mask];
+            }
+        }
+    });
+
+    // Bucket major, chunk minor prefix sum, so that each chunk scatters its
+    // elements after those of all previous chunks within the same bucket.
+    uint32_t acc = 0;
+    for (uint32_t bucket = 0; bucket < numBuckets; ++bucket) {
+        for (unsigned chunk = 0; chunk < numChunks; ++chunk) {
+            uint32_t &count = histograms[chunk * numBuckets + bucket];
+            const uint32_t a = count + acc;
+            count = acc;
+            acc = a;
+        }
+    }
+
+    tbb::parallel_for(tbb::blocked_range<unsigned>(0, numChunks, 1),
+                      [&](const tbb::blocked_range<unsigned> &range) {
+        for (unsigned chunk = range.begin(); chunk != range.end(); ++chunk) {
+            uint32_t *histogram = histograms + chunk * numBuckets;
+            const unsigned end = std::min(numElems, (chunk + 1) * chunkSize);
+            for (unsigned i = chunk * chunkSize; i < end; ++i) {
+                const uint32_t bucket = (EXTRACT_KEY32(src[i], SORT_KEY_OFFSET) >> SHIFT) & mask;
+                dst[histogram[bucket]++] = src[i];
+            }
+        }
+    });
+}
+
+// Serial stable counting sort pass on an 8-bit digit, used to finish off the
+// buckets produced by the MSB pass.
+template<typename T, unsigned SORT_KEY_OFFSET>
+inline void
+radixPass8(unsigned numElems, const T *src, T *dst, unsigned shift)
+{
+    uint32_t histogram[256] = {};
+    for (unsigned i = 0; i < numElems; ++i) {
+        ++histogram[(EXTRACT_KEY32(src[i], SORT_KEY_OFFSET) >> shift) & 0xff];
+    }
+
+    uint32_t acc = 0;
+    for (unsigned i = 0; i < 256; ++i) {
+        const uint32_t a = histogram[i] + acc;
+        histogram[i] = acc;
+        acc = a;
+    }
+
+    for (unsigned i = 0; i < numElems; ++i) {
+        const uint32_t bucket = (EXTRACT_KEY32(src[i], SORT_KEY_OFFSET) >> shift) & 0xff;
+        dst[histogram[bucket]++] = src[i];
+    }
+}
+
+} // namespace detail
+
+// Parallel least significant digit radix sort of a 32-bit key, using four 8-bit
+// passes so that the result ends up back in elems.
+template<typename T, unsigned SORT_KEY_OFFSET = 0>
+inline void
+parallelInPlaceRadixSort32(unsigned numElems, T *elems, alloc::Arena *arena)
+{
+    MNRY_ASSERT(arena);
+
+    const uint32_t numBuckets = 1 << 8;
+    const unsigned numChunks = detail::getParallelRadixChunkCount(numElems);
+
+    SCOPED_ARENA_MARKER(arena);
+    T *scratch = arena->allocArray<T>(numElems, CACHE_LINE_SIZE);
+    uint32_t *histograms = arena->allocArray<uint32_t>(numChunks * numBuckets, CACHE_LINE_SIZE);
+    MNRY_ASSERT(scratch && histograms);
+
+    detail::parallelRadixPass<T, SORT_KEY_OFFSET,  0, 8>(numElems, elems, scratch, numChunks, histograms);
+    detail::parallelRadixPass<T, SORT_KEY_OFFSET,  8, 8>(numElems, scratch, elems, numChunks, histograms);
+    detail::parallelRadixPass<T, SORT_KEY_OFFSET, 16, 8>(numElems, elems, scratch, numChunks, histograms);
+    detail::parallelRadixPass<T, SORT_KEY_OFFSET, 24, 8>(numElems, scratch, elems, numChunks, histograms);
+}
+
+// Same as parallelInPlaceRadixSort32 but faster if sort key only uses least
+// significant 22 bits.
+template<typename T, unsigned SORT_KEY_OFFSET = 0>
+inline void
+parallelInPlaceRadixSort22(unsigned numElems, T *elems, alloc::Arena *arena)
+{
+    MNRY_ASSERT(arena);
+
+    const uint32_t numBuckets = 1 << 11;
+    const unsigned numChunks = detail::getParallelRadixChunkCount(numElems);
+
+    SCOPED_ARENA_MARKER(arena);
+    T *scratch = arena->allocArray<T>(numElems, CACHE_LINE_SIZE);
+    uint32_t *histograms = arena->allocArray<uint32_t>(numChunks * numBuckets, CACHE_LINE_SIZE);
+    MNRY_ASSERT(scratch && histograms);
+
+    detail::parallelRadixPass<T, SORT_KEY_OFFSET,  0, 11>(numElems, elems, scratch, numChunks, histograms);
+    detail::parallelRadixPass<T, SORT_KEY_OFFSET, 11, 11>(numElems, scratch, elems, numChunks, histograms);
+}
+
+// Parallel most significant digit radix sort of a 32-bit key. The first pass
+// partitions on the top 8 bits in parallel, after which each of the 256
+// buckets is independently finished with a serial LSD sort on the remaining
+// 24 bits, with the buckets spread across threads. This touches memory in a
+// more cache friendly way than the LSD version once the input is much larger
+// than the LLC, at the cost of load imbalance on heavily skewed keys.
+template<typename T, unsigned SORT_KEY_OFFSET = 0>
+inline void
+parallelInPlaceRadixSortMSB32(unsigned numElems, T *elems, alloc::Arena *arena)
+{
+    MNRY_ASSERT(arena);
+
+    const uint32_t numBuckets = 1 << 8;
+    const unsigned numChunks = detail::getParallelRadixChunkCount(numElems);
+
+    SCOPED_ARENA_MARKER(arena);
+    T *scratch = arena->allocArray<T>(numElems, CACHE_LINE_SIZE);
+    uint32_t *histograms = arena->allocArray<uint32_t>(numChunks * numBuckets, CACHE_LINE_SIZE);
+    MNRY_ASSERT(scratch && histograms);
+
+    detail::parallelRadixPass<T, SORT_KEY_OFFSET, 24, 8>(numElems, elems, scratch, numChunks, histograms);
+
+    // After the scatter, the first chunk's offsets hold the start of each bucket.
+    uint32_t bucketStart[numBuckets + 1];
+    for (uint32_t bucket = 0; bucket < numBuckets; ++bucket) {
+        bucketStart[bucket] = (bucket == 0) ? 0 : histograms[(numChunks - 1) * numBuckets + bucket - 1];
+    }
+    bucketStart[numBuckets] = numElems;
+
+    // Sorting each bucket on the low 24 bits in 3 passes leaves the result back
+    // in elems, using the bucket's own range of elems as the second buffer.
+    tbb::parallel_for(tbb::blocked_range<unsigned>(0, numBuckets, 1),
+                      [&](const tbb::blocked_range<unsigned> &range) {
+        for (unsigned bucket = range.begin(); bucket != range.end(); ++bucket) {
+            const unsigned start = bucketStart[bucket];
+            const unsigned count = bucketStart[bucket + 1] - start;
+            detail::radixPass8<T, SORT_KEY_OFFSET>(count, scratch + start, elems + start, 0);
+            detail::radixPass8<T, SORT_KEY_OFFSET>(count, elems + start, scratch + start, 8);
+            detail::radixPass8<T, SORT_KEY_OFFSET>(count, scratch + start, elems + start, 16);
+        }
+    });
+}
+
+// Picks between the serial and parallel sorts based on the element count.
+// Below PARALLEL_CUTOFF the cost of spinning up tasks outweighs the gain. The
+// default is a conservative starting point; the crossover depends on the core
+// count and entry size, so measure it with "renderUtilBench radixSort".
+template<typename T, unsigned SORT_KEY_OFFSET = 0, unsigned STD_SORT_CUTOFF = 200,
+         unsigned PARALLEL_CUTOFF = 128 * 1024>
+inline void
+inPlaceParallelSort32(unsigned numElems, T *elems, alloc::Arena *arena)
+{
+    if (numElems < PARALLEL_CUTOFF) {
+        inPlaceSort32<T, SORT_KEY_OFFSET, STD_SORT_CUTOFF>(numElems, elems, arena);
+    } else {
+        parallelInPlaceRadixSort32<T, SORT_KEY_OFFSET>(numElems, elems, arena);
+    }
+
+    MNRY_ASSERT( (isSorted32<T, SORT_KEY_OFFSET>(numElems, elems)) );
+}
+
+//-----------------------------------------------------------------------------
+
 } // namespace util
 } // namespace scene_rdl2
 
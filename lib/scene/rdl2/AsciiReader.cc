@@ -28,6 +28,7 @@
 #include <scene_rdl2/common/except/exceptions.h>
 #include <scene_rdl2/render/util/Alloc.h>
 #include <scene_rdl2/render/util/BitUtils.h>
+#include <scene_rdl2/render/util/LuaStatePool.h>
 #include <scene_rdl2/render/util/Strings.h>
 #include <scene_rdl2/render/logging/logging.h>
 
@@ -159,6 +160,13 @@ struct Undef {
 }
 static Undef undef;
 
+util::LuaStatePool&
+getLuaStatePool()
+{
+    static util::LuaStatePool pool(4); // max idle states
+    return pool;
+}
+
 } // namespace
 
 const char AsciiReader::LUA_REGISTRY_KEY = 'k';
@@ -184,17 +192,51 @@ const char* AsciiReader::UNDEF_VALUE_METATABLE = "rdl2_Undef";
 
 AsciiReader::AsciiReader(SceneContext& context) :
     mContext(context),
-    mLua(luaL_newstate()),
+    mLua(getLuaStatePool().acquire()),
     mWarningsAsErrors(false)
 {
+    // A pooled Lua state is already initialized and reset to just after the
+    // support library was loaded, so only the per reader setup is needed.
     if (!mLua) {
-        throw except::RuntimeError("Could not initialize Lua interpreter.");
+        mLua = luaL_newstate();
+        if (!mLua) {
+            throw except::RuntimeError("Could not initialize Lua interpreter.");
+        }
+        initLuaState();
     }
 
     // Squirrel way a pointer to "this" in the Lua registry so we know which
     // object instance to forward callbacks to.
     storeInstancePtr();
 
+    // Export the SceneVariables global. This is a raw set which bypasses the
+    // support library's global table metatable, so SceneVariables stays an
+    // undeclared global the same as a global set before the library is loaded.
+    lua_pushglobaltable(mLua);
+    lua_pushstring(mLua, "SceneVariables");
+    boxPtr(SCENE_OBJECT_METATABLE, &(mContext.getSceneVariables()));
+    lua_rawset(mLua, -3);
+    lua_pop(mLua, 1);
+}
+
+AsciiReader::~AsciiReader()
+{
+    if (mLua) {
+        // Reset to the snapshot state and keep it for the next AsciiReader.
+        getLuaStatePool().release(mLua);
+    }
+
+}
+
+void
+AsciiReader::setLuaStatePoolSize(size_t maxIdle)
+{
+    getLuaStatePool().setMaxIdle(maxIdle);
+}
+
+void
+AsciiReader::initLuaState()
+{
     // Open Lua libraries. Perhaps constrain this in the future. Do we really
     // need/want all the standard libs?
     luaL_openlibs(mLua);
@@ -224,10 +266,6 @@ AsciiReader::AsciiReader(SceneContext& context) :
     lua_register(mLua, "blur", RDL2_LUA_FUNCPTR(blurredValueCreate));
     lua_register(mLua, "undef", RDL2_LUA_FUNCPTR(undefValueCreate));
 
-    // Export the SceneVariables global.
-    boxPtr(SCENE_OBJECT_METATABLE, &(mContext.getSceneVariables()));
-    lua_setglobal(mLua, "SceneVariables");
-
     // Load support library, which is binary bytecode included from rdlalib.cc
     // (which is generated on the fly during a build from the Lua source code).
     if (luaL_loadbuffer(mLua, reinterpret_cast<const char*>(bin2cc_data), bin2cc_len, "RDLA Support Library") != LUA_OK) {
@@ -238,14 +276,10 @@ AsciiReader::AsciiReader(SceneContext& context) :
         std::cerr << "luaL_pcall failed" << std::endl;
         throw except::RuntimeError("Could not load RDLA support library.");
     }
-}
-
-AsciiReader::~AsciiReader()
-{
-    if (mLua) {
-        lua_close(mLua);
-    }
 
+    // Everything above is shared by all the readers. release() of the pool
+    // resets the state back to here.
+    util::LuaStatePool::snapshotGlobals(mLua);
 }
 
 void
@@ -277,7 +311,9 @@ AsciiReader::fromString(const std::string& code, const std::string& chunkName)
     // anything interesting. (This just does what luaL_dostring() does, we've
     // just expanded it here because we'd like to control the "name" of the
     // chunk for nice error messages.)
-    if (luaL_loadbuffer(mLua, code.c_str(), code.size(), chunkName.c_str()) ||
+    // Compiled chunk is cached, so reading the same RDL text again skips
+    // the compile.
+    if (util::LuaChunkCache::get().load(mLua, code, chunkName) ||
             lua_pcall(mLua, 0, LUA_MULTRET, 0)) {
         std::string errorMessage("RDLA Error: ");
         errorMessage.append(lua_tostring(mLua, -1));
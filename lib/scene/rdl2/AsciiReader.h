@@ -102,7 +102,22 @@ public:
      */
     finline void setWarningsAsErrors(bool warningsAsErrors);
 
+    /**
+     * Sets the max number of initialized Lua states kept for reuse by the
+     * following AsciiReaders. Each reader takes a pooled state if available
+     * and gives it back reset to just after the RDLA support library was
+     * loaded, which saves the interpreter setup of every reader. 0 disables
+     * the pooling. Default is 4.
+     *
+     * @param   maxIdle     Max number of pooled Lua states.
+     */
+    static void setLuaStatePoolSize(size_t maxIdle);
+
 private:
+    // Opens Lua libraries, creates metatables, registers callbacks and loads
+    // the RDLA support library. This is done once per pooled Lua state.
+    void initLuaState();
+
     // This squirrels away the "this" pointer of this AsciiReader instance
     // within the Lua interpreter registry. This is used for figuring out which
     // instance of AsciiReader to dispatch to when Lua callbacks are invoked
@@ -0,0 +1,192 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+// Include this before any other includes!
+#include <scene_rdl2/common/platform/Platform.h>
+#include <scene_rdl2/common/except/exceptions.h>
+
+#include "Types.h"
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+/**
+ * Computes the offset of an attribute value of the given size and alignment
+ * in an attribute storage chunk which already holds storageSize bytes. This
+ * is the placement used by SceneClass::declareAttribute(), so it can be
+ * evaluated at compile time for SceneClasses with a fixed list of attributes.
+ *
+ * Our alignment strategy is to get reasonably good packing (maximize spatial
+ * locality) and alignment (maximize access speed) without trying to solve a
+ * full-on bin packing problem. It works as follows:
+ * - If the value is larger than a cache line, align it to the next cache line
+ *   boundary.
+ * - If the value is smaller than a cache line, first align it to the type's
+ *   alignment requirements. Then:
+ *   - If there isn't enough space left for it in the current cache line (it
+ *     would straddle cache lines), align it to the next cache line boundary.
+ *   - If there is enough space left for it in the current cache line, leave
+ *     it there, aligned on the type's alignment requirements.
+ *
+ * Of course, for this to actually work, the block of memory allocated for
+ * storing attribute values must be aligned on a cache line boundary.
+ */
+constexpr uint32_t
+placeAttribute(std::size_t storageSize, std::size_t size, std::size_t alignment)
+{
+    // Cache lines on all modern processors are 64 bytes.
+    const std::size_t cacheLineSize = 64;
+
+    // Where is the next cache line boundary?
+    const std::size_t nextBoundary = (storageSize % cacheLineSize == 0) ?
+        storageSize : ((storageSize / cacheLineSize) + 1) * cacheLineSize;
+
+    if (size >= cacheLineSize) {
+        return nextBoundary;
+    }
+
+    // What is the padding we need to get to the alignment of the type?
+    const std::size_t misalignment = storageSize % alignment;
+    const std::size_t padding = (misalignment == 0) ? 0 : alignment - misalignment;
+    const std::size_t typeOffset = storageSize + padding;
+
+    // Bump it to the next cache line if it doesn't fit on this one.
+    return (typeOffset + size <= nextBoundary) ? typeOffset : nextBoundary;
+}
+
+/**
+ * One attribute of a compile-time attribute layout. See layoutEntry().
+ */
+struct AttributeLayoutEntry
+{
+    const char* mName;
+    AttributeType mType;
+    AttributeFlags mFlags;
+    std::size_t mSize;      // of all its timesteps
+    std::size_t mAlignment;
+};
+
+/**
+ * Describes an attribute declared with declareAttribute<T>(name, ..., flags).
+ */
+template <typename T>
+constexpr AttributeLayoutEntry
+layoutEntry(const char* name, AttributeFlags flags = FLAGS_NONE)
+{
+    // If the type is blurrable, we are storing an array of length NUM_TIMESTEPS.
+    return AttributeLayoutEntry {
+        name,
+        attributeType<T>(),
+        flags,
+        (static_cast<int>(flags) & FLAGS_BLURRABLE) ? sizeof(T[NUM_TIMESTEPS]) : sizeof(T),
+        alignof(T)
+    };
+}
+
+/**
+ * A FixedAttributeKey is an AttributeKey whose index and offset are known at
+ * compile time. It is computed with fixedAttributeKey() from the layout of a
+ * built-in SceneClass, and SceneObject::get() with a constexpr
+ * FixedAttributeKey compiles down to a load at a fixed offset from the
+ * attribute storage, without reading the offset from the key.
+ *
+ * It is only valid for SceneObjects of the SceneClass whose layout it was
+ * computed from. That SceneClass checks its layout when it is declared (see
+ * SceneClass::checkAttributeLayout()).
+ */
+template <typename T>
+class FixedAttributeKey
+{
+public:
+    typedef T Type;
+
+    constexpr FixedAttributeKey(uint32_t index, uint32_t offset, bool blurrable) :
+        mIndex(index),
+        mOffset(offset),
+        mBlurrable(blurrable)
+    {
+    }
+
+    constexpr uint32_t getIndex() const { return mIndex; }
+    constexpr uint32_t getOffset() const { return mOffset; }
+    constexpr bool isBlurrable() const { return mBlurrable; }
+
+private:
+    uint32_t mIndex;
+    uint32_t mOffset;
+    bool mBlurrable;
+};
+
+namespace layout_detail {
+
+constexpr bool
+equalNames(const char* a, const char* b)
+{
+    while (*a != '\0' && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return *a == *b;
+}
+
+} // namespace layout_detail
+
+/**
+ * Index of the named attribute in the layout. Fails to compile (or throws
+ * an except::KeyError at runtime) if there is no such attribute.
+ */
+template <std::size_t N>
+constexpr std::size_t
+layoutIndex(const AttributeLayoutEntry (&layout)[N], const char* name)
+{
+    for (std::size_t i = 0; i < N; ++i) {
+        if (layout_detail::equalNames(layout[i].mName, name)) {
+            return i;
+        }
+    }
+    throw except::KeyError("No attribute with that name in the attribute layout.");
+}
+
+/**
+ * Offset of the attribute at the given index, as placed by
+ * SceneClass::declareAttribute() when the attributes are declared in layout
+ * order.
+ */
+template <std::size_t N>
+constexpr uint32_t
+layoutOffset(const AttributeLayoutEntry (&layout)[N], std::size_t index)
+{
+    std::size_t storageSize = 0;
+    uint32_t offset = 0;
+    for (std::size_t i = 0; i <= index; ++i) {
+        offset = placeAttribute(storageSize, layout[i].mSize, layout[i].mAlignment);
+        storageSize = offset + layout[i].mSize;
+    }
+    return offset;
+}
+
+/**
+ * Computes the key of the named attribute. Fails to compile (or throws at
+ * runtime) if there is no such attribute or if T doesn't match its type.
+ */
+template <typename T, std::size_t N>
+constexpr FixedAttributeKey<T>
+fixedAttributeKey(const AttributeLayoutEntry (&layout)[N], const char* name)
+{
+    const std::size_t index = layoutIndex(layout, name);
+    if (layout[index].mType != attributeType<T>()) {
+        throw except::TypeError("Attribute layout type does not match the key type.");
+    }
+    return FixedAttributeKey<T>(index, layoutOffset(layout, index),
+                                static_cast<int>(layout[index].mFlags) & FLAGS_BLURRABLE);
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
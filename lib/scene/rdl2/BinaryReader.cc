@@ -21,6 +21,7 @@
 #include "VolumeShader.h"
 #include "ValueContainerDeq.h"
 
+#include <scene_rdl2/common/rec_time/RecScopeProfiler.h>
 #include <scene_rdl2/render/logging/logging.h>
 #include <scene_rdl2/common/except/exceptions.h>
 #include <scene_rdl2/render/util/Strings.h>
@@ -31,6 +32,8 @@
 #include <sstream>
 #include <string>
 #include <stdint.h>
+#include <utility>
+#include <vector>
 
 #ifdef __APPLE__
 #include <libkern/OSByteOrder.h>
@@ -71,30 +74,51 @@ BinaryReader::fromFile(const std::string& filename)
 void
 BinaryReader::fromStream(std::istream& input)
 {
-    // Read the manifest length from the stream and convert to native byte order.
-    uint64_t manifestLen;
-    input.read(reinterpret_cast<char*>(&manifestLen), sizeof(uint64_t));
-    manifestLen = be64toh(manifestLen);
+    std::string manifest;
+    std::string payload;
+    readFramedBytes(input, manifest, payload);
 
-    // Read the payload length from the stream and convert to native byte order.
+    fromBytes(manifest, payload);
+}
+
+// static function
+void
+BinaryReader::readFramedBytes(std::istream& input, std::string& manifest, std::string& payload)
+{
+    uint64_t manifestLen;
     uint64_t payloadLen;
-    input.read(reinterpret_cast<char*>(&payloadLen), sizeof(uint64_t));
-    payloadLen = be64toh(payloadLen);
+    readFrameHeader(input, manifestLen, payloadLen);
 
     // Read the manifest.
-    std::string manifest(manifestLen, '\0');
+    manifest.assign(manifestLen, '\0');
     input.read(&(manifest[0]), manifestLen);
 
     // Read the payload.
-    std::string payload(payloadLen, '\0');
+    payload.assign(payloadLen, '\0');
     input.read(&(payload[0]), payloadLen);
+}
 
-    fromBytes(manifest, payload);
+// static function
+void
+BinaryReader::readFrameHeader(std::istream& input, uint64_t& manifestLen, uint64_t& payloadLen)
+{
+    // Read the manifest length from the stream and convert to native byte order.
+    manifestLen = 0;
+    input.read(reinterpret_cast<char*>(&manifestLen), sizeof(uint64_t));
+    manifestLen = be64toh(manifestLen);
+
+    // Read the payload length from the stream and convert to native byte order.
+    payloadLen = 0;
+    input.read(reinterpret_cast<char*>(&payloadLen), sizeof(uint64_t));
+    payloadLen = be64toh(payloadLen);
 }
 
 void
 BinaryReader::fromBytes(const std::string& manifest, const std::string& payload)
 {
+    REC_SCOPE_PROFILE("BinaryReader::fromBytes");
+    REC_SCOPE_COUNTER("BinaryReader payload bytes", payload.size());
+
     Slice manifestBytes(manifest);
     Slice payloadBytes(payload);
 
@@ -130,6 +154,96 @@ BinaryReader::fromBytes(const std::string& manifest, const std::string& payload)
     }
 }
 
+// static function
+void
+BinaryReader::streamRecords(std::istream& input, const RecordFilter& filter,
+                            const RecordCallback& callback)
+{
+    // Read the manifest length and payload length, then the manifest.
+    uint64_t manifestLen;
+    uint64_t payloadLen;
+    readFrameHeader(input, manifestLen, payloadLen);
+
+    std::string manifest(manifestLen, '\0');
+    input.read(&(manifest[0]), manifestLen);
+
+    RecordInfoVector records;
+    readManifest(Slice(manifest), records);
+
+    // Records are laid out back to back in the payload, in manifest order.
+    for (const RecordInfo& info : records) {
+        if (info.mType != SCENE_OBJECT_2) {
+            std::stringstream errMsg;
+            if (info.mType == SCENE_OBJECT) {
+                errMsg << "SCENE_OBJECT payload type is nolonger supported";
+            } else {
+                errMsg << "Encountered unknown payload type '" << info.mType <<
+                    "' in manifest while parsing RDL2 binary file.";
+            }
+            throw except::TypeError(errMsg.str());
+        }
+
+        std::string record(info.mSize, '\0');
+        if (!input.read(&(record[0]), info.mSize)) {
+            throw except::IoError("Unexpected end of RDL2 binary payload.");
+        }
+
+        if (filter) {
+            std::string klassName;
+            std::string objName;
+            readRecordNames(Slice(record), klassName, objName);
+            if (!filter(klassName, objName)) continue;
+        }
+        callback(std::move(record));
+    }
+}
+
+SceneObject*
+BinaryReader::fromRecord(const std::string& record)
+{
+    return readSceneObject(Slice(record));
+}
+
+SceneObject*
+BinaryReader::fromRecord(Slice record)
+{
+    return readSceneObject(record);
+}
+
+// static function
+void
+BinaryReader::splitRecords(const std::string& manifest, const std::string& payload,
+                           std::vector<Slice>& records)
+{
+    RecordInfoVector infos;
+    readManifest(Slice(manifest), infos);
+
+    Slice payloadBytes(payload);
+    records.reserve(records.size() + infos.size());
+    for (const RecordInfo& info : infos) {
+        if (info.mType != SCENE_OBJECT_2) {
+            std::stringstream errMsg;
+            if (info.mType == SCENE_OBJECT) {
+                errMsg << "SCENE_OBJECT payload type is nolonger supported";
+            } else {
+                errMsg << "Encountered unknown payload type '" << info.mType <<
+                    "' in manifest while parsing RDL2 binary file.";
+            }
+            throw except::TypeError(errMsg.str());
+        }
+        records.emplace_back(payloadBytes, info.mOffset, info.mSize);
+    }
+}
+
+// static function
+void
+BinaryReader::readRecordNames(Slice record, std::string& className, std::string& objectName)
+{
+    ValueContainerDeq vContainerDeq(static_cast<const char *>(record.getData()), record.getLength());
+    vContainerDeq.deqString(className);
+    vContainerDeq.deqString(objectName);
+}
+
 // static function    
 std::string
 BinaryReader::showManifest(const std::string& manifest)
@@ -159,6 +273,7 @@ BinaryReader::showManifest(const std::string& manifest)
     return ostr.str();
 }
 
+// static function
 void
 BinaryReader::readManifest(Slice bytes, RecordInfoVector& info)
 {
@@ -178,7 +293,7 @@ BinaryReader::readManifest(Slice bytes, RecordInfoVector& info)
     }
 }
 
-void
+SceneObject*
 BinaryReader::readSceneObject(Slice bytes)
 {
     const char *ptr = static_cast<const char *>(bytes.getData());
@@ -201,11 +316,12 @@ BinaryReader::readSceneObject(Slice bytes)
         } else {
             logging::Logger::warn(msg);
         }
-        return;
+        return nullptr;
     }
 
     // Unpack the data into the object.
     unpackSceneObject(vContainerDeq, *sceneObject);
+    return sceneObject;
 }
 
 void
@@ -443,6 +559,12 @@ BinaryReader::unpackValue(ValueContainerDeq &vContainerDeq,
     {
         unsigned char uc;
         vContainerDeq.deqUChar(uc);
+        if (uc & ValueContainerUtil::timestepRangesFlag) {
+            const unsigned char ts = uc & ~ValueContainerUtil::timestepRangesFlag;
+            unpackChangedRanges(vContainerDeq, sceneObject, valueType, static_cast<AttributeTimestep>(ts),
+                                transientEncoding, attributeId, attributeName);
+            return;
+        }
         timestepInt = static_cast<int>(uc);
     }
     AttributeTimestep timestep = static_cast<AttributeTimestep>(static_cast<int>(timestepInt));
@@ -648,6 +770,85 @@ BinaryReader::unpackValue(ValueContainerDeq &vContainerDeq,
     }
 }
 
+void
+BinaryReader::unpackChangedRanges(ValueContainerDeq &vContainerDeq,
+                                  SceneObject &sceneObject,
+                                  ValueContainerUtil::ValueType valueType,
+                                  AttributeTimestep timestep,
+                                  bool transientEncoding,
+                                  int attributeId,
+                                  std::string &attributeName) const
+{
+#define UNPACK_RANGES(type) \
+    unpackChangedRanges<type>(vContainerDeq, sceneObject, timestep, transientEncoding, attributeId, attributeName)
+
+    switch (valueType) {
+    case ValueContainerUtil::ValueType::INT_VECTOR :    UNPACK_RANGES(Int); break;
+    case ValueContainerUtil::ValueType::LONG_VECTOR :   UNPACK_RANGES(Long); break;
+    case ValueContainerUtil::ValueType::FLOAT_VECTOR :  UNPACK_RANGES(Float); break;
+    case ValueContainerUtil::ValueType::DOUBLE_VECTOR : UNPACK_RANGES(Double); break;
+    case ValueContainerUtil::ValueType::RGB_VECTOR :    UNPACK_RANGES(Rgb); break;
+    case ValueContainerUtil::ValueType::RGBA_VECTOR :   UNPACK_RANGES(Rgba); break;
+    case ValueContainerUtil::ValueType::VEC2F_VECTOR :  UNPACK_RANGES(Vec2f); break;
+    case ValueContainerUtil::ValueType::VEC2D_VECTOR :  UNPACK_RANGES(Vec2d); break;
+    case ValueContainerUtil::ValueType::VEC3F_VECTOR :  UNPACK_RANGES(Vec3f); break;
+    case ValueContainerUtil::ValueType::VEC3D_VECTOR :  UNPACK_RANGES(Vec3d); break;
+    case ValueContainerUtil::ValueType::VEC4F_VECTOR :  UNPACK_RANGES(Vec4f); break;
+    case ValueContainerUtil::ValueType::VEC4D_VECTOR :  UNPACK_RANGES(Vec4d); break;
+    case ValueContainerUtil::ValueType::MAT4F_VECTOR :  UNPACK_RANGES(Mat4f); break;
+    case ValueContainerUtil::ValueType::MAT4D_VECTOR :  UNPACK_RANGES(Mat4d); break;
+    default : {
+        // The rest of the value can't be skipped, the stream is unusable.
+        throw except::RuntimeError(util::buildString("Attribute '", attributeName, "' of SceneObject '",
+                                                     sceneObject.getName(), "' has changed element ranges,"
+                                                     " but its type doesn't support them."));
+    }
+    }
+
+#undef UNPACK_RANGES
+}
+
+template <typename T>
+void
+BinaryReader::unpackChangedRanges(ValueContainerDeq &vContainerDeq,
+                                  SceneObject &sceneObject,
+                                  AttributeTimestep timestep,
+                                  bool transientEncoding,
+                                  int attributeId,
+                                  std::string &attributeName) const
+{
+    // Dequeue everything before looking up the attribute. An unknown
+    // attribute or a size mismatch throws, and unless warnings are errors
+    // unpackSceneObject() logs it and goes on with the next attribute, which
+    // must start right after these ranges.
+    const size_t size = vContainerDeq.deqVLSizeT();
+    const size_t rangeCount = vContainerDeq.deqVLSizeT();
+    std::vector<std::pair<size_t, std::vector<T>>> ranges(rangeCount);
+    for (auto& range : ranges) {
+        range.first = vContainerDeq.deqVLSizeT();
+        range.second.resize(vContainerDeq.deqVLSizeT());
+        vContainerDeq.deqByteData(range.second.data(), range.second.size() * sizeof(T));
+    }
+
+    const SceneClass& sceneClass = sceneObject.getSceneClass();
+    AttributeKey<std::vector<T>> key =
+        keyGen<std::vector<T>>(transientEncoding, attributeId, attributeName, sceneClass);
+
+    // The ranges patch the vector the writer had at its last commit, which
+    // must be what we have too.
+    const size_t currentSize = sceneObject.get(key, timestep).size();
+    if (currentSize != size) {
+        throw except::TypeError(util::buildString("Changed element ranges of attribute '",
+                                                  sceneClass.getAttribute(key)->getName(),
+                                                  "' of SceneObject '", sceneObject.getName(),
+                                                  "' are for ", size, " elements, but it has ",
+                                                  currentSize, "."));
+    }
+    for (const auto& range : ranges) {
+        sceneObject.setRange(key, range.first, range.second, timestep);
+    }
+}
+
 void
 BinaryReader::unpackLayerValue(ValueContainerDeq &vContainerDeq,
                                BinaryReaderLayerUnpackStrings &layerStrVectors,
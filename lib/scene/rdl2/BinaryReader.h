@@ -11,6 +11,7 @@
 #include "SceneClass.h"
 
 #include <cstddef>
+#include <functional>
 #include <istream>
 #include <string>
 #include <vector>
@@ -143,6 +144,85 @@ public:
      */
     void fromBytes(const std::string& manifest, const std::string& payload);
 
+    /**
+     * Reads the manifest and payload of framed RDL binary from the given
+     * input stream without decoding them, so they can be read ahead of
+     * fromBytes() (which is what fromStream() does).
+     *
+     * @param   input       The generic input stream to read framed RDL binary from.
+     * @param   manifest    Receives the manifest data.
+     * @param   payload     Receives the payload data.
+     */
+    static void readFramedBytes(std::istream& input, std::string& manifest, std::string& payload);
+
+    typedef std::function<bool(const std::string& className,
+                               const std::string& objectName)> RecordFilter;
+    typedef std::function<void(std::string&& record)> RecordCallback;
+
+    /**
+     * Reads framed RDL binary from the given input stream one SceneObject
+     * record at a time, without decoding anything. Only the manifest and the
+     * current record are held in memory, so arbitrarily large files can be
+     * walked in bounded memory.
+     *
+     * The SceneClass and SceneObject names are read from each record header
+     * and passed to the filter (if any) first. Rejected records are skipped,
+     * accepted ones are passed to the callback in file order. They can be
+     * decoded later with fromRecord(), possibly by another BinaryReader.
+     *
+     * @param   input       The generic input stream to read framed RDL binary from.
+     * @param   filter      Returns true for the records to pass on. May be empty.
+     * @param   callback    Receives the bytes of each accepted record.
+     * @throw   except::IoError     If the stream ends before the payload does.
+     * @throw   except::TypeError   If the manifest has an unsupported record type.
+     */
+    static void streamRecords(std::istream& input, const RecordFilter& filter,
+                              const RecordCallback& callback);
+
+    /**
+     * Decodes a single SceneObject record, as given by streamRecords(), into
+     * the SceneContext.
+     *
+     * @param   record  Byte string containing one SceneObject record.
+     * @return  The decoded SceneObject, or nullptr if its SceneClass couldn't
+     *          be loaded and warnings are not errors.
+     */
+    SceneObject* fromRecord(const std::string& record);
+
+    /**
+     * Same as fromRecord(const std::string&), but decodes directly from the
+     * given bytes (e.g. a record inside a memory mapping) without copying
+     * them first.
+     *
+     * @param   record  Bytes of one SceneObject record.
+     * @return  The decoded SceneObject, or nullptr if its SceneClass couldn't
+     *          be loaded and warnings are not errors.
+     */
+    SceneObject* fromRecord(Slice record);
+
+    /**
+     * Splits an unframed manifest and payload, as given by
+     * BinaryWriter::toBytes(), into their SceneObject records without
+     * decoding anything. The returned Slices point into the payload.
+     *
+     * @param   manifest    Byte string containing the manifest data.
+     * @param   payload     Byte string containing the payload data.
+     * @param   records     Receives one Slice per record, in payload order.
+     * @throw   except::TypeError   If the manifest has an unsupported record type.
+     */
+    static void splitRecords(const std::string& manifest, const std::string& payload,
+                             std::vector<Slice>& records);
+
+    /**
+     * Reads the SceneClass and SceneObject names from the header of a
+     * SceneObject record, without decoding the rest of it.
+     *
+     * @param   record      Bytes of one SceneObject record.
+     * @param   className   Receives the SceneClass name.
+     * @param   objectName  Receives the SceneObject name.
+     */
+    static void readRecordNames(Slice record, std::string& className, std::string& objectName);
+
     /**
      * When enabled, questionable actions which may be mistakes (such as trying
      * to set an attribute which doesn't exist) will cause an error rather than
@@ -170,11 +250,15 @@ private:
     };
     typedef std::vector<RecordInfo> RecordInfoVector;
 
+    // Helper function to read mlen and plen, in native byte order, from the
+    // start of framed RDL binary.
+    static void readFrameHeader(std::istream& input, uint64_t& manifestLen, uint64_t& payloadLen);
+
     // Helper function to decode the manifest and compute message offsets.
-    void readManifest(Slice bytes, RecordInfoVector& info);
+    static void readManifest(Slice bytes, RecordInfoVector& info);
 
     // Helper function for reading SceneObject messages out of the payload.
-    void readSceneObject(Slice bytes);
+    SceneObject* readSceneObject(Slice bytes);
 
     // Helper function for unpacking a Layer object one assignment
     // at a time
@@ -192,6 +276,16 @@ private:
     void unpackLayerValue(ValueContainerDeq &vContainerDeq, BinaryReaderLayerUnpackStrings &layerStrVectors,
                           ValueContainerUtil::ValueType valueType, const std::string &attrName) const;
 
+    // Helper functions for patching the element ranges of a vector attribute
+    // sent by delta encoding (see SceneObject::setRange()) into a SceneObject.
+    void unpackChangedRanges(ValueContainerDeq &vContainerDeq, SceneObject &sceneObject,
+                             ValueContainerUtil::ValueType valueType, AttributeTimestep timestep,
+                             bool transientEncoding, int attributeId, std::string &attributeName) const;
+    template <typename T>
+    void unpackChangedRanges(ValueContainerDeq &vContainerDeq, SceneObject &sceneObject,
+                             AttributeTimestep timestep,
+                             bool transientEncoding, int attributeId, std::string &attributeName) const;
+
     // Generate attribute key
     template <typename T> AttributeKey<T> keyGen(bool transientEncoding, int attrId, std::string &attrName,
                                                  const SceneClass &sceneClass) const {
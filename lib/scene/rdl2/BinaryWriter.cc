@@ -20,6 +20,7 @@
 #include <sstream>
 #include <string>
 #include <stdint.h>
+#include <vector>
 
 #ifdef __APPLE__
 #include <libkern/OSByteOrder.h>
@@ -45,6 +46,65 @@ isSkippedInSplitMode(const SceneObject& so)
             so.isA<Metadata>());
 }
 
+// Sends the element ranges of a vector changed by SceneObject::setRange()
+// instead of the whole vector. Returns false, and enqueues nothing, when the
+// whole vector should be sent: the attribute isn't tracked by ranges or more
+// than half of it changed.
+template <typename T>
+bool
+packChangedRanges(const SceneObject& sObj, const Attribute& attr, int timeStep,
+                  ValueContainerEnq& vContainerEnq)
+{
+    const AttributeTimestep timestep = static_cast<AttributeTimestep>(timeStep);
+    const SceneObject::ElementRanges* ranges = sObj.getChangedRanges(attr, timestep);
+    if (!ranges) {
+        return false;
+    }
+
+    const std::vector<T>& vec = sObj.get(AttributeKey<std::vector<T>>(attr), timestep);
+    size_t changedCount = 0;
+    for (const auto& range : *ranges) {
+        changedCount += range.second - range.first;
+    }
+    if (changedCount * 2 > vec.size()) {
+        return false;
+    }
+
+    vContainerEnq.enqUChar(static_cast<unsigned char>(timeStep) | ValueContainerUtil::timestepRangesFlag);
+    vContainerEnq.enqVLSizeT(vec.size());
+    vContainerEnq.enqVLSizeT(ranges->size());
+    for (const auto& range : *ranges) {
+        const size_t count = range.second - range.first;
+        vContainerEnq.enqVLSizeT(range.first);
+        vContainerEnq.enqVLSizeT(count);
+        vContainerEnq.enqByteData(vec.data() + range.first, count * sizeof(T));
+    }
+    return true;
+}
+
+bool
+packChangedRanges(const SceneObject& sObj, const Attribute& attr, int timeStep,
+                  ValueContainerEnq& vContainerEnq)
+{
+    switch (attr.getType()) {
+    case TYPE_INT_VECTOR:    return packChangedRanges<Int>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_LONG_VECTOR:   return packChangedRanges<Long>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_FLOAT_VECTOR:  return packChangedRanges<Float>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_DOUBLE_VECTOR: return packChangedRanges<Double>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_RGB_VECTOR:    return packChangedRanges<Rgb>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_RGBA_VECTOR:   return packChangedRanges<Rgba>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_VEC2F_VECTOR:  return packChangedRanges<Vec2f>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_VEC2D_VECTOR:  return packChangedRanges<Vec2d>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_VEC3F_VECTOR:  return packChangedRanges<Vec3f>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_VEC3D_VECTOR:  return packChangedRanges<Vec3d>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_VEC4F_VECTOR:  return packChangedRanges<Vec4f>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_VEC4D_VECTOR:  return packChangedRanges<Vec4d>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_MAT4F_VECTOR:  return packChangedRanges<Mat4f>(sObj, attr, timeStep, vContainerEnq);
+    case TYPE_MAT4D_VECTOR:  return packChangedRanges<Mat4d>(sObj, attr, timeStep, vContainerEnq);
+    default:                 return false;
+    }
+}
+
 } // namespace {
 
 BinaryWriter::BinaryWriter(const SceneContext& context) :
@@ -218,7 +278,10 @@ BinaryWriter::packSceneObject(const SceneObject& sceneObject, ValueContainerEnq
         // Set the value for each relevant timestep.
         int timestep = TIMESTEP_BEGIN;
         do {
-            packValue(sceneObject, attribute, timestep, vContainerEnq);
+            if (!mDeltaEncoding ||
+                !packChangedRanges(sceneObject, *attribute, timestep, vContainerEnq)) {
+                packValue(sceneObject, attribute, timestep, vContainerEnq);
+            }
             ++timestep;
         } while (attribute->isBlurrable() && timestep < NUM_TIMESTEPS);
     }
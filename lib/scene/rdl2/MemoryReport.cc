@@ -0,0 +1,299 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "MemoryReport.h"
+
+#include "Attribute.h"
+#include "AttributeKey.h"
+#include "SceneClass.h"
+#include "SceneContext.h"
+#include "SceneObject.h"
+
+#include <scene_rdl2/common/rec_time/RecScopeProfiler.h>
+#include <scene_rdl2/render/util/StrUtil.h>
+
+#include <boost/dynamic_bitset.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+namespace {
+
+struct ValueBytes
+{
+    std::size_t mCount = 0;
+    std::size_t mStorage = 0;
+    std::size_t mHeap = 0;
+};
+
+std::size_t
+stringHeapBytes(const std::string& str)
+{
+    // Short strings are stored in the std::string itself.
+    static const std::size_t inlineCapacity = std::string().capacity();
+    return (str.capacity() > inlineCapacity) ? str.capacity() + 1 : 0;
+}
+
+std::size_t
+changeMaskBytes(std::size_t numBits)
+{
+    // The boost::dynamic_bitset itself and its block vector.
+    typedef boost::dynamic_bitset<> Mask;
+    const std::size_t numBlocks = (numBits + Mask::bits_per_block - 1) / Mask::bits_per_block;
+    return sizeof(Mask) + numBlocks * sizeof(Mask::block_type);
+}
+
+template <typename T>
+std::size_t
+heapBytes(const T&)
+{
+    return 0;
+}
+
+std::size_t
+heapBytes(const String& value)
+{
+    return stringHeapBytes(value);
+}
+
+template <typename T>
+std::size_t
+heapBytes(const std::vector<T>& value)
+{
+    return value.capacity() * sizeof(T);
+}
+
+std::size_t
+heapBytes(const StringVector& value)
+{
+    std::size_t bytes = value.capacity() * sizeof(String);
+    for (const String& str : value) {
+        bytes += stringHeapBytes(str);
+    }
+    return bytes;
+}
+
+std::size_t
+heapBytes(const BoolVector& value)
+{
+    // Estimate for the libstdc++ layout: 512 byte blocks and a map of at
+    // least 8 block pointers.
+    const std::size_t blockSize = 512;
+    const std::size_t numBlocks = value.size() * sizeof(Bool) / blockSize + 1;
+    return numBlocks * blockSize + std::max<std::size_t>(8, numBlocks + 2) * sizeof(Bool*);
+}
+
+std::size_t
+heapBytes(const SceneObjectIndexable& value)
+{
+    return value.heap_bytes();
+}
+
+template <typename T>
+void
+measureValue(const SceneObject& sceneObject, const Attribute& attribute, ValueBytes& bytes)
+{
+    const AttributeKey<T> key(attribute);
+    const int numTimesteps = attribute.isBlurrable() ? NUM_TIMESTEPS : 1;
+    for (int timestep = TIMESTEP_BEGIN; timestep < numTimesteps; ++timestep) {
+        ++bytes.mCount;
+        bytes.mStorage += sizeof(T);
+        bytes.mHeap += heapBytes(sceneObject.get(key, static_cast<AttributeTimestep>(timestep)));
+    }
+}
+
+void
+measureAttribute(const SceneObject& sceneObject, const Attribute& attribute, ValueBytes& bytes)
+{
+    switch (attribute.getType()) {
+    case TYPE_BOOL:                   measureValue<Bool>(sceneObject, attribute, bytes); break;
+    case TYPE_INT:                    measureValue<Int>(sceneObject, attribute, bytes); break;
+    case TYPE_LONG:                   measureValue<Long>(sceneObject, attribute, bytes); break;
+    case TYPE_FLOAT:                  measureValue<Float>(sceneObject, attribute, bytes); break;
+    case TYPE_DOUBLE:                 measureValue<Double>(sceneObject, attribute, bytes); break;
+    case TYPE_STRING:                 measureValue<String>(sceneObject, attribute, bytes); break;
+    case TYPE_RGB:                    measureValue<Rgb>(sceneObject, attribute, bytes); break;
+    case TYPE_RGBA:                   measureValue<Rgba>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC2F:                  measureValue<Vec2f>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC2D:                  measureValue<Vec2d>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC3F:                  measureValue<Vec3f>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC3D:                  measureValue<Vec3d>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC4F:                  measureValue<Vec4f>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC4D:                  measureValue<Vec4d>(sceneObject, attribute, bytes); break;
+    case TYPE_MAT4F:                  measureValue<Mat4f>(sceneObject, attribute, bytes); break;
+    case TYPE_MAT4D:                  measureValue<Mat4d>(sceneObject, attribute, bytes); break;
+    case TYPE_SCENE_OBJECT:           measureValue<SceneObject*>(sceneObject, attribute, bytes); break;
+    case TYPE_BOOL_VECTOR:            measureValue<BoolVector>(sceneObject, attribute, bytes); break;
+    case TYPE_INT_VECTOR:             measureValue<IntVector>(sceneObject, attribute, bytes); break;
+    case TYPE_LONG_VECTOR:            measureValue<LongVector>(sceneObject, attribute, bytes); break;
+    case TYPE_FLOAT_VECTOR:           measureValue<FloatVector>(sceneObject, attribute, bytes); break;
+    case TYPE_DOUBLE_VECTOR:          measureValue<DoubleVector>(sceneObject, attribute, bytes); break;
+    case TYPE_STRING_VECTOR:          measureValue<StringVector>(sceneObject, attribute, bytes); break;
+    case TYPE_RGB_VECTOR:             measureValue<RgbVector>(sceneObject, attribute, bytes); break;
+    case TYPE_RGBA_VECTOR:            measureValue<RgbaVector>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC2F_VECTOR:           measureValue<Vec2fVector>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC2D_VECTOR:           measureValue<Vec2dVector>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC3F_VECTOR:           measureValue<Vec3fVector>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC3D_VECTOR:           measureValue<Vec3dVector>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC4F_VECTOR:           measureValue<Vec4fVector>(sceneObject, attribute, bytes); break;
+    case TYPE_VEC4D_VECTOR:           measureValue<Vec4dVector>(sceneObject, attribute, bytes); break;
+    case TYPE_MAT4F_VECTOR:           measureValue<Mat4fVector>(sceneObject, attribute, bytes); break;
+    case TYPE_MAT4D_VECTOR:           measureValue<Mat4dVector>(sceneObject, attribute, bytes); break;
+    case TYPE_SCENE_OBJECT_VECTOR:    measureValue<SceneObjectVector>(sceneObject, attribute, bytes); break;
+    case TYPE_SCENE_OBJECT_INDEXABLE: measureValue<SceneObjectIndexable>(sceneObject, attribute, bytes); break;
+    default: break;
+    }
+}
+
+void
+sortEntries(MemoryReport::EntryVector& entries)
+{
+    std::sort(entries.begin(), entries.end(),
+              [](const MemoryReport::Entry& a, const MemoryReport::Entry& b) {
+                  if (a.getTotalBytes() != b.getTotalBytes()) {
+                      return a.getTotalBytes() > b.getTotalBytes();
+                  }
+                  return (a.mClassName != b.mClassName) ? a.mClassName < b.mClassName : a.mName < b.mName;
+              });
+}
+
+void
+showEntries(std::ostringstream& ostr, const std::string& title, const MemoryReport::EntryVector& entries,
+            std::size_t topCount, bool showClass)
+{
+    const std::size_t count = std::min(topCount, entries.size());
+    ostr << title << " (top " << count << " of " << entries.size() << ")\n";
+    for (std::size_t i = 0; i < count; ++i) {
+        const MemoryReport::Entry& entry = entries[i];
+        ostr << "  " << std::setw(14) << std::right << str_util::byteStr(entry.getTotalBytes())
+             << "  storage " << std::setw(14) << std::right << str_util::byteStr(entry.mStorageBytes)
+             << "  heap " << std::setw(14) << std::right << str_util::byteStr(entry.mHeapBytes)
+             << "  count " << std::setw(8) << std::right << entry.mCount << "  ";
+        if (showClass) ostr << entry.mClassName << '.';
+        ostr << entry.mName << '\n';
+    }
+}
+
+} // namespace
+
+MemoryReport::MemoryReport(const SceneContext& context) :
+    mStorageBytes(0),
+    mHeapBytes(0)
+{
+    REC_SCOPE_PROFILE("MemoryReport");
+
+    // Gather the SceneObjects and give the attributes of each SceneClass a
+    // range of slots in mAttributes.
+    std::vector<const SceneObject*> sceneObjects;
+    std::unordered_map<const SceneClass*, std::size_t> attributeSlots;
+    for (auto iter = context.beginSceneObject(); iter != context.endSceneObject(); ++iter) {
+        const SceneObject* sceneObject = iter->second;
+        sceneObjects.push_back(sceneObject);
+
+        const SceneClass& sceneClass = sceneObject->getSceneClass();
+        if (attributeSlots.emplace(&sceneClass, mAttributes.size()).second) {
+            for (auto attr = sceneClass.beginAttributes(); attr != sceneClass.endAttributes(); ++attr) {
+                Entry entry;
+                entry.mName = (*attr)->getName();
+                entry.mClassName = sceneClass.getName();
+                mAttributes.push_back(std::move(entry));
+            }
+        }
+    }
+
+    // Each thread sums its attribute values in its own slots, the SceneObject
+    // entries are filled in place.
+    mObjects.resize(sceneObjects.size());
+    tbb::enumerable_thread_specific<std::vector<ValueBytes>> threadBytes(
+        std::vector<ValueBytes>(mAttributes.size()));
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, sceneObjects.size()),
+                      [&](const tbb::blocked_range<std::size_t>& range) {
+        std::vector<ValueBytes>& bytes = threadBytes.local();
+        for (std::size_t i = range.begin(); i != range.end(); ++i) {
+            const SceneObject& sceneObject = *sceneObjects[i];
+            const SceneClass& sceneClass = sceneObject.getSceneClass();
+            std::size_t slot = attributeSlots.at(&sceneClass);
+
+            Entry& entry = mObjects[i];
+            entry.mName = sceneObject.getName();
+            entry.mClassName = sceneClass.getName();
+            entry.mCount = 1;
+            for (auto attr = sceneClass.beginAttributes(); attr != sceneClass.endAttributes(); ++attr, ++slot) {
+                ValueBytes value;
+                measureAttribute(sceneObject, **attr, value);
+                bytes[slot].mCount += value.mCount;
+                bytes[slot].mStorage += value.mStorage;
+                bytes[slot].mHeap += value.mHeap;
+                entry.mHeapBytes += value.mHeap;
+            }
+
+            // The attribute storage chunk (with its padding) and the binding
+            // array. The 4 attribute / binding change masks are bitsets which
+            // allocate their blocks on the heap, like the element ranges
+            // changed by setRange().
+            const std::size_t numAttributes = std::distance(sceneClass.beginAttributes(),
+                                                            sceneClass.endAttributes());
+            entry.mStorageBytes = sceneClass.mAttributeStorageSize +
+                                  numAttributes * sizeof(SceneObject*);
+            entry.mHeapBytes += 4 * changeMaskBytes(numAttributes);
+            entry.mHeapBytes += sceneObject.getChangedRangesBytes();
+            entry.mHeapBytes += stringHeapBytes(entry.mName);
+        }
+    });
+
+    threadBytes.combine_each([&](const std::vector<ValueBytes>& bytes) {
+        for (std::size_t slot = 0; slot < bytes.size(); ++slot) {
+            mAttributes[slot].mCount += bytes[slot].mCount;
+            mAttributes[slot].mStorageBytes += bytes[slot].mStorage;
+            mAttributes[slot].mHeapBytes += bytes[slot].mHeap;
+        }
+    });
+
+    std::unordered_map<std::string, Entry> classes;
+    for (const Entry& object : mObjects) {
+        Entry& entry = classes[object.mClassName];
+        entry.mName = object.mClassName;
+        ++entry.mCount;
+        entry.mStorageBytes += object.mStorageBytes;
+        entry.mHeapBytes += object.mHeapBytes;
+        mStorageBytes += object.mStorageBytes;
+        mHeapBytes += object.mHeapBytes;
+    }
+    for (auto& item : classes) {
+        mClasses.push_back(std::move(item.second));
+    }
+
+    sortEntries(mClasses);
+    sortEntries(mObjects);
+    sortEntries(mAttributes);
+}
+
+std::string
+MemoryReport::show(std::size_t topCount) const
+{
+    std::ostringstream ostr;
+    ostr << "MemoryReport {\n"
+         << "  total   " << str_util::byteStr(getTotalBytes()) << '\n'
+         << "  storage " << str_util::byteStr(mStorageBytes) << '\n'
+         << "  heap    " << str_util::byteStr(mHeapBytes) << '\n'
+         << "  objects " << mObjects.size() << '\n';
+    showEntries(ostr, "SceneClasses", mClasses, topCount, false);
+    showEntries(ostr, "SceneObjects", mObjects, topCount, false);
+    showEntries(ostr, "Attributes", mAttributes, topCount, true);
+    ostr << "}";
+    return ostr.str();
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,84 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include "Types.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+/**
+ * A MemoryReport breaks down the memory held by the SceneObjects of a
+ * SceneContext by SceneClass, by SceneObject and by attribute.
+ *
+ * Every SceneObject is walked (in parallel) and for each attribute value we
+ * count:
+ *
+ *   - its storage: the bytes it occupies in the attribute storage chunk of
+ *     the SceneObject (once per timestep for blurrable attributes),
+ *   - its heap: the bytes owned by vectors and strings, by capacity rather
+ *     than size, including the index of SceneObjectIndexable values.
+ *
+ * SceneObject entries also include their bookkeeping: the padding of the
+ * attribute storage and the binding array as storage, the change masks, the
+ * element ranges changed by setRange() and the name as heap. UserData and the
+ * Layer and TraceSet assignments keep their data in attributes, so they show
+ * up in the attribute entries like any other value.
+ *
+ * What the SceneObject subclasses allocate on their own (geometry caches,
+ * shader state, ...) is not visible from RDL and is not counted.
+ */
+class MemoryReport
+{
+public:
+    struct Entry
+    {
+        std::size_t getTotalBytes() const { return mStorageBytes + mHeapBytes; }
+
+        std::string mName;         // SceneClass, SceneObject or attribute name
+        std::string mClassName;    // owning SceneClass, empty for SceneClasses
+        std::size_t mCount {0};    // SceneObjects (attributes : values) counted
+        std::size_t mStorageBytes {0};
+        std::size_t mHeapBytes {0};
+    };
+
+    typedef std::vector<Entry> EntryVector;
+
+    /**
+     * Walks all the SceneObjects of the context. The context must not be
+     * modified while the report is built.
+     */
+    explicit MemoryReport(const SceneContext& context);
+
+    /// All entries are sorted by decreasing total bytes.
+    const EntryVector& getClasses() const { return mClasses; }
+    const EntryVector& getObjects() const { return mObjects; }
+    const EntryVector& getAttributes() const { return mAttributes; }
+
+    std::size_t getStorageBytes() const { return mStorageBytes; }
+    std::size_t getHeapBytes() const { return mHeapBytes; }
+    std::size_t getTotalBytes() const { return mStorageBytes + mHeapBytes; }
+
+    /**
+     * Formats the totals and the topCount biggest SceneClasses, SceneObjects
+     * and attributes as a table.
+     */
+    std::string show(std::size_t topCount) const;
+
+private:
+    EntryVector mClasses;
+    EntryVector mObjects;
+    EntryVector mAttributes;
+    std::size_t mStorageBytes;
+    std::size_t mHeapBytes;
+};
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -60,47 +60,8 @@ SceneClass::computeOffsetAndSize(AttributeFlags flags)
     // can't do anything about it here.
     std::size_t size = (flags & FLAGS_BLURRABLE) ? sizeof(T[NUM_TIMESTEPS]) : sizeof(T);
 
-    // Cache lines on all modern processors are 64 bytes.
-    const std::size_t cacheLineSize = 64;
-
-    // Where is the next cache line boundary?
-    const std::size_t nextBoundary = (mAttributeStorageSize % cacheLineSize == 0) ?
-        mAttributeStorageSize : ((mAttributeStorageSize / cacheLineSize) + 1) * cacheLineSize;
-
-    // Our alignment strategy is to get reasonably good packing (maximize
-    // spatial locality) and alignment (maximize access speed) without trying
-    // to solve a full-on bin packing problem. It works as follows:
-    // * If the type is larger than a cache line, align it to the next cache
-    //   line boundary.
-    // * If the type is smaller than a cache line, first align it to the type's
-    //   alignment requirements. Then:
-    //   * If there isn't enough space left for it in the current cache line
-    //     (it would straddle cache lines), align it to the next cache line
-    //     boundary.
-    //   * If there is enough space left for it in the current cache line,
-    //     leave it there, aligned on the type's alignment requirements.
-    // 
-    // Of course, for this to actually work, the block of memory allocated
-    // for storing attribute values must be aligned on a cache line boundary.
-    uint32_t offset = 0;
-    if (size >= cacheLineSize) {
-        offset = nextBoundary;
-    } else {
-        // What is the alignment requirement of the type and the padding we
-        // need to get there?
-        const std::size_t alignment = boost::alignment_of<T>::value;
-        const std::size_t misalignment = mAttributeStorageSize % alignment;
-        const std::size_t padding = (misalignment == 0) ?  0 : alignment - misalignment;
-        uint32_t typeOffset = mAttributeStorageSize + padding;
-
-        if (typeOffset + size <= nextBoundary) {
-            // It will fit on the same cache line, so place it there.
-            offset = typeOffset;
-        } else {
-            // Not enough space left, so bump it to the next cache line.
-            offset = nextBoundary;
-        }
-    }
+    // The placement itself is shared with compile-time attribute layouts.
+    uint32_t offset = placeAttribute(mAttributeStorageSize, size, boost::alignment_of<T>::value);
 
     return std::make_pair(offset, size);
 }
@@ -549,6 +510,36 @@ SceneClass::getSourcePath() const
     return mObjectFactory->getSourcePath();
 }
 
+void
+SceneClass::checkAttributeLayout(const AttributeLayoutEntry* layout, std::size_t count) const
+{
+    if (count != mAttributes.size()) {
+        std::stringstream errMsg;
+        errMsg << "SceneClass '" << mName << "' has " << mAttributes.size() <<
+            " attributes, but its attribute layout has " << count << ".";
+        throw except::RuntimeError(errMsg.str());
+    }
+
+    std::size_t storageSize = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const AttributeLayoutEntry& entry = layout[i];
+        const Attribute* attribute = mAttributes[i];
+        const uint32_t offset = placeAttribute(storageSize, entry.mSize, entry.mAlignment);
+        storageSize = offset + entry.mSize;
+
+        if (attribute->mName != entry.mName || attribute->mType != entry.mType ||
+                attribute->mFlags != entry.mFlags || attribute->mOffset != offset) {
+            std::stringstream errMsg;
+            errMsg << "Attribute " << i << " '" << attribute->mName << "' of SceneClass '" <<
+                mName << "' (" << attributeTypeName(attribute->mType) << ", offset " <<
+                attribute->mOffset << ") does not match attribute layout entry '" <<
+                entry.mName << "' (" << attributeTypeName(entry.mType) << ", offset " <<
+                offset << ").";
+            throw except::RuntimeError(errMsg.str());
+        }
+    }
+}
+
 // Explicit instantiations of templated functions for all attribute types.
 template std::pair<uint32_t, std::size_t> SceneClass::computeOffsetAndSize<Bool>(AttributeFlags);
 template std::pair<uint32_t, std::size_t> SceneClass::computeOffsetAndSize<Int>(AttributeFlags);
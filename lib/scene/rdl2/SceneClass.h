@@ -9,6 +9,7 @@
 
 #include "Attribute.h"
 #include "AttributeKey.h"
+#include "AttributeLayout.h"
 #include "ObjectFactory.h"
 #include "Types.h"
 
@@ -425,6 +426,18 @@ public:
     template <typename T>
     finline const T *getDataPtr(const std::string &name) const;
 
+    /**
+     * Checks that the declared attributes match a compile-time attribute
+     * layout (see AttributeLayout.h): the same attributes in the same order,
+     * with the same types, flags and offsets. Built-in SceneClasses which hand
+     * out FixedAttributeKeys call it at the end of their declaration function.
+     *
+     * @param   layout  The layout entries, in declaration order.
+     * @param   count   The number of layout entries.
+     * @throw   except::RuntimeError    If the attributes don't match.
+     */
+    void checkAttributeLayout(const AttributeLayoutEntry* layout, std::size_t count) const;
+
     std::string showAllAttributes() const; // returns all attribute info as a string for display purposes
 
     // Metadata Keys
@@ -579,6 +592,9 @@ private:
     friend class BinaryWriter;
     friend class BinaryReader;
 
+    // Needs the attribute storage size for memory accounting.
+    friend class MemoryReport;
+
     // Classes that need access for testing purposes.
     friend class unittest::TestSceneClass;
     friend class unittest::TestSceneObject;
@@ -27,6 +27,7 @@
 
 #include <scene_rdl2/common/platform/Platform.h>
 #include <scene_rdl2/common/except/exceptions.h>
+#include <scene_rdl2/common/rec_time/RecScopeProfiler.h>
 #include <scene_rdl2/render/util/Strings.h>
 #include <scene_rdl2/render/logging/logging.h>
 
@@ -479,6 +480,8 @@ SceneContext::createSceneObject(const std::string& className,
 void
 SceneContext::applyUpdates(Layer * const layer)
 {
+    REC_SCOPE_PROFILE("SceneContext::applyUpdates");
+
     // Now that the scene variables and the camera are available, we can update the
     // coefficients in the scene context that hold information about the shutter interval and
     // motion steps.
@@ -717,6 +720,12 @@ SceneContext::commitAllChanges()
     });
 }
 
+MemoryReport
+SceneContext::getMemoryReport() const
+{
+    return MemoryReport(*this);
+}
+
 void
 SceneContext::loadAllSceneClasses()
 {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "Camera.h"
+#include "MemoryReport.h"
 #include "SceneObject.h"
 #include "SceneContext.h"
 #include "SceneVariables.h"
@@ -298,6 +299,14 @@ public:
      */
     void commitAllChanges();
 
+    /**
+     * Walks all the SceneObjects (in parallel) and reports the memory held by
+     * their attribute values, by SceneClass, by SceneObject and by attribute.
+     * See MemoryReport for what is counted. Don't modify the context while
+     * the report is built.
+     */
+    MemoryReport getMemoryReport() const;
+
     /**
      * Searches every directory in the DSO path looking for ".so" files and
      * attempts to load them as RDL DSOs. Files that are not successfully
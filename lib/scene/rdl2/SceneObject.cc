@@ -12,15 +12,44 @@
 #include <scene_rdl2/render/util/Strings.h>
 #include <scene_rdl2/common/except/exceptions.h>
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <string>
 #include <stdint.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace scene_rdl2 {
 namespace rdl2 {
 
 namespace {
 
+// Maximum number of disjoint ranges tracked per attribute and timestep. Past
+// that they are collapsed into their bounding range.
+const std::size_t MAX_CHANGED_RANGES = 64;
+
+// Copies values over vec starting at offset, writing only the elements which
+// differ. Returns the [begin, end) range of the changed elements, empty if
+// nothing changed.
+template <typename T>
+std::pair<std::size_t, std::size_t>
+overwriteRange(std::vector<T>& vec, std::size_t offset, const std::vector<T>& values)
+{
+    std::size_t begin = vec.size();
+    std::size_t end = 0;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        T& element = vec[offset + i];
+        if (!(element == values[i])) {
+            element = values[i];
+            begin = std::min(begin, offset + i);
+            end = offset + i + 1;
+        }
+    }
+    return (begin < end) ? std::make_pair(begin, end) : std::make_pair(std::size_t(0), std::size_t(0));
+}
+
 // Interpolation functions for types that we know how to interpolate.
 template <typename T>
 T
@@ -68,6 +97,11 @@ interpolate(const Mat4d& begin, const Mat4d& end, float t)
 
 } // namespace
 
+struct SceneObject::ChangedRanges
+{
+    std::unordered_map<uint32_t, std::array<ElementRanges, NUM_TIMESTEPS>> mRanges;
+};
+
 SceneObject::SceneObject(const SceneClass& sceneClass, const std::string& name) :
     mAttributeStorage(nullptr),
     mBindings(nullptr),
@@ -189,6 +223,10 @@ SceneObject::set(AttributeKey<T> key, const T& value)
     } while (key.isBlurrable() && timestep < NUM_TIMESTEPS);
 
     if (changed) {
+        // The whole value has to be sent now, not just the changed ranges.
+        if (mChangedRanges) {
+            clearChangedRanges(key.mIndex);
+        }
         mAttributeSetMask.set(key.mIndex, true);
         mAttributeUpdateMask.set(key.mIndex, true);
         mDirty = true;
@@ -301,6 +339,9 @@ SceneObject::set(AttributeKey<T> key, const T& value, AttributeTimestep timestep
     }
 
     if (SceneClass::setValue(mAttributeStorage, key, timestep, value)) {
+        if (mChangedRanges) {
+            clearChangedRanges(key.mIndex);
+        }
         mAttributeSetMask.set(key.mIndex, true);
         mAttributeUpdateMask.set(key.mIndex, true);
         mDirty = true;
@@ -391,6 +432,133 @@ SceneObject::set(AttributeKey<SceneObject*> key, SceneObject* value, AttributeTi
     }
 }
 
+template <typename T>
+void
+SceneObject::setRange(AttributeKey<std::vector<T>> key, std::size_t offset, const std::vector<T>& values)
+{
+    int timestep = TIMESTEP_BEGIN;
+    do {
+        setRange(key, offset, values, static_cast<AttributeTimestep>(timestep));
+        ++timestep;
+    } while (key.isBlurrable() && timestep < NUM_TIMESTEPS);
+}
+
+template <typename T>
+void
+SceneObject::setRange(AttributeKey<std::vector<T>> key, std::size_t offset, const std::vector<T>& values,
+                      AttributeTimestep timestep)
+{
+    if (!mUpdateActive) {
+        std::stringstream errMsg;
+        errMsg << "Attribute '" << mSceneClass.getAttribute(key)->getName() <<
+            "' of SceneObject '" << mName << "' can only be set between"
+            " beginUpdate() and endUpdate() calls.";
+        throw except::RuntimeError(errMsg.str());
+    }
+
+    // If the attribute isn't blurrable, it's constant at all timesteps.
+    if (!key.isBlurrable()) {
+        timestep = TIMESTEP_BEGIN;
+    }
+
+    std::vector<T>& vec = getMutable(key, timestep);
+    if (offset > vec.size() || values.size() > vec.size() - offset) {
+        throw except::IndexError(util::buildString("Range [", offset, ", ", offset + values.size(),
+                                                   ") of attribute '", mSceneClass.getAttribute(key)->getName(),
+                                                   "' of SceneObject '", mName, "' is past the end of its ",
+                                                   vec.size(), " elements."));
+    }
+
+    const std::pair<std::size_t, std::size_t> changed = overwriteRange(vec, offset, values);
+    if (changed.first == changed.second) {
+        return;
+    }
+
+    // Only track ranges if the vector hasn't already been set as a whole.
+    if (!mAttributeSetMask.test(key.mIndex) ||
+        (mChangedRanges && mChangedRanges->mRanges.count(key.mIndex))) {
+        addChangedRange(key.mIndex, timestep, changed.first, changed.second);
+    }
+    mAttributeSetMask.set(key.mIndex, true);
+    mAttributeUpdateMask.set(key.mIndex, true);
+    mDirty = true;
+}
+
+const SceneObject::ElementRanges*
+SceneObject::getChangedRanges(const Attribute& attribute, AttributeTimestep timestep) const
+{
+    if (!mChangedRanges) {
+        return nullptr;
+    }
+    auto iter = mChangedRanges->mRanges.find(attribute.mIndex);
+    return (iter != mChangedRanges->mRanges.end()) ? &iter->second[timestep] : nullptr;
+}
+
+void
+SceneObject::addChangedRange(uint32_t index, AttributeTimestep timestep, std::size_t begin, std::size_t end)
+{
+    if (!mChangedRanges) {
+        mChangedRanges.reset(new ChangedRanges);
+    }
+    ElementRanges& ranges = mChangedRanges->mRanges[index][timestep];
+
+    // First range which ends at or after begin, i.e. which may overlap or
+    // touch the new one.
+    auto first = std::lower_bound(ranges.begin(), ranges.end(), begin,
+                                  [](const std::pair<std::size_t, std::size_t>& range, std::size_t value) {
+                                      return range.second < value;
+                                  });
+    auto last = first;
+    while (last != ranges.end() && last->first <= end) {
+        begin = std::min(begin, last->first);
+        end = std::max(end, last->second);
+        ++last;
+    }
+    first = ranges.erase(first, last);
+    ranges.emplace(first, begin, end);
+
+    if (ranges.size() > MAX_CHANGED_RANGES) {
+        const std::pair<std::size_t, std::size_t> bounds(ranges.front().first, ranges.back().second);
+        ranges.assign(1, bounds);
+    }
+}
+
+void
+SceneObject::clearChangedRanges(uint32_t index)
+{
+    mChangedRanges->mRanges.erase(index);
+    if (mChangedRanges->mRanges.empty()) {
+        mChangedRanges.reset();
+    }
+}
+
+void
+SceneObject::clearChangedRanges()
+{
+    mChangedRanges.reset();
+}
+
+std::size_t
+SceneObject::getChangedRangesBytes() const
+{
+    if (!mChangedRanges) {
+        return 0;
+    }
+
+    // The map with its bucket array and nodes (a value and the next pointer
+    // each), and the range vectors by capacity.
+    typedef decltype(mChangedRanges->mRanges) RangeMap;
+    const RangeMap& ranges = mChangedRanges->mRanges;
+    std::size_t bytes = sizeof(ChangedRanges) + ranges.bucket_count() * sizeof(void*) +
+                        ranges.size() * (sizeof(RangeMap::value_type) + sizeof(void*));
+    for (const auto& item : ranges) {
+        for (const ElementRanges& timestepRanges : item.second) {
+            bytes += timestepRanges.capacity() * sizeof(ElementRanges::value_type);
+        }
+    }
+    return bytes;
+}
+
 template <typename T>
 void
 SceneObject::set(const std::string& name, const T& value)
@@ -837,6 +1005,51 @@ template void SceneObject::resetToDefault(AttributeKey<Mat4dVector>);
 template void SceneObject::resetToDefault(AttributeKey<SceneObjectVector>);
 template void SceneObject::resetToDefault(AttributeKey<SceneObjectIndexable>);
 
+// Explicit instantiations of setRange() for the vector attribute types which
+// support changed range tracking.
+template void SceneObject::setRange(AttributeKey<IntVector>, std::size_t, const IntVector&);
+template void SceneObject::setRange(AttributeKey<LongVector>, std::size_t, const LongVector&);
+template void SceneObject::setRange(AttributeKey<FloatVector>, std::size_t, const FloatVector&);
+template void SceneObject::setRange(AttributeKey<DoubleVector>, std::size_t, const DoubleVector&);
+template void SceneObject::setRange(AttributeKey<RgbVector>, std::size_t, const RgbVector&);
+template void SceneObject::setRange(AttributeKey<RgbaVector>, std::size_t, const RgbaVector&);
+template void SceneObject::setRange(AttributeKey<Vec2fVector>, std::size_t, const Vec2fVector&);
+template void SceneObject::setRange(AttributeKey<Vec2dVector>, std::size_t, const Vec2dVector&);
+template void SceneObject::setRange(AttributeKey<Vec3fVector>, std::size_t, const Vec3fVector&);
+template void SceneObject::setRange(AttributeKey<Vec3dVector>, std::size_t, const Vec3dVector&);
+template void SceneObject::setRange(AttributeKey<Vec4fVector>, std::size_t, const Vec4fVector&);
+template void SceneObject::setRange(AttributeKey<Vec4dVector>, std::size_t, const Vec4dVector&);
+template void SceneObject::setRange(AttributeKey<Mat4fVector>, std::size_t, const Mat4fVector&);
+template void SceneObject::setRange(AttributeKey<Mat4dVector>, std::size_t, const Mat4dVector&);
+template void SceneObject::setRange(AttributeKey<IntVector>, std::size_t, const IntVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<LongVector>, std::size_t, const LongVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<FloatVector>, std::size_t, const FloatVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<DoubleVector>, std::size_t, const DoubleVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<RgbVector>, std::size_t, const RgbVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<RgbaVector>, std::size_t, const RgbaVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<Vec2fVector>, std::size_t, const Vec2fVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<Vec2dVector>, std::size_t, const Vec2dVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<Vec3fVector>, std::size_t, const Vec3fVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<Vec3dVector>, std::size_t, const Vec3dVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<Vec4fVector>, std::size_t, const Vec4fVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<Vec4dVector>, std::size_t, const Vec4dVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<Mat4fVector>, std::size_t, const Mat4fVector&,
+                                      AttributeTimestep);
+template void SceneObject::setRange(AttributeKey<Mat4dVector>, std::size_t, const Mat4dVector&,
+                                      AttributeTimestep);
+
 template bool SceneObject::isDefault(AttributeKey<Bool>) const;
 template bool SceneObject::isDefault(AttributeKey<Int>) const;
 template bool SceneObject::isDefault(AttributeKey<int64_t>) const;
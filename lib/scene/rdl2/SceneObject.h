@@ -8,6 +8,7 @@
 #include <scene_rdl2/common/platform/Platform.h>
 
 #include "AttributeKey.h"
+#include "AttributeLayout.h"
 #include "SceneClass.h"
 #include "Types.h"
 #include "UpdateHelper.h"
@@ -23,6 +24,7 @@
 #include <string>
 #include <stdint.h>
 #include <utility>
+#include <vector>
 
 namespace llvm {
     class Function;
@@ -189,6 +191,21 @@ public:
     template <typename T>
     finline const T& get(AttributeKey<T> key, AttributeTimestep timestep) const;
 
+    /**
+     * Attribute getters for FixedAttributeKeys of built-in SceneClasses (see
+     * AttributeLayout.h). With a constexpr key they compile down to a load at
+     * a fixed offset from the attribute storage. The key must come from the
+     * layout of the SceneClass of this object.
+     *
+     * @param   key         A FixedAttributeKey for the value you want to get.
+     * @param   timestep    The timestep at which to retrieve the value.
+     * @return  A const reference to the value.
+     */
+    template <typename T>
+    finline const T& get(FixedAttributeKey<T> key) const;
+    template <typename T>
+    finline const T& get(FixedAttributeKey<T> key, AttributeTimestep timestep) const;
+
     /**
      * Attribute getter that computes a linearly interpolated or extrapolated
      * value based on the values set at TIMESTEP_BEGIN and TIMESTEP_END, which
@@ -276,6 +293,44 @@ public:
     template <typename Container>
     void setSequenceContainer(AttributeKey<Container> key, const Container& value, AttributeTimestep timestep);
 
+    /**
+     * Overwrites the elements [offset, offset + values.size()) of a vector
+     * attribute, at all timesteps if the attribute is blurrable. Only the
+     * elements which actually change are written, and the changed element
+     * ranges are tracked so delta encoding (BinaryWriter) can send just those
+     * ranges instead of the whole vector.
+     *
+     * Supported for the Int, Long, Float, Double, Rgb, Rgba, Vec2, Vec3, Vec4
+     * and Mat4 vector attributes.
+     *
+     * @param   key     An AttributeKey for the vector you want to modify.
+     * @param   offset  Index of the first element to overwrite.
+     * @param   values  The new element values.
+     * @throw   except::IndexError  If the range is past the end of the vector.
+     */
+    template <typename T>
+    void setRange(AttributeKey<std::vector<T>> key, std::size_t offset, const std::vector<T>& values);
+
+    /**
+     * Same as above, at the given timestep. If the attribute is not
+     * blurrable, the timestep is ignored.
+     */
+    template <typename T>
+    void setRange(AttributeKey<std::vector<T>> key, std::size_t offset, const std::vector<T>& values,
+                  AttributeTimestep timestep);
+
+    // Sorted, disjoint [begin, end) element ranges.
+    typedef std::vector<std::pair<std::size_t, std::size_t>> ElementRanges;
+
+    /**
+     * Returns the element ranges of a vector attribute changed through
+     * setRange() at the given timestep since the last commitChanges(). The
+     * ranges are empty if that timestep is unchanged. Returns nullptr if the
+     * attribute is not tracked by ranges (it is unchanged, or it was set as a
+     * whole).
+     */
+    const ElementRanges* getChangedRanges(const Attribute& attribute, AttributeTimestep timestep) const;
+
     /**
      * Convenience attribute setters that behave like their AttributeKey
      * counterparts, but take an attribute name instead of an AttributeKey.
@@ -998,6 +1053,17 @@ private:
                     SceneObjectInterface objectType, SceneObject* sceneObject,
                     F attributeNameFetcher);
 
+    // Records [begin, end) as changed in the vector attribute at the given
+    // index, merging it with the ranges it overlaps or touches.
+    void addChangedRange(uint32_t index, AttributeTimestep timestep, std::size_t begin, std::size_t end);
+
+    // Drops the changed ranges of one attribute, or of all of them.
+    void clearChangedRanges(uint32_t index);
+    void clearChangedRanges();
+
+    // Heap bytes held by mChangedRanges, for the MemoryReport.
+    std::size_t getChangedRangesBytes() const;
+
     // Bitmask indicating which attributes have been set. Used for determining
     // which attribute values to pack during serialization.
     boost::dynamic_bitset<> mAttributeSetMask;
@@ -1018,6 +1084,13 @@ private:
     // mAttributeSetMask is used internally for the purposes of serialization.
     boost::dynamic_bitset<> mBindingUpdateMask;
 
+    // Element ranges changed by setRange() since the last commitChanges(), by
+    // attribute index. An attribute which has its set mask bit but no entry
+    // here was set as a whole. Only allocated by the first setRange(), most
+    // SceneObjects never have any.
+    struct ChangedRanges;
+    std::unique_ptr<ChangedRanges> mChangedRanges;
+
     // Used to ensure that calls to set() and setBinding() only happen between
     // pairs of beginUpdate() and endUpdate() calls.
     bool mUpdateActive;
@@ -1052,6 +1125,9 @@ private:
     friend class BinaryWriter;
     friend class BinaryReader;
 
+    // Classes requiring access for memory accounting.
+    friend class MemoryReport;
+
     // Derived classes which provided specialized APIs for setting attributes
     // and need to manually handle the set flags.
     friend class Geometry;
@@ -1110,6 +1186,30 @@ SceneObject::get(AttributeKey<T> key, AttributeTimestep timestep) const
     return SceneClass::getValue(mAttributeStorage, key, timestep);
 }
 
+template <typename T>
+const T&
+SceneObject::get(FixedAttributeKey<T> key) const
+{
+    MNRY_ASSERT(key.getIndex() < mSceneClass.mAttributes.size() &&
+                mSceneClass.mAttributes[key.getIndex()]->mOffset == key.getOffset());
+    return reinterpret_cast<const T*>(static_cast<const char*>(mAttributeStorage) + key.getOffset())[TIMESTEP_BEGIN];
+}
+
+template <typename T>
+const T&
+SceneObject::get(FixedAttributeKey<T> key, AttributeTimestep timestep) const
+{
+    MNRY_ASSERT(key.getIndex() < mSceneClass.mAttributes.size() &&
+                mSceneClass.mAttributes[key.getIndex()]->mOffset == key.getOffset());
+
+    // If the attribute isn't blurrable, it's constant at all timesteps.
+    if (!key.isBlurrable()) {
+        timestep = TIMESTEP_BEGIN;
+    }
+
+    return reinterpret_cast<const T*>(static_cast<const char*>(mAttributeStorage) + key.getOffset())[timestep];
+}
+
 template <typename T>
 const T&
 SceneObject::get(const std::string& name) const
@@ -1255,6 +1355,9 @@ SceneObject::commitChanges()
     MNRY_ASSERT_REQUIRE(!mUpdateActive, "Cannot commit changes while an update is active.");
     mAttributeSetMask.reset();
     mBindingSetMask.reset();
+    if (mChangedRanges) {
+        clearChangedRanges();
+    }
     mDirty = false;
 }
 
@@ -14,6 +14,7 @@
 #include <scene_rdl2/common/except/exceptions.h>
 #include <scene_rdl2/render/util/GetEnv.h>
 
+#include <iterator>
 #include <limits>
 #include <string>
 
@@ -1208,6 +1209,10 @@ SceneObjectInterface SceneVariables::declare(SceneClass& sceneClass)
     sceneClass.setGroup("Debug", sDebugConsole);
     sceneClass.setGroup("Debug", sValidateGeometry);
 
+    // The fixed keys are only valid if the attributes were placed where the
+    // compile-time layout expects them.
+    sceneClass.checkAttributeLayout(sLayout, std::size(sLayout));
+
     return interface;
 }
 
@@ -1223,14 +1228,14 @@ uint32_t SceneVariables::getRezedHeight() const
 
 HalfOpenViewport SceneVariables::getRezedApertureWindow() const
 {
-    float invRes = 1.f / get(sResKey);
+    float invRes = 1.f / get(sFixedResKey);
 
-    const std::vector<int>& window = get(sApertureWindow);
+    const std::vector<int>& window = get(sFixedApertureWindow);
     if (window[0] == std::numeric_limits<int>::lowest()) {
         // Assume the sApertureWindow hasn't been set and key off of the
         // sWidth and sHeigh attributes instead.
-        int width       = get(sImageWidth);
-        int height      = get(sImageHeight);
+        int width       = get(sFixedImageWidth);
+        int height      = get(sFixedImageHeight);
         int rezedWidth  = math::max(int(float(width) * invRes), 1);
         int rezedHeight = math::max(int(float(height) * invRes), 1);
         return HalfOpenViewport(0, 0, rezedWidth, rezedHeight);
@@ -1241,13 +1246,13 @@ HalfOpenViewport SceneVariables::getRezedApertureWindow() const
 
 HalfOpenViewport SceneVariables::getRezedRegionWindow() const
 {
-    const std::vector<int>& window = get(sRegionWindow);
+    const std::vector<int>& window = get(sFixedRegionWindow);
     if (window[0] == std::numeric_limits<int>::lowest()) {
         // Assume the sRegionWindow and replace it with the aperture window instead.
         return getRezedApertureWindow();
     }
 
-    float invRes = 1.f / get(sResKey);
+    float invRes = 1.f / get(sFixedResKey);
 
     return HalfOpenViewport(window, invRes);
 }
@@ -1265,13 +1270,13 @@ HalfOpenViewport SceneVariables::getRezedSubViewport() const
         }
     }
 
-    const std::vector<int>& viewport = get(sSubViewport);
+    const std::vector<int>& viewport = get(sFixedSubViewport);
     if (viewport[0] == std::numeric_limits<int>::lowest()) {
         return screen;
     }
 
     // Clip rezed sub-viewport to eventual screen window.
-    float invRes = 1.f / get(sResKey);
+    float invRes = 1.f / get(sFixedResKey);
     int   minX   = int(float(viewport[0]) * invRes);
     int   minY   = int(float(viewport[1]) * invRes);
     int   maxX   = int(float(viewport[2]) * invRes);
@@ -1290,7 +1295,7 @@ HalfOpenViewport SceneVariables::getRezedSubViewport() const
 
 int SceneVariables::getMachineId() const
 {
-    int machineId = get(sMachineId);
+    int machineId = get(sFixedMachineId);
 
     if (machineId >= 0) {
         return machineId;
@@ -1302,7 +1307,7 @@ int SceneVariables::getMachineId() const
 
 int SceneVariables::getNumMachines() const
 {
-    int numMachines = get(sNumMachines);
+    int numMachines = get(sFixedNumMachines);
 
     if (numMachines > 1) {
         return numMachines;
@@ -1314,7 +1319,7 @@ int SceneVariables::getNumMachines() const
 
 SceneObject* SceneVariables::getLayer() const
 {
-    auto layerSceneObj = get(sLayer);
+    auto layerSceneObj = get(sFixedLayer);
     if (layerSceneObj) {
         return layerSceneObj;
     }
@@ -1334,7 +1339,7 @@ SceneObject* SceneVariables::getLayer() const
 
 SceneObject* SceneVariables::getCamera() const
 {
-    auto cameraSceneObj = get(sCamera);
+    auto cameraSceneObj = get(sFixedCamera);
     if (cameraSceneObj) {
         return cameraSceneObj;
     }
@@ -1364,7 +1369,7 @@ const SceneObject* SceneVariables::getExrHeaderAttributes() const
 
 bool SceneVariables::getDebugPixel(math::Vec2i& pixel) const
 {
-    const std::vector<int>& debugPixel = get(sDebugPixel);
+    const std::vector<int>& debugPixel = get(sFixedDebugPixel);
     if (debugPixel[0] == std::numeric_limits<int>::lowest()) { // unset
         return false;
     } else {
@@ -1403,7 +1408,7 @@ bool SceneVariables::getDebugRaysDepthRange(int& start, int& end) const
 
 bool SceneVariables::getSubViewport(math::HalfOpenViewport& viewport) const
 {
-    const std::vector<int>& viewportVector = get(sSubViewport);
+    const std::vector<int>& viewportVector = get(sFixedSubViewport);
     if (viewportVector[0] == std::numeric_limits<int>::lowest()) { // unset
         return false;
     } else {
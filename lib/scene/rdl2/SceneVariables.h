@@ -8,6 +8,7 @@
 #include <scene_rdl2/common/platform/Platform.h>
 
 #include "AttributeKey.h"
+#include "AttributeLayout.h"
 #include "SceneClass.h"
 #include "SceneObject.h"
 #include "Types.h"
@@ -393,6 +394,154 @@ public:
 
     // capture multiple layers of presence for cryptomatte
     static AttributeKey<Bool> sCryptomatteMultiPresence;
+
+    //
+    // Compile-time attribute layout
+    //
+
+    // The attributes declared by declare(), in declaration order, so their
+    // offsets are known at compile time. declare() checks it against the
+    // SceneClass: keep it in sync when adding or reordering attributes.
+    static constexpr AttributeLayoutEntry sLayout[] = {
+        layoutEntry<Float>("min_frame"),
+        layoutEntry<Float>("max_frame"),
+        layoutEntry<Float>("frame"),
+        layoutEntry<SceneObject*>("camera"),
+        layoutEntry<SceneObject*>("dicing_camera"),
+        layoutEntry<SceneObject*>("layer"),
+        layoutEntry<SceneObject*>("exr_header_attributes"),
+        layoutEntry<Int>("image_width"),
+        layoutEntry<Int>("image_height"),
+        layoutEntry<Float>("res"),
+        layoutEntry<IntVector>("aperture_window"),
+        layoutEntry<IntVector>("region_window"),
+        layoutEntry<IntVector>("sub_viewport"),
+        layoutEntry<FloatVector>("motion_steps"),
+        layoutEntry<Float>("fps"),
+        layoutEntry<Float>("scene_scale"),
+        layoutEntry<Int>("sampling_mode", FLAGS_ENUMERABLE),
+        layoutEntry<Int>("min_adaptive_samples"),
+        layoutEntry<Int>("max_adaptive_samples"),
+        layoutEntry<Float>("target_adaptive_error"),
+        layoutEntry<Int>("light_sampling_mode", FLAGS_ENUMERABLE),
+        layoutEntry<Float>("light_sampling_quality"),
+        layoutEntry<Int>("pixel_samples"),
+        layoutEntry<Int>("light_samples"),
+        layoutEntry<Int>("bsdf_samples"),
+        layoutEntry<Int>("bssrdf_samples"),
+        layoutEntry<Int>("max_depth"),
+        layoutEntry<Int>("max_diffuse_depth"),
+        layoutEntry<Int>("max_glossy_depth"),
+        layoutEntry<Int>("max_mirror_depth"),
+        layoutEntry<Int>("max_volume_depth"),
+        layoutEntry<Int>("max_presence_depth"),
+        layoutEntry<Int>("max_hair_depth"),
+        layoutEntry<Bool>("disable_optimized_hair_sampling"),
+        layoutEntry<Int>("max_subsurface_per_path"),
+        layoutEntry<Float>("russian_roulette_threshold"),
+        layoutEntry<Float>("transparency_threshold"),
+        layoutEntry<Float>("presence_threshold"),
+        layoutEntry<Bool>("lock_frame_noise"),
+        layoutEntry<Float>("volume_quality"),
+        layoutEntry<Float>("volume_shadow_quality"),
+        layoutEntry<Int>("volume_illumination_samples"),
+        layoutEntry<Float>("volume_opacity_threshold"),
+        layoutEntry<Int>("volume_overlap_mode", FLAGS_ENUMERABLE),
+        layoutEntry<Float>("volume_attenuation_factor"),
+        layoutEntry<Float>("volume_contribution_factor"),
+        layoutEntry<Float>("volume_phase_attenuation_factor"),
+        layoutEntry<Bool>("path_guide_enable"),
+        layoutEntry<Float>("sample_clamping_value"),
+        layoutEntry<Int>("sample_clamping_depth"),
+        layoutEntry<Float>("roughness_clamping_factor"),
+        layoutEntry<Float>("texture_blur"),
+        layoutEntry<Float>("pixel_filter_width"),
+        layoutEntry<Int>("pixel_filter", FLAGS_ENUMERABLE),
+        layoutEntry<Int>("deep_format", FLAGS_ENUMERABLE),
+        layoutEntry<Float>("deep_curvature_tolerance"),
+        layoutEntry<Float>("deep_z_tolerance"),
+        layoutEntry<Int>("deep_vol_compression_res"),
+        layoutEntry<StringVector>("deep_id_attribute_names"),
+        layoutEntry<Int>("texture_cache_size"),
+        layoutEntry<String>("crypto_uv_attribute_name"),
+        layoutEntry<Int>("texture_file_handles"),
+        layoutEntry<Bool>("fast_geometry_update"),
+        layoutEntry<Bool>("checkpoint_active"),
+        layoutEntry<Float>("checkpoint_interval"),
+        layoutEntry<Int>("checkpoint_quality_steps"),
+        layoutEntry<Float>("checkpoint_time_cap"),
+        layoutEntry<Int>("checkpoint_sample_cap"),
+        layoutEntry<Bool>("checkpoint_overwrite"),
+        layoutEntry<Int>("checkpoint_mode", FLAGS_ENUMERABLE),
+        layoutEntry<Int>("checkpoint_start_sample"),
+        layoutEntry<Bool>("checkpoint_bg_write"),
+        layoutEntry<String>("checkpoint_post_script"),
+        layoutEntry<Int>("checkpoint_total_files"),
+        layoutEntry<Int>("checkpoint_max_bgcache"),
+        layoutEntry<Float>("checkpoint_max_snapshot_overhead"),
+        layoutEntry<Float>("checkpoint_snapshot_interval"),
+        layoutEntry<Bool>("resumable_output"),
+        layoutEntry<Bool>("resume_render"),
+        layoutEntry<String>("on_resume_script"),
+        layoutEntry<Bool>("enable_motion_blur"),
+        layoutEntry<Bool>("enable_dof"),
+        layoutEntry<Bool>("enable_max_geometry_resolution"),
+        layoutEntry<Int>("max_geometry_resolution"),
+        layoutEntry<Bool>("enable_displacement"),
+        layoutEntry<Bool>("enable_subsurface_scattering"),
+        layoutEntry<Bool>("enable_shadowing"),
+        layoutEntry<Bool>("enable_presence_shadows"),
+        layoutEntry<Bool>("lights_visible_in_camera"),
+        layoutEntry<Bool>("propagate_visibility_bounce_type"),
+        layoutEntry<Int>("shadow_terminator_fix", FLAGS_ENUMERABLE),
+        layoutEntry<Int>("machine_id"),
+        layoutEntry<Int>("num_machines"),
+        layoutEntry<Int>("task_distribution_type", FLAGS_ENUMERABLE),
+        layoutEntry<Int>("batch_tile_order", FLAGS_ENUMERABLE),
+        layoutEntry<Int>("progressive_tile_order", FLAGS_ENUMERABLE),
+        layoutEntry<Int>("checkpoint_tile_order", FLAGS_ENUMERABLE),
+        layoutEntry<String>("output_file"),
+        layoutEntry<String>("tmp_dir"),
+        layoutEntry<Bool>("two_stage_output"),
+        layoutEntry<Bool>("log_debug"),
+        layoutEntry<Bool>("log_info"),
+        layoutEntry<Rgb>("fatal_color"),
+        layoutEntry<String>("stats_file"),
+        layoutEntry<Bool>("athena_debug"),
+        layoutEntry<IntVector>("debug_pixel"),
+        layoutEntry<String>("debug_rays_file"),
+        layoutEntry<IntVector>("debug_rays_primary_range"),
+        layoutEntry<IntVector>("debug_rays_depth_range"),
+        layoutEntry<Int>("debug_console"),
+        layoutEntry<Bool>("validate_geometry"),
+        layoutEntry<Bool>("cryptomatte_multi_presence")
+    };
+
+    // Fixed keys for the attributes read by the per-frame and per-tile
+    // getters above. SceneObject::get() with these is a load at a constant
+    // offset.
+    static constexpr FixedAttributeKey<SceneObject*> sFixedCamera =
+        fixedAttributeKey<SceneObject*>(sLayout, "camera");
+    static constexpr FixedAttributeKey<SceneObject*> sFixedLayer =
+        fixedAttributeKey<SceneObject*>(sLayout, "layer");
+    static constexpr FixedAttributeKey<Int> sFixedImageWidth =
+        fixedAttributeKey<Int>(sLayout, "image_width");
+    static constexpr FixedAttributeKey<Int> sFixedImageHeight =
+        fixedAttributeKey<Int>(sLayout, "image_height");
+    static constexpr FixedAttributeKey<Float> sFixedResKey =
+        fixedAttributeKey<Float>(sLayout, "res");
+    static constexpr FixedAttributeKey<IntVector> sFixedApertureWindow =
+        fixedAttributeKey<IntVector>(sLayout, "aperture_window");
+    static constexpr FixedAttributeKey<IntVector> sFixedRegionWindow =
+        fixedAttributeKey<IntVector>(sLayout, "region_window");
+    static constexpr FixedAttributeKey<IntVector> sFixedSubViewport =
+        fixedAttributeKey<IntVector>(sLayout, "sub_viewport");
+    static constexpr FixedAttributeKey<Int> sFixedMachineId =
+        fixedAttributeKey<Int>(sLayout, "machine_id");
+    static constexpr FixedAttributeKey<Int> sFixedNumMachines =
+        fixedAttributeKey<Int>(sLayout, "num_machines");
+    static constexpr FixedAttributeKey<IntVector> sFixedDebugPixel =
+        fixedAttributeKey<IntVector>(sLayout, "debug_pixel");
 };
 
 } // namespace rdl2
@@ -0,0 +1,442 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "SharedSceneSnapshot.h"
+
+#include "BinaryWriter.h"
+#include "SceneContext.h"
+
+#include <scene_rdl2/common/except/exceptions.h>
+#include <scene_rdl2/common/rec_time/RecScopeProfiler.h>
+#include <scene_rdl2/render/util/Strings.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'R', 'D', 'L', '2', 'S', 'N', 'A', 'P'};
+const char POINTER_MAGIC[8] = {'R', 'D', 'L', '2', 'S', 'P', 'T', 'R'};
+const uint32_t SNAPSHOT_VERSION = 2;
+
+// A reader which finds the data segment already replaced by a republish
+// reads the pointer again. Only a publisher which republishes faster than the
+// reader opens a segment can run out of attempts.
+const int OPEN_ATTEMPTS = 16;
+
+uint64_t
+align8(uint64_t offset)
+{
+    return (offset + 7) & ~uint64_t(7);
+}
+
+} // namespace
+
+// All offsets are from the start of the segment.
+struct SharedSceneSnapshot::Header
+{
+    char mMagic[8];
+    uint32_t mVersion;
+    uint32_t mComplete;      // set last by publish()
+    uint64_t mSegmentSize;
+    uint64_t mObjectCount;
+    uint64_t mIndexOffset;   // IndexEntry[mObjectCount], in record order
+    uint64_t mSortedOffset;  // uint64_t[mObjectCount], index ids sorted by object name
+    uint64_t mStringsOffset; // class and object names
+    uint64_t mRecordsOffset; // SceneObject records, back to back
+};
+
+// The segment under the snapshot name itself. It only holds the generation
+// of the current data segment, which is switched atomically by publish().
+struct SharedSceneSnapshot::Pointer
+{
+    char mMagic[8];
+    uint64_t mGeneration; // 0 : no data segment
+};
+
+struct SharedSceneSnapshot::IndexEntry
+{
+    uint64_t mClassNameOffset;
+    uint64_t mObjectNameOffset;
+    uint64_t mRecordOffset;
+    uint64_t mRecordSize;
+    uint32_t mClassNameLength;
+    uint32_t mObjectNameLength;
+};
+
+SharedSceneSnapshot::SharedSceneSnapshot(const std::string& name) :
+    mData(nullptr),
+    mSize(0)
+{
+    const std::string segmentName = shmName(name);
+
+    // Follow the pointer to the current data segment. If a republish unlinks
+    // it before we open it, the pointer has been switched already.
+    int fd = -1;
+    std::string dataName;
+    for (int attempt = 0; fd == -1; ++attempt) {
+        dataName = dataSegmentName(segmentName, readGeneration(segmentName));
+        fd = shm_open(dataName.c_str(), O_RDONLY, 0);
+        const int err = errno;
+        if (fd == -1 && (err != ENOENT || attempt + 1 >= OPEN_ATTEMPTS)) {
+            throw except::IoError(util::buildString("Failed to open scene snapshot '", dataName, "': ",
+                                                    std::strerror(err)));
+        }
+    }
+
+    struct stat statBuf;
+    if (fstat(fd, &statBuf) == -1) {
+        const int err = errno;
+        close(fd);
+        throw except::IoError(util::buildString("Failed to stat scene snapshot '", dataName, "': ",
+                                                std::strerror(err)));
+    }
+    if (static_cast<size_t>(statBuf.st_size) < sizeof(Header)) {
+        close(fd);
+        throw except::RuntimeError(util::buildString("Scene snapshot '", dataName, "' is not complete."));
+    }
+
+    void* addr = mmap(nullptr, statBuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    const int err = errno;
+    close(fd); // the mapping keeps the segment
+    if (addr == MAP_FAILED) {
+        throw except::IoError(util::buildString("Failed to map scene snapshot '", dataName, "': ",
+                                                std::strerror(err)));
+    }
+    mData = static_cast<const char*>(addr);
+    mSize = statBuf.st_size;
+
+    const Header& header = getHeader();
+    const uint64_t objectCount = header.mObjectCount;
+    const bool valid =
+        std::memcmp(header.mMagic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 &&
+        header.mVersion == SNAPSHOT_VERSION &&
+        __atomic_load_n(&header.mComplete, __ATOMIC_ACQUIRE) == 1 &&
+        header.mSegmentSize == mSize &&
+        header.mIndexOffset + objectCount * sizeof(IndexEntry) <= mSize &&
+        header.mSortedOffset + objectCount * sizeof(uint64_t) <= mSize &&
+        header.mStringsOffset <= mSize &&
+        header.mRecordsOffset <= mSize;
+    if (!valid) {
+        munmap(const_cast<char*>(mData), mSize);
+        throw except::RuntimeError(util::buildString("Scene snapshot '", dataName,
+                                                     "' is not a complete version ", SNAPSHOT_VERSION,
+                                                     " snapshot."));
+    }
+}
+
+SharedSceneSnapshot::~SharedSceneSnapshot()
+{
+    if (mData) {
+        munmap(const_cast<char*>(mData), mSize);
+    }
+}
+
+// static function
+size_t
+SharedSceneSnapshot::publish(const SceneContext& context, const std::string& name)
+{
+    REC_SCOPE_PROFILE("SharedSceneSnapshot::publish");
+
+    // Full (non delta) encoding of every SceneObject.
+    std::string manifest;
+    std::string payload;
+    BinaryWriter writer(context);
+    writer.setDeltaEncoding(false);
+    writer.toBytes(manifest, payload);
+
+    std::vector<Slice> records;
+    BinaryReader::splitRecords(manifest, payload, records);
+    const uint64_t objectCount = records.size();
+
+    // Lay out the names. Class names are shared by all their objects.
+    std::vector<IndexEntry> index(objectCount);
+    std::vector<std::string> objectNames(objectCount);
+    std::map<std::string, uint64_t> classNameOffsets;
+    std::string strings;
+    for (uint64_t i = 0; i < objectCount; ++i) {
+        std::string className;
+        BinaryReader::readRecordNames(records[i], className, objectNames[i]);
+
+        auto result = classNameOffsets.emplace(className, strings.size());
+        if (result.second) strings += className;
+        index[i].mClassNameOffset = result.first->second;
+        index[i].mClassNameLength = className.size();
+        index[i].mObjectNameOffset = strings.size();
+        index[i].mObjectNameLength = objectNames[i].size();
+        strings += objectNames[i];
+
+        index[i].mRecordOffset = static_cast<const char*>(records[i].getData()) - payload.data();
+        index[i].mRecordSize = records[i].getLength();
+    }
+
+    std::vector<uint64_t> sorted(objectCount);
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::sort(sorted.begin(), sorted.end(),
+              [&](uint64_t a, uint64_t b) { return objectNames[a] < objectNames[b]; });
+
+    Header header;
+    std::memcpy(header.mMagic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.mVersion = SNAPSHOT_VERSION;
+    header.mComplete = 0;
+    header.mObjectCount = objectCount;
+    header.mIndexOffset = align8(sizeof(Header));
+    header.mSortedOffset = align8(header.mIndexOffset + objectCount * sizeof(IndexEntry));
+    header.mStringsOffset = align8(header.mSortedOffset + objectCount * sizeof(uint64_t));
+    header.mRecordsOffset = align8(header.mStringsOffset + strings.size());
+    header.mSegmentSize = header.mRecordsOffset + payload.size();
+
+    for (IndexEntry& entry : index) {
+        entry.mClassNameOffset += header.mStringsOffset;
+        entry.mObjectNameOffset += header.mStringsOffset;
+        entry.mRecordOffset += header.mRecordsOffset;
+    }
+
+    // The snapshot is written to a new data segment of the next generation,
+    // then the pointer is switched to it. Readers open either the previous or
+    // the new data segment, never a partially written one. Processes which
+    // mapped the previous one keep it until they unmap it.
+    const std::string segmentName = shmName(name);
+    Pointer* pointer = mapPointer(segmentName);
+    const uint64_t prevGeneration = __atomic_load_n(&pointer->mGeneration, __ATOMIC_ACQUIRE);
+    const uint64_t generation = prevGeneration + 1;
+    const std::string dataName = dataSegmentName(segmentName, generation);
+
+    shm_unlink(dataName.c_str()); // leftover of a publisher which died
+    const int fd = shm_open(dataName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1) {
+        const int err = errno;
+        munmap(pointer, sizeof(Pointer));
+        throw except::IoError(util::buildString("Failed to create scene snapshot '", dataName, "': ",
+                                                std::strerror(err)));
+    }
+    if (ftruncate(fd, header.mSegmentSize) == -1) {
+        const int err = errno;
+        close(fd);
+        shm_unlink(dataName.c_str());
+        munmap(pointer, sizeof(Pointer));
+        throw except::IoError(util::buildString("Failed to size scene snapshot '", dataName, "' to ",
+                                                header.mSegmentSize, " bytes: ", std::strerror(err)));
+    }
+    void* addr = mmap(nullptr, header.mSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int err = errno;
+    close(fd);
+    if (addr == MAP_FAILED) {
+        shm_unlink(dataName.c_str());
+        munmap(pointer, sizeof(Pointer));
+        throw except::IoError(util::buildString("Failed to map scene snapshot '", dataName, "': ",
+                                                std::strerror(err)));
+    }
+
+    char* data = static_cast<char*>(addr);
+    std::memcpy(data, &header, sizeof(Header));
+    std::memcpy(data + header.mIndexOffset, index.data(), objectCount * sizeof(IndexEntry));
+    std::memcpy(data + header.mSortedOffset, sorted.data(), objectCount * sizeof(uint64_t));
+    std::memcpy(data + header.mStringsOffset, strings.data(), strings.size());
+    std::memcpy(data + header.mRecordsOffset, payload.data(), payload.size());
+
+    // Readers check this flag before using anything else.
+    __atomic_store_n(&reinterpret_cast<Header*>(data)->mComplete, uint32_t(1), __ATOMIC_RELEASE);
+    munmap(addr, header.mSegmentSize);
+
+    __atomic_store_n(&pointer->mGeneration, generation, __ATOMIC_RELEASE);
+    munmap(pointer, sizeof(Pointer));
+    if (prevGeneration) {
+        shm_unlink(dataSegmentName(segmentName, prevGeneration).c_str());
+    }
+
+    return header.mSegmentSize;
+}
+
+// static function
+bool
+SharedSceneSnapshot::unpublish(const std::string& name)
+{
+    const std::string segmentName = shmName(name);
+    uint64_t generation = 0;
+    try {
+        generation = readGeneration(segmentName);
+    } catch (const except::IoError&) {
+        return false;
+    }
+    shm_unlink(segmentName.c_str());
+    shm_unlink(dataSegmentName(segmentName, generation).c_str());
+    return true;
+}
+
+std::size_t
+SharedSceneSnapshot::getObjectCount() const
+{
+    return getHeader().mObjectCount;
+}
+
+bool
+SharedSceneSnapshot::findObject(const std::string& objectName, ObjectRecord& object) const
+{
+    const IndexEntry* index = getIndex();
+    const uint64_t* sortedBegin = reinterpret_cast<const uint64_t*>(mData + getHeader().mSortedOffset);
+    const uint64_t* sortedEnd = sortedBegin + getObjectCount();
+
+    auto compareName = [&](const IndexEntry& entry) {
+        const size_t length = std::min<size_t>(entry.mObjectNameLength, objectName.size());
+        const int result = std::memcmp(mData + entry.mObjectNameOffset, objectName.data(), length);
+        if (result) return result;
+        return (entry.mObjectNameLength < objectName.size()) ? -1 :
+               (entry.mObjectNameLength > objectName.size()) ? 1 : 0;
+    };
+
+    const uint64_t* itr = std::lower_bound(sortedBegin, sortedEnd, objectName,
+                                           [&](uint64_t id, const std::string&) {
+                                               return compareName(index[id]) < 0;
+                                           });
+    if (itr == sortedEnd || compareName(index[*itr]) != 0) {
+        return false;
+    }
+    toObjectRecord(index[*itr], object);
+    return true;
+}
+
+void
+SharedSceneSnapshot::forEachObject(const ObjectCallback& callback) const
+{
+    const IndexEntry* index = getIndex();
+    ObjectRecord object;
+    for (std::size_t i = 0; i < getObjectCount(); ++i) {
+        toObjectRecord(index[i], object);
+        callback(object);
+    }
+}
+
+std::size_t
+SharedSceneSnapshot::populate(SceneContext& context, const BinaryReader::RecordFilter& filter) const
+{
+    REC_SCOPE_PROFILE("SharedSceneSnapshot::populate");
+
+    BinaryReader reader(context);
+    std::size_t total = 0;
+    forEachObject([&](const ObjectRecord& object) {
+        if (filter && !filter(object.mClassName, object.mObjectName)) return;
+        reader.fromRecord(object.getRecord());
+        ++total;
+    });
+    return total;
+}
+
+const SharedSceneSnapshot::Header&
+SharedSceneSnapshot::getHeader() const
+{
+    return *reinterpret_cast<const Header*>(mData);
+}
+
+const SharedSceneSnapshot::IndexEntry*
+SharedSceneSnapshot::getIndex() const
+{
+    return reinterpret_cast<const IndexEntry*>(mData + getHeader().mIndexOffset);
+}
+
+void
+SharedSceneSnapshot::toObjectRecord(const IndexEntry& entry, ObjectRecord& object) const
+{
+    object.mClassName.assign(mData + entry.mClassNameOffset, entry.mClassNameLength);
+    object.mObjectName.assign(mData + entry.mObjectNameOffset, entry.mObjectNameLength);
+    object.mRecordData = mData + entry.mRecordOffset;
+    object.mRecordSize = entry.mRecordSize;
+}
+
+// static function
+std::string
+SharedSceneSnapshot::shmName(const std::string& name)
+{
+    return (!name.empty() && name[0] == '/') ? name : '/' + name;
+}
+
+// static function
+std::string
+SharedSceneSnapshot::dataSegmentName(const std::string& segmentName, uint64_t generation)
+{
+    return util::buildString(segmentName, '.', generation);
+}
+
+// static function
+uint64_t
+SharedSceneSnapshot::readGeneration(const std::string& segmentName)
+{
+    const int fd = shm_open(segmentName.c_str(), O_RDONLY, 0);
+    if (fd == -1) {
+        throw except::IoError(util::buildString("Failed to open scene snapshot '", segmentName, "': ",
+                                                std::strerror(errno)));
+    }
+    struct stat statBuf;
+    void* addr = MAP_FAILED;
+    if (fstat(fd, &statBuf) == 0 && statBuf.st_size == sizeof(Pointer)) {
+        addr = mmap(nullptr, sizeof(Pointer), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+        throw except::IoError(util::buildString("Scene snapshot '", segmentName,
+                                                "' is not a version ", SNAPSHOT_VERSION, " snapshot."));
+    }
+
+    const Pointer* pointer = static_cast<const Pointer*>(addr);
+    const bool valid = std::memcmp(pointer->mMagic, POINTER_MAGIC, sizeof(POINTER_MAGIC)) == 0;
+    const uint64_t generation = __atomic_load_n(&pointer->mGeneration, __ATOMIC_ACQUIRE);
+    munmap(addr, sizeof(Pointer));
+    if (!valid || !generation) {
+        throw except::IoError(util::buildString("Scene snapshot '", segmentName, "' is not published."));
+    }
+    return generation;
+}
+
+// static function
+SharedSceneSnapshot::Pointer*
+SharedSceneSnapshot::mapPointer(const std::string& segmentName)
+{
+    // Creates the pointer segment on the first publish. A segment of another
+    // size is a snapshot of the previous version, which can't be switched.
+    int fd = shm_open(segmentName.c_str(), O_CREAT | O_RDWR, 0644);
+    struct stat statBuf;
+    if (fd != -1 && fstat(fd, &statBuf) == 0 &&
+        statBuf.st_size != 0 && statBuf.st_size != sizeof(Pointer)) {
+        close(fd);
+        shm_unlink(segmentName.c_str());
+        fd = shm_open(segmentName.c_str(), O_CREAT | O_RDWR, 0644);
+    }
+    if (fd == -1) {
+        throw except::IoError(util::buildString("Failed to create scene snapshot '", segmentName, "': ",
+                                                std::strerror(errno)));
+    }
+    void* addr = MAP_FAILED;
+    if (ftruncate(fd, sizeof(Pointer)) == 0) { // zero filled when created
+        addr = mmap(nullptr, sizeof(Pointer), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int err = errno;
+    close(fd);
+    if (addr == MAP_FAILED) {
+        throw except::IoError(util::buildString("Failed to map scene snapshot '", segmentName, "': ",
+                                                std::strerror(err)));
+    }
+
+    Pointer* pointer = static_cast<Pointer*>(addr);
+    if (std::memcmp(pointer->mMagic, POINTER_MAGIC, sizeof(POINTER_MAGIC)) != 0) {
+        std::memcpy(pointer->mMagic, POINTER_MAGIC, sizeof(POINTER_MAGIC));
+        __atomic_store_n(&pointer->mGeneration, uint64_t(0), __ATOMIC_RELEASE);
+    }
+    return pointer;
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,160 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include "BinaryReader.h"
+#include "Slice.h"
+#include "Types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+/**
+ * A SharedSceneSnapshot is a read-only view of a SceneContext published in a
+ * POSIX shared memory segment. It lets several processes on the same node
+ * (render, merge, dispatch, ...) share one copy of the scene instead of each
+ * of them reading and parsing the same rdlb.
+ *
+ * publish() encodes the SceneContext once and lays it out in the segment:
+ *
+ *   - a header (magic, version, sizes),
+ *   - an index of every SceneObject, sorted by name,
+ *   - the SceneClass and SceneObject names,
+ *   - the SceneObject records, in the BinaryWriter binary format.
+ *
+ * Everything in the segment refers to everything else by offsets from the
+ * start of the segment, so it can be mapped at any address. Attribute values,
+ * vectors and bindings are kept inside the records exactly as BinaryWriter
+ * encoded them (bindings and SceneObject references by class and object
+ * name).
+ *
+ * Opening a snapshot only maps the segment and checks its header. Listing
+ * the SceneObjects, looking them up by name and getting their records don't
+ * decode anything. SceneObjects themselves are created by their DSO in
+ * process private memory, so a SceneContext can't point into the segment;
+ * populate() decodes the records it needs straight from the mapping, with no
+ * file IO and no copy of the bytes, optionally filtered so each process only
+ * pays for the objects it uses.
+ *
+ * The segment outlives the publishing process. The segment under the
+ * snapshot name only points to the data segment of the current generation
+ * (name.1, name.2, ...). Republishing writes the next generation completely,
+ * switches the pointer atomically and removes the previous data segment, so
+ * a process which opens the snapshot meanwhile gets either the previous or
+ * the new one, while processes which already mapped the previous one keep a
+ * valid view of it. Publishing the same name from several processes at the
+ * same time is not supported. Call unpublish() to remove it.
+ */
+class SharedSceneSnapshot
+{
+public:
+    /**
+     * One SceneObject of the snapshot. The record points into the mapping and
+     * is only valid as long as the SharedSceneSnapshot is alive.
+     */
+    struct ObjectRecord
+    {
+        Slice getRecord() const { return Slice(mRecordData, mRecordSize); }
+
+        std::string mClassName;
+        std::string mObjectName;
+        const void* mRecordData {nullptr};
+        std::size_t mRecordSize {0};
+    };
+
+    typedef std::function<void(const ObjectRecord& object)> ObjectCallback;
+
+    /**
+     * Maps the published snapshot read-only.
+     *
+     * @param   name    Name of the snapshot, as given to publish().
+     * @throw   except::IoError     If there is no such segment or it can't be
+     *                              mapped.
+     * @throw   except::RuntimeError If the segment is not a complete snapshot
+     *                              of this version.
+     */
+    explicit SharedSceneSnapshot(const std::string& name);
+    ~SharedSceneSnapshot();
+
+    SharedSceneSnapshot(const SharedSceneSnapshot&) = delete;
+    SharedSceneSnapshot& operator=(const SharedSceneSnapshot&) = delete;
+
+    /**
+     * Encodes the SceneContext and publishes it in a new shared memory
+     * segment under the given name, replacing any previous one.
+     *
+     * @param   context     The SceneContext to publish.
+     * @param   name        Name of the snapshot. A leading '/' is added if
+     *                      missing, it must not contain any other '/'.
+     * @return  The size of the segment in bytes.
+     * @throw   except::IoError     If the segment can't be created.
+     */
+    static size_t publish(const SceneContext& context, const std::string& name);
+
+    /**
+     * Removes the published snapshot. Processes which mapped it keep their
+     * view until they release it.
+     *
+     * @return  False if there was no such snapshot.
+     */
+    static bool unpublish(const std::string& name);
+
+    std::size_t getSegmentSize() const { return mSize; }
+    std::size_t getObjectCount() const;
+
+    /**
+     * Looks up a SceneObject by name (binary search of the index, nothing is
+     * decoded).
+     *
+     * @return  False if there is no such SceneObject.
+     */
+    bool findObject(const std::string& objectName, ObjectRecord& object) const;
+
+    /**
+     * Calls the callback for every SceneObject, in the order populate()
+     * decodes them.
+     */
+    void forEachObject(const ObjectCallback& callback) const;
+
+    /**
+     * Decodes the SceneObjects of the snapshot into the SceneContext, like
+     * BinaryReader would from the equivalent rdlb.
+     *
+     * @param   context     The SceneContext to populate.
+     * @param   filter      Returns true for the SceneObjects to decode. May be
+     *                      empty to decode them all. Objects referenced by
+     *                      decoded ones are still created (with their default
+     *                      values) if they were filtered out.
+     * @return  The number of decoded SceneObjects.
+     */
+    std::size_t populate(SceneContext& context,
+                         const BinaryReader::RecordFilter& filter = nullptr) const;
+
+private:
+    struct Header;
+    struct Pointer;
+    struct IndexEntry;
+
+    const Header& getHeader() const;
+    const IndexEntry* getIndex() const;
+    void toObjectRecord(const IndexEntry& entry, ObjectRecord& object) const;
+
+    static std::string shmName(const std::string& name);
+    static std::string dataSegmentName(const std::string& segmentName, uint64_t generation);
+    static uint64_t readGeneration(const std::string& segmentName); // throws except::IoError
+    static Pointer* mapPointer(const std::string& segmentName);     // creates it if needed
+
+    const char* mData;
+    std::size_t mSize;
+};
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
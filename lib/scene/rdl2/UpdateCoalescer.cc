@@ -0,0 +1,313 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "UpdateCoalescer.h"
+
+#include "BinaryReader.h"
+#include "Slice.h"
+#include "ValueContainerDeq.h"
+#include "ValueContainerEnq.h"
+#include "ValueContainerUtil.h"
+
+#include <scene_rdl2/common/except/exceptions.h>
+#include <scene_rdl2/common/rec_time/RecScopeProfiler.h>
+#include <scene_rdl2/render/util/Strings.h>
+
+#include <utility>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+namespace {
+
+typedef ValueContainerUtil::ValueType ValueType;
+
+// Attributes and bindings encoded by index can't clash with names.
+std::string
+indexKey(int attributeId)
+{
+    return std::string(1, '\0') + std::to_string(attributeId);
+}
+
+// Size of the elements of the vector types which support changed element
+// ranges.
+std::size_t
+rangeElementSize(ValueType valueType)
+{
+    switch (valueType) {
+    case ValueType::INT_VECTOR :    return sizeof(Int);
+    case ValueType::LONG_VECTOR :   return sizeof(Long);
+    case ValueType::FLOAT_VECTOR :  return sizeof(Float);
+    case ValueType::DOUBLE_VECTOR : return sizeof(Double);
+    case ValueType::RGB_VECTOR :    return sizeof(Rgb);
+    case ValueType::RGBA_VECTOR :   return sizeof(Rgba);
+    case ValueType::VEC2F_VECTOR :  return sizeof(Vec2f);
+    case ValueType::VEC2D_VECTOR :  return sizeof(Vec2d);
+    case ValueType::VEC3F_VECTOR :  return sizeof(Vec3f);
+    case ValueType::VEC3D_VECTOR :  return sizeof(Vec3d);
+    case ValueType::VEC4F_VECTOR :  return sizeof(Vec4f);
+    case ValueType::VEC4D_VECTOR :  return sizeof(Vec4d);
+    case ValueType::MAT4F_VECTOR :  return sizeof(Mat4f);
+    case ValueType::MAT4D_VECTOR :  return sizeof(Mat4d);
+    default :
+        throw except::TypeError(util::buildString("Value type '", ValueContainerUtil::valueType2Str(valueType),
+                                                  "' doesn't support changed element ranges."));
+    }
+}
+
+// Steps over one value as BinaryWriter::packValue() encodes it (after its
+// timestep).
+void
+skipValue(ValueContainerDeq& vContainerDeq, ValueType valueType)
+{
+    switch (valueType) {
+    case ValueType::BOOL :          vContainerDeq.deqBool(); break;
+    case ValueType::BOOL_VECTOR :   vContainerDeq.deqBoolVector(); break;
+    case ValueType::INT :           vContainerDeq.deqInt(); break;
+    case ValueType::INT_VECTOR :    vContainerDeq.deqVLIntVector(); break;
+    case ValueType::LONG :          vContainerDeq.deqLong(); break;
+    case ValueType::LONG_VECTOR :   vContainerDeq.deqVLLongVector(); break;
+    case ValueType::FLOAT :         vContainerDeq.deqFloat(); break;
+    case ValueType::FLOAT_VECTOR :  vContainerDeq.deqFloatVector(); break;
+    case ValueType::DOUBLE :        vContainerDeq.deqDouble(); break;
+    case ValueType::DOUBLE_VECTOR : vContainerDeq.deqDoubleVector(); break;
+    case ValueType::STRING :        vContainerDeq.skipString(); break;
+    case ValueType::STRING_VECTOR : vContainerDeq.deqStringVector(); break;
+    case ValueType::RGB :           vContainerDeq.deqRgb(); break;
+    case ValueType::RGB_VECTOR :    vContainerDeq.deqRgbVector(); break;
+    case ValueType::RGBA :          vContainerDeq.deqRgba(); break;
+    case ValueType::RGBA_VECTOR :   vContainerDeq.deqRgbaVector(); break;
+    case ValueType::VEC2F :         vContainerDeq.deqVec2f(); break;
+    case ValueType::VEC2F_VECTOR :  vContainerDeq.deqVec2fVector(); break;
+    case ValueType::VEC2D :         vContainerDeq.deqVec2d(); break;
+    case ValueType::VEC2D_VECTOR :  vContainerDeq.deqVec2dVector(); break;
+    case ValueType::VEC3F :         vContainerDeq.deqVec3f(); break;
+    case ValueType::VEC3F_VECTOR :  vContainerDeq.deqVec3fVector(); break;
+    case ValueType::VEC3D :         vContainerDeq.deqVec3d(); break;
+    case ValueType::VEC3D_VECTOR :  vContainerDeq.deqVec3dVector(); break;
+    case ValueType::VEC4F :         vContainerDeq.deqVec4f(); break;
+    case ValueType::VEC4F_VECTOR :  vContainerDeq.deqVec4fVector(); break;
+    case ValueType::VEC4D :         vContainerDeq.deqVec4d(); break;
+    case ValueType::VEC4D_VECTOR :  vContainerDeq.deqVec4dVector(); break;
+    case ValueType::MAT4F :         vContainerDeq.deqMat4f(); break;
+    case ValueType::MAT4F_VECTOR :  vContainerDeq.deqMat4fVector(); break;
+    case ValueType::MAT4D :         vContainerDeq.deqMat4d(); break;
+    case ValueType::MAT4D_VECTOR :  vContainerDeq.deqMat4dVector(); break;
+    case ValueType::SCENE_OBJECT : {
+        std::string klassName, objName;
+        vContainerDeq.deqSceneObject(klassName, objName);
+    } break;
+    case ValueType::SCENE_OBJECT_VECTOR : {
+        StringVector klassNameVec, objNameVec;
+        vContainerDeq.deqSceneObjectVector(klassNameVec, objNameVec);
+    } break;
+    case ValueType::SCENE_OBJECT_INDEXABLE : {
+        StringVector klassNameVec, objNameVec;
+        vContainerDeq.deqSceneObjectIndexable(klassNameVec, objNameVec);
+    } break;
+    default :
+        throw except::TypeError(util::buildString("Encountered unknown value type ",
+                                                  static_cast<int>(valueType), " while coalescing updates."));
+    }
+}
+
+} // namespace
+
+UpdateCoalescer::UpdateCoalescer() :
+    mQueuedCount(0),
+    mElidedCount(0),
+    mTotalDeltaCount(0),
+    mTotalElidedCount(0)
+{
+}
+
+void
+UpdateCoalescer::push(const std::string& manifest, const std::string& payload)
+{
+    REC_SCOPE_PROFILE("UpdateCoalescer::push");
+
+    std::vector<Slice> records;
+    BinaryReader::splitRecords(manifest, payload, records);
+    for (const Slice& record : records) {
+        mergeRecord(record);
+    }
+    ++mQueuedCount;
+    ++mTotalDeltaCount;
+}
+
+std::size_t
+UpdateCoalescer::toBytes(std::string& manifest, std::string& payload)
+{
+    REC_SCOPE_PROFILE("UpdateCoalescer::toBytes");
+
+    manifest.clear();
+    payload.clear();
+
+    std::vector<std::size_t> recordSizes;
+    for (const ObjectUpdates& object : mObjects) {
+        if (!object.mRecords.empty()) {
+            for (const std::string& record : object.mRecords) {
+                payload += record;
+                recordSizes.push_back(record.size());
+            }
+        } else {
+            recordSizes.push_back(writeRecord(object, payload));
+        }
+    }
+
+    // Same manifest as BinaryWriter writes.
+    ValueContainerEnq vContainerEnq(&manifest);
+    vContainerEnq.enqVLSizeT(recordSizes.size());
+    for (std::size_t size : recordSizes) {
+        vContainerEnq.enqVLUInt(static_cast<unsigned int>(BinaryReader::SCENE_OBJECT_2));
+        vContainerEnq.enqVLSizeT(size);
+    }
+    vContainerEnq.finalize();
+
+    const std::size_t elided = mElidedCount;
+    mTotalElidedCount += elided;
+    clear();
+    return elided;
+}
+
+std::size_t
+UpdateCoalescer::apply(BinaryReader& reader)
+{
+    if (empty()) {
+        clear();
+        return 0;
+    }
+
+    std::string manifest;
+    std::string payload;
+    const std::size_t elided = toBytes(manifest, payload);
+    reader.fromBytes(manifest, payload);
+    return elided;
+}
+
+void
+UpdateCoalescer::clear()
+{
+    mObjects.clear();
+    mObjectIndex.clear();
+    mQueuedCount = 0;
+    mElidedCount = 0;
+}
+
+void
+UpdateCoalescer::mergeRecord(const Slice& record)
+{
+    const char* data = static_cast<const char*>(record.getData());
+    ValueContainerDeq vContainerDeq(data, record.getLength());
+    auto position = [&vContainerDeq]() { return vContainerDeq.getDataSize() - vContainerDeq.getRestSize(); };
+
+    std::string className;
+    std::string objectName;
+    vContainerDeq.deqString(className);
+    vContainerDeq.deqString(objectName);
+
+    auto result = mObjectIndex.emplace(objectName, mObjects.size());
+    if (result.second) {
+        mObjects.emplace_back();
+        mObjects.back().mClassName = className;
+        mObjects.back().mObjectName = objectName;
+    }
+    ObjectUpdates& object = mObjects[result.first->second];
+
+    // Decoding a Layer record appends to its assignments, so Layer records
+    // can't be merged.
+    if (className == "Layer") {
+        object.mRecords.emplace_back(data, record.getLength());
+        return;
+    }
+
+    // Attribute values, see BinaryWriter::packSceneObject().
+    while (true) {
+        const std::size_t begin = position();
+        ValueType valueType;
+        vContainerDeq.deqAttributeType(valueType);
+        if (valueType == ValueType::UNKNOWN) break;
+
+        const std::string key = vContainerDeq.deqBool() ? indexKey(vContainerDeq.deqInt())
+                                                        : vContainerDeq.deqString();
+        const int timeMax = vContainerDeq.deqUChar();
+        bool hasRanges = false;
+        for (int timestep = 0; timestep <= timeMax; ++timestep) {
+            const unsigned char uc = vContainerDeq.deqUChar();
+            if (uc & ValueContainerUtil::timestepRangesFlag) {
+                hasRanges = true;
+                const std::size_t elementSize = rangeElementSize(valueType);
+                vContainerDeq.deqVLSizeT(); // vector size
+                const std::size_t rangeCount = vContainerDeq.deqVLSizeT();
+                for (std::size_t i = 0; i < rangeCount; ++i) {
+                    vContainerDeq.deqVLSizeT(); // offset
+                    vContainerDeq.skipByteData(vContainerDeq.deqVLSizeT() * elementSize);
+                }
+            } else {
+                skipValue(vContainerDeq, valueType);
+            }
+        }
+
+        // A whole value replaces everything before it, changed element
+        // ranges patch it.
+        std::vector<std::size_t>& indices = object.mValueIndex[key];
+        if (!hasRanges) {
+            for (std::size_t index : indices) {
+                Entry& elided = object.mValues[index];
+                elided.mValid = false;
+                std::string().swap(elided.mBytes);
+                ++mElidedCount;
+            }
+            indices.clear();
+        }
+        indices.push_back(object.mValues.size());
+        object.mValues.push_back(Entry {std::string(data + begin, position() - begin), true});
+    }
+
+    // Bindings.
+    while (true) {
+        const std::size_t begin = position();
+        if (!vContainerDeq.deqBool()) break;
+
+        const std::string key = vContainerDeq.deqBool() ? indexKey(vContainerDeq.deqInt())
+                                                        : vContainerDeq.deqString();
+        vContainerDeq.skipString(); // target SceneClass
+        vContainerDeq.skipString(); // target SceneObject
+
+        auto binding = object.mBindingIndex.emplace(key, object.mBindings.size());
+        if (!binding.second) {
+            Entry& elided = object.mBindings[binding.first->second];
+            elided.mValid = false;
+            std::string().swap(elided.mBytes);
+            ++mElidedCount;
+            binding.first->second = object.mBindings.size();
+        }
+        object.mBindings.push_back(Entry {std::string(data + begin, position() - begin), true});
+    }
+}
+
+std::size_t
+UpdateCoalescer::writeRecord(const ObjectUpdates& object, std::string& payload) const
+{
+    ValueContainerEnq vContainerEnq(&payload);
+    vContainerEnq.enqString(object.mClassName);
+    vContainerEnq.enqString(object.mObjectName);
+    for (const Entry& entry : object.mValues) {
+        if (entry.mValid) {
+            vContainerEnq.enqByteData(entry.mBytes.data(), entry.mBytes.size());
+        }
+    }
+    vContainerEnq.enqAttributeType(AttributeType::TYPE_UNKNOWN); // end marker
+    for (const Entry& entry : object.mBindings) {
+        if (entry.mValid) {
+            vContainerEnq.enqByteData(entry.mBytes.data(), entry.mBytes.size());
+        }
+    }
+    vContainerEnq.enqBool(false); // end marker
+    return vContainerEnq.finalize();
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,122 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+class BinaryReader;
+class Slice;
+
+/**
+ * An UpdateCoalescer merges a queue of BinaryWriter deltas into a single
+ * delta, so a burst of small updates (camera scrubs, slider drags, ...) is
+ * decoded and run through SceneContext::applyUpdates() once instead of once
+ * per delta.
+ *
+ * Each queued delta is split into its SceneObject records, and each record
+ * into its attribute values and bindings, without decoding any of them.
+ * Records of the same SceneObject are merged into one:
+ *
+ *   - attribute values are last-writer-wins: a value replaces every earlier
+ *     value of the same attribute, which is then elided. Changed element
+ *     ranges (see SceneObject::setRange()) patch the value before them, so
+ *     they are kept, in order, until a whole value replaces them.
+ *   - bindings are last-writer-wins too, and applied in the order of their
+ *     last change, after all the attribute values, like in any delta.
+ *
+ * Attributes are matched by how they were encoded (by name, or by index with
+ * transient encoding), so a client should stick to one encoding.
+ *
+ * Layer records are never merged: decoding one appends its assignments to the
+ * Layer, so they are kept as they are, in order.
+ *
+ * Decoding the merged delta leaves the SceneContext in the same state as
+ * decoding the queued deltas one after the other.
+ */
+class UpdateCoalescer
+{
+public:
+    UpdateCoalescer();
+
+    /**
+     * Queues a delta, as given by BinaryWriter::toBytes(), and merges it with
+     * the deltas already queued. The bytes are copied.
+     *
+     * @param   manifest    Byte string containing the manifest data.
+     * @param   payload     Byte string containing the payload data.
+     * @throw   except::TypeError   If the manifest has an unsupported record
+     *                              type or a record has an unknown value type.
+     */
+    void push(const std::string& manifest, const std::string& payload);
+
+    bool empty() const { return mObjects.empty(); }
+
+    /// Number of deltas queued since the last flush.
+    std::size_t getQueuedCount() const { return mQueuedCount; }
+
+    /**
+     * Writes the merged delta, which can be read with BinaryReader::fromBytes(),
+     * and clears the queue.
+     *
+     * @return  The number of attribute values and bindings which were elided
+     *          because a later delta replaced them.
+     */
+    std::size_t toBytes(std::string& manifest, std::string& payload);
+
+    /**
+     * Decodes the merged delta into the SceneContext of the reader and clears
+     * the queue. Does nothing if the queue is empty.
+     *
+     * @return  The number of elided attribute values and bindings.
+     */
+    std::size_t apply(BinaryReader& reader);
+
+    /// Discards the queued deltas.
+    void clear();
+
+    /// Totals since construction.
+    std::size_t getTotalDeltaCount() const { return mTotalDeltaCount; }
+    std::size_t getTotalElidedCount() const { return mTotalElidedCount; }
+
+private:
+    // One attribute value (all its timesteps) or one binding, as encoded.
+    struct Entry
+    {
+        std::string mBytes;
+        bool mValid;
+    };
+
+    struct ObjectUpdates
+    {
+        std::string mClassName;
+        std::string mObjectName;
+        std::vector<Entry> mValues;
+        std::vector<Entry> mBindings;
+        std::unordered_map<std::string, std::vector<std::size_t>> mValueIndex;
+        std::unordered_map<std::string, std::size_t> mBindingIndex;
+        std::vector<std::string> mRecords; // whole records, if never merged
+    };
+
+    void mergeRecord(const Slice& record);
+    std::size_t writeRecord(const ObjectUpdates& object, std::string& payload) const;
+
+    std::vector<ObjectUpdates> mObjects;
+    std::unordered_map<std::string, std::size_t> mObjectIndex; // by SceneObject name
+
+    std::size_t mQueuedCount;
+    std::size_t mElidedCount;
+    std::size_t mTotalDeltaCount;
+    std::size_t mTotalElidedCount;
+};
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -14,26 +14,33 @@
 #include <scene_rdl2/common/platform/Platform.h>
 #include <scene_rdl2/common/except/exceptions.h>
 #include <scene_rdl2/render/util/Files.h>
+#include <scene_rdl2/render/util/LuaStatePool.h>
 #include <scene_rdl2/render/util/Strings.h>
 
+#include <lua.hpp>
+
 #include <algorithm>
 #include <cctype>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <memory>
 #include <set>
+#include <sstream>
 #include <string>
+#include <vector>
 
 namespace {
 
 // maximum size of vector to write to rdla in "split rdla/rdlb mode"
 constexpr int SPLIT_VEC_SIZE = 12;
 
-}
-
-namespace scene_rdl2 {
-namespace rdl2 {
-
-void
-readSceneFromFile(const std::string& filePath, SceneContext& context)
+// Returns true for .rdlb and false for .rdla, throws otherwise.
+bool
+isBinarySceneFile(const std::string& filePath)
 {
+    using namespace scene_rdl2;
+
     // Grab the file extension and convert it to lower case.
     auto ext = util::lowerCaseExtension(filePath);
     if (ext.empty()) {
@@ -43,15 +50,117 @@ readSceneFromFile(const std::string& filePath, SceneContext& context)
     }
 
     if (ext == "rdla") {
+        return false;
+    } else if (ext == "rdlb") {
+        return true;
+    }
+    throw except::RuntimeError(util::buildString(
+            "File '", filePath, "' has an unknown extension."
+            " Cannot determine file type."));
+}
+
+// Contents of a scene file, read ahead of applying it to the SceneContext.
+struct PreloadedSceneFile
+{
+    bool mBinary {false};
+    std::string mCode;                      // rdla
+    std::unique_ptr<std::string> mPayload;  // rdlb. Not moved, mRecords point into it
+    std::vector<scene_rdl2::rdl2::Slice> mRecords; // rdlb SceneObject records in payload order
+};
+
+// Reads the file the same way as AsciiReader::fromFile() and
+// BinaryReader::fromFile(), without touching any SceneContext. For rdlb the
+// manifest is parsed and the payload is split into its records here as well,
+// so only the decode of the records themselves is left. MTsafe.
+PreloadedSceneFile
+preloadSceneFile(const std::string& filePath)
+{
+    using namespace scene_rdl2;
+
+    PreloadedSceneFile file;
+    file.mBinary = isBinarySceneFile(filePath);
+
+    std::ifstream in(filePath.c_str(), std::ios::binary);
+    if (!file.mBinary) {
+        if (!in) {
+            throw except::IoError("Could not open file for reading.");
+        }
+        file.mCode.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+        // Compile the chunk into the LuaChunkCache, so applying the file
+        // only runs it. Compile errors are reported when the file is applied.
+        // Files too large for the cache would only be compiled twice.
+        lua_State* state = (file.mCode.size() <= util::LuaChunkCache::get().getMaxEntryByte()) ?
+            luaL_newstate() : nullptr;
+        if (state) {
+            util::LuaChunkCache::get().load(state, file.mCode, '@' + filePath);
+            lua_close(state);
+        }
+        return file;
+    }
+
+    if (!in) {
+        std::stringstream errMsg;
+        errMsg << "Could not open file '" << filePath << "' for reading with"
+            " an RDL2 binary reader.";
+        throw except::IoError(errMsg.str());
+    }
+
+    std::string manifest;
+    file.mPayload.reset(new std::string);
+    rdl2::BinaryReader::readFramedBytes(in, manifest, *file.mPayload);
+    rdl2::BinaryReader::splitRecords(manifest, *file.mPayload, file.mRecords);
+    return file;
+}
+
+} // namespace
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+void
+readSceneFromFile(const std::string& filePath, SceneContext& context)
+{
+    if (!isBinarySceneFile(filePath)) {
         AsciiReader reader(context);
         reader.fromFile(filePath);
-    } else if (ext == "rdlb") {
+    } else {
         BinaryReader reader(context);
         reader.fromFile(filePath);
-    } else {
-        throw except::RuntimeError(util::buildString(
-                "File '", filePath, "' has an unknown extension."
-                " Cannot determine file type."));
+    }
+}
+
+void
+readScenesFromFiles(const std::vector<std::string>& filePaths, SceneContext& context,
+                    unsigned maxInFlight)
+{
+    maxInFlight = std::max(maxInFlight, 1u);
+
+    // Keep up to maxInFlight files read ahead of the one being applied.
+    std::vector<std::future<PreloadedSceneFile>> preloads(filePaths.size());
+    auto startPreload = [&](size_t id) {
+        if (id < filePaths.size()) {
+            preloads[id] = std::async(std::launch::async, preloadSceneFile, std::cref(filePaths[id]));
+        }
+    };
+    for (size_t id = 0; id < maxInFlight; ++id) {
+        startPreload(id);
+    }
+
+    for (size_t id = 0; id < filePaths.size(); ++id) {
+        PreloadedSceneFile file = preloads[id].get(); // rethrows the preload error
+        startPreload(id + maxInFlight);
+
+        if (!file.mBinary) {
+            AsciiReader reader(context);
+            reader.fromString(file.mCode, '@' + filePaths[id]);
+        } else {
+            // Same as BinaryReader::fromBytes() on the already split records.
+            BinaryReader reader(context);
+            for (const Slice& record : file.mRecords) {
+                reader.fromRecord(record);
+            }
+        }
     }
 }
 
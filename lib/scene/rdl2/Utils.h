@@ -7,6 +7,7 @@
 #include "Types.h"
 
 #include <string>
+#include <vector>
 
 namespace scene_rdl2 {
 namespace rdl2 {
@@ -23,6 +24,39 @@ namespace rdl2 {
 void
 readSceneFromFile(const std::string& filePath, SceneContext& context);
 
+/**
+ * Loads several files into a SceneContext (e.g. a base scene and its
+ * overrides, or a split rdla/rdlb pair), with the same result as calling
+ * readSceneFromFile() on each of them in the given order.
+ *
+ * Up to maxInFlight files ahead are read from disk concurrently. The Lua
+ * chunks of .rdla files are compiled ahead as well, and the manifests of
+ * .rdlb files are parsed and their payloads split into SceneObject records.
+ * The files are applied to the SceneContext by the calling thread in the
+ * given order, so later files override earlier ones exactly as with
+ * sequential loading.
+ *
+ * Only the work which doesn't touch the SceneContext is overlapped. Running
+ * the rdla chunks and decoding the rdlb records (creating the SceneObjects and
+ * setting their attribute values) is still serial on the calling thread, so
+ * for a scene whose load time is dominated by the decode rather than by
+ * reading the files the speedup is small.
+ *
+ * @param   filePaths   The paths to the .rdla or .rdlb files, in load order.
+ * @param   context     The SceneContext to read into.
+ * @param   maxInFlight Max number of files read ahead concurrently.
+ * @throw   except::RuntimeError    If the file type cannot be inferred from
+ *                                  the file extension.
+ * @throw   except::IoError         If a file cannot be opened.
+ *
+ * Errors are reported for the first failing file in the given order. All the
+ * files before it have been applied to the SceneContext at that point. An
+ * .rdlb file with a broken manifest is not applied at all.
+ */
+void
+readScenesFromFiles(const std::vector<std::string>& filePaths, SceneContext& context,
+                    unsigned maxInFlight = 4);
+
 /**
  * Convenience function for easily dumping a SceneContext to a file, with the
  * type of writer inferred from the file extension.
@@ -57,6 +57,10 @@ public:
     static std::string hexDump(const std::string& titleMsg, const void* buff, const size_t size);
     static std::string hexDump(const std::string &hd, const std::string &titleMsg, const void *buff, const size_t size);
 
+    // OR'ed into the timestep of a vector value sent as its changed element
+    // ranges instead of as a whole (see SceneObject::setRange()).
+    static constexpr unsigned char timestepRangesFlag = 0x80;
+
     // 32bit unsigned int              0 ~ 4,294,967,295 -> 1byte ~ 5byte
     // 32bit int          -2,147,483,648 ~ 2,147,483,647 -> 1byte ~ 5byte
     static constexpr size_t variableLengthIntMaxSize = 5;
@@ -90,6 +90,7 @@
 #include "AsciiWriter.h"
 #include "Attribute.h"
 #include "AttributeKey.h"
+#include "AttributeLayout.h"
 #include "BinaryReader.h"
 #include "BinaryWriter.h"
 #include "Camera.h"
@@ -112,6 +113,7 @@
 #include "NormalMap.h"
 #include "Displacement.h"
 #include "Material.h"
+#include "MemoryReport.h"
 #include "Metadata.h"
 #include "Node.h"
 #include "ObjectFactory.h"
@@ -123,9 +125,11 @@
 #include "Shader.h"
 #include "ShadowReceiverSet.h"
 #include "ShadowSet.h"
+#include "SharedSceneSnapshot.h"
 #include "Slice.h"
 #include "TraceSet.h"
 #include "Types.h"
+#include "UpdateCoalescer.h"
 #include "UserData.h"
 #include "Utils.h"
 #include "VolumeShader.h"
@@ -9,6 +9,7 @@
 #include <scene_rdl2/scene/rdl2/Geometry.h>
 #include <scene_rdl2/scene/rdl2/GeometrySet.h>
 #include <scene_rdl2/scene/rdl2/Layer.h>
+#include <scene_rdl2/scene/rdl2/MemoryReport.h>
 #include <scene_rdl2/scene/rdl2/Proxies.h>
 #include <scene_rdl2/scene/rdl2/SceneContext.h>
 using namespace scene_rdl2;
@@ -124,6 +125,47 @@ namespace py_scene_rdl2
         return res;
     }
 
+    bp::list
+    PySceneContext_memoryReportEntries(const rdl2::MemoryReport::EntryVector& entries, std::size_t topCount)
+    {
+        bp::list res;
+        for (std::size_t i = 0; i < std::min(topCount, entries.size()); ++i) {
+            const rdl2::MemoryReport::Entry& entry = entries[i];
+            bp::dict item;
+            item["name"] = entry.mName;
+            item["className"] = entry.mClassName;
+            item["count"] = entry.mCount;
+            item["storageBytes"] = entry.mStorageBytes;
+            item["heapBytes"] = entry.mHeapBytes;
+            item["totalBytes"] = entry.getTotalBytes();
+            res.append(item);
+        }
+
+        return res;
+    }
+
+    bp::dict
+    PySceneContext_getMemoryReport(rdl2::SceneContext& self, std::size_t topCount)
+    {
+        const rdl2::MemoryReport report = self.getMemoryReport();
+
+        bp::dict res;
+        res["storageBytes"] = report.getStorageBytes();
+        res["heapBytes"] = report.getHeapBytes();
+        res["totalBytes"] = report.getTotalBytes();
+        res["classes"] = PySceneContext_memoryReportEntries(report.getClasses(), topCount);
+        res["objects"] = PySceneContext_memoryReportEntries(report.getObjects(), topCount);
+        res["attributes"] = PySceneContext_memoryReportEntries(report.getAttributes(), topCount);
+
+        return res;
+    }
+
+    std::string
+    PySceneContext_showMemoryReport(rdl2::SceneContext& self, std::size_t topCount)
+    {
+        return self.getMemoryReport().show(topCount);
+    }
+
     void
     registerSceneContextPyBinding()
     {
@@ -310,6 +352,20 @@ namespace py_scene_rdl2
                  "           objectName    The name of the object. Must be unique. \n"
                  "Returns the new SceneObject or the existing SceneObject (if the name already existed).")
 
+            .def("getMemoryReport",
+                 &PySceneContext_getMemoryReport,
+                 ( bp::arg("topCount") = 20 ),
+                 "(Python Only) Walks all the SceneObjects and reports the memory held by their attribute "
+                 "values: storage (inline attribute storage) and heap (vector and string capacity) bytes. \n"
+                 "Returns a dictionary with the totals and the 'classes', 'objects' and 'attributes' lists "
+                 "of the topCount biggest entries, each a dictionary of name, className, count, "
+                 "storageBytes, heapBytes and totalBytes.")
+
+            .def("showMemoryReport",
+                 &PySceneContext_showMemoryReport,
+                 ( bp::arg("topCount") = 20 ),
+                 "(Python Only) Same as getMemoryReport(), formatted as a table.")
+
             .def("getGeometryListSize",
                  &PySceneContext_getGeometryListSize,
                  "(Python Only) Returns the number of Geometry objects held by this SceneContext.")
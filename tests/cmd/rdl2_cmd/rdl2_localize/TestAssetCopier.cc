@@ -0,0 +1,334 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "TestAssetCopier.h"
+
+#include <AssetCopier.h>
+
+#include <scene_rdl2/common/except/exceptions.h>
+#include <scene_rdl2/render/util/Files.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace scene_rdl2;
+
+namespace rdl2_localize {
+namespace unittest {
+
+namespace {
+
+std::string
+makeContents(size_t size, unsigned seed)
+{
+    std::string contents(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        contents[i] = static_cast<char>((i * 31 + seed * 7 + (i >> 10)) & 0xff);
+    }
+    return contents;
+}
+
+void
+writeFile(const std::string& path, const std::string& contents, time_t mtime = 1000000000)
+{
+    CPPUNIT_ASSERT(util::writeTest(path, true));
+    {
+        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+        ofs << contents;
+    }
+    struct timespec times[2];
+    times[0].tv_sec = mtime;
+    times[0].tv_nsec = 0;
+    times[1] = times[0];
+    CPPUNIT_ASSERT(utimensat(AT_FDCWD, path.c_str(), times, 0) == 0);
+}
+
+std::string
+readFile(const std::string& path)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+bool
+exists(const std::string& path)
+{
+    return access(path.c_str(), F_OK) == 0;
+}
+
+time_t
+getMtime(const std::string& path)
+{
+    struct stat statBuf;
+    return (stat(path.c_str(), &statBuf) == 0) ? statBuf.st_mtim.tv_sec : 0;
+}
+
+bool
+hasStat(const AssetCopier& copier, const std::string& line)
+{
+    return copier.showStats().find(line) != std::string::npos;
+}
+
+bool
+checkOverwriteThrows(const AssetCopier& copier)
+{
+    try {
+        copier.checkOverwrite();
+    } catch (const except::IoError&) {
+        return true;
+    }
+    return false;
+}
+
+int
+removeEntry(const char* path, const struct stat*, int, struct FTW*)
+{
+    return ::remove(path);
+}
+
+} // namespace
+
+void
+TestAssetCopier::setUp()
+{
+    char dirTemplate[] = "TestAssetCopier_XXXXXX";
+    CPPUNIT_ASSERT(mkdtemp(dirTemplate) != nullptr);
+    mDir = util::absolutePath(dirTemplate);
+}
+
+void
+TestAssetCopier::tearDown()
+{
+    nftw(mDir.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+void
+TestAssetCopier::testParallelCopy()
+{
+    const size_t fileTotal = 64;
+    std::vector<FileCopy> fileCopies;
+    std::set<std::string> redirectable;
+    for (size_t i = 0; i < fileTotal; ++i) {
+        std::ostringstream name;
+        name << "d" << (i % 4) << "/f" << i << ".bin";
+        fileCopies.emplace_back(mDir + "/src/" + name.str(), mDir + "/dest/" + name.str());
+        // Includes empty files and files larger than the read chunk size.
+        writeFile(fileCopies.back().mSrcPath, makeContents((i == 0) ? 0 : i * i * 317, i));
+        redirectable.insert(fileCopies.back().mDestPath);
+    }
+
+    AssetCopier copier(8, AssetCopier::SkipMode::NONE, true);
+    copier.plan(fileCopies, redirectable);
+    CPPUNIT_ASSERT_EQUAL(fileTotal, copier.getPlannedCopies().size());
+    CPPUNIT_ASSERT(!checkOverwriteThrows(copier));
+    copier.copy();
+
+    for (const FileCopy& fileCopy : fileCopies) {
+        CPPUNIT_ASSERT(readFile(fileCopy.mSrcPath) == readFile(fileCopy.mDestPath));
+        CPPUNIT_ASSERT_EQUAL(getMtime(fileCopy.mSrcPath), getMtime(fileCopy.mDestPath));
+    }
+    CPPUNIT_ASSERT(hasStat(copier, "copied 64 files"));
+    CPPUNIT_ASSERT(hasStat(copier, "failed 0 copies, 0 missing sources"));
+}
+
+void
+TestAssetCopier::testSkipSizeMtime()
+{
+    std::vector<FileCopy> fileCopies;
+    for (unsigned i = 0; i < 3; ++i) {
+        const std::string name = "f" + std::to_string(i) + ".tex";
+        fileCopies.emplace_back(mDir + "/src/" + name, mDir + "/dest/" + name);
+        writeFile(fileCopies.back().mSrcPath, makeContents(4096, i));
+    }
+    {
+        AssetCopier copier(4, AssetCopier::SkipMode::NONE, false);
+        copier.plan(fileCopies, {});
+        copier.copy();
+    }
+
+    // Without a skip mode, any existing destination is rejected.
+    {
+        AssetCopier copier(4, AssetCopier::SkipMode::NONE, false);
+        copier.plan(fileCopies, {});
+        CPPUNIT_ASSERT(!copier.isUpToDate(0));
+        CPPUNIT_ASSERT(checkOverwriteThrows(copier));
+    }
+
+    // Everything is up to date.
+    {
+        AssetCopier copier(4, AssetCopier::SkipMode::SIZE_MTIME, false);
+        copier.plan(fileCopies, {});
+        for (size_t id = 0; id < fileCopies.size(); ++id) CPPUNIT_ASSERT(copier.isUpToDate(id));
+        CPPUNIT_ASSERT(!checkOverwriteThrows(copier));
+        copier.copy();
+        CPPUNIT_ASSERT(hasStat(copier, "skipped 3 unchanged files"));
+    }
+
+    // Same size but a newer source, and a destination which differs in size.
+    writeFile(fileCopies[1].mSrcPath, makeContents(4096, 100), 1000000100);
+    writeFile(fileCopies[2].mDestPath, makeContents(100, 2));
+    {
+        AssetCopier copier(4, AssetCopier::SkipMode::SIZE_MTIME, false);
+        copier.plan(fileCopies, {});
+        CPPUNIT_ASSERT(copier.isUpToDate(0));
+        CPPUNIT_ASSERT(!copier.isUpToDate(1));
+        CPPUNIT_ASSERT(!copier.isUpToDate(2));
+        CPPUNIT_ASSERT(checkOverwriteThrows(copier)); // existing files which differ need --force
+
+        copier.copy(); // --force
+        CPPUNIT_ASSERT(hasStat(copier, "copied 2 files"));
+        CPPUNIT_ASSERT(hasStat(copier, "skipped 1 unchanged files"));
+        for (const FileCopy& fileCopy : fileCopies) {
+            CPPUNIT_ASSERT(readFile(fileCopy.mSrcPath) == readFile(fileCopy.mDestPath));
+        }
+    }
+}
+
+void
+TestAssetCopier::testSkipContent()
+{
+    std::vector<FileCopy> fileCopies;
+    fileCopies.emplace_back(mDir + "/src/same.tex", mDir + "/dest/same.tex");
+    fileCopies.emplace_back(mDir + "/src/differ.tex", mDir + "/dest/differ.tex");
+    fileCopies.emplace_back(mDir + "/src/new.tex", mDir + "/dest/new.tex");
+    writeFile(fileCopies[0].mSrcPath, makeContents(5000, 0));
+    writeFile(fileCopies[1].mSrcPath, makeContents(5000, 1));
+    writeFile(fileCopies[2].mSrcPath, makeContents(5000, 2));
+    // Same contents with another mtime, and same size with other contents.
+    writeFile(fileCopies[0].mDestPath, makeContents(5000, 0), 1200000000);
+    writeFile(fileCopies[1].mDestPath, makeContents(5000, 9));
+
+    {
+        AssetCopier copier(2, AssetCopier::SkipMode::SIZE_MTIME, false);
+        copier.plan(fileCopies, {});
+        CPPUNIT_ASSERT(!copier.isUpToDate(0));
+        CPPUNIT_ASSERT(copier.isUpToDate(1)); // can't be told from its size and mtime
+    }
+
+    AssetCopier copier(2, AssetCopier::SkipMode::CONTENT, false);
+    copier.plan(fileCopies, {});
+    CPPUNIT_ASSERT(copier.isUpToDate(0));
+    CPPUNIT_ASSERT(!copier.isUpToDate(1));
+    CPPUNIT_ASSERT(!copier.isUpToDate(2));
+    CPPUNIT_ASSERT(checkOverwriteThrows(copier));
+
+    copier.copy(); // --force
+    CPPUNIT_ASSERT(hasStat(copier, "copied 2 files"));
+    CPPUNIT_ASSERT_EQUAL(time_t(1200000000), getMtime(fileCopies[0].mDestPath)); // not touched
+    CPPUNIT_ASSERT(readFile(fileCopies[1].mSrcPath) == readFile(fileCopies[1].mDestPath));
+    CPPUNIT_ASSERT(readFile(fileCopies[2].mSrcPath) == readFile(fileCopies[2].mDestPath));
+}
+
+void
+TestAssetCopier::testDedupe()
+{
+    const std::string srcDir = mDir + "/src/";
+    const std::string destPrefix = mDir + "/dest/";
+    const std::string contents = makeContents(3000, 0);
+    writeFile(srcDir + "a.tex", contents);
+    writeFile(srcDir + "sub/b.tex", contents);                 // identical contents
+    CPPUNIT_ASSERT(symlink("a.tex", (srcDir + "link.tex").c_str()) == 0); // same file
+    writeFile(srcDir + "udim/c_1001.tex", contents);           // identical, but not redirectable
+    writeFile(srcDir + "d.tex", makeContents(3000, 1));        // same size, other contents
+
+    std::vector<FileCopy> fileCopies;
+    fileCopies.emplace_back(srcDir + "a.tex", destPrefix + "a.tex");
+    fileCopies.emplace_back(srcDir + "sub/b.tex", destPrefix + "sub/b.tex");
+    fileCopies.emplace_back(srcDir + "link.tex", destPrefix + "link.tex");
+    fileCopies.emplace_back(srcDir + "udim/c_1001.tex", destPrefix + "udim/c_1001.tex");
+    fileCopies.emplace_back(srcDir + "d.tex", destPrefix + "d.tex");
+    fileCopies.emplace_back(srcDir + "missing.tex", destPrefix + "missing.tex");
+    const std::set<std::string> redirectable = {
+        destPrefix + "a.tex", destPrefix + "sub/b.tex", destPrefix + "link.tex",
+        destPrefix + "d.tex", destPrefix + "missing.tex"
+    };
+
+    AssetCopier copier(4, AssetCopier::SkipMode::NONE, true);
+    copier.plan(fileCopies, redirectable);
+    const auto& planned = copier.getPlannedCopies();
+    CPPUNIT_ASSERT_EQUAL(size_t(3), planned.size());
+    CPPUNIT_ASSERT_EQUAL(destPrefix + "a.tex", planned[0].mDestPath);
+    CPPUNIT_ASSERT_EQUAL(destPrefix + "udim/c_1001.tex", planned[1].mDestPath);
+    CPPUNIT_ASSERT_EQUAL(destPrefix + "d.tex", planned[2].mDestPath);
+    CPPUNIT_ASSERT_EQUAL(destPrefix + "a.tex", copier.getRedirect(destPrefix + "sub/b.tex"));
+    CPPUNIT_ASSERT_EQUAL(destPrefix + "a.tex", copier.getRedirect(destPrefix + "link.tex"));
+    CPPUNIT_ASSERT_EQUAL(destPrefix + "d.tex", copier.getRedirect(destPrefix + "d.tex"));
+    CPPUNIT_ASSERT(hasStat(copier, "deduped 1 same files, 1 identical contents"));
+    CPPUNIT_ASSERT(hasStat(copier, "1 missing sources"));
+
+    copier.copy();
+    CPPUNIT_ASSERT(readFile(destPrefix + "a.tex") == contents);
+    CPPUNIT_ASSERT(exists(destPrefix + "udim/c_1001.tex"));
+    CPPUNIT_ASSERT(!exists(destPrefix + "sub/b.tex"));
+    CPPUNIT_ASSERT(!exists(destPrefix + "link.tex"));
+
+    // The attribute values, relative to destPrefix (--relative) or absolute.
+    std::string value = "sub/b.tex";
+    copier.redirectAttrValue(destPrefix, value);
+    CPPUNIT_ASSERT_EQUAL(std::string("a.tex"), value);
+    value = destPrefix + "link.tex";
+    copier.redirectAttrValue(destPrefix, value);
+    CPPUNIT_ASSERT_EQUAL(destPrefix + "a.tex", value);
+    value = "d.tex";
+    copier.redirectAttrValue(destPrefix, value);
+    CPPUNIT_ASSERT_EQUAL(std::string("d.tex"), value);
+
+    // Without dedupe, every existing source is copied to its own destination.
+    AssetCopier noDedupe(4, AssetCopier::SkipMode::NONE, false);
+    noDedupe.plan(fileCopies, redirectable);
+    CPPUNIT_ASSERT_EQUAL(size_t(5), noDedupe.getPlannedCopies().size());
+    CPPUNIT_ASSERT_EQUAL(destPrefix + "link.tex", noDedupe.getRedirect(destPrefix + "link.tex"));
+}
+
+void
+TestAssetCopier::testCopyFileFallback()
+{
+    // copy_file_range() fails with EXDEV between different filesystems (tmpfs
+    // and the test directory on most systems), then sendfile() copies the file.
+    // On the same filesystem copy_file_range() does the copy.
+    char shmTemplate[] = "/dev/shm/TestAssetCopier_XXXXXX";
+    const bool shmAvailable = (mkstemp(shmTemplate) != -1);
+    const std::string contents = makeContents(3 * 1024 * 1024 + 17, 3);
+
+    std::vector<std::pair<std::string, std::string>> copies;
+    copies.emplace_back(mDir + "/src.bin", mDir + "/same_fs.bin");
+    if (shmAvailable) {
+        copies.emplace_back(shmTemplate, mDir + "/cross_fs.bin");
+        copies.emplace_back(mDir + "/src.bin", std::string(shmTemplate) + ".copy");
+    }
+    writeFile(mDir + "/src.bin", contents);
+    if (shmAvailable) writeFile(shmTemplate, contents);
+
+    for (const auto& copy : copies) {
+        util::copyFile(copy.first, copy.second);
+        CPPUNIT_ASSERT(readFile(copy.second) == contents);
+    }
+
+    // Empty file.
+    writeFile(mDir + "/empty.bin", "");
+    util::copyFile(mDir + "/empty.bin", mDir + "/empty_copy.bin");
+    CPPUNIT_ASSERT(exists(mDir + "/empty_copy.bin"));
+    CPPUNIT_ASSERT(readFile(mDir + "/empty_copy.bin").empty());
+
+    if (shmAvailable) {
+        ::remove(shmTemplate);
+        ::remove((std::string(shmTemplate) + ".copy").c_str());
+    }
+}
+
+} // namespace unittest
+} // namespace rdl2_localize
+
+CPPUNIT_TEST_SUITE_REGISTRATION(rdl2_localize::unittest::TestAssetCopier);
+
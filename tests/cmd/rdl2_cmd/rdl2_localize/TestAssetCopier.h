@@ -0,0 +1,53 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+namespace rdl2_localize {
+namespace unittest {
+
+class TestAssetCopier : public CppUnit::TestFixture
+{
+public:
+    void setUp();
+    void tearDown();
+
+    /// Many files copied with multiple copies in flight.
+    void testParallelCopy();
+
+    /// Existing destinations with the same size and mtime are skipped, others
+    /// are rejected unless overwriting is forced.
+    void testSkipSizeMtime();
+
+    /// Existing destinations with the same size and contents are skipped.
+    void testSkipContent();
+
+    /// Identical sources under different paths are copied once and the
+    /// attribute values are redirected to the copy.
+    void testDedupe();
+
+    /// util::copyFile() across filesystems, where copy_file_range() fails and
+    /// sendfile() does the copy.
+    void testCopyFileFallback();
+
+    CPPUNIT_TEST_SUITE(TestAssetCopier);
+    CPPUNIT_TEST(testParallelCopy);
+    CPPUNIT_TEST(testSkipSizeMtime);
+    CPPUNIT_TEST(testSkipContent);
+    CPPUNIT_TEST(testDedupe);
+    CPPUNIT_TEST(testCopyFileFallback);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::string mDir; // working directory of the test, removed by tearDown()
+};
+
+} // namespace unittest
+} // namespace rdl2_localize
+
@@ -0,0 +1,9 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include <scene_rdl2/pdevunit/pdevunit.h>
+
+int
+main(int argc, char *argv[])
+{
+    return pdevunit::run(argc, argv);    
+}
@@ -0,0 +1,106 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "TestStreamPrinter.h"
+
+#include <printers.h>
+#include <streamPrinter.h>
+
+#include <scene_rdl2/scene/rdl2/rdl2.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace scene_rdl2;
+
+namespace rdl2_print {
+namespace unittest {
+
+namespace {
+
+const char* SCENE_FILE = "TestStreamPrinter.rdlb";
+
+// Writes a scene of built-in SceneObjects, enough for many stream batches.
+void
+writeScene()
+{
+    rdl2::SceneContext ctx;
+    for (int i = 0; i < 1500; ++i) {
+        const std::string id = std::to_string(i);
+        ctx.createSceneObject((i % 3 == 0) ? "LightSet" : "GeometrySet", "/set/" + id);
+        if (i % 50 == 0) {
+            ctx.createSceneObject("TraceSet", "/trace/" + id);
+        }
+    }
+    rdl2::writeSceneToFile(ctx, SCENE_FILE);
+}
+
+// The expected stream output : every SceneObject of the fully loaded scene,
+// in file order.
+std::string
+expectedOutput(const Options& options, const std::string& className = "")
+{
+    rdl2::SceneContext ctx;
+    setupContext(ctx, options);
+    rdl2::readSceneFromFile(SCENE_FILE, ctx);
+
+    std::vector<std::string> names;
+    std::ifstream in(SCENE_FILE, std::ios::binary);
+    rdl2::BinaryReader::streamRecords(in, nullptr, [&](std::string&& record) {
+        std::string recordClassName, objectName;
+        rdl2::BinaryReader::readRecordNames(rdl2::Slice(record), recordClassName, objectName);
+        if (className.empty() || recordClassName == className) names.push_back(objectName);
+    });
+
+    std::string str;
+    for (const std::string& name : names) {
+        str += getSceneInfoStr(*ctx.getSceneObject(name), options);
+    }
+    return str;
+}
+
+} // namespace
+
+void
+TestStreamPrinter::testStreamJobs()
+{
+    writeScene();
+
+    Options options;
+    const std::string expected = expectedOutput(options);
+    CPPUNIT_ASSERT(expected.find("GeometrySet(\"/set/1499\")") != std::string::npos);
+
+    for (unsigned jobs : {1u, 2u, 8u}) {
+        options.jobs = jobs;
+        std::ostringstream out;
+        printSceneObjectsStreamed(SCENE_FILE, options, out);
+        CPPUNIT_ASSERT(out.str() == expected);
+    }
+
+    std::remove(SCENE_FILE);
+}
+
+void
+TestStreamPrinter::testStreamFilter()
+{
+    writeScene();
+
+    Options options;
+    options.jobs = 4;
+    options.sceneClassNames.push_back("TraceSet");
+    std::ostringstream out;
+    printSceneObjectsStreamed(SCENE_FILE, options, out);
+    CPPUNIT_ASSERT(out.str() == expectedOutput(options, "TraceSet"));
+    CPPUNIT_ASSERT(out.str().find("GeometrySet(") == std::string::npos);
+
+    std::remove(SCENE_FILE);
+}
+
+} // namespace unittest
+} // namespace rdl2_print
+
+CPPUNIT_TEST_SUITE_REGISTRATION(rdl2_print::unittest::TestStreamPrinter);
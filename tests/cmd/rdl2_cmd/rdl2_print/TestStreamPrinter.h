@@ -0,0 +1,32 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace rdl2_print {
+namespace unittest {
+
+class TestStreamPrinter : public CppUnit::TestFixture
+{
+public:
+    /// --stream -j N on a file of many batches prints the same as decoding
+    /// the whole scene, in file order. (Run under TSAN this also checks that
+    /// the per batch SceneContexts don't race.)
+    void testStreamJobs();
+
+    /// --class filters the records by their header.
+    void testStreamFilter();
+
+    CPPUNIT_TEST_SUITE(TestStreamPrinter);
+    CPPUNIT_TEST(testStreamJobs);
+    CPPUNIT_TEST(testStreamFilter);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+} // namespace unittest
+} // namespace rdl2_print
+
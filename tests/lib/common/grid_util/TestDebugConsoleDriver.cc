@@ -0,0 +1,96 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "TestDebugConsoleDriver.h"
+
+#include <scene_rdl2/common/grid_util/DebugConsoleDriver.h>
+#include <scene_rdl2/common/rec_time/RecTimeLap.h>
+
+#include <thread>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+std::string
+TestDebugConsoleDriver::runCommand(DebugConsoleDriver &driver, const std::string &cmdLine)
+{
+    Arg arg(cmdLine);
+    std::string out;
+    arg.setMessageHandler([&](const std::string &msg) -> bool {
+            out += msg;
+            return true;
+        });
+    arg.setCerrOutput(false);
+    CPPUNIT_ASSERT(driver.getRootParser().main(arg));
+    return out;
+}
+
+void
+TestDebugConsoleDriver::testTimeLap()
+{
+    DebugConsoleDriver driver;
+    driver.initialize(0); // configures the built-in commands
+    CPPUNIT_ASSERT(driver.getPort() != 0);
+
+    rec_time::RecTimeLap timeLap;
+    timeLap.setName("lap");
+    const size_t section = timeLap.sectionRegistration("section");
+    driver.addTimeLap("lap", timeLap);
+
+    CPPUNIT_ASSERT(runCommand(driver, "timeLap list").find("lap perfCounter:off") != std::string::npos);
+    CPPUNIT_ASSERT_EQUAL(std::string("unknown timeLap:foo\n"), runCommand(driver, "timeLap perfInfo foo"));
+
+    CPPUNIT_ASSERT_EQUAL(std::string("timeLap:lap perfCounter:on\n"),
+                         runCommand(driver, "timeLap perfCounter lap on"));
+    CPPUNIT_ASSERT(timeLap.getPerfCounter());
+    CPPUNIT_ASSERT_EQUAL(std::string("timeLap:lap perfCounter:on\n"),
+                         runCommand(driver, "timeLap perfCounter lap show"));
+
+    // The section runs on two threads, perfInfo breaks it down by thread.
+    auto runSection = [&] {
+        for (int i = 0; i < 5; ++i) {
+            timeLap.sectionStart(section);
+            timeLap.sectionEnd(section);
+        }
+    };
+    runSection();
+    std::thread(runSection).join();
+
+    const std::string info = runCommand(driver, "timeLap perfInfo lap");
+    CPPUNIT_ASSERT(info.find("perfInfo lap (perfCounter:on)") != std::string::npos);
+    CPPUNIT_ASSERT(info.find("section") != std::string::npos);
+    size_t threads = 0;
+    for (size_t pos = info.find("thread:"); pos != std::string::npos; pos = info.find("thread:", pos + 1)) {
+        ++threads;
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(2), threads);
+
+    CPPUNIT_ASSERT_EQUAL(std::string("timeLap:lap perfCounter:off\n"),
+                         runCommand(driver, "timeLap perfCounter lap off"));
+    CPPUNIT_ASSERT(!timeLap.getPerfCounter());
+
+    driver.removeTimeLap("lap");
+    CPPUNIT_ASSERT_EQUAL(std::string("unknown timeLap:lap\n"), runCommand(driver, "timeLap perfCounter lap on"));
+}
+
+void
+TestDebugConsoleDriver::testStreamSub()
+{
+    DebugConsoleDriver driver;
+    driver.initialize(0);
+
+    CPPUNIT_ASSERT_EQUAL(std::string("unknown stream:foo\n"), runCommand(driver, "stream sub foo 100"));
+    CPPUNIT_ASSERT_EQUAL(std::string("intervalMs has to be 1 or more\n"), runCommand(driver, "stream sub metrics 0"));
+    CPPUNIT_ASSERT_EQUAL(std::string("not subscribed stream:metrics\n"), runCommand(driver, "stream unsub metrics"));
+
+    CPPUNIT_ASSERT_EQUAL(std::string("subscribed stream:metrics intervalMs:100\n"),
+                         runCommand(driver, "stream sub metrics 100"));
+    CPPUNIT_ASSERT_EQUAL(std::string("unsubscribed stream:metrics\n"), runCommand(driver, "stream unsub metrics"));
+}
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,43 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+
+#pragma once
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include <string>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+class DebugConsoleDriver;
+
+namespace unittest {
+
+class TestDebugConsoleDriver : public CppUnit::TestFixture
+{
+public:
+    void setUp() {}
+    void tearDown() {}
+
+    void testTimeLap();
+    void testStreamSub();
+
+    CPPUNIT_TEST_SUITE(TestDebugConsoleDriver);
+    CPPUNIT_TEST(testTimeLap);
+    CPPUNIT_TEST(testStreamSub);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    // Evaluates cmdLine by the root parser, as the console thread does for a
+    // client, and returns the output.
+    static std::string runCommand(DebugConsoleDriver &driver, const std::string &cmdLine);
+};
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,342 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "TestFbStream.h"
+
+#include <scene_rdl2/common/fb_util/Tiler.h>
+#include <scene_rdl2/common/grid_util/FbStreamClient.h>
+#include <scene_rdl2/common/grid_util/FbStreamServer.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+namespace {
+
+using ActivePixels = fb_util::ActivePixels;
+using PrecisionMode = PackTiles::PrecisionMode;
+
+constexpr unsigned width = 64;
+constexpr unsigned height = 48;
+constexpr const char *aovName = "depth";
+
+float
+pixValue(unsigned x, unsigned y, unsigned frame, unsigned chan)
+{
+    return static_cast<float>((x * 7 + y * 13 + frame * 31 + chan * 101) % 256) / 255.0f;
+}
+
+void
+updateFb(Fb &fb, unsigned y0, unsigned y1, unsigned frame, ActivePixels &dirty)
+//
+// Updates scanlines [y0, y1) of beauty and AOV, dirty is set to exactly these pixels.
+//
+{
+    fb_util::Tiler tiler(width, height);
+    float *beauty = reinterpret_cast<float *>(fb.getRenderBufferTiled().getData());
+    float *aov = fb.getAov(aovName)->getBufferTiled().getFloatBuffer().getData();
+
+    dirty.reset();
+    for (unsigned y = y0; y < y1; ++y) {
+        for (unsigned x = 0; x < width; ++x) {
+            const unsigned ofs = tiler.linearCoordsToTiledOffset(x, y);
+            for (unsigned c = 0; c < 4; ++c) beauty[ofs * 4 + c] = pixValue(x, y, frame, c);
+            aov[ofs] = pixValue(x, y, frame, 4);
+            dirty.orOp((y >> 3) * dirty.getNumTilesX() + (x >> 3), 0x1ULL << (((y & 0x7) << 3) + (x & 0x7)));
+        }
+    }
+}
+
+void
+setupSrc(Fb &src, ActivePixels &dirty)
+{
+    src.init(math::Viewport(0, 0, width - 1, height - 1));
+    src.getAov(aovName)->setup(nullptr, fb_util::VariablePixelBuffer::FLOAT, width, height, false);
+    dirty.init(width, height);
+    updateFb(src, 0, height, 0, dirty);
+}
+
+bool
+samePixels(const Fb &src, const Fb &dst, const FbStreamSubscribeParam &param, float tolerance)
+//
+// Compares the subscribed items inside ROI. Beauty outside ROI has to be untouched (zero).
+//
+{
+    if (dst.getWidth() != width || dst.getHeight() != height) return false;
+
+    fb_util::Tiler tiler(width, height);
+    const float *srcBeauty = reinterpret_cast<const float *>(src.getRenderBufferTiled().getData());
+    const float *dstBeauty = reinterpret_cast<const float *>(dst.getRenderBufferTiled().getData());
+    Fb::FbAovShPtr srcAov, dstAov;
+    src.getAov2(aovName, srcAov);
+    const bool aov = !param.mAovNames.empty();
+    if (aov != dst.getAov2(aovName, dstAov)) return false;
+
+    for (unsigned y = 0; y < height; ++y) {
+        for (unsigned x = 0; x < width; ++x) {
+            const unsigned ofs = tiler.linearCoordsToTiledOffset(x, y);
+            if (param.mRoiActive && !param.mRoi.contains(static_cast<int>(x), static_cast<int>(y))) {
+                for (unsigned c = 0; c < 4; ++c) {
+                    if (dstBeauty[ofs * 4 + c] != 0.0f) return false;
+                }
+                continue;
+            }
+            for (unsigned c = 0; c < 4; ++c) {
+                if (std::fabs(srcBeauty[ofs * 4 + c] - dstBeauty[ofs * 4 + c]) > tolerance) return false;
+            }
+            if (aov) {
+                const float srcV = srcAov->getBufferTiled().getFloatBuffer().getData()[ofs];
+                const float dstV = dstAov->getBufferTiled().getFloatBuffer().getData()[ofs];
+                if (std::fabs(srcV - dstV) > tolerance) return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool
+waitUntil(const std::function<bool()> &cond)
+{
+    for (int i = 0; i < 500; ++i) {
+        if (cond()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+FbStreamSubscribeParam
+makeParam(PrecisionMode precision, bool aov)
+{
+    FbStreamSubscribeParam param;
+    param.mPrecision = precision;
+    if (aov) param.mAovNames.push_back(aovName);
+    return param;
+}
+
+// Connects and subscribes, and waits until the server has received the SUBSCRIBE.
+void
+subscribe(FbStreamServer &server, FbStreamClient &client, const FbStreamSubscribeParam &param,
+          size_t subscribedTotal)
+{
+    std::string error;
+    if (!client.isConnected()) CPPUNIT_ASSERT(client.connect("localhost", server.getPort(), error));
+    CPPUNIT_ASSERT(client.subscribe(param, error));
+    CPPUNIT_ASSERT(waitUntil([&] { return server.getSubscribedClientTotal() == subscribedTotal; }));
+}
+
+} // namespace
+
+void
+TestFbStream::testFullAndDelta()
+{
+    Fb src;
+    ActivePixels dirty;
+    setupSrc(src, dirty);
+
+    FbStreamServer server;
+    CPPUNIT_ASSERT(server.open(0) != 0);
+    FbStreamClient client;
+    const FbStreamSubscribeParam param = makeParam(PrecisionMode::F32, true);
+    subscribe(server, client, param, 1);
+
+    // The first FRAME is a full frame, whatever the dirty pixels are.
+    Fb dst;
+    std::string error;
+    ActivePixels noPixels;
+    noPixels.init(width, height);
+    noPixels.reset();
+    server.publish(src, &noPixels);
+    CPPUNIT_ASSERT_EQUAL(1, client.recvFrame(dst, 2000, error));
+    const FbStreamClient::FrameInfo full = client.getLastFrameInfo();
+    CPPUNIT_ASSERT(full.mFullFrame);
+    CPPUNIT_ASSERT_EQUAL(width, full.mWidth);
+    CPPUNIT_ASSERT_EQUAL(height, full.mHeight);
+    CPPUNIT_ASSERT_EQUAL(2u, full.mItemTotal);
+    CPPUNIT_ASSERT(samePixels(src, dst, param, 0.0f));
+
+    // Then only the updated scanlines.
+    updateFb(src, 8, 16, 1, dirty);
+    server.publish(src, &dirty);
+    CPPUNIT_ASSERT_EQUAL(1, client.recvFrame(dst, 2000, error));
+    const FbStreamClient::FrameInfo delta = client.getLastFrameInfo();
+    CPPUNIT_ASSERT(!delta.mFullFrame);
+    CPPUNIT_ASSERT(delta.mFrameId > full.mFrameId);
+    CPPUNIT_ASSERT(delta.mMessageSize < full.mMessageSize / 2);
+    CPPUNIT_ASSERT(samePixels(src, dst, param, 0.0f));
+
+    // Nothing updated : no FRAME.
+    server.publish(src, &noPixels);
+    CPPUNIT_ASSERT_EQUAL(0, client.recvFrame(dst, 100, error));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), client.getRecvFrameTotal());
+}
+
+void
+TestFbStream::testPrecisionRoi()
+{
+    Fb src;
+    ActivePixels dirty;
+    setupSrc(src, dirty);
+
+    FbStreamServer server;
+    CPPUNIT_ASSERT(server.open(0) != 0);
+
+    // Two clients with their own precision and ROI, served by the same publish().
+    FbStreamClient clientA;
+    const FbStreamSubscribeParam paramA = makeParam(PrecisionMode::F32, true);
+    subscribe(server, clientA, paramA, 1);
+
+    FbStreamClient clientB;
+    FbStreamSubscribeParam paramB = makeParam(PrecisionMode::H16, false);
+    paramB.mRoiActive = true;
+    paramB.mRoi = math::Viewport(8, 8, 31, 23);
+    subscribe(server, clientB, paramB, 2);
+
+    server.publish(src, &dirty);
+
+    std::string error;
+    Fb dstA, dstB;
+    CPPUNIT_ASSERT_EQUAL(1, clientA.recvFrame(dstA, 2000, error));
+    CPPUNIT_ASSERT_EQUAL(1, clientB.recvFrame(dstB, 2000, error));
+    CPPUNIT_ASSERT(samePixels(src, dstA, paramA, 0.0f));
+    CPPUNIT_ASSERT(samePixels(src, dstB, paramB, 1.0e-3f));
+    CPPUNIT_ASSERT_EQUAL(1u, clientB.getLastFrameInfo().mItemTotal);
+    CPPUNIT_ASSERT(clientB.getLastFrameInfo().mMessageSize < clientA.getLastFrameInfo().mMessageSize / 4);
+
+    // An update outside of B's ROI only goes to A.
+    updateFb(src, 40, 48, 1, dirty);
+    server.publish(src, &dirty);
+    CPPUNIT_ASSERT_EQUAL(1, clientA.recvFrame(dstA, 2000, error));
+    CPPUNIT_ASSERT_EQUAL(0, clientB.recvFrame(dstB, 100, error));
+    CPPUNIT_ASSERT(samePixels(src, dstA, paramA, 0.0f));
+}
+
+void
+TestFbStream::testRateLimit()
+{
+    Fb src;
+    ActivePixels dirty;
+    setupSrc(src, dirty);
+
+    FbStreamServer server;
+    CPPUNIT_ASSERT(server.open(0) != 0);
+    FbStreamClient client;
+    FbStreamSubscribeParam param = makeParam(PrecisionMode::F32, true);
+    param.mMaxFps = 2.0f; // 500ms interval
+    subscribe(server, client, param, 1);
+
+    std::string error;
+    Fb dst;
+    server.publish(src, &dirty);
+    CPPUNIT_ASSERT_EQUAL(1, client.recvFrame(dst, 2000, error));
+    const auto firstTime = std::chrono::steady_clock::now();
+
+    // Updates inside the interval are held back and accumulated.
+    for (unsigned frame = 1; frame <= 5; ++frame) {
+        updateFb(src, frame * 8 - 8, frame * 8, frame, dirty);
+        server.publish(src, &dirty);
+    }
+    CPPUNIT_ASSERT_EQUAL(0, client.recvFrame(dst, 50, error));
+
+    // After the interval, an empty publish() sends all the pending pixels as a single delta.
+    std::this_thread::sleep_until(firstTime + std::chrono::milliseconds(600));
+    dirty.reset();
+    server.publish(src, &dirty);
+    CPPUNIT_ASSERT_EQUAL(1, client.recvFrame(dst, 2000, error));
+    CPPUNIT_ASSERT(!client.getLastFrameInfo().mFullFrame);
+    CPPUNIT_ASSERT(samePixels(src, dst, param, 0.0f));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), client.getRecvFrameTotal());
+}
+
+void
+TestFbStream::testUnsubscribe()
+{
+    Fb src;
+    ActivePixels dirty;
+    setupSrc(src, dirty);
+
+    FbStreamServer server;
+    CPPUNIT_ASSERT(server.open(0) != 0);
+    FbStreamClient client;
+    const FbStreamSubscribeParam param = makeParam(PrecisionMode::UC8, false);
+    subscribe(server, client, param, 1);
+
+    std::string error;
+    Fb dst;
+    server.publish(src, &dirty);
+    CPPUNIT_ASSERT_EQUAL(1, client.recvFrame(dst, 2000, error));
+
+    // No FRAME after UNSUBSCRIBE, but the connection stays.
+    CPPUNIT_ASSERT(client.unsubscribe(error));
+    CPPUNIT_ASSERT(waitUntil([&] { return server.getSubscribedClientTotal() == 0; }));
+    updateFb(src, 0, 8, 1, dirty);
+    server.publish(src, &dirty);
+    CPPUNIT_ASSERT_EQUAL(0, client.recvFrame(dst, 100, error));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), server.getClientTotal());
+
+    // Subscribing again starts over with a full frame.
+    subscribe(server, client, param, 1);
+    server.publish(src, &dirty);
+    CPPUNIT_ASSERT_EQUAL(1, client.recvFrame(dst, 2000, error));
+    CPPUNIT_ASSERT(client.getLastFrameInfo().mFullFrame);
+
+    // Disconnect.
+    client.close();
+    CPPUNIT_ASSERT(waitUntil([&] { return server.getClientTotal() == 0; }));
+    server.publish(src, &dirty); // no client left, must not fail
+}
+
+void
+TestFbStream::testBrokenHeader()
+{
+    // A fake server which sends a FRAME header with a huge payload size.
+    const int listenSock = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CPPUNIT_ASSERT(::bind(listenSock, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    CPPUNIT_ASSERT(::listen(listenSock, 1) == 0);
+    socklen_t addrLen = sizeof(addr);
+    CPPUNIT_ASSERT(::getsockname(listenSock, (struct sockaddr *)&addr, &addrLen) == 0);
+
+    std::thread fakeServer([&] {
+        const int sock = ::accept(listenSock, nullptr, nullptr);
+        FbStreamMsgHeader header;
+        header.mMagic = FbStreamMsgHeader::MAGIC;
+        header.mType = static_cast<uint16_t>(FbStreamMsgHeader::Type::FRAME);
+        header.mPad = 0;
+        header.mPayloadSize = uint64_t(1) << 62;
+        (void)::send(sock, &header, sizeof(header), MSG_NOSIGNAL);
+        char buff[256];
+        while (::recv(sock, buff, sizeof(buff), 0) > 0) {} // until the client closes
+        ::close(sock);
+    });
+
+    FbStreamClient client;
+    std::string error;
+    CPPUNIT_ASSERT(client.connect("localhost", ntohs(addr.sin_port), error));
+    Fb dst;
+    CPPUNIT_ASSERT_EQUAL(-1, client.recvFrame(dst, 2000, error));
+    CPPUNIT_ASSERT(error.find("too big FRAME") != std::string::npos);
+    CPPUNIT_ASSERT(!client.isConnected());
+
+    fakeServer.join();
+    ::close(listenSock);
+}
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,39 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+
+#pragma once
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+class TestFbStream : public CppUnit::TestFixture
+{
+public:
+    void setUp() {}
+    void tearDown() {}
+
+    void testFullAndDelta();
+    void testPrecisionRoi();
+    void testRateLimit();
+    void testUnsubscribe();
+    void testBrokenHeader();
+
+    CPPUNIT_TEST_SUITE(TestFbStream);
+    CPPUNIT_TEST(testFullAndDelta);
+    CPPUNIT_TEST(testPrecisionRoi);
+    CPPUNIT_TEST(testRateLimit);
+    CPPUNIT_TEST(testUnsubscribe);
+    CPPUNIT_TEST(testBrokenHeader);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,100 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "TestLatencyTrace.h"
+
+#include <scene_rdl2/common/grid_util/LatencyTrace.h>
+
+#include <cstdio>
+#include <unistd.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+void
+TestLatencyTrace::testHistogram()
+{
+    LatencyHistogram histogram;
+    CPPUNIT_ASSERT(histogram.getPercentile(50.0) == 0);
+
+    // Small values are exact.
+    for (uint64_t v = 1; v <= 50; ++v) histogram.record(v);
+    CPPUNIT_ASSERT(histogram.getPercentile(50.0) == 25);
+    CPPUNIT_ASSERT(histogram.getMin() == 1 && histogram.getMax() == 50);
+
+    // Large values within the bucket resolution (~3%).
+    histogram.reset();
+    for (uint64_t v = 1; v <= 100000; ++v) histogram.record(v * 10);
+    auto near = [](uint64_t v, uint64_t expected) {
+        return v >= expected && v <= expected + expected / 30;
+    };
+    CPPUNIT_ASSERT(near(histogram.getPercentile(50.0), 500000));
+    CPPUNIT_ASSERT(near(histogram.getPercentile(99.0), 990000));
+    CPPUNIT_ASSERT(near(histogram.getPercentile(99.9), 999000));
+    CPPUNIT_ASSERT(histogram.getPercentile(100.0) == 1000000);
+    CPPUNIT_ASSERT(histogram.getCount() == 100000);
+
+    LatencyHistogram other;
+    other.record(5);
+    histogram.merge(other);
+    CPPUNIT_ASSERT(histogram.getCount() == 100001 && histogram.getMin() == 5);
+}
+
+void
+TestLatencyTrace::testTraceFile()
+{
+    using Key = LatencyItem::Key;
+
+    char filename[] = "/tmp/TestLatencyTraceXXXXXX";
+    const int fd = mkstemp(filename);
+    CPPUNIT_ASSERT(fd >= 0);
+    close(fd);
+
+    const int frameTotal = 10;
+    {
+        LatencyTraceWriter writer;
+        CPPUNIT_ASSERT(writer.open(filename));
+        for (int i = 0; i < frameTotal; ++i) {
+            LatencyLog log;
+            log.setName("mcrt");
+            log.setSnapshotId(i);
+            log.start();
+            log.enq(Key::ENCODE_START_BEAUTY);
+            log.enq(Key::ENCODE_END_BEAUTY);
+            log.enq(Key::SEND_MSG);
+            CPPUNIT_ASSERT(writer.write(log));
+        }
+        CPPUNIT_ASSERT(writer.getRecordTotal() == frameTotal);
+    }
+
+    LatencyHistogramSet histograms;
+    histograms.addPair(Key::START, Key::SEND_MSG);
+    histograms.addPair(Key::ENCODE_START_BEAUTY, Key::ENCODE_END_BEAUTY);
+    histograms.addPair(Key::MERGE_FBRESET_START, Key::MERGE_FBRESET_END); // never recorded
+
+    LatencyTraceReader reader;
+    std::string errorMsg;
+    CPPUNIT_ASSERT(reader.open(filename, errorMsg));
+    int frame = 0;
+    while (reader.next()) {
+        CPPUNIT_ASSERT(reader.getLog().getName() == "mcrt");
+        CPPUNIT_ASSERT(reader.getLog().getSnapshotId() == static_cast<uint32_t>(frame));
+        CPPUNIT_ASSERT(reader.getLog().getItems().size() == 4);
+        CPPUNIT_ASSERT(!reader.hasUpstream());
+        histograms.add(reader.getLog());
+        ++frame;
+    }
+    CPPUNIT_ASSERT(frame == frameTotal);
+    CPPUNIT_ASSERT(histograms.getHistogram(0).getCount() == frameTotal);
+    CPPUNIT_ASSERT(histograms.getHistogram(1).getCount() == frameTotal);
+    CPPUNIT_ASSERT(histograms.getHistogram(2).getCount() == 0);
+
+    std::remove(filename);
+    CPPUNIT_ASSERT(!reader.open(filename, errorMsg));
+}
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
+
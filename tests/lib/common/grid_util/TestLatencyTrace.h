@@ -0,0 +1,34 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+
+#pragma once
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+class TestLatencyTrace : public CppUnit::TestFixture
+{
+public:
+    void setUp() {}
+    void testDown() {}
+
+    void testHistogram();
+    void testTraceFile();
+
+    CPPUNIT_TEST_SUITE(TestLatencyTrace);
+    CPPUNIT_TEST(testHistogram);
+    CPPUNIT_TEST(testTraceFile);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
+
@@ -0,0 +1,109 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "TestMetricsRegistry.h"
+
+#include <scene_rdl2/common/grid_util/MetricsRegistry.h>
+
+#include <thread>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+void
+TestMetricsRegistry::testCounter()
+{
+    const unsigned threadTotal = 8;
+    const unsigned incTotal = 100000;
+
+    MetricsRegistry registry;
+    MetricsCounter &counter = registry.counter("test_inc_total", "test counter");
+    CPPUNIT_ASSERT(&counter == &registry.counter("test_inc_total", "")); // same name returns same metric
+
+    std::vector<std::thread> threads;
+    for (unsigned threadId = 0; threadId < threadTotal; ++threadId) {
+        threads.emplace_back([&] {
+            for (unsigned i = 0; i < incTotal; ++i) counter.inc();
+        });
+    }
+    for (auto &itr : threads) itr.join();
+    CPPUNIT_ASSERT(counter.get() == threadTotal * incTotal);
+
+    counter.reset();
+    CPPUNIT_ASSERT(counter.get() == 0);
+
+    bool thrown = false;
+    try { registry.gauge("test_inc_total", ""); } // type mismatch
+    catch (const std::string &) { thrown = true; }
+    CPPUNIT_ASSERT(thrown);
+
+    CPPUNIT_ASSERT(MetricsRegistry::isValidName("mcrt_frame:send_total"));
+    CPPUNIT_ASSERT(!MetricsRegistry::isValidName("0abc"));
+    CPPUNIT_ASSERT(!MetricsRegistry::isValidName("frame-send"));
+}
+
+void
+TestMetricsRegistry::testHistogram()
+{
+    MetricsHistogram histogram({4.0, 1.0, 2.0}); // sorted internally
+    for (const double v : {0.5, 1.0, 1.5, 3.0, 8.0}) histogram.observe(v);
+
+    const MetricsHistogram::Snapshot snapshot = histogram.snapshot();
+    CPPUNIT_ASSERT(snapshot.mBounds == std::vector<double>({1.0, 2.0, 4.0}));
+    CPPUNIT_ASSERT(snapshot.mCounts == std::vector<uint64_t>({2, 1, 1, 1}));
+    CPPUNIT_ASSERT(snapshot.mTotal == 5);
+    CPPUNIT_ASSERT(snapshot.mSum == 14.0);
+    CPPUNIT_ASSERT(snapshot.getPercentile(0.5f) == 2.0);
+
+    CPPUNIT_ASSERT(MetricsHistogram::exponentialBounds(1.0, 2.0, 4) == std::vector<double>({1.0, 2.0, 4.0, 8.0}));
+}
+
+void
+TestMetricsRegistry::testExport()
+{
+    MetricsRegistry registry;
+    registry.counter("test_a_total", "a").inc(3);
+    registry.gauge("test_b", "b").set(1.5);
+    registry.gaugeFunc("test_c", "c", [] { return 7.0; });
+    registry.histogram("test_d", "d", {1.0}).observe(0.5);
+
+    const std::string prom = registry.exportPrometheus();
+    CPPUNIT_ASSERT(prom.find("# TYPE test_a_total counter\ntest_a_total 3\n") != std::string::npos);
+    CPPUNIT_ASSERT(prom.find("test_b 1.5\n") != std::string::npos);
+    CPPUNIT_ASSERT(prom.find("# TYPE test_c gauge\ntest_c 7\n") != std::string::npos);
+    CPPUNIT_ASSERT(prom.find("test_d_bucket{le=\"1\"} 1\ntest_d_bucket{le=\"+Inf\"} 1\n") != std::string::npos);
+    CPPUNIT_ASSERT(prom.find("test_d_count 1\n") != std::string::npos);
+
+    const std::string json = registry.exportJson();
+    CPPUNIT_ASSERT(json.find("\"test_a_total\": {\"type\": \"counter\", \"help\": \"a\", \"value\": 3}") !=
+                   std::string::npos);
+    CPPUNIT_ASSERT(json.find("\"counts\": [1, 0]") != std::string::npos);
+
+    registry.removeGaugeFunc("test_c");
+    CPPUNIT_ASSERT(registry.getNames() == std::vector<std::string>({"test_a_total", "test_b", "test_d"}));
+}
+
+void
+TestMetricsRegistry::testGaugeFuncReentry()
+{
+    // A gaugeFunc which uses the registry itself must not deadlock the export.
+    MetricsRegistry registry;
+    registry.counter("test_a_total", "a").inc(2);
+    registry.gaugeFunc("test_names", "number of metrics",
+                       [&] { return static_cast<double>(registry.getNames().size()); });
+    registry.gaugeFunc("test_a_double", "twice of test_a_total",
+                       [&] { return 2.0 * static_cast<double>(registry.counter("test_a_total", "a").get()); });
+
+    const std::string prom = registry.exportPrometheus();
+    CPPUNIT_ASSERT(prom.find("test_names 3\n") != std::string::npos);
+    CPPUNIT_ASSERT(prom.find("test_a_double 4\n") != std::string::npos);
+    CPPUNIT_ASSERT(registry.exportJson().find("\"test_names\": {\"type\": \"gaugeFunc\", \"help\": "
+                                              "\"number of metrics\", \"value\": 3}") != std::string::npos);
+    CPPUNIT_ASSERT(registry.show("test_a_double") == "test_a_double (gaugeFunc) 4");
+}
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
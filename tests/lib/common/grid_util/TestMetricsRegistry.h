@@ -0,0 +1,37 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+
+#pragma once
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+class TestMetricsRegistry : public CppUnit::TestFixture
+{
+public:
+    void setUp() {}
+    void testDown() {}
+
+    void testCounter();
+    void testHistogram();
+    void testExport();
+    void testGaugeFuncReentry();
+
+    CPPUNIT_TEST_SUITE(TestMetricsRegistry);
+    CPPUNIT_TEST(testCounter);
+    CPPUNIT_TEST(testHistogram);
+    CPPUNIT_TEST(testExport);
+    CPPUNIT_TEST(testGaugeFuncReentry);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
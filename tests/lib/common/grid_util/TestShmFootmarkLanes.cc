@@ -0,0 +1,121 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "TestShmFootmarkLanes.h"
+
+#include <scene_rdl2/common/grid_util/ShmFootmarkLanes.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+void
+TestShmFootmarkLanes::testLanes()
+{
+    const unsigned threadTotal = 4;
+    const unsigned recordTotal = 100;
+
+    // One lane less than the threads, the last thread's records are dropped.
+    ShmFootmarkLanes footmark("TestShmFootmarkLanes", threadTotal - 1, 256);
+    footmark.setEventName(1, "step");
+
+    // The threads record in turn, so that the lane assignment is deterministic, and stay alive until
+    // all of them are done, so that they keep their lanes.
+    std::atomic<unsigned> turn(0);
+    std::vector<std::thread> threads;
+    std::vector<unsigned> dropped(threadTotal, 0);
+    for (unsigned threadId = 0; threadId < threadTotal; ++threadId) {
+        threads.emplace_back([&, threadId] {
+            while (turn != threadId) std::this_thread::yield();
+            for (unsigned i = 0; i < recordTotal; ++i) {
+                if (!footmark.record(1, i, threadId)) ++dropped[threadId];
+            }
+            ++turn;
+            while (turn != threadTotal) std::this_thread::yield();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CPPUNIT_ASSERT(dropped[threadTotal - 1] == recordTotal);
+
+    ShmFootmarkLanesView view(footmark.getShmId());
+    CPPUNIT_ASSERT(view.isValid());
+
+    const std::vector<ShmFootmarkLanesView::Item> items = view.getTimeline();
+    CPPUNIT_ASSERT(items.size() == (threadTotal - 1) * recordTotal);
+    for (size_t i = 0; i < items.size(); ++i) {
+        const ShmFootmarkRecord& rec = items[i].mRecord;
+        if (i > 0) CPPUNIT_ASSERT(items[i - 1].mRecord.mTimeNs <= rec.mTimeNs);
+        CPPUNIT_ASSERT(rec.mEventId == 1);
+        CPPUNIT_ASSERT(rec.mPayload[0] == items[i].mLaneId); // lanes were taken in thread order
+        CPPUNIT_ASSERT(rec.mArg == i % recordTotal);
+        CPPUNIT_ASSERT(!items[i].mPrevOwner);
+    }
+    CPPUNIT_ASSERT(view.showItem(items[0]).find("step(1)") != std::string::npos);
+
+    // The threads have exited and handed their lanes back.
+    CPPUNIT_ASSERT(footmark.record(1));
+
+    view.freeShMem();
+}
+
+void
+TestShmFootmarkLanes::testLaneRecycle()
+{
+    // Many more short lived threads than lanes, like TBB arena churn.
+    const unsigned laneTotal = 2;
+    const unsigned threadTotal = 50;
+    ShmFootmarkLanes footmark("TestShmFootmarkLanes", laneTotal, 16);
+
+    unsigned dropped = 0;
+    for (unsigned threadId = 0; threadId < threadTotal; ++threadId) {
+        std::thread([&, threadId] {
+            if (!footmark.record(1, threadId)) ++dropped;
+        }).join();
+    }
+    CPPUNIT_ASSERT(dropped == 0);
+
+    ShmFootmarkLanesView view(footmark.getShmId());
+    CPPUNIT_ASSERT(view.showHeader().find("droppedRecords:0") != std::string::npos);
+
+    // Every thread reused lane 0, the earlier threads' records are kept and marked as such.
+    const std::vector<ShmFootmarkLanesView::Item> items = view.getTimeline();
+    CPPUNIT_ASSERT(items.size() == 15); // the oldest slot is treated as possibly overwritten
+    for (size_t i = 0; i < items.size(); ++i) {
+        CPPUNIT_ASSERT(items[i].mLaneId == 0);
+        CPPUNIT_ASSERT(items[i].mRecord.mArg == threadTotal - items.size() + i);
+        CPPUNIT_ASSERT(items[i].mPrevOwner == (i + 1 < items.size()));
+    }
+    CPPUNIT_ASSERT(view.showItem(items.front()).find("tid:prev") != std::string::npos);
+
+    view.freeShMem();
+}
+
+void
+TestShmFootmarkLanes::testWrapAround()
+{
+    ShmFootmarkLanes footmark("TestShmFootmarkLanes", 1, 16);
+    for (unsigned i = 0; i < 100; ++i) {
+        footmark.record(1, i);
+    }
+    footmark.recordText(2, "text longer than the payload");
+
+    ShmFootmarkLanesView view(footmark.getShmId());
+    const std::vector<ShmFootmarkLanesView::Item> items = view.getTimeline();
+
+    // The oldest slot is conservatively treated as possibly overwritten.
+    CPPUNIT_ASSERT(items.size() == 15);
+    CPPUNIT_ASSERT(items.front().mRecord.mArg == 86);
+    CPPUNIT_ASSERT(view.showItem(items.back()).find("text:\"text longer than\"") != std::string::npos);
+
+    view.freeShMem();
+}
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,35 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+
+#pragma once
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+class TestShmFootmarkLanes : public CppUnit::TestFixture
+{
+public:
+    void setUp() {}
+    void testDown() {}
+
+    void testLanes();
+    void testLaneRecycle();
+    void testWrapAround();
+
+    CPPUNIT_TEST_SUITE(TestShmFootmarkLanes);
+    CPPUNIT_TEST(testLanes);
+    CPPUNIT_TEST(testLaneRecycle);
+    CPPUNIT_TEST(testWrapAround);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,210 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "TestTlSvrMulti.h"
+
+#include <scene_rdl2/common/grid_util/TlSvrMulti.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+namespace {
+
+// Runs the poll() loop of a loopback TlSvrMulti on its own thread. Every received line is answered
+// by the reply of replyFunc, to its sender only.
+class LoopbackServer
+{
+public:
+    using ReplyFunc = std::function<std::string(const std::string &line)>;
+
+    explicit LoopbackServer(const ReplyFunc &replyFunc)
+    {
+        if (mSvr.open(0)) {
+            mThread = std::thread([this, replyFunc] {
+                auto lineCallBack = [&](TlSvrMulti::ClientId clientId, const std::string &line) {
+                    mSvr.send(clientId, replyFunc(line));
+                };
+                while (!mShutdown) {
+                    mSvr.poll(100, lineCallBack, [this](TlSvrMulti::ClientId) { ++mClosedTotal; });
+                }
+            });
+        }
+    }
+    ~LoopbackServer()
+    {
+        mShutdown = true;
+        mSvr.wakeup();
+        if (mThread.joinable()) mThread.join();
+        mSvr.close();
+    }
+
+    TlSvrMulti &svr() { return mSvr; }
+    int getClosedTotal() const { return mClosedTotal; }
+
+private:
+    TlSvrMulti mSvr;
+    std::atomic<bool> mShutdown {false};
+    std::atomic<int> mClosedTotal {0};
+    std::thread mThread;
+};
+
+int
+connectClient(int port)
+{
+    const int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ::close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool
+sendAll(int sock, const std::string &str)
+{
+    size_t offset = 0;
+    while (offset < str.size()) {
+        const ssize_t wSize = ::send(sock, str.data() + offset, str.size() - offset, MSG_NOSIGNAL);
+        if (wSize <= 0) return false;
+        offset += static_cast<size_t>(wSize);
+    }
+    return true;
+}
+
+// Reads until done(received) is true, the server closes the connection or timeoutMs passes.
+// eof is set if the server closed the connection.
+std::string
+recvUntil(int sock, const std::function<bool(const std::string &)> &done, int timeoutMs, bool &eof)
+{
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point limit = Clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    std::string received;
+    eof = false;
+    while (!done(received) && Clock::now() < limit) {
+        struct pollfd pfd {sock, POLLIN, 0};
+        if (::poll(&pfd, 1, 10) <= 0) continue;
+        char buff[65536];
+        const ssize_t rSize = ::recv(sock, buff, sizeof(buff), 0);
+        if (rSize <= 0) {
+            eof = true;
+            break;
+        }
+        received.append(buff, static_cast<size_t>(rSize));
+    }
+    return received;
+}
+
+size_t
+countStr(const std::string &str, const std::string &key)
+{
+    size_t count = 0;
+    for (size_t pos = str.find(key); pos != std::string::npos; pos = str.find(key, pos + 1)) ++count;
+    return count;
+}
+
+} // namespace
+
+void
+TestTlSvrMulti::testTwoClients()
+{
+    LoopbackServer server([](const std::string &line) { return "reply:" + line + '\n'; });
+    const int port = server.svr().getPort();
+    CPPUNIT_ASSERT(port != 0);
+
+    const int sockA = connectClient(port);
+    const int sockB = connectClient(port);
+    CPPUNIT_ASSERT(sockA >= 0 && sockB >= 0);
+
+    constexpr int lineTotal = 100;
+    std::string cmdA;
+    std::string cmdB;
+    for (int i = 0; i < lineTotal; ++i) {
+        cmdA += "a" + std::to_string(i) + "\r\n"; // telnet line end
+        cmdB += "b" + std::to_string(i) + '\n';
+    }
+    CPPUNIT_ASSERT(sendAll(sockA, cmdA));
+    CPPUNIT_ASSERT(sendAll(sockB, cmdB));
+
+    auto allLines = [&](const std::string &received) { return countStr(received, "\n") >= lineTotal; };
+    bool eofA = false;
+    bool eofB = false;
+    const std::string outA = recvUntil(sockA, allLines, 5000, eofA);
+    const std::string outB = recvUntil(sockB, allLines, 5000, eofB);
+    CPPUNIT_ASSERT(!eofA && !eofB);
+
+    std::string expectA;
+    std::string expectB;
+    for (int i = 0; i < lineTotal; ++i) {
+        expectA += "reply:a" + std::to_string(i) + '\n';
+        expectB += "reply:b" + std::to_string(i) + '\n';
+    }
+    CPPUNIT_ASSERT_EQUAL(expectA, outA);
+    CPPUNIT_ASSERT_EQUAL(expectB, outB);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), server.svr().getClientTotal());
+
+    // broadcast goes to both
+    server.svr().broadcast("all\n");
+    auto oneLine = [](const std::string &received) { return received.find('\n') != std::string::npos; };
+    CPPUNIT_ASSERT_EQUAL(std::string("all\n"), recvUntil(sockA, oneLine, 5000, eofA));
+    CPPUNIT_ASSERT_EQUAL(std::string("all\n"), recvUntil(sockB, oneLine, 5000, eofB));
+
+    ::close(sockA);
+    ::close(sockB);
+}
+
+void
+TestTlSvrMulti::testHalfClose()
+{
+    // "echo cmd | nc host port" : the client sends its command and closes its sending side right away.
+    // The reply is larger than the socket buffers, so most of it is still queued when the EOF arrives.
+    const std::string reply = std::string(4 * 1024 * 1024, 'x') + "end\n";
+
+    LoopbackServer server([&](const std::string &line) { return (line == "cmd") ? reply : "unknown\n"; });
+    const int port = server.svr().getPort();
+    CPPUNIT_ASSERT(port != 0);
+
+    for (const std::string &cmd : {std::string("cmd\n"), std::string("cmd")}) { // also without '\n'
+        const int sock = connectClient(port);
+        CPPUNIT_ASSERT(sock >= 0);
+        CPPUNIT_ASSERT(sendAll(sock, cmd));
+        CPPUNIT_ASSERT_EQUAL(0, ::shutdown(sock, SHUT_WR));
+
+        // The whole reply arrives, then the server closes the connection.
+        bool eof = false;
+        const std::string out = recvUntil(sock, [](const std::string &) { return false; }, 10000, eof);
+        CPPUNIT_ASSERT(eof);
+        CPPUNIT_ASSERT_EQUAL(reply.size(), out.size());
+        CPPUNIT_ASSERT(out == reply);
+        ::close(sock);
+    }
+
+    for (int i = 0; i < 500 && server.getClosedTotal() < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CPPUNIT_ASSERT_EQUAL(2, server.getClosedTotal());
+    CPPUNIT_ASSERT_EQUAL(size_t(0), server.svr().getClientTotal());
+}
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
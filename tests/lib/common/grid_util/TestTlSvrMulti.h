@@ -0,0 +1,33 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+
+#pragma once
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+class TestTlSvrMulti : public CppUnit::TestFixture
+{
+public:
+    void setUp() {}
+    void tearDown() {}
+
+    void testTwoClients();
+    void testHalfClose();
+
+    CPPUNIT_TEST_SUITE(TestTlSvrMulti);
+    CPPUNIT_TEST(testTwoClients);
+    CPPUNIT_TEST(testHalfClose);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
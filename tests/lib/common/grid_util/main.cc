@@ -2,9 +2,15 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "TestArg.h"
+#include "TestDebugConsoleDriver.h"
+#include "TestFbStream.h"
+#include "TestLatencyTrace.h"
+#include "TestMetricsRegistry.h"
 #include "TestPixelBufferSha1.h"
 #include "TestParser.h"
 #include "TestSha1.h"
+#include "TestShmFootmarkLanes.h"
+#include "TestTlSvrMulti.h"
 
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
@@ -16,9 +22,15 @@ main(int ac, char **av)
     using namespace scene_rdl2::grid_util::unittest;
 
     CPPUNIT_TEST_SUITE_REGISTRATION(TestArg);
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestDebugConsoleDriver);
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestFbStream);
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestLatencyTrace);
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestMetricsRegistry);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestParser);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestSha1);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestPixelBufferSha1);
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestShmFootmarkLanes);
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestTlSvrMulti);
 
     return pdevunit::run(ac, av);
 }
@@ -0,0 +1,211 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "TestRecScopeProfiler.h"
+
+#include <scene_rdl2/common/rec_time/RecScopeProfiler.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace scene_rdl2 {
+namespace rec_time {
+namespace unittest {
+
+namespace {
+
+// Returns the value following "key": on the line, unquoted.
+std::string
+findField(const std::string &line, const std::string &key)
+{
+    const std::string tag = "\"" + key + "\":";
+    const size_t pos = line.find(tag);
+    if (pos == std::string::npos) return std::string();
+    size_t begin = pos + tag.size();
+    if (line[begin] == '"') {
+        ++begin;
+        return line.substr(begin, line.find('"', begin) - begin);
+    }
+    return line.substr(begin, line.find_first_of(",}", begin) - begin);
+}
+
+void
+recordThread(const std::string &threadName, int scopes)
+{
+    RecScopeProfiler::setThreadName(threadName);
+    for (int i = 0; i < scopes; ++i) {
+        REC_SCOPE_PROFILE("work");
+        REC_SCOPE_COUNTER("index", i);
+    }
+}
+
+} // namespace
+
+void
+TestRecScopeProfiler::setUp()
+{
+    RecScopeProfiler::setEnabled(true);
+    RecScopeProfiler::reset();
+}
+
+void
+TestRecScopeProfiler::tearDown()
+{
+    RecScopeProfiler::setEnabled(false);
+    RecScopeProfiler::reset();
+}
+
+std::vector<TestRecScopeProfiler::TraceEvent>
+TestRecScopeProfiler::exportEvents()
+{
+    std::ostringstream out;
+    RecScopeProfiler::exportChromeTrace(out);
+
+    std::vector<TraceEvent> events;
+    std::istringstream in(out.str());
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find("\"ph\":") == std::string::npos) continue;
+        TraceEvent event;
+        event.mPh = findField(line, "ph");
+        event.mName = (event.mPh == "M") ? findField(line.substr(line.find("\"args\"")), "name")
+                                         : findField(line, "name");
+        event.mTid = static_cast<unsigned>(std::stoul(findField(line, "tid")));
+        if (event.mPh != "M") event.mTs = std::stod(findField(line, "ts"));
+        if (event.mPh == "X") event.mDur = std::stod(findField(line, "dur"));
+        events.push_back(event);
+    }
+    return events;
+}
+
+void
+TestRecScopeProfiler::testNestedScopes()
+{
+    {
+        REC_SCOPE_PROFILE("outer");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        {
+            REC_SCOPE_PROFILE("inner");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CPPUNIT_ASSERT(RecScopeProfiler::getTicksPerMicroSec() > 0.0);
+
+    const std::vector<TraceEvent> events = exportEvents();
+    CPPUNIT_ASSERT_EQUAL(size_t(2), events.size());
+
+    // Scopes are recorded when they end, so the inner one comes first.
+    const TraceEvent &inner = events[0];
+    const TraceEvent &outer = events[1];
+    CPPUNIT_ASSERT_EQUAL(std::string("inner"), inner.mName);
+    CPPUNIT_ASSERT_EQUAL(std::string("outer"), outer.mName);
+    CPPUNIT_ASSERT_EQUAL(inner.mTid, outer.mTid);
+    CPPUNIT_ASSERT(inner.mTs >= outer.mTs);
+    CPPUNIT_ASSERT(inner.mTs + inner.mDur <= outer.mTs + outer.mDur);
+
+    // The sleeps give a lower bound on the durations, with a generous margin
+    // for the tick rate measurement.
+    CPPUNIT_ASSERT(inner.mDur >= 500.0);
+    CPPUNIT_ASSERT(outer.mDur >= inner.mDur + 1000.0);
+}
+
+void
+TestRecScopeProfiler::testMultiThread()
+{
+    constexpr int numThreads = 8;
+    constexpr int numScopes = 20000; // spans several buffer chunks
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(recordThread, "worker" + std::to_string(i), numScopes);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::map<unsigned, std::string> threadNames;
+    std::map<unsigned, int> scopes;
+    std::map<unsigned, int> counters;
+    std::map<unsigned, double> lastTs;
+    bool ordered = true;
+    for (const TraceEvent &event : exportEvents()) {
+        if (event.mPh == "M") {
+            threadNames[event.mTid] = event.mName;
+        } else if (event.mPh == "X") {
+            ++scopes[event.mTid];
+        } else if (event.mPh == "C") {
+            // Counters are recorded in order within a thread.
+            ordered = ordered && event.mTs >= lastTs[event.mTid];
+            lastTs[event.mTid] = event.mTs;
+            ++counters[event.mTid];
+        }
+    }
+    CPPUNIT_ASSERT(ordered);
+    CPPUNIT_ASSERT_EQUAL(size_t(numThreads), threadNames.size());
+    CPPUNIT_ASSERT_EQUAL(size_t(numThreads), scopes.size());
+    for (const auto &entry : threadNames) {
+        CPPUNIT_ASSERT_EQUAL(0, entry.second.compare(0, 6, "worker"));
+        CPPUNIT_ASSERT_EQUAL(numScopes, scopes[entry.first]);
+        CPPUNIT_ASSERT_EQUAL(numScopes, counters[entry.first]);
+    }
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), RecScopeProfiler::getDroppedEventCount());
+}
+
+void
+TestRecScopeProfiler::testThreadChurn()
+{
+    constexpr int numRounds = 50;
+    constexpr int numThreads = 4;
+    constexpr int numScopes = 100;
+
+    // The buffers of exited threads are reused, so the number of buffers is
+    // bounded by the threads recording at the same time, not by the number of
+    // threads ever started.
+    const size_t buffersBefore = RecScopeProfiler::getThreadBufferCount();
+    for (int round = 0; round < numRounds; ++round) {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < numThreads; ++i) {
+            threads.emplace_back(recordThread, "churn", numScopes);
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+    CPPUNIT_ASSERT(RecScopeProfiler::getThreadBufferCount() <= buffersBefore + numThreads);
+
+    // Every exited thread's events are still exported, each under its own tid.
+    std::map<unsigned, int> scopes;
+    for (const TraceEvent &event : exportEvents()) {
+        if (event.mPh == "X") ++scopes[event.mTid];
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(numRounds * numThreads), scopes.size());
+    for (const auto &entry : scopes) {
+        CPPUNIT_ASSERT_EQUAL(numScopes, entry.second);
+    }
+}
+
+void
+TestRecScopeProfiler::testReset()
+{
+    std::thread(recordThread, "exited", 10).join();
+    {
+        REC_SCOPE_PROFILE("live");
+    }
+    CPPUNIT_ASSERT(!exportEvents().empty());
+
+    RecScopeProfiler::reset();
+    CPPUNIT_ASSERT(exportEvents().empty());
+
+    RecScopeProfiler::setEnabled(false);
+    {
+        REC_SCOPE_PROFILE("disabled");
+    }
+    CPPUNIT_ASSERT(exportEvents().empty());
+}
+
+} // namespace unittest
+} // namespace rec_time
+} // namespace scene_rdl2
@@ -0,0 +1,52 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include <string>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rec_time {
+namespace unittest {
+
+class TestRecScopeProfiler : public CppUnit::TestFixture
+{
+public:
+    void setUp();
+    void tearDown();
+
+    void testNestedScopes();
+    void testMultiThread();
+    void testThreadChurn();
+    void testReset();
+
+    CPPUNIT_TEST_SUITE(TestRecScopeProfiler);
+    CPPUNIT_TEST(testNestedScopes);
+    CPPUNIT_TEST(testMultiThread);
+    CPPUNIT_TEST(testThreadChurn);
+    CPPUNIT_TEST(testReset);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    struct TraceEvent
+    {
+        std::string mName;
+        std::string mPh;
+        double mTs {0.0};
+        double mDur {0.0};
+        unsigned mTid {0};
+    };
+
+    // Exports the trace and parses back its events, one per line.
+    static std::vector<TraceEvent> exportEvents();
+};
+
+} // namespace unittest
+} // namespace rec_time
+} // namespace scene_rdl2
@@ -0,0 +1,195 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "TestRecTimeLap.h"
+
+#include <scene_rdl2/common/rec_time/RecTimeLap.h>
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rec_time {
+namespace unittest {
+
+namespace {
+
+RecPerfValues
+makeValues(uint64_t cycles, uint64_t instructions)
+{
+    RecPerfValues v;
+    v.mCycles = cycles;
+    v.mInstructions = instructions;
+    v.mLlcMisses = cycles / 100;
+    v.mBranchMisses = cycles / 1000;
+    return v;
+}
+
+int
+countLines(const std::string &str, const std::string &key)
+{
+    int count = 0;
+    std::istringstream istr(str);
+    std::string line;
+    while (std::getline(istr, line)) {
+        if (line.find(key) != std::string::npos) ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+void
+TestRecTimeLap::testPerfIntervalPerThread()
+{
+    // Synthetic values, so the breakdown is checked without a PMU.
+    std::thread::id threadA = std::this_thread::get_id();
+    std::thread::id threadB;
+    std::thread([&] { threadB = std::this_thread::get_id(); }).join();
+
+    RecPerfManualInterval interval;
+    CPPUNIT_ASSERT(interval.isReset());
+    interval.add(makeValues(1000, 2000), threadA);
+    interval.add(makeValues(3000, 1000), threadB);
+    interval.add(makeValues(3000, 4000), threadA);
+
+    CPPUNIT_ASSERT_EQUAL(uint64_t(3), interval.getTotal());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(3000), interval.getLast().mCycles);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(7000 / 3), interval.getAverage().mCycles);
+
+    const std::vector<RecPerfManualInterval::ThreadValues> &threads = interval.getThreads();
+    CPPUNIT_ASSERT_EQUAL(size_t(2), threads.size());
+    CPPUNIT_ASSERT(threads[0].mThreadId == threadA);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), threads[0].mTotal);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2000), threads[0].getAverage().mCycles);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(3000), threads[0].getAverage().mInstructions);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.5f, threads[0].getAverage().getIpc(), 1.0e-6f);
+    CPPUNIT_ASSERT(threads[1].mThreadId == threadB);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), threads[1].mTotal);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(3000), threads[1].getAverage().mCycles);
+
+    interval.reset();
+    CPPUNIT_ASSERT(interval.isReset());
+    CPPUNIT_ASSERT(interval.getThreads().empty());
+}
+
+void
+TestRecTimeLap::testPerfInfoPerThread()
+{
+    constexpr int numThreads = 3;
+    constexpr int numLaps = 10;
+
+    RecTimeLap timeLap;
+    timeLap.setName("lap");
+    const size_t sectionA = timeLap.sectionRegistration("sectionA");
+    const size_t sectionB = timeLap.sectionRegistration("sectionB");
+    timeLap.setPerfCounter(true);
+
+    // sectionA runs on every thread in turn, sectionB on the main thread only.
+    // The threads stay alive until all of them are done, so that their ids
+    // are not reused.
+    std::atomic<int> turn(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&, i] {
+            while (turn != i) std::this_thread::yield();
+            for (int lap = 0; lap < numLaps; ++lap) {
+                timeLap.sectionStart(sectionA);
+                timeLap.sectionEnd(sectionA);
+            }
+            ++turn;
+            while (turn != numThreads) std::this_thread::yield();
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    timeLap.sectionStart(sectionB);
+    timeLap.sectionEnd(sectionB);
+
+    const std::string info = timeLap.showPerfInfo();
+    CPPUNIT_ASSERT(info.find("perfInfo lap (perfCounter:on)") != std::string::npos);
+    CPPUNIT_ASSERT_EQUAL(numThreads + 1, countLines(info, "thread:"));
+    CPPUNIT_ASSERT_EQUAL(numThreads, countLines(info, " n:" + std::to_string(numLaps) + ":"));
+    CPPUNIT_ASSERT_EQUAL(1, countLines(info, " n:1:"));
+
+    timeLap.reset();
+    CPPUNIT_ASSERT_EQUAL(0, countLines(timeLap.showPerfInfo(), "thread:"));
+}
+
+void
+TestRecTimeLap::testPerfCounterSwitch()
+{
+    // The switch is flipped from another thread, like a debug console command,
+    // while the sections run. Every section which started with the counters on
+    // is measured, the others are not.
+    RecTimeLap timeLap;
+    timeLap.setName("lap");
+    const size_t section = timeLap.sectionRegistration("section");
+    CPPUNIT_ASSERT(!timeLap.getPerfCounter());
+
+    std::atomic<bool> done(false);
+    std::thread console([&] {
+        bool flag = false;
+        while (!done) {
+            flag = !flag;
+            timeLap.setPerfCounter(flag);
+            (void)timeLap.showPerfInfo();
+            std::this_thread::yield();
+        }
+    });
+    for (int lap = 0; lap < 2000; ++lap) {
+        timeLap.sectionStart(section);
+        timeLap.sectionEnd(section);
+    }
+    done = true;
+    console.join();
+
+    timeLap.setPerfCounter(false);
+    timeLap.reset();
+    timeLap.sectionStart(section);
+    timeLap.sectionEnd(section);
+    CPPUNIT_ASSERT_EQUAL(0, countLines(timeLap.showPerfInfo(), "thread:"));
+
+    timeLap.setPerfCounter(true);
+    timeLap.sectionStart(section);
+    timeLap.setPerfCounter(false); // still measured, it started with the counters on
+    timeLap.sectionEnd(section);
+    CPPUNIT_ASSERT_EQUAL(1, countLines(timeLap.showPerfInfo(), " n:1:"));
+}
+
+void
+TestRecTimeLap::testMove()
+{
+    // Laps are stored and returned by value, the perf state moves with them.
+    auto makeLap = [](const std::string &name) {
+        RecTimeLap timeLap;
+        timeLap.setName(std::string(name));
+        timeLap.sectionRegistration("section");
+        timeLap.setPerfCounter(true);
+        return timeLap;
+    };
+    std::vector<RecTimeLap> laps;
+    laps.push_back(makeLap("lapA"));
+    laps.push_back(makeLap("lapB"));
+
+    // Nothing ran yet: showPerfInfo() has nothing to report, not even whether
+    // the console thread itself could open perf events.
+    std::string info;
+    std::thread([&] { info = laps[1].showPerfInfo(); }).join();
+    CPPUNIT_ASSERT(info.find("perfInfo lapB (perfCounter:on)") != std::string::npos);
+    CPPUNIT_ASSERT(info.find("not available") == std::string::npos);
+
+    laps[1].sectionStart(0);
+    laps[1].sectionEnd(0);
+    RecTimeLap moved = std::move(laps[1]);
+    CPPUNIT_ASSERT(moved.getPerfCounter());
+    CPPUNIT_ASSERT_EQUAL(1, countLines(moved.showPerfInfo(), " n:1:"));
+    CPPUNIT_ASSERT_EQUAL(0, countLines(laps[0].showPerfInfo(), "thread:"));
+}
+
+} // namespace unittest
+} // namespace rec_time
+} // namespace scene_rdl2
@@ -0,0 +1,36 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace rec_time {
+namespace unittest {
+
+class TestRecTimeLap : public CppUnit::TestFixture
+{
+public:
+    void setUp() {}
+    void tearDown() {}
+
+    void testPerfIntervalPerThread();
+    void testPerfInfoPerThread();
+    void testPerfCounterSwitch();
+    void testMove();
+
+    CPPUNIT_TEST_SUITE(TestRecTimeLap);
+    CPPUNIT_TEST(testPerfIntervalPerThread);
+    CPPUNIT_TEST(testPerfInfoPerThread);
+    CPPUNIT_TEST(testPerfCounterSwitch);
+    CPPUNIT_TEST(testMove);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+} // namespace unittest
+} // namespace rec_time
+} // namespace scene_rdl2
@@ -0,0 +1,20 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "TestRecScopeProfiler.h"
+#include "TestRecTimeLap.h"
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <scene_rdl2/pdevunit/pdevunit.h>
+
+int
+main(int ac, char **av)
+{
+    using namespace scene_rdl2::rec_time::unittest;
+
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestRecScopeProfiler);
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestRecTimeLap);
+
+    return pdevunit::run(ac, av);
+}
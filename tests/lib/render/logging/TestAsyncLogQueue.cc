@@ -0,0 +1,189 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "TestAsyncLogQueue.h"
+#include <scene_rdl2/render/logging/AsyncLogQueue.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace logging {
+
+namespace {
+
+// Collects the output of the queue instead of sending it to log4cplus.
+struct Sink
+{
+    void add(LogLevel level, const std::string& text)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mLevels.push_back(level);
+        mTexts.push_back(text);
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mTexts.size();
+    }
+
+    std::mutex               mMutex;
+    std::vector<LogLevel>    mLevels;
+    std::vector<std::string> mTexts;
+};
+
+Sink* sSink = nullptr;
+
+bool
+logAsync(LogLevel level, const std::string& text)
+{
+    AsyncLogQueue& queue = AsyncLogQueue::getInstance();
+    std::ostream* o = queue.beginMessage();
+    if (!o) {
+        return false;
+    }
+    *o << text;
+    queue.commitMessage(level);
+    return true;
+}
+
+} // anonymous namespace
+
+void
+TestAsyncLogQueue::setUp()
+{
+    sSink = new Sink;
+    AsyncLogQueue::getInstance().setOutput([](LogLevel level, const std::string& text) {
+        sSink->add(level, text);
+    });
+}
+
+void
+TestAsyncLogQueue::tearDown()
+{
+    AsyncLogQueue& queue = AsyncLogQueue::getInstance();
+    queue.stop();
+    queue.setOutput(AsyncLogQueue::OutputFunc());
+    delete sSink;
+    sSink = nullptr;
+}
+
+void
+TestAsyncLogQueue::testCrossThreadOrder()
+{
+    // The threads take turns through a mutex, so there is a single global
+    // order, and the output must follow it exactly even though the messages
+    // are spread over many rings and many drains.
+    const unsigned numThreads = 8;
+    const unsigned numMessages = 2000; // per thread, more than a ring holds
+
+    AsyncLogQueue& queue = AsyncLogQueue::getInstance();
+    queue.start();
+
+    std::mutex turnMutex;
+    unsigned next = 0;
+    std::atomic<unsigned> rejected(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&]() {
+            for (unsigned i = 0; i < numMessages; ++i) {
+                std::lock_guard<std::mutex> lock(turnMutex);
+                if (!logAsync(INFO_LEVEL, std::to_string(next++))) {
+                    ++rejected;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    queue.flush();
+
+    CPPUNIT_ASSERT_EQUAL(0u, rejected.load());
+
+    CPPUNIT_ASSERT_EQUAL(size_t(numThreads * numMessages), sSink->mTexts.size());
+    for (unsigned i = 0; i < numThreads * numMessages; ++i) {
+        CPPUNIT_ASSERT_EQUAL(std::to_string(i), sSink->mTexts[i]);
+    }
+}
+
+void
+TestAsyncLogQueue::testFlushOnStop()
+{
+    AsyncLogQueue& queue = AsyncLogQueue::getInstance();
+    queue.start();
+    CPPUNIT_ASSERT(queue.isRunning());
+
+    // Longer than the inline slot text, to go through the spill path.
+    const std::string longText(AsyncLogQueue::kSlotTextSize * 2, 'x');
+    CPPUNIT_ASSERT(logAsync(WARN_LEVEL, "first"));
+    CPPUNIT_ASSERT(logAsync(ERROR_LEVEL, longText));
+
+    // A thread which exits right away: its ring must still be drained.
+    bool threadLogged = false;
+    std::thread([&]() { threadLogged = logAsync(DEBUG_LEVEL, "from thread"); }).join();
+    CPPUNIT_ASSERT(threadLogged);
+    CPPUNIT_ASSERT(logAsync(INFO_LEVEL, "last"));
+
+    queue.stop();
+    CPPUNIT_ASSERT(!queue.isRunning());
+    CPPUNIT_ASSERT_EQUAL(size_t(4), sSink->mTexts.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("first"), sSink->mTexts[0]);
+    CPPUNIT_ASSERT_EQUAL(longText, sSink->mTexts[1]);
+    CPPUNIT_ASSERT_EQUAL(std::string("from thread"), sSink->mTexts[2]);
+    CPPUNIT_ASSERT_EQUAL(std::string("last"), sSink->mTexts[3]);
+    CPPUNIT_ASSERT(sSink->mLevels[1] == ERROR_LEVEL);
+    CPPUNIT_ASSERT(sSink->mLevels[2] == DEBUG_LEVEL);
+
+    // Stopped: messages are turned away to be logged synchronously.
+    CPPUNIT_ASSERT(!logAsync(INFO_LEVEL, "sync"));
+    CPPUNIT_ASSERT_EQUAL(size_t(4), sSink->size());
+}
+
+void
+TestAsyncLogQueue::testSwitching()
+{
+    // Threads keep logging while the queue is switched on and off. Every
+    // message the queue accepted must have been output once it is stopped,
+    // including the ones committed while it was stopping.
+    const unsigned numThreads = 4;
+
+    AsyncLogQueue& queue = AsyncLogQueue::getInstance();
+    std::atomic<bool> done(false);
+    std::atomic<size_t> accepted(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (unsigned i = 0; !done.load(std::memory_order_relaxed); ++i) {
+                if (logAsync(INFO_LEVEL, std::to_string(t) + ":" + std::to_string(i))) {
+                    accepted.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    for (unsigned i = 0; i < 50; ++i) {
+        queue.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        queue.stop();
+    }
+
+    done = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+    CPPUNIT_ASSERT_EQUAL(accepted.load(), sSink->size());
+    CPPUNIT_ASSERT(accepted.load() > 0);
+}
+
+} // namespace logging
+} // namespace scene_rdl2
+
+CPPUNIT_TEST_SUITE_REGISTRATION(scene_rdl2::logging::TestAsyncLogQueue);
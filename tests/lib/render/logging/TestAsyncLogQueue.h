@@ -0,0 +1,32 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace logging {
+
+class TestAsyncLogQueue : public CppUnit::TestFixture
+{
+public:
+    CPPUNIT_TEST_SUITE(TestAsyncLogQueue);
+    CPPUNIT_TEST(testCrossThreadOrder);
+    CPPUNIT_TEST(testFlushOnStop);
+    CPPUNIT_TEST(testSwitching);
+    CPPUNIT_TEST_SUITE_END();
+
+    void setUp() override;
+    void tearDown() override;
+
+    void testCrossThreadOrder();
+    void testFlushOnStop();
+    void testSwitching();
+};
+
+} // namespace logging
+} // namespace scene_rdl2
+
@@ -0,0 +1,167 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "TestEventCounters.h"
+#include <scene_rdl2/render/logging/logging.h>
+
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace logging {
+
+namespace {
+
+struct Object
+{
+    int mPad;
+};
+
+using Counters = EventCounters<Object>;
+using Reference = std::map<std::pair<const Object*, LogEvent>, unsigned>;
+
+const unsigned NUM_THREADS = 8;
+const unsigned NUM_RECORDS = 20000;  // per thread
+const unsigned NUM_SHARED_OBJECTS = 64;
+const unsigned NUM_SHARED_EVENTS = 16; // 1024 shared keys, more than the first table holds
+
+// Every thread records into the shared objects, in a different order so that
+// they race for the same keys, and into its own object, which gives the
+// per-thread breakdown.
+template <typename Record>
+void
+recordPattern(unsigned thread, const std::vector<Object>& shared, const std::vector<Object>& own,
+              const Record& record)
+{
+    for (unsigned i = 0; i < NUM_RECORDS; ++i) {
+        const unsigned n = i * 7 + thread * 131;
+        record(&shared[n % NUM_SHARED_OBJECTS], LogEvent((n / NUM_SHARED_OBJECTS) % NUM_SHARED_EVENTS));
+        record(&own[thread], LogEvent(i % 3));
+    }
+}
+
+Reference
+toReference(const Counters& counters)
+{
+    Reference result;
+    counters.forEachRecord([&](const Object* p, LogEvent event, unsigned count) {
+        // Every key is reported once.
+        CPPUNIT_ASSERT(result.emplace(std::make_pair(p, event), count).second);
+    });
+    return result;
+}
+
+} // anonymous namespace
+
+void
+TestEventCounters::testSerial()
+{
+    Object a, b;
+    Counters counters;
+
+    CPPUNIT_ASSERT_EQUAL(0u, counters.getCount(&a, 0));
+    counters.record(&a, 0);
+    counters.record(&a, 0);
+    counters.record(&a, 5);
+    counters.record(&b, 0);
+    CPPUNIT_ASSERT_EQUAL(2u, counters.getCount(&a, 0));
+    CPPUNIT_ASSERT_EQUAL(1u, counters.getCount(&a, 5));
+    CPPUNIT_ASSERT_EQUAL(1u, counters.getCount(&b, 0));
+    CPPUNIT_ASSERT_EQUAL(0u, counters.getCount(&b, 5));
+    CPPUNIT_ASSERT_EQUAL(size_t(3), toReference(counters).size());
+
+    // Cleared counts are skipped by forEachRecord().
+    counters.clear();
+    CPPUNIT_ASSERT_EQUAL(0u, counters.getCount(&a, 0));
+    CPPUNIT_ASSERT(toReference(counters).empty());
+    counters.record(&b, 0);
+    CPPUNIT_ASSERT_EQUAL(1u, counters.getCount(&b, 0));
+}
+
+void
+TestEventCounters::testClear()
+{
+    const std::vector<Object> objects(NUM_SHARED_OBJECTS);
+    Counters counters;
+    const size_t initialCapacity = counters.getCapacity();
+
+    // More keys than the first table holds, so overflow tables get added.
+    for (const Object& object : objects) {
+        for (LogEvent event = 0; event < LogEvent(NUM_SHARED_EVENTS); ++event) {
+            counters.record(&object, event);
+        }
+    }
+    const size_t grownCapacity = counters.getCapacity();
+    CPPUNIT_ASSERT(grownCapacity > initialCapacity);
+    CPPUNIT_ASSERT_EQUAL(size_t(NUM_SHARED_OBJECTS * NUM_SHARED_EVENTS), toReference(counters).size());
+
+    // resetCounts() zeroes in place and keeps the tables.
+    counters.resetCounts();
+    CPPUNIT_ASSERT(toReference(counters).empty());
+    CPPUNIT_ASSERT_EQUAL(grownCapacity, counters.getCapacity());
+    counters.record(&objects[3], 2);
+    CPPUNIT_ASSERT_EQUAL(1u, counters.getCount(&objects[3], 2));
+
+    // clear() frees the overflow tables and forgets the keys.
+    counters.clear();
+    CPPUNIT_ASSERT(toReference(counters).empty());
+    CPPUNIT_ASSERT_EQUAL(initialCapacity, counters.getCapacity());
+    counters.record(&objects[5], 7);
+    counters.record(&objects[5], 7);
+    CPPUNIT_ASSERT_EQUAL(2u, counters.getCount(&objects[5], 7));
+    CPPUNIT_ASSERT_EQUAL(0u, counters.getCount(&objects[3], 2));
+}
+
+void
+TestEventCounters::testConcurrent()
+{
+    const std::vector<Object> shared(NUM_SHARED_OBJECTS);
+    const std::vector<Object> own(NUM_THREADS);
+
+    Reference reference;
+    for (unsigned thread = 0; thread < NUM_THREADS; ++thread) {
+        recordPattern(thread, shared, own, [&](const Object* p, LogEvent event) {
+            ++reference[std::make_pair(p, event)];
+        });
+    }
+
+    Counters counters;
+    std::vector<std::thread> threads;
+    for (unsigned thread = 0; thread < NUM_THREADS; ++thread) {
+        threads.emplace_back([&, thread]() {
+            recordPattern(thread, shared, own, [&](const Object* p, LogEvent event) {
+                counters.record(p, event);
+            });
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    // Per key, through both lookups.
+    CPPUNIT_ASSERT(toReference(counters) == reference);
+    for (const auto& entry : reference) {
+        CPPUNIT_ASSERT_EQUAL(entry.second, counters.getCount(entry.first.first, entry.first.second));
+    }
+
+    // Per thread, and in total.
+    for (unsigned thread = 0; thread < NUM_THREADS; ++thread) {
+        unsigned threadTotal = 0;
+        for (LogEvent event = 0; event < 3; ++event) {
+            threadTotal += counters.getCount(&own[thread], event);
+        }
+        CPPUNIT_ASSERT_EQUAL(NUM_RECORDS, threadTotal);
+    }
+    unsigned total = 0;
+    counters.forEachRecord([&](const Object*, LogEvent, unsigned count) { total += count; });
+    CPPUNIT_ASSERT_EQUAL(NUM_THREADS * NUM_RECORDS * 2, total);
+}
+
+} // namespace logging
+} // namespace scene_rdl2
+
+CPPUNIT_TEST_SUITE_REGISTRATION(scene_rdl2::logging::TestEventCounters);
@@ -0,0 +1,29 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace logging {
+
+class TestEventCounters : public CppUnit::TestFixture
+{
+public:
+    CPPUNIT_TEST_SUITE(TestEventCounters);
+    CPPUNIT_TEST(testSerial);
+    CPPUNIT_TEST(testClear);
+    CPPUNIT_TEST(testConcurrent);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testSerial();
+    void testClear();
+    void testConcurrent();
+};
+
+} // namespace logging
+} // namespace scene_rdl2
+
@@ -8,6 +8,10 @@
 
 #include "TestAtomicFloat.h"
 #include <scene_rdl2/render/util/AtomicFloat.h>
+#include <scene_rdl2/render/util/AtomicAccumulate.h>
+#include <scene_rdl2/common/math/Vec2.h>
+#include <scene_rdl2/common/math/Vec3.h>
+#include <scene_rdl2/common/math/Vec4.h>
 
 #include <algorithm>
 #include <thread>
@@ -136,6 +140,49 @@ bool atomicFloatTest()
 
     return tester.validate();
 }
+
+// Every thread adds (1, 2, 3, 4) style values to every pixel of a small
+// buffer, so all threads are hammering the same few cache lines.
+template <typename T>
+bool atomicAccumulateTest(const T& v)
+{
+    constexpr int numThreads = 20;
+    constexpr int numIterations = 2000;
+    constexpr unsigned size = 10; // Not a multiple of the tile size.
+
+    scene_rdl2::util::AtomicTileAccumBuffer<T> buffer(size, size);
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&buffer, &v]() {
+            for (int iter = 0; iter < numIterations; ++iter) {
+                for (unsigned y = 0; y < size; ++y) {
+                    for (unsigned x = 0; x < size; ++x) {
+                        buffer.add(x, y, v);
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    // Small integers are represented exactly, so the sums must be exact.
+    const T expected = v * static_cast<float>(numThreads * numIterations);
+    std::vector<T> untiled(size * size);
+    buffer.untile(untiled.data());
+    for (unsigned y = 0; y < size; ++y) {
+        for (unsigned x = 0; x < size; ++x) {
+            if (buffer.get(x, y) != expected || untiled[y * size + x] != expected) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
 } // anonymous namespace
 
 void TestAtomicFloat::testAtomicFloat()
@@ -150,6 +197,28 @@ void TestAtomicFloat::testAtomicFloat()
     CPPUNIT_ASSERT(f.is_lock_free());
 }
 
+void TestAtomicFloat::testAtomicAccumulate()
+{
+    CPPUNIT_ASSERT(atomicAccumulateTest(math::Vec2f(1.0f, 2.0f)));
+    CPPUNIT_ASSERT(atomicAccumulateTest(math::Vec3f(1.0f, 2.0f, 3.0f)));
+    CPPUNIT_ASSERT(atomicAccumulateTest(math::Vec4f(1.0f, 2.0f, 3.0f, 4.0f)));
+
+    CPPUNIT_ASSERT(util::isAtomicAddLockFree<math::Vec2f>());
+    CPPUNIT_ASSERT(!util::isAtomicAddLockFree<math::Vec3f>());
+
+    // Every tile starts on its own cache line, whatever the pixel size.
+    util::AtomicTileAccumBuffer<math::Vec4f> tiles(20, 20);
+    for (unsigned tileId = 0; tileId < tiles.getNumTiles(); ++tileId) {
+        CPPUNIT_ASSERT(reinterpret_cast<uintptr_t>(tiles.getTile(tileId)) % CACHE_LINE_SIZE == 0);
+    }
+
+    // Misaligned values are still updated correctly via the locked path.
+    alignas(16) float raw[8] = {};
+    math::Vec4f* misaligned = reinterpret_cast<math::Vec4f*>(raw + 1);
+    util::atomicAdd(misaligned, math::Vec4f(1.0f, 2.0f, 3.0f, 4.0f));
+    CPPUNIT_ASSERT(util::atomicLoad(misaligned) == math::Vec4f(1.0f, 2.0f, 3.0f, 4.0f));
+}
+
 } // namespace pbr
 } // namespace scene_rdl2
 
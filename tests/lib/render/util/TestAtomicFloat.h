@@ -27,9 +27,11 @@ class TestAtomicFloat : public CppUnit::TestFixture
 public:
     CPPUNIT_TEST_SUITE(TestAtomicFloat);
     CPPUNIT_TEST(testAtomicFloat);
+    CPPUNIT_TEST(testAtomicAccumulate);
     CPPUNIT_TEST_SUITE_END();
 
     void testAtomicFloat();
+    void testAtomicAccumulate();
 };
 
 
@@ -0,0 +1,161 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "TestLuaStatePool.h"
+#include <scene_rdl2/render/util/LuaScriptRunner.h>
+#include <scene_rdl2/render/util/LuaStatePool.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <lua.hpp>
+
+namespace scene_rdl2 {
+namespace util {
+
+namespace {
+
+lua_State *
+newSnapshotState()
+{
+    lua_State *state = luaL_newstate();
+    luaL_openlibs(state);
+    LuaStatePool::snapshotGlobals(state);
+    return state;
+}
+
+bool
+run(lua_State *state, const char *code)
+{
+    return luaL_loadstring(state, code) == LUA_OK && lua_pcall(state, 0, 0, 0) == LUA_OK;
+}
+
+// Runs the script file by LuaScriptRunner and returns the error message, empty if no error.
+std::string
+runScript(const std::string &filename, const std::string &code)
+{
+    {
+        std::ofstream ofs(filename, std::ios::binary);
+        ofs << code;
+    }
+    std::string error;
+    try {
+        LuaScriptRunner lua;
+        lua.runFile(filename);
+    }
+    catch (const std::runtime_error &e) {
+        error = e.what();
+    }
+    std::remove(filename.c_str());
+    return error;
+}
+
+} // namespace
+
+void
+TestLuaStatePool::testRestoreGlobals()
+{
+    LuaStatePool pool(1);
+    CPPUNIT_ASSERT(pool.acquire() == nullptr);
+
+    lua_State *state = newSnapshotState();
+    CPPUNIT_ASSERT(run(state, "answer = 42\n"
+                              "string.answer = 42\n"
+                              "print = nil\n"));
+    pool.release(state);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), pool.getIdleTotal());
+
+    state = pool.acquire();
+    CPPUNIT_ASSERT(state != nullptr);
+    CPPUNIT_ASSERT(run(state, "assert(answer == nil)\n"
+                              "assert(string.answer == nil)\n"
+                              "assert(type(print) == 'function')\n"));
+    pool.release(state);
+
+    // setMaxIdle(0) closes the idle states and disables pooling.
+    pool.setMaxIdle(0);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), pool.getIdleTotal());
+}
+
+void
+TestLuaStatePool::testRestoreLoadedModules()
+{
+    LuaStatePool pool(1);
+
+    lua_State *state = newSnapshotState();
+    CPPUNIT_ASSERT(run(state, "package.preload.counter = function() return { value = 1 } end\n"
+                              "local counter = require('counter')\n"
+                              "counter.value = counter.value + 1\n"
+                              "package.path = ''\n"));
+    pool.release(state);
+
+    // require() of the next use doesn't see the module of the previous use.
+    state = pool.acquire();
+    CPPUNIT_ASSERT(state != nullptr);
+    CPPUNIT_ASSERT(run(state, "assert(package.loaded.counter == nil)\n"
+                              "assert(package.preload.counter == nil)\n"
+                              "assert(package.path ~= '')\n"
+                              "assert(not pcall(require, 'counter'))\n"
+                              "assert(package.loaded.string == string)\n"));
+    pool.release(state);
+}
+
+void
+TestLuaStatePool::testRestoreNestedTables()
+{
+    LuaStatePool pool(1);
+
+    // Nested tables like the ones of a support library, which already exist at the snapshot.
+    lua_State *state = luaL_newstate();
+    luaL_openlibs(state);
+    CPPUNIT_ASSERT(run(state, "lib = { config = { samples = 4, layers = { 'a' } } }\n"
+                              "lib.self = lib\n"));
+    LuaStatePool::snapshotGlobals(state);
+
+    CPPUNIT_ASSERT(run(state, "lib.config.samples = 64\n"
+                              "lib.config.extra = { 1, 2, 3 }\n"
+                              "table.insert(lib.config.layers, 'b')\n"
+                              "lib.self.added = true\n"
+                              "package.loaded.string.answer = 42\n"));
+    pool.release(state);
+
+    // The next use sees none of the writes into the nested tables by the previous use.
+    state = pool.acquire();
+    CPPUNIT_ASSERT(state != nullptr);
+    CPPUNIT_ASSERT(run(state, "assert(lib.config.samples == 4)\n"
+                              "assert(lib.config.extra == nil)\n"
+                              "assert(#lib.config.layers == 1 and lib.config.layers[1] == 'a')\n"
+                              "assert(lib.self == lib and lib.added == nil)\n"
+                              "assert(string.answer == nil)\n"));
+    pool.release(state);
+}
+
+void
+TestLuaStatePool::testScriptFirstLineComment()
+{
+    const std::string filename = "TestLuaStatePool_script.lua";
+
+    // Same as luaL_loadfile(), the first line is skipped if it starts with '#'.
+    CPPUNIT_ASSERT_EQUAL(std::string(), runScript(filename, "#!/usr/bin/env lua\n"
+                                                            "x = 1\n"));
+
+    // Line numbers of the error messages don't change.
+    const std::string error = runScript(filename, "#!/usr/bin/env lua\n"
+                                                  "x = 1\n"
+                                                  "error('boom')\n");
+    CPPUNIT_ASSERT(error.find(filename + ":3:") != std::string::npos);
+    CPPUNIT_ASSERT(error.find("boom") != std::string::npos);
+
+    // Only the first line.
+    CPPUNIT_ASSERT(!runScript(filename, "x = 1\n"
+                                        "# not a comment\n").empty());
+}
+
+} // namespace util
+} // namespace scene_rdl2
+
+CPPUNIT_TEST_SUITE_REGISTRATION(scene_rdl2::util::TestLuaStatePool);
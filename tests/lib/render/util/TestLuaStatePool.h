@@ -0,0 +1,30 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace util {
+
+class TestLuaStatePool : public CppUnit::TestFixture
+{
+public:
+    CPPUNIT_TEST_SUITE(TestLuaStatePool);
+    CPPUNIT_TEST(testRestoreGlobals);
+    CPPUNIT_TEST(testRestoreLoadedModules);
+    CPPUNIT_TEST(testRestoreNestedTables);
+    CPPUNIT_TEST(testScriptFirstLineComment);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testRestoreGlobals();
+    void testRestoreLoadedModules();
+    void testRestoreNestedTables();
+    void testScriptFirstLineComment();
+};
+
+} // namespace util
+} // namespace scene_rdl2
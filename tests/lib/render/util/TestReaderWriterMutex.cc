@@ -0,0 +1,119 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "TestReaderWriterMutex.h"
+#include <scene_rdl2/render/util/DistributedReaderWriterMutex.h>
+#include <scene_rdl2/render/util/ReaderWriterMutex.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace util {
+
+namespace {
+
+// Writers keep two plain counters equal; readers must never see them differ,
+// and the final values must account for every write.
+template <typename Mutex, typename ReadLockType, typename WriteLockType>
+bool
+readersNeverSeeTornWrites()
+{
+    constexpr int numReaders = 8;
+    constexpr int numWriters = 2;
+    constexpr int numWrites = 2000;
+    constexpr int numReads = 20000;
+
+    Mutex mutex;
+    long a = 0;
+    long b = 0;
+    std::atomic<bool> torn(false);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numWriters; ++i) {
+        threads.emplace_back([&]() {
+            for (int w = 0; w < numWrites; ++w) {
+                WriteLockType lock(mutex);
+                ++a;
+                std::this_thread::yield();
+                ++b;
+            }
+        });
+    }
+    for (int i = 0; i < numReaders; ++i) {
+        threads.emplace_back([&]() {
+            // A fixed number of reads rather than "until the writers are
+            // done", a reader preferring mutex could otherwise starve them.
+            for (int r = 0; r < numReads; ++r) {
+                {
+                    ReadLockType lock(mutex);
+                    if (a != b) {
+                        torn = true;
+                    }
+                }
+                if ((r & 63) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    return !torn && a == numWriters * numWrites && b == a;
+}
+
+} // anonymous namespace
+
+void
+TestReaderWriterMutex::testSharedMutex()
+{
+    CPPUNIT_ASSERT((readersNeverSeeTornWrites<ReaderWriterMutex, ReadLock, WriteLock>()));
+}
+
+void
+TestReaderWriterMutex::testDistributedMutex()
+{
+    CPPUNIT_ASSERT((readersNeverSeeTornWrites<DistributedReaderWriterMutex,
+                                              DistributedReaderWriterMutex::ReadLock,
+                                              DistributedReaderWriterMutex::WriteLock>()));
+}
+
+void
+TestReaderWriterMutex::testDistributedTryLock()
+{
+    DistributedReaderWriterMutex mutex;
+
+    {
+        DistributedReaderWriterMutex::ReadLock readLock(mutex);
+        // Recursive read locks are fine, writers have to wait.
+        CPPUNIT_ASSERT(mutex.try_lock_shared());
+        mutex.unlock_shared();
+
+        // A reader on another thread holds the lock, so no writer may get in.
+        bool gotWriteLock = true;
+        std::thread([&]() { gotWriteLock = mutex.try_lock(); }).join();
+        CPPUNIT_ASSERT(!gotWriteLock);
+    }
+
+    {
+        DistributedReaderWriterMutex::WriteLock writeLock(mutex);
+        bool gotReadLock = true;
+        std::thread([&]() { gotReadLock = mutex.try_lock_shared(); }).join();
+        CPPUNIT_ASSERT(!gotReadLock);
+        CPPUNIT_ASSERT(!mutex.try_lock());
+    }
+
+    CPPUNIT_ASSERT(mutex.try_lock());
+    mutex.unlock();
+}
+
+} // namespace util
+} // namespace scene_rdl2
+
+CPPUNIT_TEST_SUITE_REGISTRATION(scene_rdl2::util::TestReaderWriterMutex);
+
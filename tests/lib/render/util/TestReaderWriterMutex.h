@@ -0,0 +1,29 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace util {
+
+class TestReaderWriterMutex : public CppUnit::TestFixture
+{
+public:
+    CPPUNIT_TEST_SUITE(TestReaderWriterMutex);
+    CPPUNIT_TEST(testSharedMutex);
+    CPPUNIT_TEST(testDistributedMutex);
+    CPPUNIT_TEST(testDistributedTryLock);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testSharedMutex();
+    void testDistributedMutex();
+    void testDistributedTryLock();
+};
+
+} // namespace util
+} // namespace scene_rdl2
+
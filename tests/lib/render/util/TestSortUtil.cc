@@ -0,0 +1,115 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#include "TestSortUtil.h"
+#include <scene_rdl2/render/util/SortUtil.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace util {
+
+namespace {
+
+// The sort key lives at offset 4 to exercise SORT_KEY_OFFSET.
+struct Entry
+{
+    uint32_t mIndex;
+    uint32_t mKey;
+};
+
+const unsigned KEY_OFFSET = 4;
+
+std::vector<Entry>
+makeEntries(unsigned count, uint32_t keyMask)
+{
+    // Plenty of duplicate keys so that stability is actually tested.
+    std::mt19937 rng(count);
+    std::vector<Entry> entries(count);
+    for (unsigned i = 0; i < count; ++i) {
+        entries[i].mIndex = i;
+        entries[i].mKey = (rng() % (count / 4 + 1)) * 2654435761u & keyMask;
+    }
+    return entries;
+}
+
+// Radix sorts are stable, so the result must match std::stable_sort exactly.
+bool
+matchesStableSort(const std::vector<Entry> &input, const Entry *sorted)
+{
+    std::vector<Entry> expected(input);
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const Entry &a, const Entry &b) { return a.mKey < b.mKey; });
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (expected[i].mIndex != sorted[i].mIndex || expected[i].mKey != sorted[i].mKey) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+void
+TestSortUtil::testSerialRadixSort()
+{
+    Ref<alloc::ArenaBlockPool> pool = alignedMallocCtorArgs<alloc::ArenaBlockPool>(CACHE_LINE_SIZE);
+    alloc::Arena arena;
+    arena.init(pool.get());
+
+    for (unsigned count : { 0u, 1u, 150u, 5000u, 100000u }) {
+        const std::vector<Entry> input = makeEntries(count, 0xffffffff);
+
+        std::vector<Entry> elems(input);
+        inPlaceRadixSort32<Entry, KEY_OFFSET>(count, elems.data(), &arena);
+        CPPUNIT_ASSERT(matchesStableSort(input, elems.data()));
+
+        const std::vector<Entry> input22 = makeEntries(count, 0x3fffff);
+        elems = input22;
+        inPlaceRadixSort22<Entry, KEY_OFFSET>(count, elems.data(), &arena);
+        CPPUNIT_ASSERT(matchesStableSort(input22, elems.data()));
+    }
+}
+
+void
+TestSortUtil::testParallelRadixSort()
+{
+    Ref<alloc::ArenaBlockPool> pool = alignedMallocCtorArgs<alloc::ArenaBlockPool>(CACHE_LINE_SIZE);
+    alloc::Arena arena;
+    arena.init(pool.get());
+
+    // Large enough counts to get split into several chunks.
+    for (unsigned count : { 0u, 1u, 150u, 5000u, 100000u, 300001u }) {
+        const std::vector<Entry> input = makeEntries(count, 0xffffffff);
+
+        std::vector<Entry> elems(input);
+        parallelInPlaceRadixSort32<Entry, KEY_OFFSET>(count, elems.data(), &arena);
+        CPPUNIT_ASSERT(matchesStableSort(input, elems.data()));
+
+        elems = input;
+        parallelInPlaceRadixSortMSB32<Entry, KEY_OFFSET>(count, elems.data(), &arena);
+        CPPUNIT_ASSERT(matchesStableSort(input, elems.data()));
+
+        elems = input;
+        inPlaceParallelSort32<Entry, KEY_OFFSET>(count, elems.data(), &arena);
+        CPPUNIT_ASSERT((isSorted32<Entry, KEY_OFFSET>(count, elems.data())));
+
+        const std::vector<Entry> input22 = makeEntries(count, 0x3fffff);
+        elems = input22;
+        parallelInPlaceRadixSort22<Entry, KEY_OFFSET>(count, elems.data(), &arena);
+        CPPUNIT_ASSERT(matchesStableSort(input22, elems.data()));
+    }
+
+    // All scratch memory should have been released back to the marker.
+    CPPUNIT_ASSERT(arena.getMarker().mNumBlocks == 1);
+}
+
+} // namespace util
+} // namespace scene_rdl2
+
+CPPUNIT_TEST_SUITE_REGISTRATION(scene_rdl2::util::TestSortUtil);
+
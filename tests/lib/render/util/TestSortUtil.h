@@ -0,0 +1,27 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+//
+//
+#pragma once
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+namespace scene_rdl2 {
+namespace util {
+
+class TestSortUtil : public CppUnit::TestFixture
+{
+public:
+    CPPUNIT_TEST_SUITE(TestSortUtil);
+    CPPUNIT_TEST(testSerialRadixSort);
+    CPPUNIT_TEST(testParallelRadixSort);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testSerialRadixSort();
+    void testParallelRadixSort();
+};
+
+} // namespace util
+} // namespace scene_rdl2
+
@@ -275,6 +275,72 @@ void TestCommonUtil::testArenaAllocator()
     CPPUNIT_ASSERT(vs1.at(5) == "Po");
 }
 
+void TestCommonUtil::testArenaMarker()
+{
+    using namespace scene_rdl2::alloc;
+
+    // Small blocks so that the allocations below cross block boundaries.
+    constexpr unsigned blockSize = 4096;
+    scene_rdl2::util::Ref<ArenaBlockPool> arenaBlockPool =
+        scene_rdl2::util::alignedMallocCtorArgs<ArenaBlockPool>(CACHE_LINE_SIZE, blockSize);
+
+    Arena arena;
+    arena.init(arenaBlockPool.get());
+    arena.alloc(100);
+
+    const ArenaMarker outer = arena.getMarker();
+    uint8_t * const outerPtr = arena.getPtr();
+    {
+        SCOPED_ARENA_MARKER(&arena);
+        for (int i = 0; i < 10; ++i) {
+            CPPUNIT_ASSERT(arena.alloc(blockSize / 2) != nullptr);
+        }
+        CPPUNIT_ASSERT(arenaBlockPool->getMemoryUsage() > blockSize);
+
+        uint8_t * const innerPtr = arena.getPtr();
+        {
+            SCOPED_ARENA_MARKER(&arena);
+            for (int i = 0; i < 10; ++i) {
+                CPPUNIT_ASSERT(arena.alloc(blockSize / 2) != nullptr);
+            }
+        }
+        CPPUNIT_ASSERT(arena.getPtr() == innerPtr);
+    }
+    CPPUNIT_ASSERT(arena.getPtr() == outerPtr);
+    CPPUNIT_ASSERT(arena.getMarker().mNumBlocks == outer.mNumBlocks);
+
+    // All blocks acquired within the scopes are back in the pool and get reused.
+    const size_t usage = arenaBlockPool->getMemoryUsage();
+    {
+        SCOPED_ARENA_MARKER(&arena);
+        for (int i = 0; i < 10; ++i) {
+            arena.alloc(blockSize / 2);
+        }
+    }
+    CPPUNIT_ASSERT(arenaBlockPool->getMemoryUsage() == usage);
+
+    // Huge page pools must always hand out usable memory, whether or not the
+    // system actually provides huge pages.
+    scene_rdl2::util::Ref<ArenaBlockPool> hugePool =
+        scene_rdl2::util::alignedMallocCtorArgs<ArenaBlockPool>(CACHE_LINE_SIZE,
+                                                                ARENA_HUGE_PAGE_SIZE * 2, true);
+    CPPUNIT_ASSERT(hugePool->getUseHugePages());
+
+    Arena hugeArena;
+    hugeArena.init(hugePool.get());
+    {
+        SCOPED_ARENA_MARKER(&hugeArena);
+        uint8_t *mem = hugeArena.alloc(ARENA_HUGE_PAGE_SIZE * 3 / 2);
+        CPPUNIT_ASSERT(mem != nullptr);
+        memset(mem, 0xff, ARENA_HUGE_PAGE_SIZE * 3 / 2);
+        mem = hugeArena.alloc(ARENA_HUGE_PAGE_SIZE);
+        CPPUNIT_ASSERT(mem != nullptr);
+        memset(mem, 0xff, ARENA_HUGE_PAGE_SIZE);
+    }
+    CPPUNIT_ASSERT(hugeArena.getMarker().mNumBlocks == 1);
+    hugeArena.cleanUp();
+}
+
 
 namespace {
 template <size_t A>
@@ -690,6 +756,56 @@ void IndexableArrayExtremeErase()
     }
 }
 
+template<template<class> class Hash>
+void IndexableArrayBulkBuild()
+{
+    typedef scene_rdl2::IndexableArray<unsigned, Hash<unsigned>> ArrayType;
+
+    // Enough elements to force several rehashes of the index, with duplicates.
+    std::vector<unsigned> values;
+    for (unsigned i = 0; i < 2000; ++i) {
+        values.push_back(i % 700);
+    }
+
+    ArrayType a0;
+    a0.reserve(values.size());
+    CPPUNIT_ASSERT(a0.capacity() >= values.size());
+    for (unsigned v : values) {
+        a0.push_back(v);
+    }
+
+    ArrayType a1;
+    a1.assign(values.begin(), values.end());
+    CPPUNIT_ASSERT(a0 == a1);
+
+    ArrayType a2(values.begin(), values.end());
+    CPPUNIT_ASSERT(a0 == a2);
+
+    for (unsigned v = 0; v < 700; v += 7) {
+        const auto p = a1.equal_range(v);
+        const std::multiset<int> expected { int(v), int(v + 700), int(v + 1400) };
+        CPPUNIT_ASSERT((v + 1400 < 2000 ? expected : std::multiset<int>{ int(v), int(v + 700) }) ==
+                       std::multiset<int>(p.first, p.second));
+    }
+
+    // Erasing from the front shifts all of the stored indices.
+    a1.erase(a1.begin());
+    {
+        const auto p = a1.equal_range(1);
+        CPPUNIT_ASSERT(std::multiset<int>({0, 700, 1400}) == std::multiset<int>(p.first, p.second));
+    }
+
+    a1.update_value(0, 5000);
+    {
+        const auto p = a1.equal_range(5000);
+        CPPUNIT_ASSERT(std::multiset<int>({0}) == std::multiset<int>(p.first, p.second));
+    }
+    {
+        const auto p = a1.equal_range(1);
+        CPPUNIT_ASSERT(std::multiset<int>({700, 1400}) == std::multiset<int>(p.first, p.second));
+    }
+}
+
 } // anonymous namespace
 
 void TestCommonUtil::testIndexableArray()
@@ -712,6 +828,8 @@ void TestCommonUtil::testIndexableArray()
     IndexableArrayExtremeErase<std::hash>();
     IndexableArrayExtremeErase<PoorHash>();
     IndexableArrayExtremeErase<ConstantHash>();
+    IndexableArrayBulkBuild<std::hash>();
+    IndexableArrayBulkBuild<PoorHash>();
 }
 
 namespace {
@@ -15,6 +15,7 @@ public:
     CPPUNIT_TEST(testCtorAlloc);
     CPPUNIT_TEST(testAlloc);
     CPPUNIT_TEST(testArenaAllocator);
+    CPPUNIT_TEST(testArenaMarker);
     CPPUNIT_TEST(testAlignedAllocator);
     CPPUNIT_TEST(testRoundDownToPowerOfTwo);
     CPPUNIT_TEST(testIndexableArray);
@@ -27,6 +28,7 @@ public:
     void testCtorAlloc();
     void testAlloc();
     void testArenaAllocator();
+    void testArenaMarker();
     void testAlignedAllocator();
     void testRoundDownToPowerOfTwo();
     void testIndexableArray();
@@ -572,6 +572,44 @@ void TestAscii::testAttributeAlias()
     CPPUNIT_ASSERT(iv[2] == 3);
 }
 
+void
+TestAscii::testReaderStateReuse()
+{
+    static const char *rdlaCode =
+        "answer = 42\n"
+        "string.answer = 42\n"
+        "ExtensiveObject(\"/seq/shot/pizza\")\n";
+
+    SceneContext context1;
+    {
+        AsciiReader reader(context1);
+        reader.fromString(rdlaCode);
+    }
+    CPPUNIT_ASSERT(context1.getSceneObject("/seq/shot/pizza"));
+
+    // The next reader takes over the Lua state of the previous reader from
+    // the pool. Constructor closures which are cached as globals must not
+    // point to the SceneClass of the previous context.
+    SceneContext context2;
+    {
+        AsciiReader reader(context2);
+        reader.fromString("ExtensiveObject(\"/seq/shot/cookie\")\n");
+        CPPUNIT_ASSERT_THROW(reader.fromString("x = answer\n"), except::RuntimeError);
+        CPPUNIT_ASSERT_THROW(reader.fromString("x = string.answer + 1\n"), except::RuntimeError);
+    }
+    CPPUNIT_ASSERT(context2.getSceneObject("/seq/shot/cookie"));
+    CPPUNIT_ASSERT_THROW(context2.getSceneObject("/seq/shot/pizza"), except::KeyError);
+    CPPUNIT_ASSERT_THROW(context1.getSceneObject("/seq/shot/cookie"), except::KeyError);
+
+    // Same chunk again is loaded from the compiled chunk cache.
+    SceneContext context3;
+    {
+        AsciiReader reader(context3);
+        reader.fromString(rdlaCode);
+    }
+    CPPUNIT_ASSERT(context3.getSceneObject("/seq/shot/pizza"));
+}
+
 void
 TestAscii::testDenormals()
 {
@@ -36,6 +36,10 @@ public:
     /// Test that attribute aliases work
     void testAttributeAlias();
 
+    /// Test that a reused (pooled) Lua state doesn't leak globals or
+    /// constructors of the previous reader.
+    void testReaderStateReuse();
+
 #ifdef _TEST_ASCII_DO_TEST_MEMORY
     /// Test to ensure that no memory leaks for the AsciiReader/Writer
     void testMemory();
@@ -49,6 +53,7 @@ public:
     CPPUNIT_TEST(testDeltaEncoding);
     CPPUNIT_TEST(testNullReferences);
     CPPUNIT_TEST(testAttributeAlias);
+    CPPUNIT_TEST(testReaderStateReuse);
 #ifdef _TEST_ASCII_DO_TEST_MEMORY
     CPPUNIT_TEST(testMemory);
 #endif
@@ -10,12 +10,21 @@
 #include <scene_rdl2/scene/rdl2/SceneClass.h>
 #include <scene_rdl2/scene/rdl2/SceneContext.h>
 #include <scene_rdl2/scene/rdl2/SceneObject.h>
+#include <scene_rdl2/scene/rdl2/SharedSceneSnapshot.h>
+#include <scene_rdl2/scene/rdl2/UpdateCoalescer.h>
 
 #include <scene_rdl2/common/except/exceptions.h>
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <numeric>
 #include <string>
+#include <thread>
+#include <utility>
 
 namespace scene_rdl2 {
 namespace rdl2 {
@@ -571,6 +580,171 @@ TestBinary::testDeltaEncoding()
     );
 }
 
+void
+TestBinary::testDeltaRanges()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<FloatVector> floatVecKey = sceneClass->getAttributeKey<FloatVector>("float_vector");
+    AttributeKey<DoubleVector> doubleVecKey = sceneClass->getAttributeKey<DoubleVector>("double_vector");
+    SceneObject* pizza = context.createSceneObject("ExtensiveObject", "/seq/shot/pizza");
+
+    FloatVector floats(10000);
+    std::iota(floats.begin(), floats.end(), 0.0f);
+    pizza->beginUpdate();
+    pizza->set(floatVecKey, floats);
+    pizza->endUpdate();
+
+    // Set as a whole, the vector isn't tracked by ranges.
+    const Attribute* attr = sceneClass->getAttribute(floatVecKey);
+    CPPUNIT_ASSERT(pizza->getChangedRanges(*attr, TIMESTEP_BEGIN) == nullptr);
+
+    // Bring a second context up to date with a full encoding.
+    std::string manifest;
+    std::string payload;
+    BinaryWriter fullWriter(context);
+    fullWriter.toBytes(manifest, payload);
+    SceneContext readContext;
+    BinaryReader reader(readContext);
+    reader.fromBytes(manifest, payload);
+    context.commitAllChanges();
+
+    // Change two disjoint ranges, and an overlapping one which merges into
+    // the first.
+    pizza->beginUpdate();
+    pizza->setRange(floatVecKey, 100, FloatVector(10, -1.0f));
+    pizza->setRange(floatVecKey, 5000, FloatVector(3, -2.0f));
+    pizza->setRange(floatVecKey, 105, FloatVector(10, -3.0f));
+    pizza->endUpdate();
+    CPPUNIT_ASSERT_THROW(pizza->setRange(floatVecKey, 0, FloatVector(1)), except::RuntimeError);
+    pizza->beginUpdate();
+    CPPUNIT_ASSERT_THROW(pizza->setRange(floatVecKey, 9999, FloatVector(2)), except::IndexError);
+    pizza->endUpdate();
+
+    const SceneObject::ElementRanges* ranges = pizza->getChangedRanges(*attr, TIMESTEP_BEGIN);
+    CPPUNIT_ASSERT(ranges);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), ranges->size());
+    CPPUNIT_ASSERT((*ranges)[0] == std::make_pair(size_t(100), size_t(115)));
+    CPPUNIT_ASSERT((*ranges)[1] == std::make_pair(size_t(5000), size_t(5003)));
+
+    // Only the changed elements are sent, not the whole vector.
+    BinaryWriter deltaWriter(context);
+    deltaWriter.setDeltaEncoding(true);
+    deltaWriter.toBytes(manifest, payload);
+    CPPUNIT_ASSERT(payload.size() < 1000);
+
+    reader.fromBytes(manifest, payload);
+    const FloatVector& patched = readContext.getSceneObject("/seq/shot/pizza")->get(floatVecKey);
+    CPPUNIT_ASSERT(patched == pizza->get(floatVecKey));
+
+    // Setting the vector as a whole again sends all of it.
+    context.commitAllChanges();
+    CPPUNIT_ASSERT(pizza->getChangedRanges(*attr, TIMESTEP_BEGIN) == nullptr);
+    pizza->beginUpdate();
+    pizza->setRange(floatVecKey, 0, FloatVector(1, -4.0f));
+    pizza->set(floatVecKey, floats);
+    pizza->endUpdate();
+    CPPUNIT_ASSERT(pizza->getChangedRanges(*attr, TIMESTEP_BEGIN) == nullptr);
+    deltaWriter.toBytes(manifest, payload);
+    CPPUNIT_ASSERT(payload.size() > floats.size() * sizeof(Float));
+    reader.fromBytes(manifest, payload);
+    CPPUNIT_ASSERT(readContext.getSceneObject("/seq/shot/pizza")->get(floatVecKey) == floats);
+
+    // Ranges for a vector of another size are skipped with a warning, the
+    // attributes after them are still read.
+    context.commitAllChanges();
+    SceneObject* readPizza = readContext.getSceneObject("/seq/shot/pizza");
+    readPizza->beginUpdate();
+    readPizza->set(floatVecKey, FloatVector(3, 0.0f));
+    readPizza->endUpdate();
+    pizza->beginUpdate();
+    pizza->setRange(floatVecKey, 10, FloatVector(1, -5.0f));
+    pizza->set(doubleVecKey, DoubleVector(2, 7.0));
+    pizza->endUpdate();
+    deltaWriter.toBytes(manifest, payload);
+    CPPUNIT_ASSERT_NO_THROW(reader.fromBytes(manifest, payload));
+    CPPUNIT_ASSERT(readPizza->get(floatVecKey) == FloatVector(3, 0.0f));
+    CPPUNIT_ASSERT(readPizza->get(doubleVecKey) == DoubleVector(2, 7.0));
+
+    reader.setWarningsAsErrors(true);
+    CPPUNIT_ASSERT_THROW(reader.fromBytes(manifest, payload), except::TypeError);
+}
+
+void
+TestBinary::testUpdateCoalescer()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<Float> floatKey = sceneClass->getAttributeKey<Float>("float");
+    AttributeKey<String> stringKey = sceneClass->getAttributeKey<String>("string");
+    AttributeKey<FloatVector> floatVecKey = sceneClass->getAttributeKey<FloatVector>("float_vector");
+    SceneObject* pizza = context.createSceneObject("ExtensiveObject", "/seq/shot/pizza");
+    SceneObject* cookie = context.createSceneObject("ExtensiveObject", "/seq/shot/cookie");
+    SceneObject* mango = context.createSceneObject("ExtensiveObject", "/seq/shot/mango");
+
+    pizza->beginUpdate();
+    pizza->set(floatVecKey, FloatVector(100, 0.0f));
+    pizza->endUpdate();
+
+    // Bring both contexts up to date with a full encoding.
+    std::string manifest;
+    std::string payload;
+    BinaryWriter fullWriter(context);
+    fullWriter.toBytes(manifest, payload);
+    SceneContext sequentialContext;
+    BinaryReader sequentialReader(sequentialContext);
+    sequentialReader.fromBytes(manifest, payload);
+    SceneContext coalescedContext;
+    BinaryReader coalescedReader(coalescedContext);
+    coalescedReader.fromBytes(manifest, payload);
+    context.commitAllChanges();
+
+    // Decode a burst of deltas one by one into the first context, and queue
+    // them for the second one.
+    UpdateCoalescer coalescer;
+    BinaryWriter deltaWriter(context);
+    deltaWriter.setDeltaEncoding(true);
+    auto sendDelta = [&]() {
+        deltaWriter.toBytes(manifest, payload);
+        sequentialReader.fromBytes(manifest, payload);
+        coalescer.push(manifest, payload);
+        context.commitAllChanges();
+    };
+    for (int i = 1; i <= 10; ++i) {
+        pizza->beginUpdate();
+        pizza->set(floatKey, static_cast<Float>(i));
+        pizza->setBinding(stringKey, (i % 2) ? cookie : mango);
+        pizza->setRange(floatVecKey, i, FloatVector(1, static_cast<Float>(i)));
+        pizza->endUpdate();
+        sendDelta();
+    }
+    pizza->beginUpdate();
+    pizza->setBinding(stringKey, nullptr);
+    pizza->endUpdate();
+    sendDelta();
+    cookie->beginUpdate();
+    cookie->set(floatKey, 42.0f);
+    cookie->endUpdate();
+    sendDelta();
+
+    // 9 of the 10 pizza floats and 10 of the 11 bindings are elided, all the
+    // changed element ranges are kept.
+    CPPUNIT_ASSERT_EQUAL(size_t(12), coalescer.getQueuedCount());
+    CPPUNIT_ASSERT_EQUAL(size_t(19), coalescer.apply(coalescedReader));
+    CPPUNIT_ASSERT(coalescer.empty());
+    CPPUNIT_ASSERT_EQUAL(size_t(19), coalescer.getTotalElidedCount());
+
+    for (const char* name : {"/seq/shot/pizza", "/seq/shot/cookie"}) {
+        const SceneObject* sequential = sequentialContext.getSceneObject(name);
+        const SceneObject* coalesced = coalescedContext.getSceneObject(name);
+        CPPUNIT_ASSERT_EQUAL(sequential->get(floatKey), coalesced->get(floatKey));
+        CPPUNIT_ASSERT(sequential->get(floatVecKey) == coalesced->get(floatVecKey));
+        CPPUNIT_ASSERT(coalesced->getBinding(stringKey) == nullptr);
+    }
+    CPPUNIT_ASSERT_EQUAL(Float(10), coalescedContext.getSceneObject("/seq/shot/pizza")->get(floatKey));
+    CPPUNIT_ASSERT_EQUAL(Float(10), coalescedContext.getSceneObject("/seq/shot/pizza")->get(floatVecKey)[10]);
+}
+
 void
 TestBinary::testNullReferences()
 {
@@ -624,6 +798,132 @@ TestBinary::testNullReferences()
     CPPUNIT_ASSERT(pizza->getBinding(stringKey) == nullptr);
 }
 
+void
+TestBinary::testStreamRecords()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<String> stringKey = sceneClass->getAttributeKey<String>("string");
+    AttributeKey<FloatVector> floatVecKey = sceneClass->getAttributeKey<FloatVector>("float_vector");
+
+    for (const char* name : {"/seq/shot/pizza", "/seq/shot/cookie", "/seq/shot/mango"}) {
+        SceneObject* obj = context.createSceneObject("ExtensiveObject", name);
+        obj->beginUpdate();
+        obj->set(stringKey, std::string(name));
+        obj->set(floatVecKey, mFloatVec2);
+        obj->endUpdate();
+    }
+
+    BinaryWriter writer(context);
+    writer.toFile("stream.rdlb");
+
+    // Skip the cookie (and the SceneVariables) by the record header.
+    std::vector<std::string> names;
+    auto filter = [&](const std::string& className, const std::string& objName) {
+        names.push_back(objName);
+        return className == "ExtensiveObject" && objName != "/seq/shot/cookie";
+    };
+
+    // Each record is decoded into a SceneContext of its own.
+    std::vector<std::string> decoded;
+    std::ifstream in("stream.rdlb", std::ios::binary);
+    BinaryReader::streamRecords(in, filter, [&](std::string&& record) {
+        SceneContext recordContext;
+        BinaryReader reader(recordContext);
+        const SceneObject* obj = reader.fromRecord(record);
+        CPPUNIT_ASSERT(obj);
+        CPPUNIT_ASSERT(obj->get(stringKey) == obj->getName());
+        CPPUNIT_ASSERT(obj->get(floatVecKey) == mFloatVec2);
+        decoded.push_back(obj->getName());
+    });
+
+    CPPUNIT_ASSERT(std::find(names.begin(), names.end(), "/seq/shot/cookie") != names.end());
+    CPPUNIT_ASSERT(decoded.size() == 2);
+    CPPUNIT_ASSERT(std::find(decoded.begin(), decoded.end(), "/seq/shot/pizza") != decoded.end());
+    CPPUNIT_ASSERT(std::find(decoded.begin(), decoded.end(), "/seq/shot/mango") != decoded.end());
+}
+
+void
+TestBinary::testSharedSnapshot()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<String> stringKey = sceneClass->getAttributeKey<String>("string");
+    AttributeKey<FloatVector> floatVecKey = sceneClass->getAttributeKey<FloatVector>("float_vector");
+
+    for (const char* name : {"/seq/shot/pizza", "/seq/shot/cookie", "/seq/shot/mango"}) {
+        SceneObject* obj = context.createSceneObject("ExtensiveObject", name);
+        obj->beginUpdate();
+        obj->set(stringKey, std::string(name));
+        obj->set(floatVecKey, mFloatVec2);
+        obj->endUpdate();
+    }
+
+    const size_t objectCount = std::distance(context.beginSceneObject(), context.endSceneObject());
+
+    const std::string name = "TestBinary_testSharedSnapshot";
+    const size_t segmentSize = SharedSceneSnapshot::publish(context, name);
+
+    {
+        SharedSceneSnapshot snapshot(name);
+        CPPUNIT_ASSERT(snapshot.getSegmentSize() == segmentSize);
+        CPPUNIT_ASSERT(snapshot.getObjectCount() == objectCount);
+
+        SharedSceneSnapshot::ObjectRecord object;
+        CPPUNIT_ASSERT(snapshot.findObject("/seq/shot/cookie", object));
+        CPPUNIT_ASSERT(object.mClassName == "ExtensiveObject");
+        CPPUNIT_ASSERT(object.mObjectName == "/seq/shot/cookie");
+        CPPUNIT_ASSERT(!snapshot.findObject("/seq/shot/cake", object));
+
+        // Skip the cookie.
+        SceneContext populated;
+        const size_t decoded = snapshot.populate(populated,
+            [](const std::string&, const std::string& objName) {
+                return objName != "/seq/shot/cookie";
+            });
+        CPPUNIT_ASSERT(decoded == objectCount - 1);
+        CPPUNIT_ASSERT(!populated.sceneObjectExists("/seq/shot/cookie"));
+        for (const char* objName : {"/seq/shot/pizza", "/seq/shot/mango"}) {
+            const SceneObject* obj = populated.getSceneObject(objName);
+            CPPUNIT_ASSERT(obj->get(stringKey) == objName);
+            CPPUNIT_ASSERT(obj->get(floatVecKey) == mFloatVec2);
+        }
+
+        // Processes opening the snapshot while it is republished get either
+        // the previous or the new one.
+        std::atomic<bool> republishing(true);
+        std::atomic<int> failures(0);
+        std::thread reader([&]() {
+            while (republishing) {
+                try {
+                    SharedSceneSnapshot current(name);
+                    const size_t count = current.getObjectCount();
+                    if (count != objectCount && count != objectCount - 1) {
+                        ++failures;
+                    }
+                } catch (const std::exception&) {
+                    ++failures;
+                }
+            }
+        });
+        for (int i = 0; i < 100; ++i) {
+            SharedSceneSnapshot::publish((i % 2) ? context : populated, name);
+        }
+        republishing = false;
+        reader.join();
+        CPPUNIT_ASSERT(failures == 0);
+        CPPUNIT_ASSERT(SharedSceneSnapshot(name).getObjectCount() == objectCount);
+
+        // Existing views survive republishing and unpublishing.
+        SharedSceneSnapshot::publish(populated, name);
+        CPPUNIT_ASSERT(SharedSceneSnapshot::unpublish(name));
+        CPPUNIT_ASSERT(snapshot.findObject("/seq/shot/cookie", object));
+    }
+
+    CPPUNIT_ASSERT(!SharedSceneSnapshot::unpublish(name));
+    CPPUNIT_ASSERT_THROW(SharedSceneSnapshot snapshot(name), except::IoError);
+}
+
 } // namespace unittest
 } // namespace rdl2
 } // namespace scene_rdl2
@@ -28,15 +28,33 @@ public:
     /// Test delta encoding for major data compression.
     void testDeltaEncoding();
 
+    /// Test delta encoding of the element ranges changed by setRange().
+    void testDeltaRanges();
+
+    /// Test that coalescing a burst of deltas gives the same result as
+    /// decoding them one by one.
+    void testUpdateCoalescer();
+
     /// Test that we can serialize and deserialize null SceneObject references
     /// and bindings.
     void testNullReferences();
 
+    /// Test reading records one at a time with a name filter.
+    void testStreamRecords();
+
+    /// Test publishing a SceneContext as a shared snapshot and populating
+    /// another one from it.
+    void testSharedSnapshot();
+
     CPPUNIT_TEST_SUITE(TestBinary);
     CPPUNIT_TEST(testRoundtrip);
     CPPUNIT_TEST(testTransientEncoding);
     CPPUNIT_TEST(testDeltaEncoding);
+    CPPUNIT_TEST(testDeltaRanges);
+    CPPUNIT_TEST(testUpdateCoalescer);
     CPPUNIT_TEST(testNullReferences);
+    CPPUNIT_TEST(testStreamRecords);
+    CPPUNIT_TEST(testSharedSnapshot);
     CPPUNIT_TEST_SUITE_END();
 
 private:
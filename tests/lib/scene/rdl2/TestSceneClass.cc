@@ -6,7 +6,9 @@
 
 #include <scene_rdl2/scene/rdl2/Attribute.h>
 #include <scene_rdl2/scene/rdl2/AttributeKey.h>
+#include <scene_rdl2/scene/rdl2/AttributeLayout.h>
 #include <scene_rdl2/scene/rdl2/SceneClass.h>
+#include <scene_rdl2/scene/rdl2/SceneVariables.h>
 #include <scene_rdl2/scene/rdl2/Types.h>
 
 #include <scene_rdl2/common/except/exceptions.h>
@@ -15,6 +17,7 @@
 
 #include <cstddef>
 #include <cstdlib>
+#include <iterator>
 #include <string>
 #include <stdint.h>
 
@@ -2052,6 +2055,89 @@ TestSceneClass::testMemoryLayout()
     }
 }
 
+void
+TestSceneClass::testAttributeLayout()
+{
+    // Same attributes as the mixed case of testMemoryLayout().
+    static constexpr AttributeLayoutEntry layout[] = {
+        layoutEntry<Bool>("bool"),
+        layoutEntry<Vec3f>("vec3f"),
+        layoutEntry<Double>("double", FLAGS_BLURRABLE),
+        layoutEntry<Float>("float", FLAGS_BLURRABLE),
+        layoutEntry<Double>("double_2", FLAGS_BLURRABLE),
+        layoutEntry<Float>("float_2", FLAGS_BLURRABLE),
+        layoutEntry<SceneObject*>("scene_object"),
+        layoutEntry<Vec3d>("vec3d", FLAGS_BLURRABLE)
+    };
+
+    // Computed at compile time.
+    static constexpr FixedAttributeKey<Float> floatKey = fixedAttributeKey<Float>(layout, "float");
+    static_assert(floatKey.getIndex() == 3, "unexpected attribute index");
+    static_assert(floatKey.getOffset() == 32, "unexpected attribute offset");
+    static_assert(floatKey.isBlurrable(), "unexpected attribute flags");
+
+    CPPUNIT_ASSERT_EQUAL(uint32_t(0), fixedAttributeKey<Bool>(layout, "bool").getOffset());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(4), fixedAttributeKey<Vec3f>(layout, "vec3f").getOffset());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(16), fixedAttributeKey<Double>(layout, "double").getOffset());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(40), fixedAttributeKey<Double>(layout, "double_2").getOffset());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(56), fixedAttributeKey<Float>(layout, "float_2").getOffset());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(64), fixedAttributeKey<SceneObject*>(layout, "scene_object").getOffset());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(128), fixedAttributeKey<Vec3d>(layout, "vec3d").getOffset());
+    CPPUNIT_ASSERT_THROW(fixedAttributeKey<Float>(layout, "bogus"), except::KeyError);
+    CPPUNIT_ASSERT_THROW(fixedAttributeKey<Int>(layout, "float"), except::TypeError);
+
+    {
+        SceneClass sc(&mContext, "ExampleObject", ObjectFactory::createDsoFactory("ExampleObject", "."));
+        sc.declareAttribute<Bool>("bool");
+        sc.declareAttribute<Vec3f>("vec3f");
+        sc.declareAttribute<Double>("double", FLAGS_BLURRABLE);
+        AttributeKey<Float> key = sc.declareAttribute<Float>("float", FLAGS_BLURRABLE);
+        sc.declareAttribute<Double>("double_2", FLAGS_BLURRABLE);
+        sc.declareAttribute<Float>("float_2", FLAGS_BLURRABLE);
+        sc.declareAttribute<SceneObject*>("scene_object");
+
+        // Missing attribute.
+        CPPUNIT_ASSERT_THROW(sc.checkAttributeLayout(layout, std::size(layout)), except::RuntimeError);
+
+        sc.declareAttribute<Vec3d>("vec3d", FLAGS_BLURRABLE);
+        sc.checkAttributeLayout(layout, std::size(layout));
+        CPPUNIT_ASSERT_EQUAL(key.mIndex, floatKey.getIndex());
+        CPPUNIT_ASSERT_EQUAL(key.mOffset, floatKey.getOffset());
+    }
+    {
+        // Flags don't match.
+        SceneClass sc(&mContext, "ExampleObject", ObjectFactory::createDsoFactory("ExampleObject", "."));
+        sc.declareAttribute<Bool>("bool");
+        sc.declareAttribute<Vec3f>("vec3f");
+        sc.declareAttribute<Double>("double");
+        sc.declareAttribute<Float>("float", FLAGS_BLURRABLE);
+        sc.declareAttribute<Double>("double_2", FLAGS_BLURRABLE);
+        sc.declareAttribute<Float>("float_2", FLAGS_BLURRABLE);
+        sc.declareAttribute<SceneObject*>("scene_object");
+        sc.declareAttribute<Vec3d>("vec3d", FLAGS_BLURRABLE);
+        CPPUNIT_ASSERT_THROW(sc.checkAttributeLayout(layout, std::size(layout)), except::RuntimeError);
+    }
+
+    // The SceneVariables check their layout when they are declared, so the
+    // fixed keys read the same values as the regular ones.
+    SceneVariables& sceneVars = mContext.getSceneVariables();
+    {
+        SceneObject::UpdateGuard guard(&sceneVars);
+        sceneVars.set(SceneVariables::sResKey, 2.0f);
+        sceneVars.set(SceneVariables::sMachineId, Int(3));
+        sceneVars.set(SceneVariables::sNumMachines, Int(8));
+    }
+    CPPUNIT_ASSERT_EQUAL(sceneVars.get(SceneVariables::sResKey),
+                         sceneVars.get(SceneVariables::sFixedResKey));
+    CPPUNIT_ASSERT_EQUAL(sceneVars.get(SceneVariables::sImageWidth),
+                         sceneVars.get(SceneVariables::sFixedImageWidth));
+    CPPUNIT_ASSERT(sceneVars.get(SceneVariables::sRegionWindow) ==
+                   sceneVars.get(SceneVariables::sFixedRegionWindow));
+    CPPUNIT_ASSERT_EQUAL(3, sceneVars.getMachineId());
+    CPPUNIT_ASSERT_EQUAL(8, sceneVars.getNumMachines());
+    CPPUNIT_ASSERT_EQUAL(960u, sceneVars.getRezedWidth());
+}
+
 void
 TestSceneClass::testCreateDestroyObject()
 {
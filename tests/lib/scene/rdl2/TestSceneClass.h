@@ -55,6 +55,9 @@ public:
     /// Test that the memory layout of attribute values is correct.
     void testMemoryLayout();
 
+    /// Test that compile-time attribute layouts match the memory layout.
+    void testAttributeLayout();
+
     /// Test that sanity checks are in place for createObject() and destroyObject().
     void testCreateDestroyObject();
 
@@ -75,6 +78,7 @@ public:
     CPPUNIT_TEST(testGetAttributeKeyByName);
     CPPUNIT_TEST(testIterateAttributes);
     CPPUNIT_TEST(testMemoryLayout);
+    CPPUNIT_TEST(testAttributeLayout);
     CPPUNIT_TEST(testCreateDestroyObject);
     CPPUNIT_TEST(testAttributeStorage);
     CPPUNIT_TEST_SUITE_END();
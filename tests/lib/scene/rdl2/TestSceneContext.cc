@@ -5,6 +5,7 @@
 #include "TestSceneContext.h"
 
 #include <scene_rdl2/scene/rdl2/AttributeKey.h>
+#include <scene_rdl2/scene/rdl2/MemoryReport.h>
 #include <scene_rdl2/scene/rdl2/SceneContext.h>
 #include <scene_rdl2/scene/rdl2/SceneClass.h>
 #include <scene_rdl2/scene/rdl2/SceneObject.h>
@@ -14,6 +15,10 @@
 #include <scene_rdl2/common/except/exceptions.h>
 #include <scene_rdl2/common/math/Color.h>
 
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <iterator>
 #include <string>
 
 namespace scene_rdl2 {
@@ -416,6 +421,53 @@ TestSceneContext::testCreateObjectFailure()
     CPPUNIT_ASSERT_EQUAL(numBefore, numAfter);
 }
 
+void
+TestSceneContext::testMemoryReport()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<FloatVector> floatVecKey = sceneClass->getAttributeKey<FloatVector>("float_vector");
+
+    SceneObject* small = context.createSceneObject("ExtensiveObject", "/seq/shot/small");
+    SceneObject* big = context.createSceneObject("ExtensiveObject", "/seq/shot/big");
+    big->beginUpdate();
+    big->set(floatVecKey, FloatVector(100000, 1.0f));
+    big->endUpdate();
+
+    const MemoryReport report = context.getMemoryReport();
+    const MemoryReport::EntryVector& objects = report.getObjects();
+    const MemoryReport::EntryVector& attributes = report.getAttributes();
+
+    // The big vector dominates everything.
+    CPPUNIT_ASSERT(objects.front().mName == big->getName());
+    CPPUNIT_ASSERT(objects.front().mHeapBytes >= 100000 * sizeof(Float));
+    CPPUNIT_ASSERT(attributes.front().mClassName == "ExtensiveObject");
+    CPPUNIT_ASSERT(attributes.front().mName == "float_vector");
+    CPPUNIT_ASSERT(report.getClasses().front().mName == "ExtensiveObject");
+
+    // Both objects share the same storage layout.
+    auto smallEntry = std::find_if(objects.begin(), objects.end(),
+                                   [&](const MemoryReport::Entry& e) { return e.mName == small->getName(); });
+    CPPUNIT_ASSERT(smallEntry != objects.end());
+    CPPUNIT_ASSERT(smallEntry->mStorageBytes == objects.front().mStorageBytes);
+    CPPUNIT_ASSERT(smallEntry->mHeapBytes < objects.front().mHeapBytes);
+
+    // The 4 change masks are counted as heap, with their bitset objects.
+    const std::size_t numAttributes = std::distance(sceneClass->beginAttributes(),
+                                                    sceneClass->endAttributes());
+    CPPUNIT_ASSERT(smallEntry->mHeapBytes >= 4 * (sizeof(boost::dynamic_bitset<>) + (numAttributes + 7) / 8));
+
+    std::size_t storageBytes = 0;
+    std::size_t heapBytes = 0;
+    for (const MemoryReport::Entry& entry : objects) {
+        storageBytes += entry.mStorageBytes;
+        heapBytes += entry.mHeapBytes;
+    }
+    CPPUNIT_ASSERT(report.getStorageBytes() == storageBytes);
+    CPPUNIT_ASSERT(report.getHeapBytes() == heapBytes);
+    CPPUNIT_ASSERT(!report.show(5).empty());
+}
+
 } // namespace unittest
 } // namespace rdl2
 } // namespace scene_rdl2
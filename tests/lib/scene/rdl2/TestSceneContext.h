@@ -65,6 +65,9 @@ public:
     /// creation fails.
     void testCreateObjectFailure();
 
+    /// Test that the memory report accounts for attribute values.
+    void testMemoryReport();
+
     CPPUNIT_TEST_SUITE(TestSceneContext);
     CPPUNIT_TEST(testDsoPath);
     CPPUNIT_TEST(testCreateSceneClass);
@@ -80,6 +83,7 @@ public:
     CPPUNIT_TEST(testSceneVariables);
     CPPUNIT_TEST(testCreateClassFailure);
     CPPUNIT_TEST(testCreateObjectFailure);
+    CPPUNIT_TEST(testMemoryReport);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -120,6 +120,56 @@ TestSplit::testRoundtrip()
     CPPUNIT_ASSERT(geoms.empty());
 }
 
+void
+TestSplit::testMultiFileLoad()
+{
+    SceneContext context;
+    const SceneClass* sc = context.createSceneClass("ExtensiveObject");
+    SceneObject* apple = context.createSceneObject("ExtensiveObject", "/seq/shot/apple");
+    SceneObject* banana = context.createSceneObject("ExtensiveObject", "/seq/shot/banana");
+
+    AttributeKey<String> stringKey = sc->getAttributeKey<String>("string");
+    AttributeKey<Vec3fVector> vec3fVectorKey = sc->getAttributeKey<Vec3fVector>("vec3f_vector");
+
+    apple->beginUpdate();
+    apple->set(stringKey, std::string("apple"));
+    apple->set(vec3fVectorKey, mShortVec);
+    apple->endUpdate();
+    banana->beginUpdate();
+    banana->set(stringKey, std::string("banana"));
+    banana->set(vec3fVectorKey, mLongVec);
+    banana->endUpdate();
+
+    writeSceneToFile(context, "multifile_split", false, true);
+
+    // Override file, which has to be applied after the split files.
+    {
+        std::ofstream out("multifile_override.rdla");
+        out << "ExtensiveObject(\"/seq/shot/apple\") { [\"string\"] = \"override\" }\n";
+    }
+
+    const std::vector<std::string> files = {
+        "multifile_split.rdla", "multifile_split.rdlb", "multifile_override.rdla"
+    };
+    for (unsigned maxInFlight : {1u, 2u, 4u}) {
+        SceneContext loadContext;
+        readScenesFromFiles(files, loadContext, maxInFlight);
+
+        SceneObject* loadApple = loadContext.getSceneObject("/seq/shot/apple");
+        SceneObject* loadBanana = loadContext.getSceneObject("/seq/shot/banana");
+        CPPUNIT_ASSERT(loadApple->get(stringKey) == "override");
+        CPPUNIT_ASSERT(loadApple->get(vec3fVectorKey) == mShortVec);
+        CPPUNIT_ASSERT(loadBanana->get(stringKey) == "banana");
+        CPPUNIT_ASSERT(loadBanana->get(vec3fVectorKey) == mLongVec);
+    }
+
+    // Errors are reported for the failing file, after the files before it.
+    SceneContext errorContext;
+    CPPUNIT_ASSERT_THROW(readScenesFromFiles({"multifile_split.rdla", "multifile_missing.rdla"},
+                                             errorContext),
+                         except::IoError);
+    CPPUNIT_ASSERT(errorContext.getSceneObject("/seq/shot/apple")->get(stringKey) == "apple");
+}
 
 } // namespace unittest
 } // namespace rdl2
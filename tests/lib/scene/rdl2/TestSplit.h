@@ -24,8 +24,12 @@ public:
     /// Test basic roundtrip functionality
     void testRoundtrip();
 
+    /// Test loading the split files and an override concurrently
+    void testMultiFileLoad();
+
     CPPUNIT_TEST_SUITE(TestSplit);
     CPPUNIT_TEST(testRoundtrip);
+    CPPUNIT_TEST(testMultiFileLoad);
     CPPUNIT_TEST_SUITE_END();
 
 private:
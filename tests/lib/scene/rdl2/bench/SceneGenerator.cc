@@ -0,0 +1,194 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "SceneGenerator.h"
+
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+namespace bench {
+
+namespace {
+
+const std::string EXTENSIVE_CLASS = "ExtensiveObject";
+const size_t PARTS_PER_GEOMETRY = 4;
+
+typedef std::function<void(const SceneClass&, SceneObject&, size_t id, size_t vectorSize)> Setter;
+
+template <typename T>
+Setter
+scalarSetter(const char* name, std::function<T(size_t)> value)
+{
+    return [=](const SceneClass& sc, SceneObject& obj, size_t id, size_t) {
+        obj.set(sc.getAttributeKey<T>(name), value(id));
+    };
+}
+
+template <typename T>
+Setter
+vectorSetter(const char* name, std::function<typename T::value_type(size_t)> value)
+{
+    return [=](const SceneClass& sc, SceneObject& obj, size_t id, size_t vectorSize) {
+        T vec;
+        vec.reserve(vectorSize);
+        for (size_t i = 0; i < vectorSize; ++i) {
+            vec.push_back(value(id + i));
+        }
+        obj.set(sc.getAttributeKey<T>(name), vec);
+    };
+}
+
+// Attributes of ExtensiveObject in the order they are set, scalars and
+// vectors interleaved so a small mAttributes still has some of each.
+const std::vector<Setter>&
+getSetters()
+{
+    static const std::vector<Setter> setters = {
+        scalarSetter<Int>("int", [](size_t i) { return Int(i); }),
+        vectorSetter<FloatVector>("float_vector", [](size_t i) { return float(i) * 0.5f; }),
+        scalarSetter<Float>("float", [](size_t i) { return float(i) * 0.25f; }),
+        vectorSetter<Vec3fVector>("vec3f_vector", [](size_t i) { return Vec3f(i, i + 1, i + 2); }),
+        scalarSetter<Rgb>("rgb", [](size_t i) { return Rgb(i % 7 * 0.1f, i % 5 * 0.2f, i % 3 * 0.3f); }),
+        vectorSetter<IntVector>("int_vector", [](size_t i) { return Int(i); }),
+        scalarSetter<Vec3f>("vec3f", [](size_t i) { return Vec3f(i, 0.0f, -float(i)); }),
+        vectorSetter<StringVector>("string_vector", [](size_t i) { return "s" + std::to_string(i); }),
+        scalarSetter<Double>("double", [](size_t i) { return double(i) * 0.125; }),
+        vectorSetter<DoubleVector>("double_vector", [](size_t i) { return double(i); }),
+        scalarSetter<Long>("long", [](size_t i) { return Long(i) << 20; }),
+        vectorSetter<Vec2fVector>("vec2f_vector", [](size_t i) { return Vec2f(i, -float(i)); }),
+        scalarSetter<Bool>("bool", [](size_t i) { return (i & 1) != 0; }),
+        vectorSetter<RgbVector>("rgb_vector", [](size_t i) { return Rgb(i % 3 * 0.5f); }),
+        scalarSetter<Mat4d>("mat4d", [](size_t i) { return Mat4d(math::one) * double(i); }),
+        vectorSetter<Mat4fVector>("mat4f_vector", [](size_t i) { return Mat4f(math::one) * float(i); }),
+        vectorSetter<Vec4fVector>("vec4f_vector", [](size_t i) { return Vec4f(i, i, i, 1.0f); }),
+        vectorSetter<LongVector>("long_vector", [](size_t i) { return Long(i); }),
+    };
+    return setters;
+}
+
+} // namespace
+
+std::string
+SceneParams::show() const
+{
+    std::ostringstream ostr;
+    ostr << "objects:" << mObjects
+         << " attributes:" << mAttributes
+         << " vectorSize:" << mVectorSize
+         << " bindingDepth:" << mBindingDepth
+         << " layerAssignments:" << mLayerAssignments
+         << " materials:" << mMaterials;
+    return ostr.str();
+}
+
+void
+SceneGenerator::generate(SceneContext& context) const
+{
+    const SceneClass& sc = *context.createSceneClass(EXTENSIVE_CLASS);
+    const AttributeKey<String> stringKey = sc.getAttributeKey<String>("string");
+    const AttributeKey<SceneObject*> sceneObjectKey = sc.getAttributeKey<SceneObject*>("scene_object");
+
+    const std::vector<Setter>& setters = getSetters();
+    const size_t attributes = std::min(mParams.mAttributes, setters.size());
+    const size_t chainLength = mParams.mBindingDepth + 1;
+
+    SceneObject* prev = nullptr;
+    for (size_t id = 0; id < mParams.mObjects; ++id) {
+        SceneObject* obj = context.createSceneObject(EXTENSIVE_CLASS, objName(id));
+        SceneObject::UpdateGuard guard(obj);
+        for (size_t i = 0; i < attributes; ++i) {
+            setters[i](sc, *obj, id, mParams.mVectorSize);
+        }
+        if (id % chainLength != 0) {
+            obj->setBinding(stringKey, prev);
+            obj->set(sceneObjectKey, prev);
+        }
+        prev = obj;
+    }
+
+    if (!mParams.mLayerAssignments) {
+        return;
+    }
+
+    std::vector<Material*> materials;
+    for (size_t i = 0; i < std::max(mParams.mMaterials, size_t(1)); ++i) {
+        materials.push_back(context.createSceneObject("FakeMaterial",
+                                                      "/bench/mtl_" + std::to_string(i))->asA<Material>());
+    }
+    LightSet* lightSet = context.createSceneObject("LightSet", "/bench/lightset")->asA<LightSet>();
+
+    Layer* layer = getLayer(context);
+    SceneObject::UpdateGuard guard(layer);
+    for (size_t i = 0; i < mParams.mLayerAssignments; ++i) {
+        const size_t geomId = i / PARTS_PER_GEOMETRY;
+        Geometry* geom = context.createSceneObject("FakeTeapot",
+                                                   "/bench/geom_" + std::to_string(geomId))->asA<Geometry>();
+        layer->assign(geom, "part_" + std::to_string(i % PARTS_PER_GEOMETRY),
+                      materials[i % materials.size()], lightSet);
+    }
+}
+
+std::vector<SceneObject*>
+SceneGenerator::touchChainLeaves(SceneContext& context, int generation) const
+{
+    const SceneClass& sc = *context.getSceneClass(EXTENSIVE_CLASS);
+    const AttributeKey<Float> floatKey = sc.getAttributeKey<Float>("float");
+    const size_t chainLength = mParams.mBindingDepth + 1;
+
+    std::vector<SceneObject*> roots;
+    for (size_t leafId = 0; leafId < mParams.mObjects; leafId += chainLength) {
+        SceneObject* leaf = context.getSceneObject(objName(leafId));
+        {
+            SceneObject::UpdateGuard guard(leaf);
+            leaf->set(floatKey, float(generation));
+        }
+        const size_t rootId = std::min(leafId + chainLength, mParams.mObjects) - 1;
+        roots.push_back(context.getSceneObject(objName(rootId)));
+    }
+    return roots;
+}
+
+void
+SceneGenerator::touchLayer(SceneContext& context, int generation) const
+{
+    const size_t geometries = (mParams.mLayerAssignments + PARTS_PER_GEOMETRY - 1) / PARTS_PER_GEOMETRY;
+    for (size_t i = 0; i < geometries; ++i) {
+        SceneObject* geom = context.getSceneObject("/bench/geom_" + std::to_string(i));
+        SceneObject::UpdateGuard guard(geom);
+        geom->set("fakeness", Float(generation));
+    }
+    for (size_t i = 0; i < std::max(mParams.mMaterials, size_t(1)); ++i) {
+        SceneObject* material = context.getSceneObject("/bench/mtl_" + std::to_string(i));
+        SceneObject::UpdateGuard guard(material);
+        material->set("fakeness", Float(generation));
+    }
+}
+
+Layer*
+SceneGenerator::getLayer(SceneContext& context) const
+{
+    return context.createSceneObject("Layer", "/bench/layer")->asA<Layer>();
+}
+
+// static function
+size_t
+SceneGenerator::maxAttributes()
+{
+    return getSetters().size();
+}
+
+// static function
+std::string
+SceneGenerator::objName(size_t id)
+{
+    return "/bench/obj_" + std::to_string(id);
+}
+
+} // namespace bench
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,75 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include <scene_rdl2/scene/rdl2/rdl2.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+namespace bench {
+
+/**
+ * Shape of a synthetic scene built from the test DSOs.
+ */
+struct SceneParams
+{
+    size_t mObjects {10000};         // ExtensiveObjects
+    size_t mAttributes {8};          // attributes set on each ExtensiveObject
+    size_t mVectorSize {16};         // elements of each vector attribute
+    size_t mBindingDepth {3};        // ExtensiveObjects bound below each chain root
+    size_t mLayerAssignments {1000}; // FakeTeapot parts assigned in the Layer
+    size_t mMaterials {16};          // FakeMaterials shared by the assignments
+
+    std::string show() const;
+};
+
+/**
+ * Builds a parametric scene from the ExtensiveObject, FakeTeapot and
+ * FakeMaterial test DSOs:
+ *
+ *  - mObjects ExtensiveObjects, each with mAttributes of its scalar and
+ *    vector attributes set (vectors hold mVectorSize elements).
+ *  - The ExtensiveObjects form chains of mBindingDepth + 1 objects. Every
+ *    object but the first of a chain binds its "string" attribute to, and
+ *    references by "scene_object", the previous one. The first object of a
+ *    chain is its leaf, the last one its root.
+ *  - A Layer with mLayerAssignments parts over FakeTeapots (4 parts each),
+ *    using mMaterials FakeMaterials and one LightSet.
+ *
+ * The scene only depends on the params, so the same params give the same
+ * scene (and the same files) on every run.
+ */
+class SceneGenerator
+{
+public:
+    explicit SceneGenerator(const SceneParams& params) : mParams(params) {}
+
+    void generate(SceneContext& context) const;
+
+    // Changes an attribute of every chain leaf. Returns the chain roots, from
+    // which updatePrep() reaches the changed leaves through the bindings.
+    std::vector<SceneObject*> touchChainLeaves(SceneContext& context, int generation) const;
+
+    // Changes an attribute of every Geometry and Material in the Layer.
+    void touchLayer(SceneContext& context, int generation) const;
+
+    Layer* getLayer(SceneContext& context) const;
+
+    static size_t maxAttributes();
+
+private:
+    static std::string objName(size_t id);
+
+    SceneParams mParams;
+};
+
+} // namespace bench
+} // namespace rdl2
+} // namespace scene_rdl2
+
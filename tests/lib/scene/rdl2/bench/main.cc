@@ -0,0 +1,318 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "SceneGenerator.h"
+
+#include <scene_rdl2/common/rec_time/RecTime.h>
+#include <scene_rdl2/scene/rdl2/rdl2.h>
+#include <scene_rdl2/scene/rdl2/UpdateHelper.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace scene_rdl2;
+using namespace scene_rdl2::rdl2;
+
+namespace {
+
+struct BenchOptions
+{
+    bench::SceneParams mParams;
+    int mRuns {3};
+    std::string mDir {"."};
+    std::string mOut; // empty : stdout
+    std::string mDsoPath;
+};
+
+struct BenchResult
+{
+    std::string mName;
+    float mSec {0.0f};     // best of the runs
+    size_t mObjects {0};   // SceneObjects processed per run
+    size_t mBytes {0};     // file bytes, 0 if not a file benchmark
+};
+
+void
+usage(const char* progName)
+{
+    std::cerr << "Usage : " << progName << " [options]\n"
+              << "Times generating, writing, reading and updating a synthetic scene made of the test DSOs\n"
+              << "and reports the results as JSON.\n"
+              << "  --objects <n>           ExtensiveObjects (default 10000)\n"
+              << "  --attrs <n>             attributes set per ExtensiveObject (default 8, max "
+              << bench::SceneGenerator::maxAttributes() << ")\n"
+              << "  --vector-size <n>       elements per vector attribute (default 16)\n"
+              << "  --binding-depth <n>     bound objects below each chain root (default 3)\n"
+              << "  --layer-assignments <n> Layer assignments (default 1000)\n"
+              << "  --materials <n>         materials shared by the assignments (default 16)\n"
+              << "  --runs <n>              runs per benchmark, the best one is reported (default 3)\n"
+              << "  --dir <path>            directory for the scene files (default .)\n"
+              << "  --out <file>            JSON output file (default stdout)\n"
+              << "  --dso-path <path>       additional DSO path\n";
+}
+
+bool
+parseCommandLine(int argc, char* argv[], BenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        auto nextSize = [&](size_t& value) {
+            if (i + 1 >= argc) return false;
+            value = std::strtoull(argv[++i], nullptr, 10);
+            return true;
+        };
+        auto nextStr = [&](std::string& value) {
+            if (i + 1 >= argc) return false;
+            value = argv[++i];
+            return true;
+        };
+
+        bool ok = true;
+        if (std::strcmp(argv[i], "--objects") == 0) ok = nextSize(options.mParams.mObjects);
+        else if (std::strcmp(argv[i], "--attrs") == 0) ok = nextSize(options.mParams.mAttributes);
+        else if (std::strcmp(argv[i], "--vector-size") == 0) ok = nextSize(options.mParams.mVectorSize);
+        else if (std::strcmp(argv[i], "--binding-depth") == 0) ok = nextSize(options.mParams.mBindingDepth);
+        else if (std::strcmp(argv[i], "--layer-assignments") == 0) ok = nextSize(options.mParams.mLayerAssignments);
+        else if (std::strcmp(argv[i], "--materials") == 0) ok = nextSize(options.mParams.mMaterials);
+        else if (std::strcmp(argv[i], "--runs") == 0) {
+            size_t runs = 0;
+            ok = nextSize(runs);
+            options.mRuns = std::max(int(runs), 1);
+        }
+        else if (std::strcmp(argv[i], "--dir") == 0) ok = nextStr(options.mDir);
+        else if (std::strcmp(argv[i], "--out") == 0) ok = nextStr(options.mOut);
+        else if (std::strcmp(argv[i], "--dso-path") == 0 ||
+                 std::strcmp(argv[i], "--dso_path") == 0 ||
+                 std::strcmp(argv[i], "-d") == 0) ok = nextStr(options.mDsoPath);
+        else ok = false;
+
+        if (!ok) return false;
+    }
+    return true;
+}
+
+std::unique_ptr<SceneContext>
+newContext(const BenchOptions& options)
+{
+    std::unique_ptr<SceneContext> context(new SceneContext);
+    if (!options.mDsoPath.empty()) {
+        context->setDsoPath(options.mDsoPath + ":" + context->getDsoPath());
+    }
+    return context;
+}
+
+size_t
+fileSize(const std::string& path)
+{
+    struct stat statBuf;
+    return (stat(path.c_str(), &statBuf) == 0) ? statBuf.st_size : 0;
+}
+
+// Best of the runs, in seconds. setup() runs before each measured run and is
+// excluded from the timing.
+float
+timeBestOf(int runs, const std::function<void()>& setup, const std::function<void()>& func)
+{
+    float best = 0.0f;
+    for (int i = 0; i < runs; ++i) {
+        setup();
+        rec_time::RecTime recTime;
+        recTime.start();
+        func();
+        const float sec = recTime.end();
+        if (i == 0 || sec < best) best = sec;
+    }
+    return best;
+}
+
+std::string
+toJson(const BenchOptions& options, size_t sceneObjects, const std::vector<BenchResult>& results)
+{
+    const bench::SceneParams& params = options.mParams;
+
+    std::ostringstream ostr;
+    ostr << "{\n"
+         << "  \"benchmark\": \"scene_rdl2_scene_load\",\n"
+         << "  \"params\": {\n"
+         << "    \"objects\": " << params.mObjects << ",\n"
+         << "    \"attributes\": " << params.mAttributes << ",\n"
+         << "    \"vector_size\": " << params.mVectorSize << ",\n"
+         << "    \"binding_depth\": " << params.mBindingDepth << ",\n"
+         << "    \"layer_assignments\": " << params.mLayerAssignments << ",\n"
+         << "    \"materials\": " << params.mMaterials << ",\n"
+         << "    \"runs\": " << options.mRuns << "\n"
+         << "  },\n"
+         << "  \"scene_objects\": " << sceneObjects << ",\n"
+         << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        const double perSec = (result.mSec > 0.0f) ? double(result.mObjects) / result.mSec : 0.0;
+        ostr << "    { \"name\": \"" << result.mName << "\""
+             << ", \"sec\": " << std::setprecision(6) << result.mSec
+             << ", \"objects\": " << result.mObjects
+             << ", \"objects_per_sec\": " << std::fixed << std::setprecision(1) << perSec
+             << std::defaultfloat;
+        if (result.mBytes) {
+            ostr << ", \"bytes\": " << result.mBytes;
+        }
+        ostr << " }" << ((i + 1 < results.size()) ? "," : "") << '\n';
+    }
+    ostr << "  ]\n"
+         << "}\n";
+    return ostr.str();
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+//
+// Scene layer benchmark : AsciiReader/Writer, BinaryReader/Writer, split mode,
+// createSceneObject and update propagation over a synthetic scene. This is not
+// part of the unit tests. Run it from the test build directory (where the test
+// DSOs are) and keep the JSON output for trend tracking.
+//
+{
+    BenchOptions options;
+    if (!parseCommandLine(argc, argv, options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const bench::SceneGenerator generator(options.mParams);
+    const int runs = options.mRuns;
+    std::cerr << "scene_rdl2 scene load benchmark (" << options.mParams.show() << " runs:" << runs << ")\n";
+
+    std::vector<BenchResult> results;
+    auto record = [&](const std::string& name, float sec, size_t objects, size_t bytes) {
+        results.push_back({name, sec, objects, bytes});
+        std::cerr << "  " << std::setw(20) << std::left << name << std::right
+                  << std::setw(12) << std::fixed << std::setprecision(3) << sec * 1000.0f << " ms"
+                  << std::defaultfloat << '\n';
+    };
+
+    const std::string rdlaPath = options.mDir + "/bench_scene.rdla";
+    const std::string rdlbPath = options.mDir + "/bench_scene.rdlb";
+    const std::string splitPath = options.mDir + "/bench_split";
+
+    try {
+        // Generating the scene exercises createSceneObject() and set().
+        std::unique_ptr<SceneContext> context;
+        const float generateSec = timeBestOf(runs, [&]() { context = newContext(options); },
+                                             [&]() { generator.generate(*context); });
+        const size_t sceneObjects = std::distance(context->beginSceneObject(), context->endSceneObject());
+        record("generate", generateSec, sceneObjects, 0);
+
+        auto noSetup = []() {};
+        record("write_rdla",
+               timeBestOf(runs, noSetup, [&]() { writeSceneToFile(*context, rdlaPath, false, true); }),
+               sceneObjects, fileSize(rdlaPath));
+        record("write_rdlb",
+               timeBestOf(runs, noSetup, [&]() { writeSceneToFile(*context, rdlbPath, false, true); }),
+               sceneObjects, fileSize(rdlbPath));
+        record("write_split",
+               timeBestOf(runs, noSetup, [&]() { writeSceneToFile(*context, splitPath, false, true); }),
+               sceneObjects, fileSize(splitPath + ".rdla") + fileSize(splitPath + ".rdlb"));
+
+        // Each read goes into a fresh SceneContext, created outside of the timing.
+        std::unique_ptr<SceneContext> readContext;
+        auto freshContext = [&]() { readContext = newContext(options); };
+        record("read_rdla",
+               timeBestOf(runs, freshContext, [&]() { readSceneFromFile(rdlaPath, *readContext); }),
+               sceneObjects, fileSize(rdlaPath));
+        record("read_rdlb",
+               timeBestOf(runs, freshContext, [&]() { readSceneFromFile(rdlbPath, *readContext); }),
+               sceneObjects, fileSize(rdlbPath));
+        record("read_split",
+               timeBestOf(runs, freshContext, [&]() {
+                   readScenesFromFiles({splitPath + ".rdla", splitPath + ".rdlb"}, *readContext);
+               }),
+               sceneObjects, fileSize(splitPath + ".rdla") + fileSize(splitPath + ".rdlb"));
+        readContext.reset();
+
+        // Update propagation through the binding chains, from each chain root
+        // down to its changed leaf.
+        int generation = 0;
+        std::vector<SceneObject*> roots;
+        auto resetAll = [&]() {
+            for (auto itr = context->beginSceneObject(); itr != context->endSceneObject(); ++itr) {
+                itr->second->resetUpdate();
+            }
+        };
+        record("update_prep_chains",
+               timeBestOf(runs, [&]() {
+                   resetAll();
+                   roots = generator.touchChainLeaves(*context, ++generation);
+               }, [&]() {
+                   UpdateHelper helper;
+                   for (SceneObject* root : roots) {
+                       root->updatePrep(helper, 0);
+                   }
+               }),
+               options.mParams.mObjects, 0);
+        resetAll();
+
+        // SceneContext::applyUpdates() over the Layer assignments.
+        if (options.mParams.mLayerAssignments) {
+            Layer* layer = generator.getLayer(*context);
+            record("apply_updates_layer",
+                   timeBestOf(runs, [&]() {
+                       context->resetUpdates(layer);
+                       generator.touchLayer(*context, ++generation);
+                   }, [&]() {
+                       context->applyUpdates(layer);
+                   }),
+                   options.mParams.mLayerAssignments, 0);
+            context->resetUpdates(layer);
+        }
+
+        // The SceneVariables getters called per tile by the renderer. They
+        // read their attributes through compile-time FixedAttributeKeys.
+        {
+            const SceneVariables& sceneVars = context->getSceneVariables();
+            const size_t calls = 1000000;
+            volatile int sink = 0;
+            record("scene_vars_getters",
+                   timeBestOf(runs, noSetup, [&]() {
+                       int sum = 0;
+                       for (size_t i = 0; i < calls; ++i) {
+                           const math::HalfOpenViewport viewport = sceneVars.getRezedSubViewport();
+                           sum += viewport.mMaxX + sceneVars.getRezedWidth() +
+                                  sceneVars.getMachineId() + sceneVars.getNumMachines();
+                       }
+                       sink = sum;
+                   }),
+                   calls, 0);
+            (void)sink;
+        }
+
+        const std::string json = toJson(options, sceneObjects, results);
+        if (options.mOut.empty()) {
+            std::cout << json;
+        } else {
+            std::ofstream out(options.mOut.c_str());
+            out << json;
+            if (!out) {
+                std::cerr << "ERROR: could not write " << options.mOut << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+